@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Compare RiscBenchmark JSON results against a baseline recorded on the same machine.
+
+Usage:
+    ./RiscBenchmark --benchmark_repetitions=5 --benchmark_report_aggregates_only=true \\
+        --benchmark_out=baseline.json --benchmark_out_format=json   # reference commit
+    ./RiscBenchmark --benchmark_repetitions=5 --benchmark_report_aggregates_only=true \\
+        --benchmark_out=results.json --benchmark_out_format=json    # change under test
+    python3 bench/compare.py baseline.json results.json [--threshold 0.10]
+
+Benchmarks that report items_per_second (guest instructions per second for the
+workloads) are compared on throughput; the others on real time. When the JSON
+holds repetition aggregates the median is used. The script exits with status 1
+if any benchmark regressed by more than the threshold, so it can gate CI.
+"""
+
+import argparse
+import json
+import sys
+
+
+def load(path):
+    """Return {benchmark name: (metric, value, higher_is_better)} for one results file."""
+    with open(path, encoding="utf-8") as f:
+        data = json.load(f)
+
+    runs = {}
+    medians = {}
+    for bench in data.get("benchmarks", []):
+        if bench.get("error_occurred"):
+            continue
+        name = bench.get("run_name", bench["name"])
+        if bench.get("run_type") == "aggregate":
+            if bench.get("aggregate_name") == "median":
+                medians[name] = bench
+        else:
+            runs.setdefault(name, bench)  # first repetition if no aggregates
+    runs.update(medians)
+
+    results = {}
+    for name, bench in runs.items():
+        if "items_per_second" in bench:
+            results[name] = ("items/s", bench["items_per_second"], True)
+        else:
+            scale = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}[bench.get("time_unit", "ns")]
+            results[name] = ("ns", bench["real_time"] * scale, False)
+    return results
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("baseline", help="JSON written by --benchmark_out for the reference build")
+    parser.add_argument("current", help="JSON written by --benchmark_out")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative slowdown treated as a regression (default: 0.10)")
+    args = parser.parse_args()
+
+    baseline = load(args.baseline)
+    current = load(args.current)
+
+    regressions = []
+    width = max((len(name) for name in current), default=10)
+    print(f"{'benchmark':<{width}}  {'metric':>7}  {'baseline':>12}  {'current':>12}  {'change':>8}")
+    for name in sorted(current, key=list(current).index):
+        metric, value, higher_is_better = current[name]
+        if name not in baseline:
+            print(f"{name:<{width}}  {metric:>7}  {'-':>12}  {value:>12.4g}  {'new':>8}")
+            continue
+        _, reference, _ = baseline[name]
+        # Positive change = faster
+        change = (value / reference - 1.0) if higher_is_better else (reference / value - 1.0)
+        flag = ""
+        if change < -args.threshold:
+            flag = "  REGRESSION"
+            regressions.append(name)
+        print(f"{name:<{width}}  {metric:>7}  {reference:>12.4g}  {value:>12.4g}  {change:>+7.1%}{flag}")
+
+    for name in sorted(set(baseline) - set(current)):
+        print(f"{name:<{width}}  missing from current results")
+
+    if regressions:
+        print(f"\n{len(regressions)} regression(s) beyond {args.threshold:.0%}:", file=sys.stderr)
+        for name in regressions:
+            print(f"  {name}", file=sys.stderr)
+        return 1
+    print(f"\nNo regressions beyond {args.threshold:.0%}.")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,635 @@
+/**
+ * @file machine_benchmark.cpp
+ * @brief Google Benchmark suite measuring emulator throughput and fixed costs.
+ *
+ * Every workload runs on each execution engine (argument "engine": 0 = Switch,
+ * 1 = Threaded, 2 = Jit), except the compile-time programs, which run on a
+ * ConstexprMachine (argument "compiled"). Each benchmark iteration is one complete guest run,
+ * so real_time is the per-run latency; items_per_second and the MIPS counter
+ * report retired guest instructions per second.
+ *
+ * Retired-instruction counts are derived from the structure of each program
+ * (see the count functions below); keep them in step with algorithms.cpp. Each
+ * benchmark checks the program's result once before timing it.
+ *
+ * Write results as JSON with --benchmark_out=results.json and compare them
+ * with bench/compare.py against results recorded on the same machine from the
+ * reference commit.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include "../src/constexpr_machine.hpp"
+#include "../src/host_call.hpp"
+#include "../src/run_cache.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <functional>
+#include <memory>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+const std::vector<int64_t> kEngines = {static_cast<int64_t>(ExecutionEngine::Switch),
+                                       static_cast<int64_t>(ExecutionEngine::Threaded),
+                                       static_cast<int64_t>(ExecutionEngine::Jit)};
+
+/**
+ * @brief Runs one guest program per iteration and reports throughput counters.
+ *
+ * @param state Benchmark state; range(0) selects the engine.
+ * @param program The program to run.
+ * @param data_size Data memory size of the machine.
+ * @param prepare Writes the inputs before every run.
+ * @param check Returns true if the machine holds the expected result after a run.
+ * @param retired Guest instructions executed by one run.
+ * @param initialise Fills data memory once, before the first run (optional).
+ */
+void runProgram(benchmark::State& state, const std::vector<Instruction>& program, size_t data_size,
+                const std::function<void(RiscMachine&)>& prepare,
+                const std::function<bool(const RiscMachine&)>& check, uint64_t retired,
+                const std::function<void(RiscMachine&)>& initialise = {}) {
+    RiscMachine machine(program.size(), data_size, static_cast<ExecutionEngine>(state.range(0)));
+    machine.loadProgram(program);
+    if (initialise) initialise(machine);
+    prepare(machine);
+    machine.run();
+    if (!check(machine)) {
+        state.SkipWithError("unexpected result");
+        return;
+    }
+
+    for (auto _ : state) {
+        machine.reset();
+        prepare(machine);
+        machine.run();
+    }
+
+    const double total = static_cast<double>(state.iterations()) * static_cast<double>(retired);
+    state.SetItemsProcessed(static_cast<int64_t>(total));
+    state.counters["MIPS"] = benchmark::Counter(total / 1e6, benchmark::Counter::kIsRate);
+    state.counters["instructions"] = static_cast<double>(retired);
+}
+
+// ─── Bundled programs ─────────────────────────────────────────────────────────
+
+// Factorial(n >= 1): 6 setup, 5 per loop iteration (n - 1), 2 to leave the loop, STORE, HALT
+uint64_t factorialInstructions(uint64_t n) { return 5 * n + 5; }
+
+// Fibonacci(n >= 2): 9 setup, 10 per loop iteration (n - 1), 2 to leave the loop, STORE, HALT
+uint64_t fibonacciInstructions(uint64_t n) { return 10 * n + 3; }
+
+// Sum(length >= 1) without overflow: 4 setup, 10 per element, 2 fewer for the last, STORE, HALT
+uint64_t sumListInstructions(uint64_t length) { return 10 * length + 4; }
+
+void BM_Factorial(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    uint32_t expected = 1;
+    for (uint32_t k = 2; k <= n; ++k) expected *= k;
+    runProgram(state, createFactorialProgram(100, 101), 1024,
+               [n](RiscMachine& m) { m.setMemoryValue(100, n); },
+               [expected](const RiscMachine& m) { return m.getMemoryValue(101) == expected; },
+               factorialInstructions(n));
+}
+BENCHMARK(BM_Factorial)->ArgNames({"engine", "n"})->ArgsProduct({kEngines, {10, 1000, 100000}});
+
+// BM_Factorial with n = 100000 run in budgeted slices of run(max_steps), as under Scheduler
+void BM_FactorialSliced(benchmark::State& state) {
+    const uint64_t slice = static_cast<uint64_t>(state.range(1));
+    const uint32_t n = 100000;
+    RiscMachine machine(64, 1024, static_cast<ExecutionEngine>(state.range(0)));
+    machine.loadProgram(createFactorialProgram(100, 101));
+    for (auto _ : state) {
+        machine.reset();
+        machine.setMemoryValue(100, n);
+        while (machine.run(slice) == RunStatus::BudgetExhausted) {
+        }
+    }
+    const double total = static_cast<double>(state.iterations()) * static_cast<double>(factorialInstructions(n));
+    state.SetItemsProcessed(static_cast<int64_t>(total));
+    state.counters["MIPS"] = benchmark::Counter(total / 1e6, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_FactorialSliced)->ArgNames({"engine", "slice"})->ArgsProduct({kEngines, {100, 10000, 1000000}});
+
+// BM_Factorial answered by a run cache: the inputs cycle through 16 values whose runs were cached beforehand
+void BM_FactorialMemoised(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine(64, 1024, static_cast<ExecutionEngine>(state.range(0)));
+    machine.setRunCache(cache);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    auto run = [&machine, n](uint32_t input) {
+        machine.reset();
+        machine.setMemoryValue(100, n + (input & 15));
+        machine.run();
+    };
+    for (uint32_t input = 0; input < 16; ++input) run(input);
+    uint32_t input = 0;
+    for (auto _ : state) {
+        run(input++);
+    }
+    if (cache->stats().hits != static_cast<uint64_t>(state.iterations())) state.SkipWithError("cache missed");
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FactorialMemoised)->ArgNames({"engine", "n"})->ArgsProduct({kEngines, {10, 1000, 100000}});
+
+void BM_Fibonacci(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    uint32_t previous = 0, current = 1;
+    for (uint32_t k = 1; k < n; ++k) {
+        uint32_t next = previous + current;
+        previous = current;
+        current = next;
+    }
+    runProgram(state, createFibonacciProgram(100, 101), 1024,
+               [n](RiscMachine& m) { m.setMemoryValue(100, n); },
+               [current](const RiscMachine& m) { return m.getMemoryValue(101) == current; },
+               fibonacciInstructions(n));
+}
+BENCHMARK(BM_Fibonacci)->ArgNames({"engine", "n"})->ArgsProduct({kEngines, {2, 24, 47}});
+
+void BM_SumList(benchmark::State& state) {
+    const uint32_t length = static_cast<uint32_t>(state.range(1));
+    const uint32_t base = 64;
+    runProgram(state, createSumListProgram(0, 1, 2), base + length,
+               [length, base](RiscMachine& m) {
+                   m.setMemoryValue(0, base);
+                   m.setMemoryValue(1, length);
+                   m.setMemoryValue(2, 0);
+               },
+               [length](const RiscMachine& m) { return m.getMemoryValue(2) == length * 3; },
+               sumListInstructions(length),
+               [length, base](RiscMachine& m) { m.writeMemory(base, std::vector<uint32_t>(length, 3)); });
+}
+BENCHMARK(BM_SumList)->ArgNames({"engine", "length"})->ArgsProduct({kEngines, {16, 1024, 65536}});
+
+// Vector sum (length >= 0, VLMAX 8): 7 setup, 8 per strip of up to 8 elements, 2 to leave the loop, 4 to finish
+uint64_t vectorSumListInstructions(uint64_t length) { return 8 * ((length + 7) / 8) + 13; }
+
+// Dot product (length >= 0, VLMAX 8): 8 setup, 11 per strip of up to 8 elements, 2 to leave the loop, 4 to finish
+uint64_t dotProductInstructions(uint64_t length) { return 11 * ((length + 7) / 8) + 14; }
+
+void BM_VectorSumList(benchmark::State& state) {
+    const uint32_t length = static_cast<uint32_t>(state.range(1));
+    const uint32_t base = 64;
+    runProgram(state, createVectorSumListProgram(0, 1, 2), base + length,
+               [length, base](RiscMachine& m) {
+                   m.setMemoryValue(0, base);
+                   m.setMemoryValue(1, length);
+                   m.setMemoryValue(2, 0);
+               },
+               [length](const RiscMachine& m) { return m.getMemoryValue(2) == length * 3; },
+               vectorSumListInstructions(length),
+               [length, base](RiscMachine& m) { m.writeMemory(base, std::vector<uint32_t>(length, 3)); });
+}
+BENCHMARK(BM_VectorSumList)->ArgNames({"engine", "length"})->ArgsProduct({kEngines, {16, 1024, 65536}});
+
+void BM_DotProduct(benchmark::State& state) {
+    const uint32_t length = static_cast<uint32_t>(state.range(1));
+    const uint32_t base = 64;
+    runProgram(state, createDotProductProgram(0, 1, 2, 3), base + 2 * length,
+               [length, base](RiscMachine& m) {
+                   m.setMemoryValue(0, base);
+                   m.setMemoryValue(1, base + length);
+                   m.setMemoryValue(2, length);
+                   m.setMemoryValue(3, 0);
+               },
+               [length](const RiscMachine& m) { return m.getMemoryValue(3) == length * 6; },
+               dotProductInstructions(length),
+               [length, base](RiscMachine& m) {
+                   m.writeMemory(base, std::vector<uint32_t>(length, 3));
+                   m.writeMemory(base + length, std::vector<uint32_t>(length, 2));
+               });
+}
+BENCHMARK(BM_DotProduct)->ArgNames({"engine", "length"})->ArgsProduct({kEngines, {16, 1024, 65536}});
+
+// Block copy: 3 setup loads, MEMCPY, HALT, however many words are copied
+void BM_MemoryCopy(benchmark::State& state) {
+    const uint32_t length = static_cast<uint32_t>(state.range(1));
+    const uint32_t base = 64;
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 0, 0},
+        {Opcode::LOAD, 1, 1, 0},
+        {Opcode::LOAD, 2, 2, 0},
+        {Opcode::MEMCPY, 1, 0, 2},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    runProgram(state, program, base + 2 * length,
+               [length, base](RiscMachine& m) {
+                   m.setMemoryValue(0, base);
+                   m.setMemoryValue(1, base + length);
+                   m.setMemoryValue(2, length);
+               },
+               [length, base](const RiscMachine& m) { return m.getMemoryValue(base + 2 * length - 1) == 3; },
+               5,
+               [length, base](RiscMachine& m) { m.writeMemory(base, std::vector<uint32_t>(length, 3)); });
+    state.SetBytesProcessed(state.iterations() * int64_t{length} * 4);
+}
+BENCHMARK(BM_MemoryCopy)->ArgNames({"engine", "length"})->ArgsProduct({kEngines, {1024, 1 << 20}});
+
+// ─── Compile-time programs ───────────────────────────────────────────────────
+//
+// The bundled programs on a ConstexprMachine instead of a RiscMachine.
+// Argument "compiled": 0 runs the constexpr interpreter, 1 the program's
+// CompiledProgram specialisation.
+
+constexpr auto kFactorialProgram = factorialProgram(100, 101);
+constexpr auto kFibonacciProgram = fibonacciProgram(100, 101);
+constexpr auto kSumListProgram = sumListProgram(0, 1, 2);
+
+/**
+ * @brief Runs one fixed program per iteration on a ConstexprMachine and reports throughput counters.
+ *
+ * @tparam Program The program.
+ * @param state Benchmark state; range(0) selects the compiled specialisation.
+ * @param machine The machine, holding the inputs; reset before every run.
+ * @param check Returns true if the machine holds the expected result after a run.
+ * @param retired Guest instructions executed by one run.
+ */
+template <const auto& Program, size_t DataSize, typename Check>
+void runFixedProgram(benchmark::State& state, ConstexprMachine<DataSize>& machine, Check check, uint64_t retired) {
+    const bool compiled = state.range(0) != 0;
+    auto run = [&machine, compiled] {
+        machine.reset();
+        if (compiled) {
+            CompiledProgram<Program>::run(machine);
+        } else {
+            machine.run(Program);
+        }
+    };
+    run();
+    if (!check(machine)) {
+        state.SkipWithError("unexpected result");
+        return;
+    }
+
+    for (auto _ : state) {
+        run();
+        benchmark::ClobberMemory();
+    }
+
+    const double total = static_cast<double>(state.iterations()) * static_cast<double>(retired);
+    state.SetItemsProcessed(static_cast<int64_t>(total));
+    state.counters["MIPS"] = benchmark::Counter(total / 1e6, benchmark::Counter::kIsRate);
+}
+
+void BM_FixedFactorial(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    uint32_t expected = 1;
+    for (uint32_t k = 2; k <= n; ++k) expected *= k;
+    ConstexprMachine<128> machine;
+    machine.setMemoryValue(100, n);
+    runFixedProgram<kFactorialProgram>(
+        state, machine, [expected](const ConstexprMachine<128>& m) { return m.getMemoryValue(101) == expected; },
+        factorialInstructions(n));
+}
+BENCHMARK(BM_FixedFactorial)->ArgNames({"compiled", "n"})->ArgsProduct({{0, 1}, {10, 1000, 100000}});
+
+void BM_FixedFibonacci(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    uint32_t previous = 0, current = 1;
+    for (uint32_t k = 1; k < n; ++k) {
+        uint32_t next = previous + current;
+        previous = current;
+        current = next;
+    }
+    ConstexprMachine<128> machine;
+    machine.setMemoryValue(100, n);
+    runFixedProgram<kFibonacciProgram>(
+        state, machine, [current](const ConstexprMachine<128>& m) { return m.getMemoryValue(101) == current; },
+        fibonacciInstructions(n));
+}
+BENCHMARK(BM_FixedFibonacci)->ArgNames({"compiled", "n"})->ArgsProduct({{0, 1}, {2, 24, 47}});
+
+void BM_FixedSumList(benchmark::State& state) {
+    constexpr uint32_t kBase = 64, kMaxLength = 1024;
+    const uint32_t length = static_cast<uint32_t>(state.range(1));
+    auto machine = std::make_unique<ConstexprMachine<kBase + kMaxLength>>();
+    machine->setMemoryValue(0, kBase);
+    machine->setMemoryValue(1, length);
+    for (uint32_t i = 0; i < length; ++i) machine->setMemoryValue(kBase + i, 3);
+    runFixedProgram<kSumListProgram>(
+        state, *machine,
+        [length](const ConstexprMachine<kBase + kMaxLength>& m) { return m.getMemoryValue(2) == length * 3; },
+        sumListInstructions(length));
+}
+BENCHMARK(BM_FixedSumList)->ArgNames({"compiled", "length"})->ArgsProduct({{0, 1}, {16, 1024}});
+
+// ─── Host calls against guest code ───────────────────────────────────────────
+//
+// Argument "host": 0 runs the guest program, 1 one HOSTCALL to the built-in
+// kernel. A host call program is 2 setup loads, HOSTCALL, STORE R0, HALT.
+
+std::vector<Instruction> hostCallProgram(uint32_t id) {
+    return {
+        {Opcode::LOAD, 0, 0, 0},
+        {Opcode::LOAD, 1, 1, 0},
+        {Opcode::HOSTCALL, id, 0, 0},
+        {Opcode::STORE, 2, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    };
+}
+
+std::vector<uint32_t> randomWords(size_t count) {
+    std::vector<uint32_t> words(count);
+    uint32_t seed = 12345;
+    for (uint32_t& word : words) {
+        seed = seed * 1103515245u + 12345u;
+        word = seed;
+    }
+    return words;
+}
+
+// Hash(length >= 0): 6 setup, 8 per element, 2 to leave the loop, STORE, HALT
+uint64_t hashListInstructions(uint64_t length) { return 8 * length + 10; }
+
+void BM_Hash(benchmark::State& state) {
+    const bool host = state.range(1) != 0;
+    const uint32_t length = static_cast<uint32_t>(state.range(2));
+    const uint32_t base = 64;
+    const std::vector<uint32_t> input = randomWords(length);
+    uint32_t expected = 0x811C9DC5u;
+    for (uint32_t word : input) expected = (expected + word) * 0x01000193u;
+    runProgram(state, host ? hostCallProgram(kHostHashWords) : createHashListProgram(0, 1, 2), base + length,
+               [length, base](RiscMachine& m) {
+                   m.setMemoryValue(0, base);
+                   m.setMemoryValue(1, length);
+               },
+               [expected](const RiscMachine& m) { return m.getMemoryValue(2) == expected; },
+               host ? 5 : hashListInstructions(length),
+               [&input, base](RiscMachine& m) {
+                   m.setHostCalls(HostCallTable::builtins());
+                   m.writeMemory(base, input);
+               });
+}
+BENCHMARK(BM_Hash)->ArgNames({"engine", "host", "length"})->ArgsProduct({kEngines, {0, 1}, {64, 4096}});
+
+// The input is rewritten before every run, for both variants
+void BM_Sort(benchmark::State& state) {
+    const bool host = state.range(1) != 0;
+    const uint32_t length = static_cast<uint32_t>(state.range(2));
+    const uint32_t base = 64;
+    const std::vector<uint32_t> input = randomWords(length);
+    std::vector<uint32_t> expected = input;
+    std::sort(expected.begin(), expected.end());
+    const std::vector<Instruction> program =
+        host ? hostCallProgram(kHostSortWords) : createInsertionSortProgram(0, 1);
+    const auto prepare = [&input, length, base](RiscMachine& m) {
+        m.setMemoryValue(0, base);
+        m.setMemoryValue(1, length);
+        m.writeMemory(base, input);
+    };
+    // Insertion sort retires a data-dependent count; take it from one run
+    RiscMachine counter(program.size(), base + length);
+    counter.loadProgram(program);
+    counter.setHostCalls(HostCallTable::builtins());
+    prepare(counter);
+    counter.run(UINT64_MAX);
+    runProgram(state, program, base + length, prepare,
+               [&expected, base](const RiscMachine& m) {
+                   std::vector<uint32_t> sorted(expected.size());
+                   return m.readMemory(base, sorted) && sorted == expected;
+               },
+               counter.getLastRunSteps(),
+               [](RiscMachine& m) { m.setHostCalls(HostCallTable::builtins()); });
+}
+BENCHMARK(BM_Sort)->ArgNames({"engine", "host", "length"})->ArgsProduct({kEngines, {0, 1}, {64, 1024}});
+
+// Big-integer multiplication on the host; there is no guest equivalent
+void BM_BigMultiply(benchmark::State& state) {
+    const uint32_t limbs = static_cast<uint32_t>(state.range(1));
+    const uint32_t base = 64;
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, base, 2},
+        {Opcode::LOAD, 1, limbs, 2},
+        {Opcode::LOAD, 2, base + limbs, 2},
+        {Opcode::LOAD, 3, limbs, 2},
+        {Opcode::LOAD, 4, base + 2 * limbs, 2},
+        {Opcode::HOSTCALL, kHostBigMultiply, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    runProgram(state, program, base + 4 * limbs, [](RiscMachine&) {},
+               // (2^(32n) - 1)^2 has 1 as its lowest limb
+               [limbs, base](const RiscMachine& m) { return m.getMemoryValue(base + 2 * limbs) == 1; },
+               7,
+               [limbs, base](RiscMachine& m) {
+                   m.setHostCalls(HostCallTable::builtins());
+                   m.writeMemory(base, std::vector<uint32_t>(2 * limbs, 0xFFFFFFFFu));
+               });
+}
+BENCHMARK(BM_BigMultiply)->ArgNames({"engine", "limbs"})->ArgsProduct({kEngines, {16, 256}});
+
+// ─── Synthetic kernels ────────────────────────────────────────────────────────
+//
+// A shared loop runs a kernel body RAM[0] times:
+//   0-4  setup (R0 = iterations, R1 = 1, R2 = 0, R8 = 64, R3 = 0)
+//   5    CMP R0, R2      loop head
+//   6    JMP end if ZF
+//   7..  body
+//        SUB R0, R0, R1
+//        JMP 5
+//   end  HALT
+// so a run retires 5 + n * (executed body + 4) + 3 instructions.
+
+constexpr uint32_t kBodyStart = 7;
+
+std::vector<Instruction> loopKernel(const std::vector<Instruction>& body) {
+    const uint32_t end = kBodyStart + static_cast<uint32_t>(body.size()) + 2;
+    std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 0, 0},
+        {Opcode::LOAD, 1, 1, 2},
+        {Opcode::LOAD, 2, 0, 2},
+        {Opcode::LOAD, 8, 64, 2},
+        {Opcode::LOAD, 3, 0, 2},
+        {Opcode::CMP, 0, 0, 2},
+        {Opcode::JMP, end, 1, 0},
+    };
+    program.insert(program.end(), body.begin(), body.end());
+    program.push_back({Opcode::SUB, 0, 0, 1});
+    program.push_back({Opcode::JMP, 5, 0, 0});
+    program.push_back({Opcode::HALT, 0, 0, 0});
+    return program;
+}
+
+uint64_t kernelInstructions(uint64_t iterations, uint64_t executed_body) {
+    return 5 + iterations * (executed_body + 4) + 3;
+}
+
+// Register-only arithmetic: dispatch cost dominates
+const std::vector<Instruction> kDispatchBody = {
+    {Opcode::ADD, 5, 3, 4},
+    {Opcode::SUB, 6, 5, 3},
+    {Opcode::MOV, 7, 6, 0},
+    {Opcode::ADD, 3, 3, 1},
+    {Opcode::MUL, 5, 5, 7},
+    {Opcode::MOV, 9, 5, 0},
+    {Opcode::SUB, 4, 9, 6},
+    {Opcode::ADD, 10, 10, 1},
+    {Opcode::MOV, 11, 10, 0},
+    {Opcode::MUL, 12, 11, 3},
+    {Opcode::CHECK_FLAG, 13, 3, 0},
+    {Opcode::ADD, 14, 14, 13},
+};
+
+// Streams through an array with indirect loads and round-trips values through memory
+const std::vector<Instruction> kMemoryBody = {
+    {Opcode::LOAD, 3, 8, 1},      // R3 = RAM[R8]
+    {Opcode::ADD, 4, 4, 3},
+    {Opcode::STORE, 1, 4, 0},     // RAM[1] = R4
+    {Opcode::LOAD, 5, 1, 0},      // R5 = RAM[1]
+    {Opcode::ADD, 8, 8, 1},       // next element
+    {Opcode::STORE, 2, 5, 0},     // RAM[2] = R5
+    {Opcode::LOAD, 6, 8, 1},      // R6 = RAM[R8]
+    {Opcode::ADD, 4, 4, 6},
+};
+
+// R3 toggles between 0 and 1, so each conditional jump alternates taken / not taken.
+// Exactly one of the two guarded ADDs is skipped per iteration.
+const std::vector<Instruction> kBranchBody = {
+    {Opcode::SUB, 3, 1, 3},                         // +0: R3 = 1 - R3
+    {Opcode::CMP, 0, 3, 2},                         // +1
+    {Opcode::JMP, kBodyStart + 4, 1, 0},            // +2: skip +3 if R3 == 0
+    {Opcode::ADD, 4, 4, 1},                         // +3
+    {Opcode::CMP, 0, 3, 1},                         // +4
+    {Opcode::JMP, kBodyStart + 7, 1, 0},            // +5: skip +6 if R3 == 1
+    {Opcode::ADD, 5, 5, 1},                         // +6
+    {Opcode::JMP, kBodyStart + 8, 0, 0},            // +7: unconditional
+};
+
+void BM_DispatchKernel(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    runProgram(state, loopKernel(kDispatchBody), 1024,
+               [n](RiscMachine& m) { m.setMemoryValue(0, n); },
+               [](const RiscMachine&) { return true; },
+               kernelInstructions(n, kDispatchBody.size()));
+}
+BENCHMARK(BM_DispatchKernel)->ArgNames({"engine", "n"})->ArgsProduct({kEngines, {1000, 100000}});
+
+void BM_MemoryKernel(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    runProgram(state, loopKernel(kMemoryBody), 64 + n + 1,
+               [n](RiscMachine& m) { m.setMemoryValue(0, n); },
+               [](const RiscMachine&) { return true; },
+               kernelInstructions(n, kMemoryBody.size()));
+}
+BENCHMARK(BM_MemoryKernel)->ArgNames({"engine", "n"})->ArgsProduct({kEngines, {1000, 100000}});
+
+void BM_BranchKernel(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(1));
+    runProgram(state, loopKernel(kBranchBody), 1024,
+               [n](RiscMachine& m) { m.setMemoryValue(0, n); },
+               [](const RiscMachine&) { return true; },
+               kernelInstructions(n, kBranchBody.size() - 1));
+}
+BENCHMARK(BM_BranchKernel)->ArgNames({"engine", "n"})->ArgsProduct({kEngines, {1000, 100000}});
+
+// Dispatch kernel with guest profiling (mode 0), binary tracing (1) or replay
+// recording (2) enabled, writing to /dev/null; compare with BM_DispatchKernel
+// for the cost of the instrumentation. Profiling and tracing always run on the
+// switch engine.
+void BM_InstrumentedKernel(benchmark::State& state) {
+    const uint32_t n = static_cast<uint32_t>(state.range(2));
+    const int64_t mode = state.range(1);
+    runProgram(state, loopKernel(kDispatchBody), 1024,
+               [n](RiscMachine& m) { m.setMemoryValue(0, n); },
+               [](const RiscMachine&) { return true; },
+               kernelInstructions(n, kDispatchBody.size()),
+               [mode](RiscMachine& m) {
+                   if (mode == 0) m.setStatsEnabled(true);
+                   if (mode == 1) m.startTrace("/dev/null");
+                   if (mode == 2) m.startRecording("/dev/null");
+               });
+}
+BENCHMARK(BM_InstrumentedKernel)
+    ->ArgNames({"engine", "mode", "n"})
+    ->ArgsProduct({{static_cast<int64_t>(ExecutionEngine::Switch)}, {0, 1}, {100000}})
+    ->ArgsProduct({kEngines, {2}, {1000, 100000}});
+
+// ─── Fixed costs ──────────────────────────────────────────────────────────────
+
+/**
+ * @brief Builds a straight-line program of @p length instructions ending in HALT.
+ */
+std::vector<Instruction> straightLineProgram(size_t length) {
+    std::vector<Instruction> program;
+    program.reserve(length);
+    for (size_t i = 0; i + 1 < length; ++i) {
+        program.push_back(kDispatchBody[i % kDispatchBody.size()]);
+    }
+    program.push_back({Opcode::HALT, 0, 0, 0});
+    return program;
+}
+
+void BM_LoadProgram(benchmark::State& state) {
+    const std::vector<Instruction> program = straightLineProgram(static_cast<size_t>(state.range(1)));
+    RiscMachine machine(program.size(), 1024, static_cast<ExecutionEngine>(state.range(0)));
+    for (auto _ : state) {
+        machine.loadProgram(program);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_LoadProgram)->ArgNames({"engine", "length"})->ArgsProduct({kEngines, {16, 1024, 65536}});
+
+// loadProgram() answered from a warm translation cache, as in a later process
+void BM_LoadProgramCached(benchmark::State& state) {
+    const std::vector<Instruction> program = straightLineProgram(static_cast<size_t>(state.range(1)));
+    TranslationCacheOptions options;
+    options.directory = "risc_benchmark_translation_cache";
+    options.min_instructions = 0;
+    auto cache = std::make_shared<TranslationCache>(options);
+    RiscMachine machine(program.size(), 1024, static_cast<ExecutionEngine>(state.range(0)));
+    machine.setTranslationCache(cache);
+    machine.loadProgram(program);
+    for (auto _ : state) {
+        machine.loadProgram(program);
+    }
+    if (cache->stats().hits != static_cast<uint64_t>(state.iterations())) state.SkipWithError("cache missed");
+    cache->clear();
+    ::rmdir(options.directory.c_str());
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+BENCHMARK(BM_LoadProgramCached)
+    ->ArgNames({"engine", "length"})
+    ->ArgsProduct({{static_cast<int64_t>(ExecutionEngine::Threaded), static_cast<int64_t>(ExecutionEngine::Jit)},
+                   {16, 1024, 65536}});
+
+void BM_Reset(benchmark::State& state) {
+    RiscMachine machine;
+    machine.loadProgram(createFactorialProgram(100, 101));
+    for (auto _ : state) {
+        machine.reset();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_Reset);
+
+void BM_Construct(benchmark::State& state) {
+    const size_t data_size = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        RiscMachine machine(256, data_size);
+        benchmark::DoNotOptimize(machine);
+    }
+}
+BENCHMARK(BM_Construct)->ArgName("data_size")->Arg(1 << 10)->Arg(1 << 20)->Arg(1 << 28);
+
+// Loading an input array: per-word setMemoryValue() (bulk = 0) against one writeMemory() (bulk = 1)
+void BM_HostWrite(benchmark::State& state) {
+    const bool bulk = state.range(0) != 0;
+    const std::vector<uint32_t> input(static_cast<size_t>(state.range(1)), 7);
+    RiscMachine machine(256, input.size());
+    for (auto _ : state) {
+        if (bulk) {
+            machine.writeMemory(0, input);
+        } else {
+            for (uint32_t i = 0; i < input.size(); ++i) machine.setMemoryValue(i, input[i]);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(input.size()) * 4);
+}
+BENCHMARK(BM_HostWrite)->ArgNames({"bulk", "words"})->ArgsProduct({{0, 1}, {1024, 1 << 20}});
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -29,28 +29,8 @@
  * - Halts the program.
  */
 std::vector<Instruction> createFactorialProgram(uint32_t input_addr, uint32_t result_addr) {
-    return {
-        {Opcode::LOAD, 0, 1, 2},                // R0 = 1 (result)
-        {Opcode::LOAD, 1, input_addr, 0},       // R1 = n
-        {Opcode::LOAD, 2, 1, 2},                // R2 = 1
-        {Opcode::LOAD, 3, 0, 2},                // R3 = 0
-
-        // if n == 0 → result = 0
-        {Opcode::CMP, 0, 1, 3},                 // if R0 == R2 (0)
-        {Opcode::JMP, 11, 1, 0},                // jump to store if ZF
-
-        // loop_start
-        {Opcode::CMP, 0, 1, 2},                 // if R1 == 1
-        {Opcode::JMP, 11, 1, 0},                 // if ZF == 1 → skip MUL/SUB
-
-        {Opcode::MUL, 0, 0, 1},                 // result *= i
-        {Opcode::SUB, 1, 1, 2},                 // i--
-        {Opcode::JMP, 6, 0, 0},                 // jump to loop_start
-
-        // loop_end
-        {Opcode::STORE, result_addr, 0, 0},     // RAM[result_addr] = result
-        {Opcode::HALT, 0, 0, 0}
-    };
+    const auto program = factorialProgram(input_addr, result_addr);
+    return std::vector<Instruction>(program.begin(), program.end());
 }
 
 
@@ -71,31 +51,8 @@ std::vector<Instruction> createFactorialProgram(uint32_t input_addr, uint32_t re
  * - The result is stored in the memory address specified by `result_addr`.
  */
 std::vector<Instruction> createSumListProgram(uint32_t array_addr, uint32_t length_addr, uint32_t result_addr) {
-    return {
-        {Opcode::LOAD, 0, array_addr, 0},      // R0 = array address
-        {Opcode::LOAD, 1, length_addr, 0},     // counter = length
-        {Opcode::LOAD, 2, result_addr, 0},     // R2 = result pointer
-        {Opcode::LOAD, 3, 1, 2},               // R3 = 1 (for pointer++ and counter--)
-        
-        // loop_start @ pc = 4
-        {Opcode::LOAD, 4, 0, 1},              // R4 = RAM[R0]
-        {Opcode::ADD, 2, 2, 4},               // sum += R4
-        
-        {Opcode::CHECK_FLAG, 5, 1, 0},         // check if sum overflowed
-        {Opcode::CMP, 0, 5, 3},               // if overflow
-        {Opcode::JMP, 15, 1, 0},              // if ZF, jump to end
-
-        {Opcode::ADD, 0, 0, 3},               // array_ptr++
-
-        {Opcode::CMP, 0, 1, 3},               // if counter == 1
-        {Opcode::JMP, 14, 1, 0},              // if ZF, jump to end
-
-        {Opcode::SUB, 1, 1, 3},               // counter--
-        {Opcode::JMP, 4, 0, 0},               // loop
-
-        {Opcode::STORE, result_addr, 2, 0},   // store sum
-        {Opcode::HALT, 0, 0, 0}
-    };
+    const auto program = sumListProgram(array_addr, length_addr, result_addr);
+    return std::vector<Instruction>(program.begin(), program.end());
 }
 
 
@@ -118,46 +75,310 @@ std::vector<Instruction> createSumListProgram(uint32_t array_addr, uint32_t leng
  * - The result is stored in the memory address specified by `result_addr`.
  */
 std::vector<Instruction> createFibonacciProgram(uint32_t input_addr, uint32_t result_addr) {
+    const auto program = fibonacciProgram(input_addr, result_addr);
+    return std::vector<Instruction>(program.begin(), program.end());
+}
+
+
+/**
+ * @brief Generates a program that sums an array with vector instructions.
+ *
+ * @param array_addr The memory address holding the address of the array.
+ * @param length_addr The memory address holding the length of the array.
+ * @param result_addr The memory address where the sum is stored.
+ * @return A vector of instructions representing the program.
+ *
+ * @details
+ * - The loop is strip-mined: VSETVL takes min(remaining, VLMAX) elements per
+ *   step, so the program works for any vector length and needs no scalar tail.
+ * - V0 accumulates element-wise at full length; the short last strip leaves
+ *   the elements above it untouched, and one VREDUCE at VLMAX sums V0.
+ * - The sum wraps at 32 bits (there is no per-element carry).
+ */
+std::vector<Instruction> createVectorSumListProgram(uint32_t array_addr, uint32_t length_addr, uint32_t result_addr) {
+    return {
+        {Opcode::LOAD, 0, array_addr, 0},      // R0 = array address
+        {Opcode::LOAD, 1, length_addr, 0},     // R1 = remaining elements
+        {Opcode::LOAD, 2, 1, 2},               // R2 = stride 1
+        {Opcode::LOAD, 3, 0, 2},               // R3 = 0
+        {Opcode::LOAD, 4, UINT32_MAX, 2},      // R4 = "as many as possible"
+        {Opcode::VSETVL, 5, 4, 0},             // vl = VLMAX
+        {Opcode::VSUB, 0, 0, 0},               // V0 = 0
+
+        // loop_start @ pc = 7
+        {Opcode::CMP, 0, 1, 3},                // if remaining == 0
+        {Opcode::JMP, 15, 1, 0},               // done
+        {Opcode::VSETVL, 5, 1, 0},             // R5 = vl = min(remaining, VLMAX)
+        {Opcode::VLOAD, 1, 0, 2},              // V1 = RAM[R0 .. R0 + vl)
+        {Opcode::VADD, 0, 0, 1},               // V0 += V1
+        {Opcode::ADD, 0, 0, 5},                // pointer += vl
+        {Opcode::SUB, 1, 1, 5},                // remaining -= vl
+        {Opcode::JMP, 7, 0, 0},                // loop
+
+        // done @ pc = 15
+        {Opcode::VSETVL, 5, 4, 0},             // vl = VLMAX
+        {Opcode::VREDUCE, 6, 0, 0},            // R6 = sum of V0
+        {Opcode::STORE, result_addr, 6, 0},    // store sum
+        {Opcode::HALT, 0, 0, 0}
+    };
+}
+
+/**
+ * @brief Generates a program that computes a dot product with vector instructions.
+ *
+ * @param lhs_addr The memory address holding the address of the first array.
+ * @param rhs_addr The memory address holding the address of the second array.
+ * @param length_addr The memory address holding the length of the arrays.
+ * @param result_addr The memory address where the dot product is stored.
+ * @return A vector of instructions representing the program.
+ *
+ * @details
+ * - Same strip-mined loop as createVectorSumListProgram(), multiplying the
+ *   strips of both arrays element-wise before accumulating.
+ * - Products and the sum wrap at 32 bits.
+ */
+std::vector<Instruction> createDotProductProgram(uint32_t lhs_addr, uint32_t rhs_addr, uint32_t length_addr,
+                                                 uint32_t result_addr) {
+    return {
+        {Opcode::LOAD, 0, lhs_addr, 0},        // R0 = first array address
+        {Opcode::LOAD, 1, rhs_addr, 0},        // R1 = second array address
+        {Opcode::LOAD, 2, length_addr, 0},     // R2 = remaining elements
+        {Opcode::LOAD, 3, 1, 2},               // R3 = stride 1
+        {Opcode::LOAD, 4, 0, 2},               // R4 = 0
+        {Opcode::LOAD, 5, UINT32_MAX, 2},      // R5 = "as many as possible"
+        {Opcode::VSETVL, 6, 5, 0},             // vl = VLMAX
+        {Opcode::VSUB, 0, 0, 0},               // V0 = 0
+
+        // loop_start @ pc = 8
+        {Opcode::CMP, 0, 2, 4},                // if remaining == 0
+        {Opcode::JMP, 19, 1, 0},               // done
+        {Opcode::VSETVL, 6, 2, 0},             // R6 = vl = min(remaining, VLMAX)
+        {Opcode::VLOAD, 1, 0, 3},              // V1 = strip of the first array
+        {Opcode::VLOAD, 2, 1, 3},              // V2 = strip of the second array
+        {Opcode::VMUL, 1, 1, 2},               // V1 *= V2
+        {Opcode::VADD, 0, 0, 1},               // V0 += V1
+        {Opcode::ADD, 0, 0, 6},                // pointers += vl
+        {Opcode::ADD, 1, 1, 6},
+        {Opcode::SUB, 2, 2, 6},                // remaining -= vl
+        {Opcode::JMP, 8, 0, 0},                // loop
+
+        // done @ pc = 19
+        {Opcode::VSETVL, 6, 5, 0},             // vl = VLMAX
+        {Opcode::VREDUCE, 7, 0, 0},            // R7 = sum of V0
+        {Opcode::STORE, result_addr, 7, 0},    // store dot product
+        {Opcode::HALT, 0, 0, 0}
+    };
+}
+
+/**
+ * @brief Generates a program that sums an array across harts.
+ *
+ * @param array_addr The memory address holding the address of the array.
+ * @param length_addr The memory address holding the length of the array.
+ * @param harts_addr The memory address holding the number of harts.
+ * @param result_addr The memory address that accumulates the sum.
+ * @return A vector of instructions representing the program.
+ *
+ * @details
+ * - Hart h sums the slice [h * chunk, (h + 1) * chunk) with chunk = length / harts;
+ *   the last hart also takes the remainder.
+ * - The slice loop has the shape of createSumListProgram() without the overflow
+ *   exit, so each hart's loop runs on the reduction kernel.
+ * - Partial sums are combined with ATOMIC_ADD; the total wraps at 32 bits.
+ */
+std::vector<Instruction> createParallelSumListProgram(uint32_t array_addr, uint32_t length_addr,
+                                                      uint32_t harts_addr, uint32_t result_addr) {
+    return {
+        {Opcode::LOAD, 0, array_addr, 0},      // R0 = array address
+        {Opcode::LOAD, 1, length_addr, 0},     // R1 = length
+        {Opcode::LOAD, 2, harts_addr, 0},      // R2 = harts
+        {Opcode::LOAD, 3, 1, 2},               // R3 = 1
+        {Opcode::HART_ID, 4, 0, 0},            // R4 = hart
+        {Opcode::DIV, 5, 1, 2},                // R5 = chunk
+        {Opcode::MUL, 6, 4, 5},                // R6 = first index
+        {Opcode::ADD, 0, 0, 6},                // R0 = pointer to the slice
+        {Opcode::ADD, 7, 4, 3},                // R7 = hart + 1
+        {Opcode::CMP, 0, 7, 2},                // last hart?
+        {Opcode::JMP, 13, 1, 0},
+        {Opcode::MOV, 8, 5, 0},                // counter = chunk
+        {Opcode::JMP, 14, 0, 0},
+        {Opcode::SUB, 8, 1, 6},                // counter = length - first index
+
+        // @ pc = 14
+        {Opcode::LOAD, 9, 0, 2},               // R9 = sum = 0
+        {Opcode::LOAD, 10, 0, 2},              // R10 = 0
+        {Opcode::CMP, 0, 8, 10},               // empty slice?
+        {Opcode::JMP, 25, 1, 0},
+
+        // loop_start @ pc = 18
+        {Opcode::LOAD, 11, 0, 1},              // R11 = RAM[R0]
+        {Opcode::ADD, 9, 9, 11},               // sum += R11
+        {Opcode::ADD, 0, 0, 3},                // pointer++
+        {Opcode::CMP, 0, 8, 3},                // if counter == 1
+        {Opcode::JMP, 25, 1, 0},               // done
+        {Opcode::SUB, 8, 8, 3},                // counter--
+        {Opcode::JMP, 18, 0, 0},               // loop
+
+        // publish @ pc = 25
+        {Opcode::LOAD, 12, result_addr, 2},    // R12 = result address
+        {Opcode::ATOMIC_ADD, 13, 12, 9},       // RAM[result] += sum
+        {Opcode::HALT, 0, 0, 0}
+    };
+}
+
+/**
+ * @brief Generates a program that computes a Fibonacci table across harts.
+ *
+ * @param input_addr The memory address holding the number of entries.
+ * @param harts_addr The memory address holding the number of harts.
+ * @param table_addr The memory address of the first table entry.
+ * @param progress_addr The memory address of the progress counter.
+ * @return A vector of instructions representing the program.
+ *
+ * @details
+ * - Entry i is written by hart i % harts once the progress counter reaches i,
+ *   i.e. once entries 0 to i - 1 are published.
+ * - The writer adds the entry to its (zero) table word and then increments
+ *   the progress counter with ATOMIC_ADD; readers spin on the counter with
+ *   plain loads and FENCE before reading the entries it covers.
+ * - Entries wrap at 32 bits.
+ */
+std::vector<Instruction> createParallelFibonacciTableProgram(uint32_t input_addr, uint32_t harts_addr,
+                                                             uint32_t table_addr, uint32_t progress_addr) {
     return {
-        {Opcode::LOAD, 0, input_addr, 0},       // R0 = n
-        {Opcode::LOAD, 1, 1, 2},                // R1 = 1 (constant 1)
-        {Opcode::LOAD, 2, 0, 2},                // R2 = 0 (fib_prev)
-        {Opcode::LOAD, 3, 1, 2},                // R3 = 1 (fib_curr)
-
-        // if n == 0 → result = 0
-        {Opcode::CMP, 0, 2, 0},                 // if R0 == R2 (0)
-        {Opcode::JMP, 21, 1, 0},                // jump to store if ZF
-
-        // if n == 1 → result = 1
-        {Opcode::CMP, 0, 1, 0},                 // if R0 == R1 (1)
-        {Opcode::JMP, 19, 1, 0},                // jump to store if ZF
-
-        // Loop setup
-        {Opcode::LOAD, 4, 1, 2},                // R4 = R1 = R1
- 
-        // loop_start
-        {Opcode::CMP, 0, 4, 0},                 // if i == n
-        {Opcode::JMP, 19, 1, 0},                // exit if ZF
-
-        {Opcode::ADD, 5, 2, 3},                 // R5 = fib_prev + fib_curr
-
-        {Opcode::CHECK_FLAG, 6, 1, 0},         // check if sum overflowed
-        {Opcode::CMP, 0, 6, 1},               // if overflow
-        {Opcode::JMP, 20, 1, 0},              // if ZF, jump to end
-        
-        {Opcode::MOV, 2, 3, 0},                 // fib_prev = fib_curr
-        {Opcode::MOV, 3, 5, 0},                 // fib_curr = next
-        
-        {Opcode::ADD, 4, 4, 1},                 // i++
-        {Opcode::JMP, 9, 0, 0},                 // jump to loop_start
-
-        // store result
-        {Opcode::STORE, result_addr, 3, 0},
+        {Opcode::LOAD, 0, input_addr, 0},      // R0 = n
+        {Opcode::LOAD, 1, 1, 2},               // R1 = 1
+        {Opcode::LOAD, 2, harts_addr, 0},      // R2 = harts
+        {Opcode::HART_ID, 3, 0, 0},            // R3 = i = hart
+        {Opcode::LOAD, 4, table_addr, 2},      // R4 = table address
+        {Opcode::LOAD, 5, progress_addr, 2},   // R5 = progress address
+        {Opcode::LOAD, 12, 2, 2},              // R12 = 2
+
+        // loop_start @ pc = 7: continue while i < n (borrow of i - n)
+        {Opcode::SUB, 6, 3, 0},
+        {Opcode::CHECK_FLAG, 6, 1, 0},
+        {Opcode::CMP, 0, 6, 1},
+        {Opcode::JMP, 12, 1, 0},
         {Opcode::HALT, 0, 0, 0},
 
-        // if n = 0 store result coming from control flow
-        {Opcode::MOV, 3, 2, 0},                 // R3 = R2 = 0  (fib_curr)
-        {Opcode::JMP, 19, 1, 0},                // exit if ZF
-        {Opcode::HALT, 0, 0, 0},                
+        // wait @ pc = 12: spin until progress == i
+        {Opcode::LOAD, 7, progress_addr, 0},
+        {Opcode::CMP, 0, 7, 3},
+        {Opcode::JMP, 16, 1, 0},
+        {Opcode::JMP, 12, 0, 0},
+
+        // @ pc = 16: entries below i are visible after the fence
+        {Opcode::FENCE, 0, 0, 0},
+        {Opcode::ADD, 8, 4, 3},                // R8 = &table[i]
+        {Opcode::SUB, 9, 3, 12},               // borrow if i < 2
+        {Opcode::CHECK_FLAG, 9, 1, 0},
+        {Opcode::CMP, 0, 9, 1},
+        {Opcode::JMP, 28, 1, 0},
+        {Opcode::SUB, 10, 8, 1},
+        {Opcode::LOAD, 10, 10, 1},             // R10 = table[i - 1]
+        {Opcode::SUB, 11, 8, 12},
+        {Opcode::LOAD, 11, 11, 1},             // R11 = table[i - 2]
+        {Opcode::ADD, 10, 10, 11},             // R10 = table[i]
+        {Opcode::JMP, 29, 0, 0},
+        {Opcode::MOV, 10, 3, 0},               // @ pc = 28: table[i] = i for i < 2
+
+        // publish @ pc = 29
+        {Opcode::ATOMIC_ADD, 11, 8, 10},       // table[i] += value
+        {Opcode::ATOMIC_ADD, 11, 5, 1},        // progress++
+        {Opcode::ADD, 3, 3, 2},                // i += harts
+        {Opcode::JMP, 7, 0, 0}
     };
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Generates a program that hashes an array like the kHostHashWords host kernel.
+ *
+ * @param array_addr The memory address holding the address of the array.
+ * @param length_addr The memory address holding the length of the array.
+ * @param result_addr The memory address where the hash will be stored.
+ * @return A vector of instructions representing the program.
+ *
+ * @details
+ * - h starts at 0x811C9DC5; each word is added and the sum multiplied by
+ *   0x01000193, wrapping at 32 bits.
+ * - An empty array stores the initial value.
+ */
+std::vector<Instruction> createHashListProgram(uint32_t array_addr, uint32_t length_addr, uint32_t result_addr) {
+    return {
+        {Opcode::LOAD, 0, array_addr, 0},      // R0 = array address
+        {Opcode::LOAD, 1, length_addr, 0},     // R1 = words left
+        {Opcode::LOAD, 2, 0x811C9DC5u, 2},     // R2 = h
+        {Opcode::LOAD, 3, 0x01000193u, 2},     // R3 = multiplier
+        {Opcode::LOAD, 4, 1, 2},               // R4 = 1
+        {Opcode::LOAD, 5, 0, 2},               // R5 = 0
+
+        // loop_start @ pc = 6
+        {Opcode::CMP, 0, 1, 5},                // if no words left
+        {Opcode::JMP, 14, 1, 0},               // done
+        {Opcode::LOAD, 6, 0, 1},               // R6 = RAM[R0]
+        {Opcode::ADD, 2, 2, 6},                // h += word
+        {Opcode::MUL, 2, 2, 3},                // h *= multiplier
+        {Opcode::ADD, 0, 0, 4},                // pointer++
+        {Opcode::SUB, 1, 1, 4},                // words left--
+        {Opcode::JMP, 6, 0, 0},                // loop
+
+        // @ pc = 14
+        {Opcode::STORE, result_addr, 2, 0},    // store h
+        {Opcode::HALT, 0, 0, 0}
+    };
+}
+
+/**
+ * @brief Generates a program that sorts an array in place with insertion sort.
+ *
+ * @param array_addr The memory address holding the address of the array.
+ * @param length_addr The memory address holding the length of the array.
+ * @return A vector of instructions representing the program.
+ *
+ * @details
+ * - Words compare as unsigned: a < b when a - b borrows (CF).
+ * - STORE takes only a direct address, so stores through a pointer are
+ *   one-word MEMSETs.
+ */
+std::vector<Instruction> createInsertionSortProgram(uint32_t array_addr, uint32_t length_addr) {
+    return {
+        {Opcode::LOAD, 0, array_addr, 0},      // R0 = array address
+        {Opcode::LOAD, 1, length_addr, 0},     // R1 = n
+        {Opcode::LOAD, 7, 1, 2},               // R7 = 1
+        {Opcode::LOAD, 11, 0, 2},              // R11 = 0
+        {Opcode::LOAD, 2, 1, 2},               // R2 = i = 1
+
+        // outer @ pc = 5: continue while i < n
+        {Opcode::SUB, 8, 2, 1},
+        {Opcode::CHECK_FLAG, 9, 1, 0},         // R9 = CF (i < n)
+        {Opcode::CMP, 0, 9, 11},
+        {Opcode::JMP, 29, 1, 0},               // i >= n: done
+        {Opcode::ADD, 10, 0, 2},
+        {Opcode::LOAD, 4, 10, 1},              // R4 = key = a[i]
+        {Opcode::MOV, 3, 2, 0},                // R3 = j = i
+
+        // inner @ pc = 12: shift a[j - 1] up while j > 0 and key < a[j - 1]
+        {Opcode::CMP, 0, 3, 11},
+        {Opcode::JMP, 25, 1, 0},               // j == 0: place key
+        {Opcode::ADD, 5, 0, 3},
+        {Opcode::SUB, 5, 5, 7},                // R5 = &a[j - 1]
+        {Opcode::LOAD, 6, 5, 1},               // R6 = a[j - 1]
+        {Opcode::SUB, 8, 4, 6},
+        {Opcode::CHECK_FLAG, 9, 1, 0},         // R9 = CF (key < a[j - 1])
+        {Opcode::CMP, 0, 9, 11},
+        {Opcode::JMP, 25, 1, 0},               // key >= a[j - 1]: place key
+        {Opcode::ADD, 8, 5, 7},
+        {Opcode::MEMSET, 8, 6, 7},             // a[j] = a[j - 1]
+        {Opcode::SUB, 3, 3, 7},                // j--
+        {Opcode::JMP, 12, 0, 0},
+
+        // place @ pc = 25
+        {Opcode::ADD, 8, 0, 3},
+        {Opcode::MEMSET, 8, 4, 7},             // a[j] = key
+        {Opcode::ADD, 2, 2, 7},                // i++
+        {Opcode::JMP, 5, 0, 0},
+
+        // @ pc = 29
+        {Opcode::HALT, 0, 0, 0}
+    };
+}
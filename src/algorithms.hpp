@@ -4,6 +4,7 @@
  */
 #pragma once
 
+#include <array>
 #include <vector>
 #include "instruction.hpp"
 
@@ -21,4 +22,155 @@ std::vector<Instruction> createSumListProgram(uint32_t array_addr, uint32_t leng
 // Returns a vector of instructions to compute the nth Fibonacci number.
 // input_addr: Address where the input number (n) is stored.
 // result_addr: Address where the result will be stored.
-std::vector<Instruction> createFibonacciProgram(uint32_t input_addr, uint32_t result_addr);
\ No newline at end of file
+std::vector<Instruction> createFibonacciProgram(uint32_t input_addr, uint32_t result_addr);
+
+// The instructions of createFactorialProgram() as an array, usable in constant expressions
+// (ConstexprMachine and CompiledProgram, constexpr_machine.hpp).
+constexpr std::array<Instruction, 13> factorialProgram(uint32_t input_addr, uint32_t result_addr) {
+    return {{
+        {Opcode::LOAD, 0, 1, 2},                // R0 = 1 (result)
+        {Opcode::LOAD, 1, input_addr, 0},       // R1 = n
+        {Opcode::LOAD, 2, 1, 2},                // R2 = 1
+        {Opcode::LOAD, 3, 0, 2},                // R3 = 0
+
+        // if n == 0 → result = 0
+        {Opcode::CMP, 0, 1, 3},                 // if R0 == R2 (0)
+        {Opcode::JMP, 11, 1, 0},                // jump to store if ZF
+
+        // loop_start
+        {Opcode::CMP, 0, 1, 2},                 // if R1 == 1
+        {Opcode::JMP, 11, 1, 0},                 // if ZF == 1 → skip MUL/SUB
+
+        {Opcode::MUL, 0, 0, 1},                 // result *= i
+        {Opcode::SUB, 1, 1, 2},                 // i--
+        {Opcode::JMP, 6, 0, 0},                 // jump to loop_start
+
+        // loop_end
+        {Opcode::STORE, result_addr, 0, 0},     // RAM[result_addr] = result
+        {Opcode::HALT, 0, 0, 0}
+    }};
+}
+
+// The instructions of createSumListProgram() as an array, usable in constant expressions
+// (ConstexprMachine and CompiledProgram, constexpr_machine.hpp).
+constexpr std::array<Instruction, 16> sumListProgram(uint32_t array_addr, uint32_t length_addr, uint32_t result_addr) {
+    return {{
+        {Opcode::LOAD, 0, array_addr, 0},      // R0 = array address
+        {Opcode::LOAD, 1, length_addr, 0},     // counter = length
+        {Opcode::LOAD, 2, result_addr, 0},     // R2 = result pointer
+        {Opcode::LOAD, 3, 1, 2},               // R3 = 1 (for pointer++ and counter--)
+        
+        // loop_start @ pc = 4
+        {Opcode::LOAD, 4, 0, 1},              // R4 = RAM[R0]
+        {Opcode::ADD, 2, 2, 4},               // sum += R4
+        
+        {Opcode::CHECK_FLAG, 5, 1, 0},         // check if sum overflowed
+        {Opcode::CMP, 0, 5, 3},               // if overflow
+        {Opcode::JMP, 15, 1, 0},              // if ZF, jump to end
+
+        {Opcode::ADD, 0, 0, 3},               // array_ptr++
+
+        {Opcode::CMP, 0, 1, 3},               // if counter == 1
+        {Opcode::JMP, 14, 1, 0},              // if ZF, jump to end
+
+        {Opcode::SUB, 1, 1, 3},               // counter--
+        {Opcode::JMP, 4, 0, 0},               // loop
+
+        {Opcode::STORE, result_addr, 2, 0},   // store sum
+        {Opcode::HALT, 0, 0, 0}
+    }};
+}
+
+// The instructions of createFibonacciProgram() as an array, usable in constant expressions
+// (ConstexprMachine and CompiledProgram, constexpr_machine.hpp).
+constexpr std::array<Instruction, 24> fibonacciProgram(uint32_t input_addr, uint32_t result_addr) {
+    return {{
+        {Opcode::LOAD, 0, input_addr, 0},       // R0 = n
+        {Opcode::LOAD, 1, 1, 2},                // R1 = 1 (constant 1)
+        {Opcode::LOAD, 2, 0, 2},                // R2 = 0 (fib_prev)
+        {Opcode::LOAD, 3, 1, 2},                // R3 = 1 (fib_curr)
+
+        // if n == 0 → result = 0
+        {Opcode::CMP, 0, 2, 0},                 // if R0 == R2 (0)
+        {Opcode::JMP, 21, 1, 0},                // jump to store if ZF
+
+        // if n == 1 → result = 1
+        {Opcode::CMP, 0, 1, 0},                 // if R0 == R1 (1)
+        {Opcode::JMP, 19, 1, 0},                // jump to store if ZF
+
+        // Loop setup
+        {Opcode::LOAD, 4, 1, 2},                // R4 = R1 = R1
+ 
+        // loop_start
+        {Opcode::CMP, 0, 4, 0},                 // if i == n
+        {Opcode::JMP, 19, 1, 0},                // exit if ZF
+
+        {Opcode::ADD, 5, 2, 3},                 // R5 = fib_prev + fib_curr
+
+        {Opcode::CHECK_FLAG, 6, 1, 0},         // check if sum overflowed
+        {Opcode::CMP, 0, 6, 1},               // if overflow
+        {Opcode::JMP, 20, 1, 0},              // if ZF, jump to end
+        
+        {Opcode::MOV, 2, 3, 0},                 // fib_prev = fib_curr
+        {Opcode::MOV, 3, 5, 0},                 // fib_curr = next
+        
+        {Opcode::ADD, 4, 4, 1},                 // i++
+        {Opcode::JMP, 9, 0, 0},                 // jump to loop_start
+
+        // store result
+        {Opcode::STORE, result_addr, 3, 0},
+        {Opcode::HALT, 0, 0, 0},
+
+        // if n = 0 store result coming from control flow
+        {Opcode::MOV, 3, 2, 0},                 // R3 = R2 = 0  (fib_curr)
+        {Opcode::JMP, 19, 1, 0},                // exit if ZF
+        {Opcode::HALT, 0, 0, 0}
+    }};
+}
+
+// Returns a vector of instructions that sums an array with vector instructions, VLMAX elements per step.
+// Unlike createSumListProgram(), the sum wraps at 32 bits and an empty array stores 0.
+// array_addr: Address where the array address is stored.
+// length_addr: Address where the length of the array is stored.
+// result_addr: Address where the result will be stored.
+std::vector<Instruction> createVectorSumListProgram(uint32_t array_addr, uint32_t length_addr, uint32_t result_addr);
+
+// Returns a vector of instructions that computes the dot product of two arrays with vector instructions.
+// The products and their sum wrap at 32 bits.
+// lhs_addr: Address where the address of the first array is stored.
+// rhs_addr: Address where the address of the second array is stored.
+// length_addr: Address where the length of both arrays is stored.
+// result_addr: Address where the result will be stored.
+std::vector<Instruction> createDotProductProgram(uint32_t lhs_addr, uint32_t rhs_addr, uint32_t length_addr,
+                                                 uint32_t result_addr);
+
+// Returns a vector of instructions that sums an array on several harts (RiscMachine::runHarts()).
+// Each hart sums a contiguous slice and atomically adds its (wrapping) partial sum to RAM[result_addr].
+// array_addr: Address where the array address is stored.
+// length_addr: Address where the length of the array is stored.
+// harts_addr: Address where the number of harts is stored.
+// result_addr: Address of the total; must hold 0 before the run.
+std::vector<Instruction> createParallelSumListProgram(uint32_t array_addr, uint32_t length_addr,
+                                                      uint32_t harts_addr, uint32_t result_addr);
+
+// Returns a vector of instructions that fills a table with Fibonacci numbers on several harts.
+// Hart h computes the entries h, h + harts, h + 2 * harts, ..., waiting for the two entries
+// before each one through a progress counter published with atomics and fences.
+// input_addr: Address where the number of entries (n) is stored.
+// harts_addr: Address where the number of harts is stored.
+// table_addr: Address of the table; its n words must hold 0 before the run.
+// progress_addr: Address of the progress counter; must hold 0 before the run.
+std::vector<Instruction> createParallelFibonacciTableProgram(uint32_t input_addr, uint32_t harts_addr,
+                                                             uint32_t table_addr, uint32_t progress_addr);
+// Returns a vector of instructions that hashes an array word by word, as the host kernel kHostHashWords does:
+// h = 0x811C9DC5, then h = (h + word) * 0x01000193 for each word (wrapping).
+// array_addr: Address where the array address is stored.
+// length_addr: Address where the length of the array is stored.
+// result_addr: Address where the hash will be stored.
+std::vector<Instruction> createHashListProgram(uint32_t array_addr, uint32_t length_addr, uint32_t result_addr);
+
+// Returns a vector of instructions that sorts an array in place in ascending unsigned order (insertion sort),
+// the guest counterpart of the host kernel kHostSortWords.
+// array_addr: Address where the array address is stored.
+// length_addr: Address where the length of the array is stored.
+std::vector<Instruction> createInsertionSortProgram(uint32_t array_addr, uint32_t length_addr);
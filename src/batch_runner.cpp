@@ -0,0 +1,171 @@
+/**
+ * @file batch_runner.cpp
+ * @brief Implementation of the work-stealing batch execution engine.
+ */
+
+#include "batch_runner.hpp"
+#include <algorithm>
+
+/**
+ * @brief Creates the worker threads; they sleep until the first batch arrives.
+ *
+ * @param options Worker count, chunking and machine configuration.
+ */
+BatchRunner::BatchRunner(BatchOptions options) : options(options) {
+    size_t count = options.workers;
+    if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+
+    workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < count; ++i) {
+        workers[i]->thread = std::thread(&BatchRunner::workerLoop, this, i);
+    }
+}
+
+/**
+ * @brief Wakes all workers with the stop request and joins them.
+ */
+BatchRunner::~BatchRunner() {
+    {
+        std::lock_guard<std::mutex> lock(state_mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief Gets the number of worker threads.
+ *
+ * @return The worker count.
+ */
+size_t BatchRunner::workerCount() const {
+    return workers.size();
+}
+
+/**
+ * @brief Splits the jobs into chunks, hands them to the workers and waits.
+ *
+ * Each worker initially receives a contiguous range of chunks so neighbouring
+ * jobs stay on one thread; load imbalance is evened out by stealing.
+ *
+ * @param program The program every job runs.
+ * @param count Number of jobs.
+ * @param job Callback executing job i on a reset worker machine.
+ */
+void BatchRunner::runJobs(const std::vector<Instruction>& program, size_t count, const Job& job) {
+    if (count == 0) return;
+    std::lock_guard<std::mutex> run_lock(run_mutex);
+
+    const size_t worker_count = workers.size();
+    size_t chunk = options.chunk_size;
+    if (chunk == 0) chunk = std::max<size_t>(1, count / (worker_count * 8));
+    const size_t chunk_count = (count + chunk - 1) / chunk;
+
+    for (size_t c = 0; c < chunk_count; ++c) {
+        Worker& owner = *workers[c * worker_count / chunk_count];
+        std::lock_guard<std::mutex> lock(owner.mutex);
+        owner.chunks.emplace_back(c * chunk, std::min(count, (c + 1) * chunk));
+    }
+
+    std::unique_lock<std::mutex> lock(state_mutex);
+    current_program = &program;
+    current_job = &job;
+    failure = nullptr;
+    busy_workers = worker_count;
+    ++generation;
+    work_ready.notify_all();
+    work_done.wait(lock, [this] { return busy_workers == 0; });
+    current_program = nullptr;
+    current_job = nullptr;
+
+    if (failure) std::rethrow_exception(failure);
+}
+
+/**
+ * @brief Takes the next chunk for a worker, stealing from others when its own deque is empty.
+ *
+ * @param index The worker asking for work.
+ * @param chunk Receives the job range.
+ * @return False when no work is left anywhere.
+ */
+bool BatchRunner::takeChunk(size_t index, Chunk& chunk) {
+    {
+        Worker& self = *workers[index];
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (!self.chunks.empty()) {
+            chunk = self.chunks.front();
+            self.chunks.pop_front();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < workers.size(); ++offset) {
+        Worker& victim = *workers[(index + offset) % workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.chunks.empty()) {
+            chunk = victim.chunks.back();
+            victim.chunks.pop_back();
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * Waits for a new batch, loads the program into the worker's machine once,
+ * executes chunks until none are left and reports completion.
+ *
+ * @param index The worker's position in the pool.
+ */
+void BatchRunner::workerLoop(size_t index) {
+    Worker& self = *workers[index];
+    uint64_t seen_generation = 0;
+
+    for (;;) {
+        const std::vector<Instruction>* program = nullptr;
+        const Job* job = nullptr;
+        {
+            std::unique_lock<std::mutex> lock(state_mutex);
+            work_ready.wait(lock, [&] { return stopping || generation != seen_generation; });
+            if (stopping) return;
+            seen_generation = generation;
+            program = current_program;
+            job = current_job;
+        }
+
+        try {
+            if (!self.machine) {
+                self.machine = std::make_unique<RiscMachine>(options.program_size, options.data_size,
+                                                             options.engine);
+            }
+            RiscMachine& machine = *self.machine;
+            machine.loadProgram(*program);
+
+            Chunk chunk;
+            while (takeChunk(index, chunk)) {
+                for (size_t i = chunk.first; i < chunk.second; ++i) {
+                    machine.reset();
+                    if (options.clear_memory) machine.clearMemory();
+                    (*job)(machine, i);
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(state_mutex);
+            if (!failure) failure = std::current_exception();
+            // Drop remaining work so the batch finishes promptly
+            for (auto& worker : workers) {
+                std::lock_guard<std::mutex> chunk_lock(worker->mutex);
+                worker->chunks.clear();
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(state_mutex);
+        if (--busy_workers == 0) work_done.notify_all();
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * @file batch_runner.hpp
+ * @brief Declares BatchRunner, which runs one program over many inputs on a thread pool.
+ *
+ * Every worker thread owns one RiscMachine that is reused for all the jobs it
+ * executes. Jobs are split into chunks that are handed out through per-worker
+ * deques; idle workers steal chunks from the back of other workers' deques.
+ */
+
+#pragma once
+
+#include "machine.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct BatchOptions
+ * @brief Configuration of a BatchRunner.
+ */
+struct BatchOptions {
+    size_t workers = 0;        /**< Worker threads (0: one per hardware thread) */
+    size_t chunk_size = 0;     /**< Jobs per chunk (0: chosen from job and worker count) */
+    size_t program_size = 256; /**< Program memory size of each worker machine */
+    size_t data_size = 1024;   /**< Data memory size of each worker machine */
+    ExecutionEngine engine = ExecutionEngine::Threaded; /**< Engine of each worker machine */
+    bool clear_memory = true;  /**< Zero data memory before every job */
+};
+
+/**
+ * @class BatchRunner
+ * @brief Runs the same guest program over many inputs in parallel.
+ *
+ * Example:
+ * @code
+ * BatchRunner runner;
+ * std::vector<uint32_t> inputs = {1, 2, 3, 4, 5};
+ * auto results = runner.run(createFactorialProgram(100, 101), inputs,
+ *     [](RiscMachine& m, uint32_t n) { m.setMemoryValue(100, n); },
+ *     [](const RiscMachine& m) { return m.getMemoryValue(101); });
+ * @endcode
+ */
+class BatchRunner {
+public:
+    /**
+     * @brief Starts the worker threads.
+     * @param options Worker count, chunking and machine configuration.
+     */
+    explicit BatchRunner(BatchOptions options = {});
+
+    /**
+     * @brief Stops and joins the worker threads.
+     */
+    ~BatchRunner();
+
+    BatchRunner(const BatchRunner&) = delete;
+    BatchRunner& operator=(const BatchRunner&) = delete;
+
+    /**
+     * @brief Runs a program once per input and collects the results in input order.
+     *
+     * For every input the worker resets its machine (and clears data memory if
+     * configured), calls @p init, runs the program and stores @p extract's result.
+     *
+     * @param program The program to run for every input.
+     * @param inputs Pointer to the first input.
+     * @param count Number of inputs.
+     * @param init Callable (RiscMachine&, const Input&) that writes the input into memory.
+     * @param extract Callable (const RiscMachine&) returning the job result.
+     * @return One result per input, in input order.
+     */
+    template <typename Input, typename Init, typename Extract>
+    auto run(const std::vector<Instruction>& program, const Input* inputs, size_t count,
+             Init init, Extract extract)
+        -> std::vector<std::decay_t<std::invoke_result_t<Extract&, const RiscMachine&>>> {
+        using Output = std::decay_t<std::invoke_result_t<Extract&, const RiscMachine&>>;
+        std::vector<Output> results(count);
+        runJobs(program, count, [&](RiscMachine& machine, size_t index) {
+            init(machine, inputs[index]);
+            machine.run();
+            results[index] = extract(static_cast<const RiscMachine&>(machine));
+        });
+        return results;
+    }
+
+    /**
+     * @brief Runs a program once per element of @p inputs.
+     * @see run(const std::vector<Instruction>&, const Input*, size_t, Init, Extract)
+     */
+    template <typename Input, typename Init, typename Extract>
+    auto run(const std::vector<Instruction>& program, const std::vector<Input>& inputs,
+             Init init, Extract extract) {
+        return run(program, inputs.data(), inputs.size(), std::move(init), std::move(extract));
+    }
+
+    /**
+     * @brief Gets the number of worker threads.
+     * @return The worker count.
+     */
+    size_t workerCount() const;
+
+private:
+    using Job = std::function<void(RiscMachine&, size_t)>;
+    using Chunk = std::pair<size_t, size_t>;  // [begin, end)
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Chunk> chunks;
+        std::unique_ptr<RiscMachine> machine;
+        std::thread thread;
+    };
+
+    /**
+     * @brief Distributes @p count jobs over the workers and waits for completion.
+     */
+    void runJobs(const std::vector<Instruction>& program, size_t count, const Job& job);
+
+    void workerLoop(size_t index);
+    bool takeChunk(size_t index, Chunk& chunk);
+
+    BatchOptions options;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex run_mutex;      // serialises concurrent run() calls
+    std::mutex state_mutex;    // guards the fields below
+    std::condition_variable work_ready;
+    std::condition_variable work_done;
+    uint64_t generation = 0;
+    size_t busy_workers = 0;
+    bool stopping = false;
+    const std::vector<Instruction>* current_program = nullptr;
+    const Job* current_job = nullptr;
+    std::exception_ptr failure;
+};
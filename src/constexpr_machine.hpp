@@ -0,0 +1,580 @@
+/**
+ * @file constexpr_machine.hpp
+ * @brief Declares ConstexprMachine, a machine usable in constant expressions, and CompiledProgram.
+ *
+ * ConstexprMachine<DataSize> executes the instruction set of RiscMachine, with
+ * the same results and the same LazyFlags, over a data memory of DataSize
+ * words held in the object. Every member function is constexpr, so a program
+ * with constant inputs can be evaluated at compile time:
+ *
+ *     static constexpr auto kFactorial = factorialProgram(100, 101);
+ *     constexpr uint32_t kFactorial10 = [] {
+ *         ConstexprMachine<128> machine;
+ *         machine.setMemoryValue(100, 10);
+ *         machine.run(kFactorial);
+ *         return machine.getMemoryValue(101);
+ *     }();
+ *
+ * CompiledProgram<kFactorial> specialises execution for one program known at
+ * compile time. Each basic block becomes straight-line code: the opcode of
+ * every instruction is resolved with `if constexpr` and its operands are
+ * template constants, so register indices, immediates, direct addresses and
+ * jump targets are folded into the generated code. Control reaches a block
+ * through a table of function pointers indexed by the program counter, once
+ * per block rather than once per instruction. CompiledProgram::run() is
+ * constexpr as well.
+ *
+ * Differences from RiscMachine: there is one hart, so HART_ID is 0, ATOMIC_ADD
+ * and CAS are plain read-modify-writes and FENCE does nothing; nothing can be
+ * bound to HOSTCALL, which therefore always faults; runs are never traced,
+ * profiled, recorded, cached or offloaded to the reduction kernel. Runs at
+ * compile time are bounded by the compiler's constant evaluation limits (with
+ * GCC, -fconstexpr-loop-limit iterations of the run loop and
+ * -fconstexpr-ops-limit operations).
+ */
+
+#pragma once
+
+#include "flags.hpp"
+#include "instruction.hpp"
+#include "machine.hpp"
+#include "vector_unit.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+template <const auto& Program>
+class CompiledProgram;
+
+/**
+ * @class ConstexprMachine
+ * @brief A RISC machine whose state and execution are constexpr.
+ *
+ * @tparam DataSize Data memory size in words.
+ */
+template <size_t DataSize>
+class ConstexprMachine {
+public:
+    static constexpr size_t kDataSize = DataSize;  /**< Data memory size in words */
+
+    /**
+     * @brief Runs a program from the current program counter.
+     *
+     * Stops at HALT, at the end of the program, on a fault or after
+     * @p max_steps instructions, like RiscMachine::run(max_steps).
+     *
+     * @param program The program's first instruction.
+     * @param length Number of instructions.
+     * @param max_steps Maximum number of instructions to execute.
+     * @return Whether the program halted, faulted or ran out of budget.
+     */
+    constexpr RunStatus run(const Instruction* program, size_t length, uint64_t max_steps = UINT64_MAX) {
+        fault = false;
+        uint64_t steps = 0;
+        while (pc < length) {
+            if (steps == max_steps) break;
+            ++steps;
+            const Instruction instr = program[pc];
+            pc++;
+            execute(instr, length);
+            if (instr.opcode == Opcode::HALT) break;
+        }
+        if (pc < length) return RunStatus::BudgetExhausted;
+        return fault ? RunStatus::Faulted : RunStatus::Halted;
+    }
+
+    /**
+     * @brief Runs a program held in an array from the current program counter.
+     * @param program The program.
+     * @param max_steps Maximum number of instructions to execute.
+     * @return Whether the program halted, faulted or ran out of budget.
+     */
+    template <size_t N>
+    constexpr RunStatus run(const std::array<Instruction, N>& program, uint64_t max_steps = UINT64_MAX) {
+        return run(program.data(), N, max_steps);
+    }
+
+    /**
+     * @brief Resets the program counter, registers and flags, like RiscMachine::reset().
+     *
+     * Data memory and the vector unit are kept.
+     */
+    constexpr void reset() {
+        pc = 0;
+        fault = false;
+        flags.reset();
+        registers = {};
+    }
+
+    /**
+     * @brief Sets every word of data memory to zero.
+     */
+    constexpr void clearMemory() { memory = {}; }
+
+    /**
+     * @brief Sets a value in data memory.
+     * @param address The address; ignored if outside data memory.
+     * @param value The value.
+     */
+    constexpr void setMemoryValue(uint32_t address, uint32_t value) {
+        if (address < DataSize) memory[address] = value;
+    }
+
+    /**
+     * @brief Retrieves a value from data memory.
+     * @param address The address.
+     * @return The value, or 0 if @p address is outside data memory.
+     */
+    constexpr uint32_t getMemoryValue(uint32_t address) const {
+        return address < DataSize ? memory[address] : 0;
+    }
+
+    /**
+     * @brief Retrieves a data register.
+     * @param index Register index (R0–R15).
+     * @return The value, or 0 if @p index is out of range.
+     */
+    constexpr uint32_t getRegister(uint32_t index) const {
+        return index < registers.size() ? registers[index] : 0;
+    }
+
+    /**
+     * @brief Gets the status register.
+     * @return The evaluated flags.
+     */
+    constexpr StatusRegister getStatusRegister() const { return flags.get(); }
+
+    /**
+     * @brief Gets the program counter.
+     * @return The index of the next instruction; the program length once it halted.
+     */
+    constexpr uint32_t getPc() const { return pc; }
+
+    /**
+     * @brief Checks whether the last run faulted.
+     * @return True if an access of the last run faulted.
+     */
+    constexpr bool isFaulted() const { return fault; }
+
+    /**
+     * @brief Sets VLMAX and makes it the active vector length, like RiscMachine::setVectorLength().
+     * @param elements Elements per vector register; clamped to [1, VectorUnit::kMaxLength].
+     */
+    constexpr void setVectorLength(uint32_t elements) {
+        max_length = elements < 1 ? 1 : elements > VectorUnit::kMaxLength ? VectorUnit::kMaxLength : elements;
+        active_length = max_length;
+    }
+
+    /**
+     * @brief Gets the maximum vector length (VLMAX).
+     * @return Elements per vector register.
+     */
+    constexpr uint32_t getVectorLength() const { return max_length; }
+
+    /**
+     * @brief Gets a vector register.
+     * @param index Register index (V0–V7).
+     * @return All VectorUnit::kMaxLength elements, or zeros if @p index is out of range.
+     */
+    constexpr VectorUnit::Register getVectorRegister(uint32_t index) const {
+        return index < VectorUnit::kRegisters ? vectors[index] : VectorUnit::Register{};
+    }
+
+private:
+    template <const auto& Program>
+    friend class CompiledProgram;
+
+    /**
+     * @brief Executes one instruction; pc already points past it.
+     * @param instr The instruction.
+     * @param length Program length, where HALT and faults leave the program counter.
+     */
+    constexpr void execute(const Instruction& instr, size_t length) {
+        switch (instr.opcode) {
+            case Opcode::HALT:
+                pc = static_cast<uint32_t>(length);
+                break;
+            case Opcode::JMP:
+                if (instr.dst < length && jumpTaken(instr.src1)) pc = instr.dst;
+                break;
+            default:
+                if (!operate(instr)) {
+                    pc = static_cast<uint32_t>(length);
+                    fault = true;
+                }
+                break;
+        }
+    }
+
+    /**
+     * @brief Executes an instruction other than HALT and JMP.
+     * @param instr The instruction.
+     * @return False if it faulted.
+     */
+    constexpr bool operate(const Instruction& instr) {
+        switch (instr.opcode) {
+            case Opcode::LOAD: return load(instr.dst, instr.src1, instr.src2);
+            case Opcode::STORE: store(instr.dst, instr.src1); return true;
+            case Opcode::ADD: add(instr.dst, instr.src1, instr.src2); return true;
+            case Opcode::SUB: sub(instr.dst, instr.src1, instr.src2); return true;
+            case Opcode::CMP: compare(instr.src1, instr.src2); return true;
+            case Opcode::MUL: mul(instr.dst, instr.src1, instr.src2); return true;
+            case Opcode::DIV: div(instr.dst, instr.src1, instr.src2); return true;
+            case Opcode::MOV: move(instr.dst, instr.src1); return true;
+            case Opcode::CHECK_FLAG: checkFlag(instr.dst, instr.src1); return true;
+            case Opcode::ATOMIC_ADD:
+            case Opcode::CAS: return atomic(instr.opcode, instr.dst, instr.src1, instr.src2);
+            case Opcode::FENCE: return true;
+            case Opcode::HART_ID: hartId(instr.dst); return true;
+            case Opcode::VLOAD:
+            case Opcode::VSTORE:
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+            case Opcode::VREDUCE:
+            case Opcode::VSETVL: return vector(instr.opcode, instr.dst, instr.src1, instr.src2);
+            case Opcode::MEMCPY:
+            case Opcode::MEMSET:
+            case Opcode::MEMCMP: return bulk(instr.opcode, instr.dst, instr.src1, instr.src2);
+            default: return false;  // HOSTCALL: nothing can be bound
+        }
+    }
+
+    constexpr bool reg(uint32_t index) const { return index < registers.size(); }
+
+    constexpr bool jumpTaken(uint32_t condition) const {
+        return condition == 0 || (condition == 1 && flags.zero());
+    }
+
+    // LOAD: mode 0 direct, 1 indirect (faults outside data memory), 2 immediate
+    constexpr bool load(uint32_t dst, uint32_t src1, uint32_t mode) {
+        if (!reg(dst)) return true;
+        if (mode == 0 && src1 < DataSize) {
+            registers[dst] = memory[src1];
+        } else if (mode == 1 && reg(src1)) {
+            if (registers[src1] >= DataSize) return false;
+            registers[dst] = memory[registers[src1]];
+        } else if (mode == 2) {
+            registers[dst] = src1;
+        }
+        return true;
+    }
+
+    constexpr void store(uint32_t address, uint32_t src) {
+        if (address < DataSize && reg(src)) memory[address] = registers[src];
+    }
+
+    constexpr void add(uint32_t dst, uint32_t lhs, uint32_t rhs) {
+        if (!reg(dst) || !reg(lhs) || !reg(rhs)) return;
+        const uint32_t a = registers[lhs], b = registers[rhs];
+        registers[dst] = a + b;
+        flags.setAdd(a, b);
+    }
+
+    constexpr void sub(uint32_t dst, uint32_t lhs, uint32_t rhs) {
+        if (!reg(dst) || !reg(lhs) || !reg(rhs)) return;
+        const uint32_t a = registers[lhs], b = registers[rhs];
+        registers[dst] = a - b;
+        flags.setSub(a, b);
+    }
+
+    constexpr void mul(uint32_t dst, uint32_t lhs, uint32_t rhs) {
+        if (!reg(dst) || !reg(lhs) || !reg(rhs)) return;
+        const uint32_t a = registers[lhs], b = registers[rhs];
+        registers[dst] = a * b;
+        flags.setMul(a, b);
+    }
+
+    constexpr void div(uint32_t dst, uint32_t lhs, uint32_t rhs) {
+        if (!reg(dst) || !reg(lhs) || !reg(rhs)) return;
+        const uint32_t dividend = registers[lhs], divisor = registers[rhs];
+        if (divisor == 0) {
+            flags.setDivByZero();  // dst unchanged
+            return;
+        }
+        registers[dst] = dividend / divisor;
+        flags.setDiv(dividend / divisor);
+    }
+
+    constexpr void compare(uint32_t lhs, uint32_t rhs) {
+        flags.setZero(reg(lhs) && reg(rhs) && registers[lhs] == registers[rhs]);
+    }
+
+    constexpr void move(uint32_t dst, uint32_t src) {
+        if (reg(dst) && reg(src)) registers[dst] = registers[src];
+    }
+
+    constexpr void checkFlag(uint32_t dst, uint32_t index) {
+        if (reg(dst)) registers[dst] = flags.read(index);
+    }
+
+    constexpr void hartId(uint32_t dst) {
+        if (reg(dst)) registers[dst] = 0;
+    }
+
+    // ATOMIC_ADD and CAS on RAM[R[address]]; faults like an indirect LOAD
+    constexpr bool atomic(Opcode op, uint32_t dst, uint32_t address, uint32_t src) {
+        if (!reg(dst) || !reg(address) || !reg(src)) return true;
+        const uint32_t at = registers[address];
+        if (at >= DataSize) return false;
+        const uint32_t old = memory[at];
+        if (op == Opcode::ATOMIC_ADD) {
+            memory[at] = old + registers[src];
+        } else {
+            const bool swapped = old == registers[dst];
+            if (swapped) memory[at] = registers[src];
+            flags.setZero(swapped);
+        }
+        registers[dst] = old;
+        return true;
+    }
+
+    // VLOAD … VSETVL on the first vl elements; VLOAD and VSTORE fault before touching anything
+    constexpr bool vector(Opcode op, uint32_t dst, uint32_t src1, uint32_t src2) {
+        auto vreg = [](uint32_t index) { return index < VectorUnit::kRegisters; };
+        const uint32_t length = active_length;
+        switch (op) {
+            case Opcode::VLOAD: {
+                if (!vreg(dst) || !reg(src1) || !reg(src2)) return true;
+                const uint32_t address = registers[src1], stride = registers[src2];
+                if (length == 0) return true;
+                if (uint64_t(address) + uint64_t(length - 1) * stride >= DataSize) return false;
+                for (uint32_t i = 0; i < length; ++i) vectors[dst][i] = memory[address + i * stride];
+                return true;
+            }
+            case Opcode::VSTORE: {
+                if (!reg(dst) || !vreg(src1) || !reg(src2)) return true;
+                const uint32_t address = registers[dst], stride = registers[src2];
+                if (length == 0) return true;
+                if (uint64_t(address) + uint64_t(length - 1) * stride >= DataSize) return false;
+                for (uint32_t i = 0; i < length; ++i) memory[address + i * stride] = vectors[src1][i];
+                return true;
+            }
+            case Opcode::VREDUCE: {
+                if (!reg(dst) || !vreg(src1)) return true;
+                uint32_t sum = 0;
+                for (uint32_t i = 0; i < length; ++i) sum += vectors[src1][i];
+                registers[dst] = sum;
+                return true;
+            }
+            case Opcode::VSETVL:
+                if (!reg(dst) || !reg(src1)) return true;
+                active_length = registers[src1] < max_length ? registers[src1] : max_length;
+                registers[dst] = active_length;
+                return true;
+            default: {
+                if (!vreg(dst) || !vreg(src1) || !vreg(src2)) return true;
+                VectorUnit::Register result = vectors[dst];  // dst may also be a source
+                for (uint32_t i = 0; i < length; ++i) {
+                    const uint32_t a = vectors[src1][i], b = vectors[src2][i];
+                    result[i] = op == Opcode::VADD ? a + b : op == Opcode::VSUB ? a - b : a * b;
+                }
+                vectors[dst] = result;
+                return true;
+            }
+        }
+    }
+
+    // MEMCPY, MEMSET and MEMCMP on register operands; fault before touching anything
+    constexpr bool bulk(Opcode op, uint32_t dst, uint32_t src1, uint32_t src2) {
+        if (!reg(dst) || !reg(src1) || !reg(src2)) return true;
+        const uint32_t lhs = registers[dst], rhs = registers[src1], count = registers[src2];
+        if (count == 0) {
+            if (op == Opcode::MEMCMP) {
+                flags.setZero(true);
+                flags.setSub(0, 0);
+            }
+            return true;
+        }
+        if (uint64_t(lhs) + count > DataSize || (op != Opcode::MEMSET && uint64_t(rhs) + count > DataSize)) {
+            return false;
+        }
+        if (op == Opcode::MEMSET) {
+            for (uint32_t i = 0; i < count; ++i) memory[lhs + i] = rhs;
+        } else if (op == Opcode::MEMCPY) {
+            // Overlapping ranges behave like memmove
+            if (lhs < rhs) {
+                for (uint32_t i = 0; i < count; ++i) memory[lhs + i] = memory[rhs + i];
+            } else if (lhs > rhs) {
+                for (uint32_t i = count; i-- > 0;) memory[lhs + i] = memory[rhs + i];
+            }
+        } else {
+            uint32_t at = 0;
+            while (at < count && memory[lhs + at] == memory[rhs + at]) ++at;
+            const bool equal = at == count;
+            flags.setZero(equal);
+            flags.setSub(equal ? 0 : memory[lhs + at], equal ? 0 : memory[rhs + at]);
+        }
+        return true;
+    }
+
+    std::array<uint32_t, 16> registers{};  // R0–R15
+    LazyFlags flags;
+    std::array<VectorUnit::Register, VectorUnit::kRegisters> vectors{};  // V0–V7
+    uint32_t max_length = VectorUnit::kDefaultLength;  // VLMAX
+    uint32_t active_length = VectorUnit::kDefaultLength;  // vl
+    uint32_t pc = 0;
+    bool fault = false;  // set when the last run faulted
+    std::array<uint32_t, DataSize> memory{};
+};
+
+/**
+ * @class CompiledProgram
+ * @brief Straight-line code specialised for one program known at compile time.
+ *
+ * @tparam Program A `constexpr std::array<Instruction, N>` with static storage
+ *         duration, e.g. `static constexpr auto kProgram = factorialProgram(100, 101);`.
+ */
+template <const auto& Program>
+class CompiledProgram {
+    using ProgramType = std::remove_cv_t<std::remove_reference_t<decltype(Program)>>;
+
+public:
+    static constexpr size_t kLength = std::tuple_size<ProgramType>::value;  /**< Number of instructions */
+
+    static_assert(std::is_same<ProgramType, std::array<Instruction, kLength>>::value,
+                  "CompiledProgram takes a std::array<Instruction, N>");
+
+    /**
+     * @brief Runs the program on a machine from its current program counter, like RiscMachine::run().
+     * @param machine The machine; its data memory holds the inputs.
+     * @return Halted, or Faulted if an access faulted.
+     */
+    template <size_t DataSize>
+    static constexpr RunStatus run(ConstexprMachine<DataSize>& machine) {
+        machine.fault = false;
+        uint32_t pc = machine.pc;
+        while (pc < kLength) pc = kEntries<DataSize>[pc](machine);
+        machine.pc = pc;
+        return machine.fault ? RunStatus::Faulted : RunStatus::Halted;
+    }
+
+    /**
+     * @brief Checks whether an instruction starts a basic block.
+     * @param index Instruction index.
+     * @return True for the entry, jump targets and instructions after a JMP or HALT.
+     */
+    static constexpr bool isLeader(size_t index) { return kLeaders[index]; }
+
+private:
+    template <size_t DataSize>
+    using Entry = uint32_t (*)(ConstexprMachine<DataSize>&);  // runs from one pc, returns the next
+
+    static constexpr std::array<bool, kLength> findLeaders() {
+        std::array<bool, kLength> leaders{};
+        if (kLength > 0) leaders[0] = true;
+        for (size_t i = 0; i < kLength; ++i) {
+            const Instruction& instr = Program[i];
+            if (instr.opcode != Opcode::JMP && instr.opcode != Opcode::HALT) continue;
+            if (instr.opcode == Opcode::JMP && instr.dst < kLength) leaders[instr.dst] = true;
+            if (i + 1 < kLength) leaders[i + 1] = true;
+        }
+        return leaders;
+    }
+
+    // Index of the JMP or HALT that ends the block starting at start, or kLength
+    static constexpr size_t blockEnd(size_t start) {
+        size_t end = start;
+        while (end < kLength && Program[end].opcode != Opcode::JMP && Program[end].opcode != Opcode::HALT) ++end;
+        return end;
+    }
+
+    template <size_t DataSize>
+    static constexpr uint32_t faulted(ConstexprMachine<DataSize>& machine) {
+        machine.fault = true;
+        return static_cast<uint32_t>(kLength);
+    }
+
+    // Instruction I other than HALT and JMP, with every operand a constant; false if it faulted
+    template <size_t I, size_t DataSize>
+    static constexpr bool operate(ConstexprMachine<DataSize>& machine) {
+        constexpr Instruction in = Program[I];
+        if constexpr (in.opcode == Opcode::LOAD) {
+            return machine.load(in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::STORE) {
+            machine.store(in.dst, in.src1);
+        } else if constexpr (in.opcode == Opcode::ADD) {
+            machine.add(in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::SUB) {
+            machine.sub(in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::CMP) {
+            machine.compare(in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::MUL) {
+            machine.mul(in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::DIV) {
+            machine.div(in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::MOV) {
+            machine.move(in.dst, in.src1);
+        } else if constexpr (in.opcode == Opcode::CHECK_FLAG) {
+            machine.checkFlag(in.dst, in.src1);
+        } else if constexpr (in.opcode == Opcode::ATOMIC_ADD || in.opcode == Opcode::CAS) {
+            return machine.atomic(in.opcode, in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::HART_ID) {
+            machine.hartId(in.dst);
+        } else if constexpr (in.opcode >= Opcode::VLOAD && in.opcode <= Opcode::VSETVL) {
+            return machine.vector(in.opcode, in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode >= Opcode::MEMCPY && in.opcode <= Opcode::MEMCMP) {
+            return machine.bulk(in.opcode, in.dst, in.src1, in.src2);
+        } else if constexpr (in.opcode == Opcode::HOSTCALL) {
+            return false;
+        }
+        return true;  // FENCE, and the instructions that cannot fault
+    }
+
+    // The JMP or HALT at End (or the end of the program); returns the next pc
+    template <size_t End, size_t DataSize>
+    static constexpr uint32_t terminate(ConstexprMachine<DataSize>& machine) {
+        if constexpr (End >= kLength) {
+            return static_cast<uint32_t>(kLength);
+        } else {
+            constexpr Instruction in = Program[End];
+            if constexpr (in.opcode == Opcode::HALT) {
+                return static_cast<uint32_t>(kLength);
+            } else if constexpr (in.dst < kLength && in.src1 == 0) {
+                return in.dst;
+            } else if constexpr (in.dst < kLength && in.src1 == 1) {
+                return machine.flags.zero() ? in.dst : static_cast<uint32_t>(End + 1);
+            } else {
+                return static_cast<uint32_t>(End + 1);  // invalid target or condition: a no-op
+            }
+        }
+    }
+
+    template <size_t Start, size_t DataSize, size_t... Offsets>
+    static constexpr bool straightLine(ConstexprMachine<DataSize>& machine, std::index_sequence<Offsets...>) {
+        return (operate<Start + Offsets>(machine) && ...);
+    }
+
+    // A block: its instructions in sequence, then its JMP or HALT
+    template <size_t Start, size_t DataSize>
+    static constexpr uint32_t block(ConstexprMachine<DataSize>& machine) {
+        constexpr size_t end = blockEnd(Start);
+        if (!straightLine<Start>(machine, std::make_index_sequence<end - Start>{})) return faulted(machine);
+        return terminate<end>(machine);
+    }
+
+    // Entry at pc I: a whole block at a leader, a single instruction elsewhere (a run resumed mid-block)
+    template <size_t I, size_t DataSize>
+    static constexpr uint32_t entry(ConstexprMachine<DataSize>& machine) {
+        if constexpr (kLeaders[I]) {
+            return block<I>(machine);
+        } else if constexpr (Program[I].opcode == Opcode::JMP || Program[I].opcode == Opcode::HALT) {
+            return terminate<I>(machine);
+        } else {
+            return operate<I>(machine) ? static_cast<uint32_t>(I + 1) : faulted(machine);
+        }
+    }
+
+    template <size_t DataSize, size_t... Is>
+    static constexpr std::array<Entry<DataSize>, kLength> makeEntries(std::index_sequence<Is...>) {
+        return {{&entry<Is, DataSize>...}};
+    }
+
+    static constexpr std::array<bool, kLength> kLeaders = findLeaders();
+
+    template <size_t DataSize>
+    static constexpr std::array<Entry<DataSize>, kLength> kEntries =
+        makeEntries<DataSize>(std::make_index_sequence<kLength>{});
+};
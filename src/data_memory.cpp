@@ -0,0 +1,407 @@
+/**
+ * @file data_memory.cpp
+ * @brief Implementation of the paged copy-on-write data memory.
+ */
+
+#include "data_memory.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Gets the page table of an untouched range: every entry points at one zero page.
+ *
+ * Neither the table nor the page is ever written; stores always go through
+ * DataMemory::makeWritable(), which allocates real storage first.
+ */
+uint32_t* const* zeroTable() {
+    static uint32_t zero_page[DataMemory::kPageWords] = {};
+    static const std::array<uint32_t*, DataMemory::kTablePages> table = [] {
+        std::array<uint32_t*, DataMemory::kTablePages> entries;
+        entries.fill(zero_page);
+        return entries;
+    }();
+    return table.data();
+}
+
+/**
+ * @brief Gets the write table of a range this memory may not write in place: all null.
+ */
+uint32_t* const* nullTable() {
+    static uint32_t* const table[DataMemory::kTablePages] = {};
+    return table;
+}
+
+/**
+ * @brief Gets the number of words from an address to the end of its page.
+ */
+uint32_t wordsToPageEnd(uint64_t address) {
+    return DataMemory::kPageWords - static_cast<uint32_t>(address & DataMemory::kPageMask);
+}
+
+/**
+ * @brief Copies words out of a page; words of a shared memory are loaded one relaxed atomic at a time.
+ */
+void loadWords(uint32_t* out, const uint32_t* words, size_t count, bool shared) {
+    if (!shared) {
+        std::memcpy(out, words, count * sizeof(uint32_t));
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) out[i] = __atomic_load_n(&words[i], __ATOMIC_RELAXED);
+}
+
+/**
+ * @brief Copies words into a page; words of a shared memory are stored one relaxed atomic at a time.
+ */
+void storeWords(uint32_t* words, const uint32_t* values, size_t count, bool shared) {
+    if (!shared) {
+        std::memcpy(words, values, count * sizeof(uint32_t));
+        return;
+    }
+    for (size_t i = 0; i < count; ++i) __atomic_store_n(&words[i], values[i], __ATOMIC_RELAXED);
+}
+
+}  // namespace
+
+/**
+ * @brief Creates an empty directory; every range reads the zero page.
+ *
+ * @param size Number of 32-bit words.
+ */
+DataMemory::DataMemory(size_t size) : word_count(size) {
+    const size_t range = size_t{1} << kDirectoryShift;
+    const size_t count = (size + range - 1) / range;
+    tables.resize(count);
+    directory.assign(count, zeroTable());
+    write_directory.assign(count, nullTable());
+}
+
+/**
+ * @brief Creates a memory sharing every page with @p other.
+ *
+ * @param other The memory to share pages with.
+ */
+DataMemory::DataMemory(const DataMemory& other) {
+    shareFrom(other);
+}
+
+/**
+ * @brief Replaces the contents with pages shared with @p other.
+ *
+ * @param other The memory to share pages with.
+ * @return This memory.
+ */
+DataMemory& DataMemory::operator=(const DataMemory& other) {
+    if (this != &other) shareFrom(other);
+    return *this;
+}
+
+/**
+ * @brief Copies the directory of @p other; neither memory may write a page in place afterwards.
+ *
+ * @param other The memory to share pages with.
+ */
+void DataMemory::shareFrom(const DataMemory& other) {
+    other.revokeWriteAccess();
+    tables = other.tables;
+    directory = other.directory;
+    write_directory.assign(directory.size(), nullTable());
+    writable = false;
+    shared = false;
+    word_count = other.word_count;
+    copied_pages = 0;
+}
+
+/**
+ * @brief Clears every write pointer, before the tables are shared with a copy.
+ *
+ * The next write to each page checks again whether the page is still shared.
+ * Memories without write access (e.g. snapshots) are left untouched, so they
+ * can be shared from several threads at once.
+ */
+void DataMemory::revokeWriteAccess() const {
+    shared = false;  // the views are gone: pages are copied on write again
+    if (!writable) return;
+    for (size_t i = 0; i < tables.size(); ++i) {
+        if (write_directory[i] == nullTable()) continue;  // nothing writable in this range
+        std::fill(std::begin(tables[i]->write), std::end(tables[i]->write), nullptr);
+        write_directory[i] = nullTable();
+    }
+    writable = false;
+}
+
+/**
+ * @brief Ensures a page table is exclusively owned, allocating or copying it.
+ *
+ * @param index Directory index of the table.
+ * @return The table; its pages may still be shared.
+ */
+DataMemory::PageTable& DataMemory::makeTableWritable(size_t index) {
+    std::shared_ptr<PageTable>& table = tables[index];
+    if (!table) {
+        table = std::make_shared<PageTable>();
+        std::copy(zeroTable(), zeroTable() + kTablePages, table->read);
+        std::fill(std::begin(table->write), std::end(table->write), nullptr);
+    } else if (table.use_count() != 1) {
+        table = std::make_shared<PageTable>(*table);  // shares every page of the original
+        std::fill(std::begin(table->write), std::end(table->write), nullptr);
+    }
+    directory[index] = table->read;
+    write_directory[index] = table->write;
+    return *table;
+}
+
+/**
+ * @brief Ensures a page and its table are exclusively owned, allocating or copying them.
+ *
+ * @param page Page index.
+ * @return The words of the writable page.
+ */
+uint32_t* DataMemory::makeWritable(uint32_t page) {
+    if (shared) return publishPage(page);
+    PageTable& table = makeTableWritable(page >> kTableShift);
+    const size_t entry = page & kTableMask;
+
+    std::shared_ptr<Page>& owned = table.pages[entry];
+    if (!owned) {
+        owned = std::make_shared<Page>();  // value-initialised: zero
+    } else if (owned.use_count() != 1) {
+        owned = std::make_shared<Page>(*owned);
+        ++copied_pages;
+    }
+    table.read[entry] = owned->words;
+    table.write[entry] = owned->words;
+    writable = true;
+    return owned->words;
+}
+
+/**
+ * @brief Allocates a never-written page of a shared memory, racing the other views.
+ *
+ * sharedView() left every table exclusive and every written page writable, so
+ * a null write pointer means the page was never written. A new zero page is
+ * published with a compare-exchange on the write pointer; a view that loses
+ * frees its page and uses the winner's. Either way the read pointer is set
+ * before returning, so no store through the page can hide behind the zero
+ * page from a reader that synchronised with it.
+ *
+ * @param page Page index.
+ * @return The words of the published page.
+ */
+uint32_t* DataMemory::publishPage(uint32_t page) {
+    PageTable& table = *tables[page >> kTableShift];
+    const size_t entry = page & kTableMask;
+    auto fresh = std::make_shared<Page>();  // value-initialised: zero
+    uint32_t* const created = fresh->words;
+    uint32_t* words = nullptr;
+    if (__atomic_compare_exchange_n(&table.write[entry], &words, created, false,
+                                    __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        words = created;
+        table.pages[entry] = std::move(fresh);  // only the winner touches the owner slot
+    }
+    __atomic_store_n(&table.read[entry], words, __ATOMIC_RELEASE);
+    return words;
+}
+
+/**
+ * @brief Reads @p count words starting at @p address, page by page.
+ *
+ * @param address First word address.
+ * @param out Receives the words.
+ * @param count Number of words.
+ */
+void DataMemory::readRange(uint32_t address, uint32_t* out, size_t count) const {
+    while (count) {
+        const size_t chunk = std::min<size_t>(count, wordsToPageEnd(address));
+        loadWords(out, readPage(address) + (address & kPageMask), chunk, shared);
+        address += static_cast<uint32_t>(chunk);
+        out += chunk;
+        count -= chunk;
+    }
+}
+
+/**
+ * @brief Writes @p count words starting at @p address, page by page.
+ *
+ * @param address First word address.
+ * @param values The words to store.
+ * @param count Number of words.
+ */
+void DataMemory::writeRange(uint32_t address, const uint32_t* values, size_t count) {
+    while (count) {
+        const size_t chunk = std::min<size_t>(count, wordsToPageEnd(address));
+        storeWords(writePage(address) + (address & kPageMask), values, chunk, shared);
+        address += static_cast<uint32_t>(chunk);
+        values += chunk;
+        count -= chunk;
+    }
+}
+
+/**
+ * @brief Moves @p count words in chunks that stay within one source and one destination page.
+ *
+ * The destination page is made writable before the source page is looked up:
+ * if both are the same shared page, the copy then reads the new page. An
+ * overlapping move to higher addresses runs from the end, like memmove. A
+ * chunk from a never-written page to another is skipped: both read as zero.
+ * In shared mode each chunk is moved one relaxed atomic word at a time, in
+ * the direction that reads every word before overwriting it.
+ *
+ * @param to First destination address.
+ * @param from First source address.
+ * @param count Number of words.
+ */
+void DataMemory::copy(uint32_t to, uint32_t from, uint32_t count) {
+    if (to == from || count == 0) return;
+    const uint32_t* const zero_page = zeroTable()[0];
+    auto move = [&](uint32_t dst, uint32_t src, uint32_t chunk) {
+        if (readPage(src) == zero_page && readPage(dst) == zero_page) return;
+        uint32_t* out = writePage(dst) + (dst & kPageMask);
+        const uint32_t* in = readPage(src) + (src & kPageMask);
+        if (!shared) {
+            std::memmove(out, in, chunk * sizeof(uint32_t));
+            return;
+        }
+        auto word = [&](uint32_t i) {
+            __atomic_store_n(&out[i], __atomic_load_n(&in[i], __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+        };
+        if (out < in) {
+            for (uint32_t i = 0; i < chunk; ++i) word(i);
+        } else {
+            for (uint32_t i = chunk; i--;) word(i);
+        }
+    };
+    const bool backward = to > from && to - from < count;
+    if (!backward) {
+        for (uint32_t done = 0; done < count;) {
+            const uint32_t chunk = std::min({count - done, wordsToPageEnd(to + done), wordsToPageEnd(from + done)});
+            move(to + done, from + done, chunk);
+            done += chunk;
+        }
+        return;
+    }
+    for (uint32_t left = count; left;) {
+        // Ends are exclusive and may equal 2^32
+        const uint64_t to_end = uint64_t(to) + left;
+        const uint64_t from_end = uint64_t(from) + left;
+        const uint32_t chunk = std::min({left, static_cast<uint32_t>(((to_end - 1) & kPageMask) + 1),
+                                         static_cast<uint32_t>(((from_end - 1) & kPageMask) + 1)});
+        left -= chunk;
+        move(to + left, from + left, chunk);
+    }
+}
+
+/**
+ * @brief Fills @p count words starting at @p address, page by page.
+ *
+ * @param address First word address.
+ * @param value The value to store.
+ * @param count Number of words.
+ */
+void DataMemory::fill(uint32_t address, uint32_t value, uint32_t count) {
+    const uint32_t* const zero_page = zeroTable()[0];
+    while (count) {
+        const uint32_t chunk = std::min(count, wordsToPageEnd(address));
+        if (value != 0 || readPage(address) != zero_page) {
+            uint32_t* out = writePage(address) + (address & kPageMask);
+            if (!shared) {
+                std::fill(out, out + chunk, value);
+            } else {
+                for (uint32_t i = 0; i < chunk; ++i) __atomic_store_n(&out[i], value, __ATOMIC_RELAXED);
+            }
+        }
+        address += chunk;
+        count -= chunk;
+    }
+}
+
+/**
+ * @brief Compares two ranges in chunks that stay within one page of each.
+ *
+ * Each chunk is compared with memcmp; only a chunk that differs is scanned
+ * word by word. In shared mode every chunk is scanned with relaxed atomic loads.
+ *
+ * @param lhs First address of one range.
+ * @param rhs First address of the other range.
+ * @param count Number of words.
+ * @return The offset of the first differing word, or @p count.
+ */
+uint32_t DataMemory::compare(uint32_t lhs, uint32_t rhs, uint32_t count) const {
+    for (uint32_t done = 0; done < count;) {
+        const uint32_t a = lhs + done;
+        const uint32_t b = rhs + done;
+        const uint32_t chunk = std::min({count - done, wordsToPageEnd(a), wordsToPageEnd(b)});
+        const uint32_t* left = readPage(a) + (a & kPageMask);
+        const uint32_t* right = readPage(b) + (b & kPageMask);
+        if (shared && left != right) {
+            for (uint32_t i = 0; i < chunk; ++i) {
+                if (__atomic_load_n(&left[i], __ATOMIC_RELAXED) != __atomic_load_n(&right[i], __ATOMIC_RELAXED)) {
+                    return done + i;
+                }
+            }
+        } else if (left != right && std::memcmp(left, right, chunk * sizeof(uint32_t)) != 0) {
+            return done + static_cast<uint32_t>(std::mismatch(left, left + chunk, right).first - left);
+        }
+        done += chunk;
+    }
+    return count;
+}
+
+/**
+ * @brief Makes every table and written page writable in place and returns a memory aliasing the same tables.
+ *
+ * The view's write pointers are the owner's, so both skip the ownership check
+ * that would otherwise copy a page shared by two memories. A table costs three
+ * pointers per page of its 2 MiB range; the pages themselves stay lazy.
+ *
+ * @return The shared view.
+ */
+DataMemory DataMemory::sharedView() {
+    if (!shared) {
+        for (size_t index = 0; index < tables.size(); ++index) {
+            PageTable& table = makeTableWritable(index);
+            for (uint32_t entry = 0; entry < kTablePages; ++entry) {
+                if (table.pages[entry] && !table.write[entry]) {
+                    makeWritable(static_cast<uint32_t>(index << kTableShift) | entry);
+                }
+            }
+        }
+        writable = true;
+        shared = true;
+    }
+    DataMemory view;
+    view.tables = tables;
+    view.directory = directory;
+    view.write_directory = write_directory;
+    view.writable = writable;
+    view.shared = true;
+    view.word_count = word_count;
+    return view;
+}
+
+/**
+ * @brief Zeroes the memory by releasing every table; copies keep their pages.
+ */
+void DataMemory::clear() {
+    std::fill(tables.begin(), tables.end(), nullptr);
+    std::fill(directory.begin(), directory.end(), zeroTable());
+    std::fill(write_directory.begin(), write_directory.end(), nullTable());
+    writable = false;
+    shared = false;
+}
+
+/**
+ * @brief Counts the pages that hold storage.
+ *
+ * @return The number of pages written at least once (by this memory or before it was copied).
+ */
+size_t DataMemory::residentPages() const {
+    size_t count = 0;
+    for (const std::shared_ptr<PageTable>& table : tables) {
+        if (!table) continue;
+        for (const std::shared_ptr<Page>& page : table->pages) count += page != nullptr;
+    }
+    return count;
+}
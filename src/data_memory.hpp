@@ -0,0 +1,289 @@
+/**
+ * @file data_memory.hpp
+ * @brief Declares DataMemory, the paged copy-on-write data memory of a RiscMachine.
+ *
+ * Data memory is split into 4 KiB pages reached through a two-level page table:
+ * a directory of page tables, each covering kTablePages pages. Pages and tables
+ * are allocated on the first write; until then reads see a shared zero page, so
+ * memory use scales with the pages touched rather than the declared size.
+ *
+ * Pages and tables are reference counted and shared between copies of a
+ * DataMemory. Copying one copies only the directory; a table or page is
+ * duplicated the first time one of its sharers writes to it.
+ *
+ * Each table also keeps write pointers, set only for pages this memory owns
+ * exclusively, and a second directory reaches them; a store through a non-null
+ * write pointer needs no ownership check.
+ *
+ * A shared view (sharedView()) is the exception to copy-on-write: it writes
+ * through to the same pages, so harts of one machine can share memory. Words
+ * and page pointers are accessed atomically (relaxed words, acquire/release
+ * pointers), which compiles to plain moves on x86-64; a page first written
+ * while views are in use is published with a compare-exchange on its write
+ * pointer, so harts never race on allocation.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @class DataMemory
+ * @brief Word-addressed, lazily allocated data memory with page-granular copy-on-write.
+ *
+ * Copies share all pages with the original. A memory and its copies may be used
+ * from different threads, but one memory must not be copied while it is being
+ * written by another thread.
+ */
+class DataMemory {
+public:
+    static constexpr uint32_t kPageShift = 10;                  /**< log2 of the words per page */
+    static constexpr uint32_t kPageWords = 1u << kPageShift;    /**< Words per page (4 KiB) */
+    static constexpr uint32_t kPageMask = kPageWords - 1;       /**< Mask of the word offset within a page */
+    static constexpr uint32_t kTableShift = 9;                  /**< log2 of the pages per page table */
+    static constexpr uint32_t kTablePages = 1u << kTableShift;  /**< Pages per page table (2 MiB) */
+    static constexpr uint32_t kTableMask = kTablePages - 1;     /**< Mask of the page index within a table */
+    static constexpr uint32_t kDirectoryShift = kPageShift + kTableShift;  /**< Address bits below the directory index */
+
+    /**
+     * @brief Creates a zeroed memory; no page is allocated until written.
+     * @param size Number of 32-bit words.
+     */
+    explicit DataMemory(size_t size = 0);
+
+    /**
+     * @brief Creates a memory that shares every page with @p other.
+     *
+     * Both memories copy a page before writing to it for the first time.
+     */
+    DataMemory(const DataMemory& other);
+    DataMemory& operator=(const DataMemory& other);
+    DataMemory(DataMemory&&) noexcept = default;
+    DataMemory& operator=(DataMemory&&) noexcept = default;
+
+    /**
+     * @brief Gets the number of words.
+     * @return The memory size in words.
+     */
+    size_t size() const { return word_count; }
+
+    /**
+     * @brief Reads a word; the address must be less than size().
+     * @param address Word address.
+     * @return The stored value.
+     */
+    uint32_t read(uint32_t address) const {
+        return __atomic_load_n(&readPage(address)[address & kPageMask], __ATOMIC_RELAXED);
+    }
+
+    /**
+     * @brief Gets the page holding an address, for reading many consecutive words.
+     * @param address Word address less than size().
+     * @return The kPageWords words of the page (the zero page if it was never written).
+     */
+    const uint32_t* readPage(uint32_t address) const {
+        return __atomic_load_n(&directory[address >> kDirectoryShift][(address >> kPageShift) & kTableMask],
+                               __ATOMIC_ACQUIRE);
+    }
+
+    /**
+     * @brief Writes a word, allocating or copying its page first; the address must be less than size().
+     * @param address Word address.
+     * @param value The value to store.
+     */
+    void write(uint32_t address, uint32_t value) {
+        __atomic_store_n(&writePage(address)[address & kPageMask], value, __ATOMIC_RELAXED);
+    }
+
+    /**
+     * @brief Gets the page holding an address for writing, allocating or copying it first.
+     * @param address Word address less than size().
+     * @return The kPageWords words of the page.
+     */
+    uint32_t* writePage(uint32_t address) {
+        uint32_t* words = __atomic_load_n(
+            &write_directory[address >> kDirectoryShift][(address >> kPageShift) & kTableMask], __ATOMIC_ACQUIRE);
+        return words ? words : makeWritable(address >> kPageShift);
+    }
+
+    /**
+     * @brief Copies consecutive words out of memory, one page at a time.
+     * @param address First word address; address + count must not exceed size().
+     * @param out Receives @p count words.
+     * @param count Number of words.
+     */
+    void readRange(uint32_t address, uint32_t* out, size_t count) const;
+
+    /**
+     * @brief Copies words into consecutive addresses, one page at a time.
+     * @param address First word address; address + count must not exceed size().
+     * @param values The @p count words to store.
+     * @param count Number of words.
+     */
+    void writeRange(uint32_t address, const uint32_t* values, size_t count);
+
+    /**
+     * @brief Copies words within memory; overlapping ranges are copied as if through a buffer (memmove).
+     * @param to First destination address; to + count must not exceed size().
+     * @param from First source address; from + count must not exceed size().
+     * @param count Number of words.
+     */
+    void copy(uint32_t to, uint32_t from, uint32_t count);
+
+    /**
+     * @brief Sets consecutive words to one value.
+     *
+     * Filling with zero skips pages that were never written.
+     *
+     * @param address First word address; address + count must not exceed size().
+     * @param value The value to store.
+     * @param count Number of words.
+     */
+    void fill(uint32_t address, uint32_t value, uint32_t count);
+
+    /**
+     * @brief Compares two ranges word by word.
+     * @param lhs First address of one range; lhs + count must not exceed size().
+     * @param rhs First address of the other range; rhs + count must not exceed size().
+     * @param count Number of words.
+     * @return The offset of the first word that differs, or @p count if the ranges are equal.
+     */
+    uint32_t compare(uint32_t lhs, uint32_t rhs, uint32_t count) const;
+
+    /**
+     * @brief Atomically adds to a word; the address must be less than size().
+     * @param address Word address.
+     * @param value The value to add (wrapping).
+     * @return The word before the addition.
+     */
+    uint32_t fetchAdd(uint32_t address, uint32_t value) {
+        return __atomic_fetch_add(&writePage(address)[address & kPageMask], value, __ATOMIC_SEQ_CST);
+    }
+
+    /**
+     * @brief Atomically replaces a word if it holds an expected value; the address must be less than size().
+     * @param address Word address.
+     * @param expected The value the word must hold; receives the word before the operation.
+     * @param desired The value to store on success.
+     * @return True if the word held @p expected and was replaced.
+     */
+    bool compareExchange(uint32_t address, uint32_t& expected, uint32_t desired) {
+        return __atomic_compare_exchange_n(&writePage(address)[address & kPageMask], &expected, desired, false,
+                                           __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+
+    /**
+     * @brief Creates a memory that reads and writes the same words as this one.
+     *
+     * Every page table, and every page already written, is made exclusive
+     * first, so a store through either memory is seen by both. Pages never
+     * written stay unallocated: the first store to one, through any view,
+     * allocates it and publishes it with a compare-exchange, and a view that
+     * loses the race uses the winner's page. Views may be written from several
+     * threads at once, and so may this memory, which stays in shared mode until
+     * it is next copied or cleared; neither memory may be copied, cleared or
+     * assigned while a view is in use.
+     *
+     * @return The view; it keeps the pages alive.
+     */
+    DataMemory sharedView();
+
+    /**
+     * @brief Sets every word to zero and releases all pages.
+     */
+    void clear();
+
+    /**
+     * @brief Gives this memory exclusive ownership of a page and sets its write pointer.
+     *
+     * Allocates the page (and its table) if it was never written, or copies it if
+     * it is shared. In shared mode (see sharedView()) the page is published for
+     * every view instead.
+     *
+     * @param page Page index.
+     * @return The writable page.
+     */
+    uint32_t* makeWritable(uint32_t page);
+
+    /**
+     * @brief Gets the page directory for generated code.
+     *
+     * Entry d points at the kTablePages page pointers of table d; the table of
+     * untouched ranges points every entry at the zero page.
+     *
+     * @return Pointer to the first entry; valid until the memory is destroyed or reassigned.
+     */
+    uint32_t* const* const* directoryTable() const { return directory.data(); }
+
+    /**
+     * @brief Gets the write directory for generated code.
+     *
+     * Laid out like directoryTable(); a null page pointer means the store must go
+     * through makeWritable().
+     *
+     * @return Pointer to the first entry; valid until the memory is destroyed or reassigned.
+     */
+    uint32_t* const* const* writeDirectoryTable() const { return write_directory.data(); }
+
+    /**
+     * @brief Gets the number of pages that hold storage (written at least once).
+     * @return The resident page count; pages shared with copies are included.
+     */
+    size_t residentPages() const;
+
+    /**
+     * @brief Calls @p visit(first_address, words) for every resident page, in address order.
+     *
+     * Pages never written are skipped; they read as zero. The last page may
+     * extend beyond size().
+     *
+     * @param visit Callable taking (uint32_t first_address, const uint32_t* words).
+     */
+    template <typename Visitor>
+    void forEachResidentPage(Visitor&& visit) const {
+        for (size_t d = 0; d < tables.size(); ++d) {
+            if (!tables[d]) continue;
+            for (uint32_t p = 0; p < kTablePages; ++p) {
+                if (!tables[d]->pages[p]) continue;
+                const uint32_t page = static_cast<uint32_t>(d << kTableShift) | p;
+                visit(page << kPageShift, static_cast<const uint32_t*>(tables[d]->pages[p]->words));
+            }
+        }
+    }
+
+    /**
+     * @brief Gets the number of pages copied because a shared page was written.
+     * @return Copies made by this memory since it was created or assigned.
+     */
+    uint64_t copiedPages() const { return copied_pages; }
+
+private:
+    struct Page {
+        uint32_t words[kPageWords];
+    };
+
+    struct PageTable {
+        std::shared_ptr<Page> pages[kTablePages];  // null: never written, reads the zero page
+        uint32_t* read[kTablePages];               // page words, or the zero page
+        uint32_t* write[kTablePages];              // page words if exclusively owned, else null
+    };
+
+    void shareFrom(const DataMemory& other);
+    void revokeWriteAccess() const;
+    PageTable& makeTableWritable(size_t index);
+    uint32_t* publishPage(uint32_t page);
+
+    std::vector<std::shared_ptr<PageTable>> tables;  // null: no page of the range written
+    std::vector<uint32_t* const*> directory;          // tables[d]->read, or the zero table
+    // tables[d]->write if the table is exclusively owned, else the null table;
+    // revoked (mutable) when a copy starts sharing the tables
+    mutable std::vector<uint32_t* const*> write_directory;
+    mutable bool writable = false;
+    // Set by sharedView(): tables are shared with views, and pages are published atomically
+    mutable bool shared = false;
+    size_t word_count = 0;
+    uint64_t copied_pages = 0;
+};
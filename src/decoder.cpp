@@ -0,0 +1,324 @@
+/**
+ * @file decoder.cpp
+ * @brief Implementation of the load-time decoder used by the threaded engine.
+ */
+
+#include "decoder.hpp"
+#include "vector_unit.hpp"
+
+/**
+ * @brief Decodes a single instruction.
+ *
+ * Mirrors the operand checks performed by RiscMachine::execute so that every
+ * instruction the switch engine would silently ignore becomes a NOP, and the
+ * threaded handlers can run without re-checking register or address operands.
+ *
+ * @param instr The instruction to decode.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @param program_size Number of instructions in the program.
+ * @return The decoded instruction.
+ */
+static DecodedInstruction decodeInstruction(const Instruction& instr, size_t register_count,
+                                            size_t data_size, size_t program_size) {
+    auto reg = [register_count](uint32_t index) { return index < register_count; };
+    auto vreg = [](uint32_t index) { return index < VectorUnit::kRegisters; };
+    DecodedInstruction decoded;
+
+    switch (instr.opcode) {
+        case Opcode::HALT:
+            decoded.op = DecodedOp::HALT;
+            break;
+
+        case Opcode::LOAD:
+            if (!reg(instr.dst)) break;
+            decoded.a = instr.dst;
+            decoded.b = instr.src1;
+            if (instr.src2 == 0 && instr.src1 < data_size) {
+                decoded.op = DecodedOp::LOAD_DIRECT;
+            } else if (instr.src2 == 1 && reg(instr.src1)) {
+                decoded.op = DecodedOp::LOAD_INDIRECT;
+            } else if (instr.src2 == 2) {
+                decoded.op = DecodedOp::LOAD_IMM;
+            }
+            break;
+
+        case Opcode::STORE:
+            if (instr.dst < data_size && reg(instr.src1)) {
+                decoded = {instr.dst, instr.src1, 0, 0, DecodedOp::STORE};
+            }
+            break;
+
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::DIV:
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
+                DecodedOp op = instr.opcode == Opcode::ADD ? DecodedOp::ADD
+                             : instr.opcode == Opcode::SUB ? DecodedOp::SUB
+                             : instr.opcode == Opcode::MUL ? DecodedOp::MUL
+                             : DecodedOp::DIV;
+                decoded = {instr.dst, instr.src1, instr.src2, 0, op};
+            }
+            break;
+
+        case Opcode::CMP:
+            if (reg(instr.src1) && reg(instr.src2)) {
+                decoded = {0, instr.src1, instr.src2, 0, DecodedOp::CMP};
+            } else {
+                decoded.op = DecodedOp::CMP_INVALID;
+            }
+            break;
+
+        case Opcode::JMP:
+            if (instr.dst < program_size) {
+                if (instr.src1 == 0) {
+                    decoded = {instr.dst, 0, 0, 0, DecodedOp::JMP};
+                } else if (instr.src1 == 1) {
+                    decoded = {instr.dst, 0, 0, 0, DecodedOp::JZ};
+                }
+            }
+            break;
+
+        case Opcode::MOV:
+            if (reg(instr.dst) && reg(instr.src1)) {
+                decoded = {instr.dst, instr.src1, 0, 0, DecodedOp::MOV};
+            }
+            break;
+
+        case Opcode::CHECK_FLAG:
+            if (!reg(instr.dst)) break;
+            if (instr.src1 <= 4) {
+                decoded = {instr.dst, instr.src1, 0, 0, DecodedOp::CHECK_FLAG};
+            } else {
+                // Unknown flags always read as 0
+                decoded = {instr.dst, 0, 0, 0, DecodedOp::LOAD_IMM};
+            }
+            break;
+
+        case Opcode::ATOMIC_ADD:
+        case Opcode::CAS:
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
+                DecodedOp op = instr.opcode == Opcode::ATOMIC_ADD ? DecodedOp::ATOMIC_ADD : DecodedOp::CAS;
+                decoded = {instr.dst, instr.src1, instr.src2, 0, op};
+            }
+            break;
+
+        case Opcode::FENCE:
+            decoded.op = DecodedOp::FENCE;
+            break;
+
+        case Opcode::HART_ID:
+            if (reg(instr.dst)) decoded = {instr.dst, 0, 0, 0, DecodedOp::HART_ID};
+            break;
+
+        case Opcode::VLOAD:
+            if (vreg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
+                decoded = {instr.dst, instr.src1, instr.src2, 0, DecodedOp::VLOAD};
+            }
+            break;
+
+        case Opcode::VSTORE:
+            if (reg(instr.dst) && vreg(instr.src1) && reg(instr.src2)) {
+                decoded = {instr.dst, instr.src1, instr.src2, 0, DecodedOp::VSTORE};
+            }
+            break;
+
+        case Opcode::VADD:
+        case Opcode::VSUB:
+        case Opcode::VMUL:
+            if (vreg(instr.dst) && vreg(instr.src1) && vreg(instr.src2)) {
+                DecodedOp op = instr.opcode == Opcode::VADD ? DecodedOp::VADD
+                             : instr.opcode == Opcode::VSUB ? DecodedOp::VSUB : DecodedOp::VMUL;
+                decoded = {instr.dst, instr.src1, instr.src2, 0, op};
+            }
+            break;
+
+        case Opcode::VREDUCE:
+            if (reg(instr.dst) && vreg(instr.src1)) decoded = {instr.dst, instr.src1, 0, 0, DecodedOp::VREDUCE};
+            break;
+
+        case Opcode::VSETVL:
+            if (reg(instr.dst) && reg(instr.src1)) decoded = {instr.dst, instr.src1, 0, 0, DecodedOp::VSETVL};
+            break;
+
+        case Opcode::MEMCPY:
+        case Opcode::MEMSET:
+        case Opcode::MEMCMP:
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
+                DecodedOp op = instr.opcode == Opcode::MEMCPY ? DecodedOp::MEMCPY
+                             : instr.opcode == Opcode::MEMSET ? DecodedOp::MEMSET : DecodedOp::MEMCMP;
+                decoded = {instr.dst, instr.src1, instr.src2, 0, op};
+            }
+            break;
+
+        case Opcode::HOSTCALL:
+            decoded = {instr.dst, 0, 0, 0, DecodedOp::HOSTCALL};
+            break;
+    }
+    return decoded;
+}
+
+/**
+ * @brief Decodes a whole program and appends the EXIT sentinel.
+ *
+ * @param program The program to decode.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The decoded program, one entry longer than the input.
+ */
+std::vector<DecodedInstruction> decodeProgram(const std::vector<Instruction>& program,
+                                              size_t register_count, size_t data_size) {
+    return decodeProgram(program.data(), program.size(), register_count, data_size);
+}
+
+/**
+ * @brief Decodes a contiguous array of instructions and appends the EXIT sentinel.
+ *
+ * @param program Pointer to the first instruction.
+ * @param count Number of instructions.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The decoded program, one entry longer than the input.
+ */
+std::vector<DecodedInstruction> decodeProgram(const Instruction* program, size_t count,
+                                              size_t register_count, size_t data_size) {
+    std::vector<DecodedInstruction> decoded;
+    decoded.reserve(count + 1);
+    for (size_t i = 0; i < count; ++i) {
+        decoded.push_back(decodeInstruction(program[i], register_count, data_size, count));
+    }
+    DecodedInstruction sentinel;
+    sentinel.op = DecodedOp::EXIT;
+    decoded.push_back(sentinel);
+    return decoded;
+}
+
+/**
+ * @brief Fuses CMP + JZ and CHECK_FLAG + CMP + JZ sequences.
+ *
+ * The CHECK_FLAG form is only fused when the CMP reads the register that
+ * CHECK_FLAG wrote, which is how every overflow check in algorithms.cpp
+ * tests a single flag.
+ *
+ * @param decoded A program produced by decodeProgram(), modified in place.
+ * @return The number of sequences that were fused.
+ */
+size_t fuseProgram(std::vector<DecodedInstruction>& decoded) {
+    size_t fused = 0;
+    const size_t n = decoded.size() - 1;  // EXIT sentinel is never fused
+    for (size_t i = 0; i < n; ++i) {
+        DecodedInstruction& first = decoded[i];
+
+        if (first.op == DecodedOp::CHECK_FLAG && i + 2 < n &&
+            decoded[i + 1].op == DecodedOp::CMP && decoded[i + 2].op == DecodedOp::JZ) {
+            const DecodedInstruction& cmp = decoded[i + 1];
+            uint32_t flag_reg = first.a;
+            if (cmp.b == flag_reg || cmp.c == flag_reg) {
+                uint32_t other = (cmp.b == flag_reg) ? cmp.c : cmp.b;
+                first = {decoded[i + 2].a, first.b, flag_reg, other, DecodedOp::FLAG_CMP_JZ};
+                ++fused;
+                continue;
+            }
+        }
+
+        if (first.op == DecodedOp::CMP && i + 1 < n && decoded[i + 1].op == DecodedOp::JZ) {
+            first = {decoded[i + 1].a, first.b, first.c, 0, DecodedOp::CMP_JZ};
+            ++fused;
+        }
+    }
+    return fused;
+}
+
+/**
+ * @brief Packs decoded records into the compact encoding of the threaded engine.
+ *
+ * @param decoded A program produced by decodeProgram() and optionally fuseProgram().
+ * @return The packed program.
+ */
+std::vector<PackedInstruction> packProgram(const std::vector<DecodedInstruction>& decoded) {
+    std::vector<PackedInstruction> packed;
+    packed.reserve(decoded.size());
+    auto reg = [](uint32_t index) { return static_cast<uint8_t>(index); };
+    for (const DecodedInstruction& d : decoded) {
+        PackedInstruction p;
+        p.op = d.op;
+        switch (d.op) {
+            case DecodedOp::LOAD_DIRECT:
+            case DecodedOp::LOAD_IMM:
+                p.x = reg(d.a);
+                p.imm = d.b;
+                break;
+            case DecodedOp::LOAD_INDIRECT:
+            case DecodedOp::MOV:
+            case DecodedOp::CHECK_FLAG:
+                p.x = reg(d.a);
+                p.y = reg(d.b);
+                break;
+            case DecodedOp::STORE:
+                p.y = reg(d.b);
+                p.imm = d.a;
+                break;
+            case DecodedOp::ADD:
+            case DecodedOp::SUB:
+            case DecodedOp::MUL:
+            case DecodedOp::DIV:
+                p.x = reg(d.a);
+                p.y = reg(d.b);
+                p.z = reg(d.c);
+                break;
+            case DecodedOp::CMP:
+                p.y = reg(d.b);
+                p.z = reg(d.c);
+                break;
+            case DecodedOp::JMP:
+            case DecodedOp::JZ:
+            case DecodedOp::HOSTCALL:
+                p.imm = d.a;
+                break;
+            case DecodedOp::CMP_JZ:
+                p.y = reg(d.b);
+                p.z = reg(d.c);
+                p.imm = d.a;
+                break;
+            case DecodedOp::FLAG_CMP_JZ:
+                p.x = reg(d.c);
+                p.y = reg(d.b);
+                p.z = reg(d.d);
+                p.imm = d.a;
+                break;
+            case DecodedOp::REDUCE:
+                p.x = reg(d.a);
+                p.y = reg(d.b);
+                p.z = reg(d.d);
+                p.imm = d.c;
+                break;
+            case DecodedOp::ATOMIC_ADD:
+            case DecodedOp::CAS:
+            case DecodedOp::VLOAD:
+            case DecodedOp::VSTORE:
+            case DecodedOp::VADD:
+            case DecodedOp::VSUB:
+            case DecodedOp::VMUL:
+            case DecodedOp::MEMCPY:
+            case DecodedOp::MEMSET:
+            case DecodedOp::MEMCMP:
+                p.x = reg(d.a);
+                p.y = reg(d.b);
+                p.z = reg(d.c);
+                break;
+            case DecodedOp::HART_ID:
+                p.x = reg(d.a);
+                break;
+            case DecodedOp::VREDUCE:
+            case DecodedOp::VSETVL:
+                p.x = reg(d.a);
+                p.y = reg(d.b);
+                break;
+            default:
+                break;
+        }
+        packed.push_back(p);
+    }
+    return packed;
+}
@@ -0,0 +1,180 @@
+/**
+ * @file decoder.hpp
+ * @brief Declares the pre-decoded program representation used by the threaded engine.
+ *
+ * The threaded engine does not interpret Instruction records directly. Instead the
+ * program is decoded once at load time: addressing modes are resolved and operands
+ * that can never be valid are folded into no-ops. The threaded engine executes the
+ * decoded program in a packed form (PackedInstruction) whose records are later bound
+ * to the address of the handler that executes them; the JIT and the wide machine
+ * work on DecodedInstruction.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @enum DecodedOp
+ * @brief Internal operations produced by the decoder.
+ *
+ * Each value corresponds to one handler in the threaded engine. Opcodes whose
+ * behaviour depends on an operand (LOAD addressing modes, conditional JMP) are
+ * split into separate operations so the handler does not need to re-inspect it.
+ */
+enum class DecodedOp : uint8_t {
+    NOP,            /**< Instruction with operands that make it a no-op */
+    HALT,           /**< Stop execution */
+    LOAD_DIRECT,    /**< R[a] = RAM[b] */
+    LOAD_INDIRECT,  /**< R[a] = RAM[R[b]] (address checked at runtime) */
+    LOAD_IMM,       /**< R[a] = b */
+    STORE,          /**< RAM[a] = R[b] */
+    ADD,            /**< R[a] = R[b] + R[c], sets CF/NF */
+    SUB,            /**< R[a] = R[b] - R[c], sets CF/NF */
+    MUL,            /**< R[a] = R[b] * R[c], sets OF/NF */
+    DIV,            /**< R[a] = R[b] / R[c], sets NF/DF/OF/CF */
+    CMP,            /**< ZF = (R[b] == R[c]) */
+    CMP_INVALID,    /**< CMP with invalid registers: ZF = 0 */
+    JMP,            /**< pc = a */
+    JZ,             /**< if ZF: pc = a */
+    MOV,            /**< R[a] = R[b] */
+    CHECK_FLAG,     /**< R[a] = flag[b] */
+    EXIT,           /**< Sentinel placed after the last instruction */
+    CMP_JZ,         /**< Fused CMP + JZ: ZF = (R[b] == R[c]); if ZF: pc = a */
+    FLAG_CMP_JZ,    /**< Fused CHECK_FLAG + CMP + JZ: R[c] = flag[b]; ZF = (R[c] == R[d]); if ZF: pc = a */
+    REDUCE,         /**< Head of reduction loop c (see reduction.hpp), then LOAD_INDIRECT R[a] = RAM[R[b]]; R[d] holds the step */
+    ATOMIC_ADD,     /**< R[a] = RAM[R[b]]; RAM[R[b]] += R[c] atomically (address checked at runtime) */
+    CAS,            /**< if RAM[R[b]] == R[a]: RAM[R[b]] = R[c]; ZF = success; R[a] = old value (address checked) */
+    FENCE,          /**< Sequentially consistent memory fence */
+    HART_ID,        /**< R[a] = hart index */
+    VLOAD,          /**< V[a] = RAM[R[b] + i * R[c]] for i < vl (addresses checked at runtime) */
+    VSTORE,         /**< RAM[R[a] + i * R[c]] = V[b] for i < vl (addresses checked at runtime) */
+    VADD,           /**< V[a] = V[b] + V[c] */
+    VSUB,           /**< V[a] = V[b] - V[c] */
+    VMUL,           /**< V[a] = V[b] * V[c] */
+    VREDUCE,        /**< R[a] = sum of V[b][i] for i < vl */
+    VSETVL,         /**< R[a] = vl = min(R[b], VLMAX) */
+    MEMCPY,         /**< RAM[R[a] + i] = RAM[R[b] + i] for i < R[c] (ranges checked at runtime) */
+    MEMSET,         /**< RAM[R[a] + i] = R[b] for i < R[c] (range checked at runtime) */
+    MEMCMP,         /**< Compare R[c] words at RAM[R[a]] and RAM[R[b]], sets ZF/CF/NF (ranges checked) */
+    HOSTCALL,       /**< Call host function a (binding checked at runtime) */
+    COUNT           /**< Number of decoded operations */
+};
+
+/**
+ * @struct DecodedInstruction
+ * @brief A single pre-decoded instruction.
+ */
+struct DecodedInstruction {
+    uint32_t a = 0;                    /**< First operand */
+    uint32_t b = 0;                    /**< Second operand */
+    uint32_t c = 0;                    /**< Third operand */
+    uint32_t d = 0;                    /**< Fourth operand (fused operations only) */
+    DecodedOp op = DecodedOp::NOP;     /**< Operation to execute */
+};
+
+/**
+ * @struct PackedInstruction
+ * @brief Compact 16-byte encoding of a DecodedInstruction executed by the threaded engine.
+ *
+ * Register operands take one byte each and the single wide operand an operation
+ * can have (memory address, immediate value or jump target) is stored in @c imm.
+ * Every operand of the ISA fits, so no escape form for larger values is needed.
+ * Besides the handler address the record is 8 bytes; the handler is kept inline
+ * because looking it up in a table by @c op adds a dependent load to every dispatch.
+ *
+ * | Operation            | x        | y          | z      | imm           |
+ * |----------------------|----------|------------|--------|---------------|
+ * | LOAD_DIRECT/LOAD_IMM | dst      |            |        | address/value |
+ * | LOAD_INDIRECT, MOV   | dst      | src        |        |               |
+ * | STORE                |          | src        |        | address       |
+ * | ADD/SUB/MUL/DIV      | dst      | src1       | src2   |               |
+ * | CMP                  |          | src1       | src2   |               |
+ * | JMP/JZ               |          |            |        | target        |
+ * | CHECK_FLAG           | dst      | flag       |        |               |
+ * | CMP_JZ               |          | src1       | src2   | target        |
+ * | FLAG_CMP_JZ          | flag reg | flag       | other  | target        |
+ * | REDUCE               | dst      | src        | step   | loop index    |
+ * | ATOMIC_ADD/CAS       | dst      | address    | src    |               |
+ * | HART_ID              | dst      |            |        |               |
+ * | VLOAD                | vdst     | address    | stride |               |
+ * | VSTORE               | address  | vsrc       | stride |               |
+ * | VADD/VSUB/VMUL       | vdst     | vsrc1      | vsrc2  |               |
+ * | VREDUCE              | dst      | vsrc       |        |               |
+ * | VSETVL               | dst      | requested  |        |               |
+ * | MEMCPY/MEMCMP        | address  | address    | count  |               |
+ * | MEMSET               | address  | value      | count  |               |
+ * | HOSTCALL             |          |            |        | call ID       |
+ */
+struct PackedInstruction {
+    const void* handler = nullptr;  /**< Handler address, bound by the engine before the first run */
+    uint32_t imm = 0;               /**< Memory address, immediate value or jump target */
+    uint8_t x = 0;                  /**< Destination register */
+    uint8_t y = 0;                  /**< First source register or flag index */
+    uint8_t z = 0;                  /**< Second source register */
+    DecodedOp op = DecodedOp::NOP;  /**< Operation to execute */
+};
+
+static_assert(sizeof(PackedInstruction) <= 16, "PackedInstruction must stay within 16 bytes");
+
+/**
+ * @brief Decodes a program for the threaded engine.
+ *
+ * The returned vector has one entry per instruction plus a trailing EXIT sentinel,
+ * so falling off the end of the program needs no bounds check.
+ *
+ * @param program The program to decode.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The decoded program.
+ */
+std::vector<DecodedInstruction> decodeProgram(const std::vector<Instruction>& program,
+                                              size_t register_count, size_t data_size);
+
+/**
+ * @brief Decodes a program stored in a contiguous array (e.g. a mapped program file).
+ *
+ * @param program Pointer to the first instruction.
+ * @param count Number of instructions.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The decoded program.
+ */
+std::vector<DecodedInstruction> decodeProgram(const Instruction* program, size_t count,
+                                              size_t register_count, size_t data_size);
+
+/**
+ * @brief Rewrites common compare-and-branch idioms into fused superinstructions.
+ *
+ * A fused record replaces only the first instruction of its sequence; the
+ * following records are left untouched so that jumps into the middle of a
+ * sequence still execute the original instructions. The architectural state
+ * after a fused record equals the state after the last instruction it covers.
+ *
+ * @param decoded A program produced by decodeProgram(), modified in place.
+ * @return The number of sequences that were fused.
+ */
+size_t fuseProgram(std::vector<DecodedInstruction>& decoded);
+
+/**
+ * @brief Converts a decoded (and possibly fused) program to the packed encoding.
+ *
+ * Register operands must be below 256, which holds for every program decoded
+ * for the 16-register machine.
+ *
+ * @param decoded A program produced by decodeProgram() and optionally fuseProgram().
+ * @return One packed record per decoded record, including the EXIT sentinel.
+ */
+std::vector<PackedInstruction> packProgram(const std::vector<DecodedInstruction>& decoded);
+
+/**
+ * @brief Checks whether an operation is a fused superinstruction.
+ * @param op The operation to check.
+ * @return True for operations produced by fuseProgram().
+ */
+inline bool isFusedOp(DecodedOp op) {
+    return op == DecodedOp::CMP_JZ || op == DecodedOp::FLAG_CMP_JZ;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file flags.hpp
+ * @brief Defines the StatusRegister struct and LazyFlags, the lazily evaluated condition flags.
+ *
+ * ADD, SUB and MUL do not compute their flags when they execute. They record the
+ * operation and its operands, and CF/NF/OF are derived from that record only when
+ * a flag is read (CHECK_FLAG, getStatusRegister(), or entering native code).
+ * ZF, which every conditional jump reads, and the rarely written DF are kept as
+ * plain values. Each flag lives in its own field, so no update needs a
+ * read-modify-write of a shared bitfield word.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @struct StatusRegister
+ * @brief Represents the status register flags for the RISC machine.
+ *
+ * Contains individual flag bits for zero, carry, negative, overflow, and division by zero.
+ */
+struct StatusRegister {
+    /** @brief Zero flag compare (1 if result is zero) */
+    uint32_t ZF : 1;
+    /** @brief Carry flag (1 if carry occurred) */
+    uint32_t CF : 1;
+    /** @brief Negative flag (1 if result is negative) */
+    uint32_t NF : 1;
+    /** @brief Overflow flag (1 if overflow occurred) */
+    uint32_t OF : 1;
+    /** @brief Division by zero flag (1 if division by zero occurred) */
+    uint32_t DF : 1;
+    /** @brief Reserved bits (unused) */
+    uint32_t reserved : 28;
+};
+
+/**
+ * @class LazyFlags
+ * @brief Condition flags that are computed on demand from the last flag-setting operation.
+ *
+ * Two pending records are kept: the carry record (last ADD or SUB, source of CF)
+ * and the overflow record (last MUL, source of OF). NF comes from whichever of
+ * them was written last, so alternating ADD and MUL never forces evaluation.
+ * Reading a flag returns exactly the value the eager implementation would hold.
+ * Every member is constexpr, so ConstexprMachine (constexpr_machine.hpp) shares
+ * these semantics in constant expressions.
+ */
+class LazyFlags {
+public:
+    /** @brief Clears all flags. */
+    constexpr void reset() { *this = LazyFlags(); }
+
+    /** @brief CMP: sets ZF. */
+    constexpr void setZero(bool zero) { zf = zero; }
+
+    /** @brief ADD: CF and NF follow from lhs + rhs. */
+    constexpr void setAdd(uint32_t lhs, uint32_t rhs) { setCarry(Carry::Add, lhs, rhs); }
+
+    /** @brief SUB: CF and NF follow from lhs - rhs. */
+    constexpr void setSub(uint32_t lhs, uint32_t rhs) { setCarry(Carry::Sub, lhs, rhs); }
+
+    /** @brief MUL: OF and NF follow from lhs * rhs. */
+    constexpr void setMul(uint32_t lhs, uint32_t rhs) {
+        overflow = Overflow::Mul;
+        of_lhs = lhs;
+        of_rhs = rhs;
+        nf_source = Negative::FromOverflow;
+    }
+
+    /** @brief DIV with a non-zero divisor: NF from the quotient, DF, OF and CF cleared. */
+    constexpr void setDiv(uint32_t quotient) {
+        nf_value = quotient >> 31;
+        nf_source = Negative::Value;
+        df = 0;
+        clearCarryAndOverflow();
+    }
+
+    /** @brief DIV by zero: DF set, OF and CF cleared, NF unchanged. */
+    constexpr void setDivByZero() {
+        nf_value = negative();
+        nf_source = Negative::Value;
+        df = 1;
+        clearCarryAndOverflow();
+    }
+
+    /** @brief Gets ZF. */
+    constexpr uint32_t zero() const { return zf; }
+
+    /** @brief Gets CF. */
+    constexpr uint32_t carry() const {
+        switch (carry_op) {
+            case Carry::Add: return static_cast<uint32_t>(cf_lhs + cf_rhs) < cf_lhs;
+            case Carry::Sub: return cf_lhs < cf_rhs;
+            default: return cf_lhs;  // Carry::Value keeps the bit in cf_lhs
+        }
+    }
+
+    /** @brief Gets NF. */
+    constexpr uint32_t negative() const {
+        switch (nf_source) {
+            case Negative::FromCarry:
+                return (carry_op == Carry::Add ? cf_lhs + cf_rhs : cf_lhs - cf_rhs) >> 31;
+            case Negative::FromOverflow:
+                return (of_lhs * of_rhs) >> 31;
+            default:
+                return nf_value;
+        }
+    }
+
+    /** @brief Gets OF. */
+    constexpr uint32_t overflowed() const {
+        if (overflow == Overflow::Mul) {
+            return (static_cast<uint64_t>(of_lhs) * of_rhs) >> 32 != 0;
+        }
+        return of_lhs;  // Overflow::Value keeps the bit in of_lhs
+    }
+
+    /** @brief Gets DF. */
+    constexpr uint32_t divideByZero() const { return df; }
+
+    /**
+     * @brief Reads a flag by its CHECK_FLAG index.
+     * @param index 0 = ZF, 1 = CF, 2 = NF, 3 = OF, 4 = DF.
+     * @return The flag value; unknown indices read as 0.
+     */
+    constexpr uint32_t read(uint32_t index) const {
+        switch (index) {
+            case 0: return zero();
+            case 1: return carry();
+            case 2: return negative();
+            case 3: return overflowed();
+            case 4: return divideByZero();
+            default: return 0;
+        }
+    }
+
+    /** @brief Evaluates all flags into a StatusRegister. */
+    constexpr StatusRegister get() const {
+        StatusRegister sr{};
+        sr.ZF = zero();
+        sr.CF = carry();
+        sr.NF = negative();
+        sr.OF = overflowed();
+        sr.DF = divideByZero();
+        return sr;
+    }
+
+    /** @brief Replaces all flags with evaluated values. */
+    constexpr void set(const StatusRegister& sr) {
+        zf = sr.ZF;
+        df = sr.DF;
+        carry_op = Carry::Value;
+        cf_lhs = sr.CF;
+        overflow = Overflow::Value;
+        of_lhs = sr.OF;
+        nf_source = Negative::Value;
+        nf_value = sr.NF;
+    }
+
+private:
+    enum class Carry : uint8_t { Value, Add, Sub };
+    enum class Overflow : uint8_t { Value, Mul };
+    enum class Negative : uint8_t { Value, FromCarry, FromOverflow };
+
+    constexpr void setCarry(Carry op, uint32_t lhs, uint32_t rhs) {
+        carry_op = op;
+        cf_lhs = lhs;
+        cf_rhs = rhs;
+        nf_source = Negative::FromCarry;
+    }
+
+    constexpr void clearCarryAndOverflow() {
+        carry_op = Carry::Value;
+        cf_lhs = 0;
+        overflow = Overflow::Value;
+        of_lhs = 0;
+    }
+
+    uint32_t cf_lhs = 0;  // carry record operands (or the CF bit)
+    uint32_t cf_rhs = 0;
+    uint32_t of_lhs = 0;  // overflow record operands (or the OF bit)
+    uint32_t of_rhs = 0;
+    uint8_t zf = 0;
+    uint8_t df = 0;
+    uint8_t nf_value = 0;
+    Carry carry_op = Carry::Value;
+    Overflow overflow = Overflow::Value;
+    Negative nf_source = Negative::Value;
+};
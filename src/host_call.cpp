@@ -0,0 +1,109 @@
+/**
+ * @file host_call.cpp
+ * @brief Implementation of the host call table and the built-in kernels.
+ */
+
+#include "host_call.hpp"
+#include <algorithm>
+#include <utility>
+
+/**
+ * @brief Binds a function to a call ID, growing the table as needed.
+ *
+ * @param id Call ID.
+ * @param function The function; empty to unbind.
+ */
+void HostCallTable::bind(uint32_t id, HostFunction function) {
+    if (id >= functions.size()) {
+        if (!function) return;
+        functions.resize(size_t{id} + 1);
+    }
+    functions[id] = std::move(function);
+}
+
+/**
+ * @brief Creates a table with kHostSortWords, kHostHashWords and kHostBigMultiply bound.
+ *
+ * @return The table.
+ */
+HostCallTable HostCallTable::builtins() {
+    HostCallTable table;
+    table.bind(kHostSortWords, hostSortWords);
+    table.bind(kHostHashWords, hostHashWords);
+    table.bind(kHostBigMultiply, hostBigMultiply);
+    return table;
+}
+
+/**
+ * @brief Sorts a range of words in place.
+ *
+ * @param call R0 = address, R1 = word count.
+ * @return False if the range extends beyond data memory.
+ */
+bool hostSortWords(HostCall& call) {
+    const uint32_t address = call.registers[0];
+    const uint32_t count = call.registers[1];
+    if (!call.memory.contains(address, count)) return false;
+    std::vector<uint32_t> words(count);
+    call.memory.read(address, words.data(), count);
+    std::sort(words.begin(), words.end());
+    call.memory.write(address, words.data(), count);
+    return true;
+}
+
+/**
+ * @brief Hashes a range of words into R0.
+ *
+ * Reads in fixed-size blocks so no allocation is needed.
+ *
+ * @param call R0 = address, R1 = word count.
+ * @return False if the range extends beyond data memory.
+ */
+bool hostHashWords(HostCall& call) {
+    uint32_t address = call.registers[0];
+    uint32_t count = call.registers[1];
+    if (!call.memory.contains(address, count)) return false;
+    uint32_t hash = 0x811C9DC5u;
+    uint32_t block[DataMemory::kPageWords];
+    while (count) {
+        const uint32_t chunk = std::min(count, DataMemory::kPageWords);
+        call.memory.read(address, block, chunk);
+        for (uint32_t i = 0; i < chunk; ++i) hash = (hash + block[i]) * 0x01000193u;
+        address += chunk;
+        count -= chunk;
+    }
+    call.registers[0] = hash;
+    return true;
+}
+
+/**
+ * @brief Schoolbook multiplication of two big integers.
+ *
+ * Both operands are read before the product is written, so the ranges may overlap.
+ *
+ * @param call R0/R1 = lhs address/limbs, R2/R3 = rhs address/limbs, R4 = product address.
+ * @return False if a range extends beyond data memory.
+ */
+bool hostBigMultiply(HostCall& call) {
+    const uint32_t* r = call.registers;
+    const uint64_t product_limbs = uint64_t(r[1]) + r[3];
+    if (!call.memory.contains(r[0], r[1]) || !call.memory.contains(r[2], r[3]) ||
+        !call.memory.contains(r[4], static_cast<size_t>(product_limbs))) {
+        return false;
+    }
+    std::vector<uint32_t> lhs(r[1]), rhs(r[3]), product(static_cast<size_t>(product_limbs), 0);
+    call.memory.read(r[0], lhs.data(), lhs.size());
+    call.memory.read(r[2], rhs.data(), rhs.size());
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        uint64_t carry = 0;
+        for (size_t j = 0; j < rhs.size(); ++j) {
+            const uint64_t t = uint64_t(lhs[i]) * rhs[j] + product[i + j] + carry;
+            product[i + j] = static_cast<uint32_t>(t);
+            carry = t >> 32;
+        }
+        product[i + rhs.size()] = static_cast<uint32_t>(carry);
+    }
+    call.memory.write(r[4], product.data(), product.size());
+    call.flags.setZero(std::all_of(product.begin(), product.end(), [](uint32_t limb) { return limb == 0; }));
+    return true;
+}
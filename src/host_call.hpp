@@ -0,0 +1,191 @@
+/**
+ * @file host_call.hpp
+ * @brief Declares host calls: native C++ functions that guest code invokes with HOSTCALL.
+ *
+ * `{HOSTCALL, id, 0, 0}` calls the function bound to call ID @c id in the
+ * machine's HostCallTable. The function receives a HostCall: the guest's data
+ * registers, which it reads and writes directly, a bounds-checked view of data
+ * memory, and the status flags. Arguments and results are passed in registers
+ * by whatever convention the function documents; the built-in kernels take
+ * their arguments from R0 upwards and return a result in R0.
+ *
+ * A function returns false to fault: the program halts like an out-of-range
+ * indirect LOAD. Calling an ID with no function bound faults the same way.
+ * Whatever the function does, HOSTCALL retires as one instruction.
+ *
+ * Functions run on the thread that runs the machine; with runHarts() they are
+ * called from several threads at once. For record/replay they must be
+ * deterministic, and the replaying machine must bind the same functions
+ * (ReplayOptions::host_calls).
+ */
+
+#pragma once
+
+#include "data_memory.hpp"
+#include "flags.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @class HostMemory
+ * @brief Bounds-checked access to a machine's data memory from a host call.
+ *
+ * Every access checks the whole range first and touches nothing if any word
+ * lies outside data memory.
+ */
+class HostMemory {
+public:
+    explicit HostMemory(DataMemory& memory) : memory(memory) {}
+
+    /** @brief Gets the data memory size in words. */
+    size_t size() const { return memory.size(); }
+
+    /**
+     * @brief Checks that a range lies inside data memory.
+     * @param address First word address.
+     * @param count Number of words.
+     * @return True if address + count does not exceed size().
+     */
+    bool contains(uint32_t address, size_t count) const { return uint64_t(address) + count <= memory.size(); }
+
+    /**
+     * @brief Reads one word.
+     * @param address Word address.
+     * @param value Receives the word.
+     * @return False if the address is outside data memory.
+     */
+    bool load(uint32_t address, uint32_t& value) const {
+        if (address >= memory.size()) return false;
+        value = memory.read(address);
+        return true;
+    }
+
+    /**
+     * @brief Writes one word.
+     * @param address Word address.
+     * @param value The value to store.
+     * @return False if the address is outside data memory.
+     */
+    bool store(uint32_t address, uint32_t value) {
+        if (address >= memory.size()) return false;
+        memory.write(address, value);
+        return true;
+    }
+
+    /**
+     * @brief Copies consecutive words out of data memory.
+     * @param address First word address.
+     * @param out Receives @p count words.
+     * @param count Number of words.
+     * @return False, reading nothing, if the range extends beyond data memory.
+     */
+    bool read(uint32_t address, uint32_t* out, size_t count) const {
+        if (!contains(address, count)) return false;
+        memory.readRange(address, out, count);
+        return true;
+    }
+
+    /**
+     * @brief Copies words into consecutive addresses of data memory.
+     * @param address First word address.
+     * @param values The @p count words to store.
+     * @param count Number of words.
+     * @return False, writing nothing, if the range extends beyond data memory.
+     */
+    bool write(uint32_t address, const uint32_t* values, size_t count) {
+        if (!contains(address, count)) return false;
+        memory.writeRange(address, values, count);
+        return true;
+    }
+
+private:
+    DataMemory& memory;
+};
+
+/**
+ * @struct HostCall
+ * @brief What a host function may access while it runs.
+ */
+struct HostCall {
+    uint32_t* registers;     /**< R0 … R(register_count - 1), read and written in place */
+    size_t register_count;   /**< Number of data registers */
+    HostMemory memory;       /**< The machine's data memory */
+    LazyFlags& flags;        /**< Status flags; set them with setFlags() or the LazyFlags setters */
+    uint32_t hart_id;        /**< Index of the calling hart */
+
+    /** @brief Gets the evaluated status flags. */
+    StatusRegister getFlags() const { return flags.get(); }
+
+    /** @brief Replaces all status flags. */
+    void setFlags(const StatusRegister& status) { flags.set(status); }
+};
+
+/**
+ * @brief A native function callable from guest code.
+ *
+ * Returns false to fault and halt the guest program.
+ */
+using HostFunction = std::function<bool(HostCall&)>;
+
+/**
+ * @class HostCallTable
+ * @brief Call IDs bound to host functions.
+ */
+class HostCallTable {
+public:
+    /**
+     * @brief Binds a function to a call ID, replacing any previous binding.
+     * @param id Call ID, the dst operand of HOSTCALL.
+     * @param function The function; an empty function unbinds the ID.
+     */
+    void bind(uint32_t id, HostFunction function);
+
+    /**
+     * @brief Looks up the function bound to a call ID.
+     * @param id Call ID.
+     * @return The function, or nullptr if none is bound.
+     */
+    const HostFunction* find(uint32_t id) const {
+        return id < functions.size() && functions[id] ? &functions[id] : nullptr;
+    }
+
+    /**
+     * @brief Creates a table holding the built-in kernels under their HostKernel IDs.
+     * @return The table.
+     */
+    static HostCallTable builtins();
+
+private:
+    std::vector<HostFunction> functions;  // indexed by call ID
+};
+
+/**
+ * @enum HostKernel
+ * @brief Call IDs of the built-in kernels (HostCallTable::builtins()).
+ *
+ * Each kernel faults, changing nothing, if a range it would touch extends
+ * beyond data memory.
+ */
+enum HostKernel : uint32_t {
+    /** Sorts R1 words at RAM[R0] in ascending unsigned order. */
+    kHostSortWords = 0,
+    /** R0 = hash of R1 words at RAM[R0]: h = 0x811C9DC5, then h = (h + word) * 0x01000193 per word. */
+    kHostHashWords = 1,
+    /**
+     * Multiplies two unsigned big integers of 32-bit little-endian limbs:
+     * RAM[R4 .. R4 + R1 + R3) = RAM[R0 .. R0 + R1) * RAM[R2 .. R2 + R3).
+     * The result may overlap the operands. Sets ZF if the product is zero.
+     */
+    kHostBigMultiply = 2,
+};
+
+/** @brief Kernel kHostSortWords. */
+bool hostSortWords(HostCall& call);
+
+/** @brief Kernel kHostHashWords. */
+bool hostHashWords(HostCall& call);
+
+/** @brief Kernel kHostBigMultiply. */
+bool hostBigMultiply(HostCall& call);
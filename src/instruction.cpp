@@ -0,0 +1,44 @@
+/**
+ * @file instruction.cpp
+ * @brief Implementation of the opcode helpers declared in instruction.hpp.
+ */
+
+#include "instruction.hpp"
+
+/**
+ * @brief Gets the mnemonic of an opcode.
+ *
+ * @param opcode The opcode.
+ * @return The mnemonic, or "UNKNOWN" for values outside the enumeration.
+ */
+const char* opcodeName(Opcode opcode) {
+    switch (opcode) {
+        case Opcode::HALT: return "HALT";
+        case Opcode::LOAD: return "LOAD";
+        case Opcode::STORE: return "STORE";
+        case Opcode::ADD: return "ADD";
+        case Opcode::SUB: return "SUB";
+        case Opcode::CMP: return "CMP";
+        case Opcode::JMP: return "JMP";
+        case Opcode::MUL: return "MUL";
+        case Opcode::DIV: return "DIV";
+        case Opcode::MOV: return "MOV";
+        case Opcode::CHECK_FLAG: return "CHECK_FLAG";
+        case Opcode::ATOMIC_ADD: return "ATOMIC_ADD";
+        case Opcode::CAS: return "CAS";
+        case Opcode::FENCE: return "FENCE";
+        case Opcode::HART_ID: return "HART_ID";
+        case Opcode::VLOAD: return "VLOAD";
+        case Opcode::VSTORE: return "VSTORE";
+        case Opcode::VADD: return "VADD";
+        case Opcode::VSUB: return "VSUB";
+        case Opcode::VMUL: return "VMUL";
+        case Opcode::VREDUCE: return "VREDUCE";
+        case Opcode::VSETVL: return "VSETVL";
+        case Opcode::MEMCPY: return "MEMCPY";
+        case Opcode::MEMSET: return "MEMSET";
+        case Opcode::MEMCMP: return "MEMCMP";
+        case Opcode::HOSTCALL: return "HOSTCALL";
+    }
+    return "UNKNOWN";
+}
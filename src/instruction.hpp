@@ -1,6 +1,40 @@
 /**
  * @file instruction.hpp
  * @brief Defines the Opcode enumeration and Instruction struct for the RISC emulator.
+ *
+ * Memory model of machines running several harts (RiscMachine::runHarts()):
+ * - Every word access is single-copy atomic: a hart never observes a torn word.
+ * - ATOMIC_ADD and CAS are indivisible read-modify-writes, and together with
+ *   FENCE they are sequentially consistent: all harts observe them in one
+ *   total order.
+ * - Plain LOAD and STORE are relaxed. Another hart may observe one hart's
+ *   plain accesses out of program order; FENCE orders every access before it
+ *   before every access after it. To publish data, STORE it, FENCE, then
+ *   STORE (or ATOMIC_ADD) a flag; to consume it, LOAD the flag, FENCE, then
+ *   LOAD the data.
+ * A single hart always observes its own accesses in program order. An
+ * ATOMIC_ADD or CAS address outside data memory faults like an indirect LOAD.
+ * The interpreters implement plain accesses as relaxed atomic loads and stores
+ * (DataMemory) and FENCE as __atomic_thread_fence(__ATOMIC_SEQ_CST); the JIT
+ * uses plain moves and MFENCE, which x86-64 orders the same way.
+ *
+ * Vector instructions (VLOAD … VSETVL) work on the vector registers V0–V7 of
+ * vector_unit.hpp and process the first vl elements; they never change flags.
+ * VLOAD and VSTORE access each element with a plain access and fault like an
+ * indirect LOAD, before touching memory, if any element lies outside data memory.
+ *
+ * Bulk memory instructions (MEMCPY, MEMSET, MEMCMP) take two address registers
+ * and a word count register and retire as one instruction, however many words
+ * they touch. They fault like an indirect LOAD, before touching memory, if
+ * either range extends beyond data memory; a count of zero never faults.
+ * MEMCMP compares the ranges in address order: ZF is set if they are equal,
+ * and CF and NF are set as SUB sets them for the first pair of words that
+ * differs (both clear if none does). With several harts, every word is a
+ * plain access.
+ *
+ * HOSTCALL runs a native function bound on the machine (host_call.hpp). It
+ * may read and write any register, flag and word of data memory, and faults
+ * if no function is bound to its call ID or the function reports a fault.
  */
 
 #pragma once
@@ -22,9 +56,31 @@ enum class Opcode {
     MUL,    /**< Multiply two data_registers and store result in destination */
     DIV,     /**< Divide two data_registers and store result in destination */
     MOV,    /**< Move value from one register to another */
-    CHECK_FLAG /**< Check a specific flag in the status register */
+    CHECK_FLAG, /**< Check a specific flag in the status register */
+    ATOMIC_ADD, /**< dst = RAM[R[src1]]; RAM[R[src1]] += R[src2], atomically */
+    CAS,        /**< Compare-and-swap: if RAM[R[src1]] == R[dst], RAM[R[src1]] = R[src2]; ZF = success; dst = old value */
+    FENCE,      /**< Order all earlier memory accesses before all later ones */
+    HART_ID,    /**< dst = index of the executing hart */
+    VLOAD,      /**< V[dst][i] = RAM[R[src1] + i * R[src2]] for i < vl */
+    VSTORE,     /**< RAM[R[dst] + i * R[src2]] = V[src1][i] for i < vl */
+    VADD,       /**< V[dst] = V[src1] + V[src2], element-wise */
+    VSUB,       /**< V[dst] = V[src1] - V[src2], element-wise */
+    VMUL,       /**< V[dst] = V[src1] * V[src2], element-wise (low 32 bits) */
+    VREDUCE,    /**< dst = sum of the first vl elements of V[src1] (wrapping) */
+    VSETVL,     /**< vl = min(R[src1], VLMAX); dst = vl */
+    MEMCPY,     /**< RAM[R[dst] + i] = RAM[R[src1] + i] for i < R[src2]; overlapping ranges behave like memmove */
+    MEMSET,     /**< RAM[R[dst] + i] = R[src1] for i < R[src2] */
+    MEMCMP,     /**< Compare R[src2] words at RAM[R[dst]] and RAM[R[src1]]: ZF = equal; CF/NF as SUB of the first differing pair */
+    HOSTCALL    /**< Call the host function bound to call ID dst (see host_call.hpp) */
 };
 
+/**
+ * @brief Gets the mnemonic of an opcode.
+ * @param opcode The opcode.
+ * @return The name used in diagnostics and traces ("ADD", "LOAD", ...), or "UNKNOWN".
+ */
+const char* opcodeName(Opcode opcode);
+
 /**
  * @struct Instruction
  * @brief Represents a single instruction for the RISC machine.
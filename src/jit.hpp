@@ -0,0 +1,137 @@
+/**
+ * @file jit.hpp
+ * @brief Declares the basic-block JIT compiler that translates programs to native x86-64 code.
+ *
+ * The JIT works on the output of decodeProgram(). Block leaders are found from JMP
+ * targets and fall-through points, every block is translated into native code in a
+ * single executable mapping, and jumps between blocks are emitted as direct native
+ * jumps. Guest registers and flags live in a pinned JitContext addressed through a
+ * host register; a flag is only materialised when a later instruction (or the exit
+ * back to the host) can observe it.
+ *
+ * Loads and stores walk the two-level page tables of a DataMemory. A store to a
+ * page without a write pointer returns to the host with ctx.fault_page set;
+ * the host makes the page writable and re-enters at ctx.pc, which re-executes
+ * the store. A REDUCE record whose step register holds 1 returns with
+ * ctx.fault_page = kReduction; the host runs the loop's clean iterations and
+ * the head load, and re-enters after the head.
+ */
+
+#pragma once
+
+#include "decoder.hpp"
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * @struct JitContext
+ * @brief Guest state shared between the host and translated code.
+ */
+struct JitContext {
+    uint32_t regs[16];            /**< Guest registers R0–R15 */
+    uint8_t flags[5];             /**< ZF, CF, NF, OF, DF (one byte each) */
+    uint32_t pc;                  /**< Program counter on exit */
+    uint32_t fault_page;          /**< Page a store needs written (kNoFault if none) */
+    uint32_t* const* const* directory; /**< DataMemory::directoryTable() */
+    uint32_t* const* const* write_directory; /**< DataMemory::writeDirectoryTable() */
+    uint64_t memory_size;         /**< Number of words in guest data memory */
+    uint32_t hart_id;             /**< Value of HART_ID */
+
+    static constexpr uint32_t kNoFault = UINT32_MAX;  /**< fault_page value of a normal exit */
+    static constexpr uint32_t kReduction = UINT32_MAX - 1;  /**< fault_page value at a REDUCE head; pc names it */
+    static constexpr uint32_t kHostOp = UINT32_MAX - 2;  /**< fault_page value at an atomic, vector, bulk memory or host call instruction; the host executes it */
+};
+
+/**
+ * @class JitProgram
+ * @brief Native translation of one decoded program.
+ *
+ * Instances are immutable once compiled and may be shared between machines.
+ */
+class JitProgram {
+public:
+    /**
+     * @brief Translates a decoded program into native code.
+     * @param decoded The decoded program (including the EXIT sentinel).
+     * @param data_size Size of the guest data memory.
+     * @return The compiled program, or nullptr if the host is not supported.
+     */
+    static std::shared_ptr<const JitProgram> compile(const std::vector<DecodedInstruction>& decoded,
+                                                     size_t data_size);
+
+    /**
+     * @brief Recreates a compiled program from code saved with codeData() (e.g. by a TranslationCache).
+     *
+     * The code is copied into a new executable mapping. It contains no absolute
+     * addresses, so it runs wherever it is placed; the caller must have
+     * validated it, since it is executed as is.
+     *
+     * @param code The generated machine code.
+     * @param length Its length in bytes.
+     * @param entry_offsets Native offset of each guest instruction, the halt stub and the exit stub.
+     * @param block_count Number of basic blocks.
+     * @return The program, or nullptr if the host is not supported or an offset lies outside the code.
+     */
+    static std::shared_ptr<const JitProgram> load(const uint8_t* code, size_t length,
+                                                  std::vector<uint32_t> entry_offsets, size_t block_count);
+
+    /**
+     * @brief Returns whether native translation is available on this host.
+     */
+    static bool isSupported();
+
+    ~JitProgram();
+    JitProgram(const JitProgram&) = delete;
+    JitProgram& operator=(const JitProgram&) = delete;
+
+    /**
+     * @brief Runs translated code starting at the given program counter.
+     *
+     * Execution continues until the program halts, faults, falls off the end,
+     * stores to a copy-on-write page or reaches a reduction loop; ctx.pc holds the
+     * program counter to resume at. ctx.fault_page must be JitContext::kNoFault on
+     * entry and names the page (or kReduction) in the last two cases.
+     *
+     * @param ctx Guest state.
+     * @param pc Program counter to start at (must be less than the program size).
+     */
+    void enter(JitContext& ctx, uint32_t pc) const;
+
+    /**
+     * @brief Gets the number of basic blocks found in the program.
+     */
+    size_t blockCount() const;
+
+    /**
+     * @brief Gets the size of the executable mapping in bytes.
+     */
+    size_t codeSize() const;
+
+    /**
+     * @brief Gets the generated machine code, codeLength() bytes long.
+     */
+    const uint8_t* codeData() const { return static_cast<const uint8_t*>(code); }
+
+    /**
+     * @brief Gets the number of bytes of generated machine code.
+     */
+    size_t codeLength() const { return code_length; }
+
+    /**
+     * @brief Gets the native offset of each guest instruction, followed by the halt and exit stubs.
+     */
+    const std::vector<uint32_t>& entryOffsets() const { return entry_offsets; }
+
+private:
+    JitProgram() = default;
+
+    bool map(const uint8_t* bytes, size_t length);
+
+    void* code = nullptr;                 // executable mapping
+    size_t code_size = 0;                 // of the mapping
+    size_t code_length = 0;               // of the generated code
+    std::vector<uint32_t> entry_offsets;  // native offset of each guest instruction
+    size_t block_count = 0;
+};
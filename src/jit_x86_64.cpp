@@ -0,0 +1,624 @@
+/**
+ * @file jit_x86_64.cpp
+ * @brief x86-64 back end of the basic-block JIT compiler.
+ *
+ * Register conventions inside translated code:
+ * - RBX holds the JitContext pointer for the whole run (callee-saved, pushed on entry).
+ * - EAX, ECX and EDX are scratch registers.
+ *
+ * Guest registers and flags are read from and written to the context directly, so
+ * entering at any instruction boundary is valid and the host sees a consistent
+ * state on exit.
+ */
+
+#include "jit.hpp"
+#include "data_memory.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define RISC_JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#else
+#define RISC_JIT_X86_64 0
+#endif
+
+namespace {
+
+// Flag bits used by the liveness analysis; index k matches CHECK_FLAG k
+constexpr uint8_t ZF_BIT = 1 << 0;
+constexpr uint8_t CF_BIT = 1 << 1;
+constexpr uint8_t NF_BIT = 1 << 2;
+constexpr uint8_t OF_BIT = 1 << 3;
+constexpr uint8_t DF_BIT = 1 << 4;
+constexpr uint8_t ALL_FLAGS = ZF_BIT | CF_BIT | NF_BIT | OF_BIT | DF_BIT;
+
+/**
+ * @brief Flags read and unconditionally overwritten by one decoded instruction.
+ */
+struct FlagEffect {
+    uint8_t use;
+    uint8_t kill;
+};
+
+FlagEffect flagEffect(const DecodedInstruction& d) {
+    switch (d.op) {
+        case DecodedOp::ADD:
+        case DecodedOp::SUB:           return {0, CF_BIT | NF_BIT};
+        case DecodedOp::MUL:           return {0, OF_BIT | NF_BIT};
+        case DecodedOp::DIV:           return {0, DF_BIT | OF_BIT | CF_BIT};  // NF only when divisor != 0
+        case DecodedOp::CMP:
+        case DecodedOp::CMP_INVALID:   return {0, ZF_BIT};
+        case DecodedOp::JZ:            return {ZF_BIT, 0};
+        case DecodedOp::CHECK_FLAG:    return {static_cast<uint8_t>(1u << d.b), 0};
+        // Leaving translated code exposes every flag to the host
+        case DecodedOp::HALT:
+        case DecodedOp::EXIT:
+        case DecodedOp::LOAD_INDIRECT:
+        case DecodedOp::REDUCE:
+        case DecodedOp::ATOMIC_ADD:
+        case DecodedOp::CAS:
+        case DecodedOp::VLOAD:
+        case DecodedOp::VSTORE:
+        case DecodedOp::VADD:
+        case DecodedOp::VSUB:
+        case DecodedOp::VMUL:
+        case DecodedOp::VREDUCE:
+        case DecodedOp::VSETVL:
+        case DecodedOp::MEMCPY:
+        case DecodedOp::MEMSET:
+        case DecodedOp::MEMCMP:
+        case DecodedOp::HOSTCALL:      return {ALL_FLAGS, 0};  // may fault or return to the host
+        default:                       return {0, 0};
+    }
+}
+
+/**
+ * @brief Computes, for each instruction, the flags that may be read after it.
+ *
+ * Standard backward liveness over the control-flow graph; a flag write is only
+ * emitted when the flag is live after the writing instruction.
+ */
+std::vector<uint8_t> liveFlagsOut(const std::vector<DecodedInstruction>& decoded) {
+    const size_t n = decoded.size() - 1;
+    std::vector<uint8_t> live_in(n + 1, 0);
+    std::vector<uint8_t> live_out(n, 0);
+    live_in[n] = ALL_FLAGS;
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = n; i-- > 0;) {
+            const DecodedInstruction& d = decoded[i];
+            uint8_t out = 0;
+            switch (d.op) {
+                case DecodedOp::JMP:  out = live_in[d.a]; break;
+                case DecodedOp::JZ:   out = live_in[d.a] | live_in[i + 1]; break;
+                case DecodedOp::HALT: out = 0; break;
+                default:              out = live_in[i + 1]; break;
+            }
+            FlagEffect effect = flagEffect(d);
+            uint8_t in = effect.use | (out & ~effect.kill);
+            live_out[i] = out;
+            if (in != live_in[i]) {
+                live_in[i] = in;
+                changed = true;
+            }
+        }
+    }
+    return live_out;
+}
+
+/**
+ * @brief Counts basic blocks: leaders are PC 0, jump targets and fall-through points.
+ */
+size_t countBlocks(const std::vector<DecodedInstruction>& decoded) {
+    const size_t n = decoded.size() - 1;
+    std::vector<bool> leader(n + 1, false);
+    leader[0] = true;
+    for (size_t i = 0; i < n; ++i) {
+        const DecodedInstruction& d = decoded[i];
+        if (d.op == DecodedOp::JMP || d.op == DecodedOp::JZ) {
+            leader[d.a] = true;
+            leader[i + 1] = true;
+        } else if (d.op == DecodedOp::HALT) {
+            leader[i + 1] = true;
+        }
+    }
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) count += leader[i];
+    return count;
+}
+
+// Host register numbers as encoded in ModRM
+enum HostReg : uint8_t { EAX = 0, ECX = 1, EDX = 2, EBX = 3 };
+
+// Condition codes (second opcode byte of SETcc is 0x90 | cc, of Jcc rel32 is 0x80 | cc)
+enum Cond : uint8_t { CC_O = 0x0, CC_B = 0x2, CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5, CC_S = 0x8 };
+
+constexpr int32_t regOffset(uint32_t index) {
+    return static_cast<int32_t>(offsetof(JitContext, regs) + 4 * index);
+}
+constexpr int32_t flagOffset(uint32_t index) {
+    return static_cast<int32_t>(offsetof(JitContext, flags) + index);
+}
+
+/**
+ * @class Assembler
+ * @brief Minimal x86-64 encoder for the handful of instruction forms the JIT needs.
+ */
+class Assembler {
+public:
+    std::vector<uint8_t> bytes;
+
+    size_t position() const { return bytes.size(); }
+
+    void byte(uint8_t value) { bytes.push_back(value); }
+
+    void dword(uint32_t value) {
+        for (int i = 0; i < 4; ++i) byte(static_cast<uint8_t>(value >> (8 * i)));
+    }
+
+    // ModRM with a [base + disp32] memory operand (base is RBX or RCX)
+    void memoryOperand(uint8_t reg, HostReg base, int32_t disp) {
+        byte(static_cast<uint8_t>(0x80 | (reg << 3) | base));
+        dword(static_cast<uint32_t>(disp));
+    }
+
+    // mov r32, [rbx + disp]
+    void loadContext(HostReg reg, int32_t disp) { byte(0x8B); memoryOperand(reg, EBX, disp); }
+
+    // mov [rbx + disp], r32
+    void storeContext(HostReg reg, int32_t disp) { byte(0x89); memoryOperand(reg, EBX, disp); }
+
+    // mov rcx, [base + disp] (64-bit)
+    void loadPointer(HostReg base, int32_t disp) {
+        byte(0x48);
+        byte(0x8B);
+        memoryOperand(ECX, base, disp);
+    }
+
+    // rcx = words of a guest page, walking ctx.directory or ctx.write_directory
+    void loadPage(int32_t directory, uint32_t page) {
+        loadPointer(EBX, directory);
+        loadPointer(ECX, static_cast<int32_t>((page >> DataMemory::kTableShift) * 8));
+        loadPointer(ECX, static_cast<int32_t>((page & DataMemory::kTableMask) * 8));
+    }
+
+    // mov byte [rbx + disp], imm8
+    void storeContextByte(int32_t disp, uint8_t value) {
+        byte(0xC6);
+        memoryOperand(0, EBX, disp);
+        byte(value);
+    }
+
+    // setcc byte [rbx + disp]
+    void setFlag(Cond cond, int32_t disp) {
+        byte(0x0F);
+        byte(static_cast<uint8_t>(0x90 | cond));
+        memoryOperand(0, EBX, disp);
+    }
+
+    // jcc rel32 / jmp rel32; returns the position of the displacement for patching
+    size_t jumpIf(Cond cond) {
+        byte(0x0F);
+        byte(static_cast<uint8_t>(0x80 | cond));
+        dword(0);
+        return position() - 4;
+    }
+    size_t jump() {
+        byte(0xE9);
+        dword(0);
+        return position() - 4;
+    }
+
+    void patch(size_t displacement_at, size_t target) {
+        int32_t rel = static_cast<int32_t>(target) - static_cast<int32_t>(displacement_at + 4);
+        std::memcpy(&bytes[displacement_at], &rel, sizeof(rel));
+    }
+};
+
+/**
+ * @brief Emits native code for one decoded instruction.
+ *
+ * Jumps to other guest instructions are recorded in @p fixups as
+ * (displacement position, guest target) pairs and patched once every
+ * instruction has an address. The guest target equal to the program size
+ * denotes the shared halt stub, one past it the store-miss exit stub.
+ */
+void emitInstruction(Assembler& as, const DecodedInstruction& d, uint32_t index, uint8_t live,
+                     uint32_t program_size, std::vector<std::pair<size_t, uint32_t>>& fixups) {
+    switch (d.op) {
+        case DecodedOp::NOP:
+        case DecodedOp::EXIT:
+            break;
+
+        case DecodedOp::HALT:
+            fixups.emplace_back(as.jump(), program_size);
+            break;
+
+        case DecodedOp::LOAD_DIRECT:
+            as.loadPage(offsetof(JitContext, directory), d.b >> DataMemory::kPageShift);
+            as.byte(0x8B);                                         // mov eax, [rcx + offset*4]
+            as.memoryOperand(EAX, ECX, static_cast<int32_t>((d.b & DataMemory::kPageMask) * 4));
+            as.storeContext(EAX, regOffset(d.a));
+            break;
+
+        case DecodedOp::REDUCE: {
+            // With a step of 1 the host runs the loop; otherwise this is the plain head load
+            as.byte(0x83);                                         // cmp dword [rbx + disp], 1
+            as.memoryOperand(7, EBX, regOffset(d.d));
+            as.byte(1);
+            size_t to_load = as.jumpIf(CC_NE);
+            as.byte(0xC7);                                         // mov dword [rbx + pc], index
+            as.memoryOperand(0, EBX, offsetof(JitContext, pc));
+            as.dword(index);
+            as.byte(0xC7);                                         // mov dword [rbx + fault_page], kReduction
+            as.memoryOperand(0, EBX, offsetof(JitContext, fault_page));
+            as.dword(JitContext::kReduction);
+            fixups.emplace_back(as.jump(), program_size + 1);
+            as.patch(to_load, as.position());
+            [[fallthrough]];
+        }
+
+        case DecodedOp::LOAD_INDIRECT:
+            as.loadContext(EAX, regOffset(d.b));                   // zero-extends into rax
+            as.byte(0x48);                                         // cmp rax, [rbx + memory_size]
+            as.byte(0x3B);
+            as.memoryOperand(EAX, EBX, offsetof(JitContext, memory_size));
+            fixups.emplace_back(as.jumpIf(CC_AE), program_size);   // fault: halt
+            as.byte(0x89);                                         // mov edx, eax
+            as.byte(0xC2);
+            as.byte(0xC1);                                         // shr edx, directory shift
+            as.byte(0xEA);
+            as.byte(DataMemory::kDirectoryShift);
+            as.loadPointer(EBX, offsetof(JitContext, directory));
+            as.byte(0x48);                                         // mov rcx, [rcx + rdx*8]
+            as.byte(0x8B);
+            as.byte(0x0C);
+            as.byte(0xD1);
+            as.byte(0x89);                                         // mov edx, eax
+            as.byte(0xC2);
+            as.byte(0xC1);                                         // shr edx, page shift
+            as.byte(0xEA);
+            as.byte(DataMemory::kPageShift);
+            as.byte(0x81);                                         // and edx, table mask
+            as.byte(0xE2);
+            as.dword(DataMemory::kTableMask);
+            as.byte(0x48);                                         // mov rcx, [rcx + rdx*8]
+            as.byte(0x8B);
+            as.byte(0x0C);
+            as.byte(0xD1);
+            as.byte(0x25);                                         // and eax, page mask
+            as.dword(DataMemory::kPageMask);
+            as.byte(0x8B);                                         // mov eax, [rcx + rax*4]
+            as.byte(0x04);
+            as.byte(0x81);
+            as.storeContext(EAX, regOffset(d.a));
+            break;
+
+        case DecodedOp::LOAD_IMM:
+            as.byte(0xC7);                                         // mov dword [rbx + disp], imm32
+            as.memoryOperand(0, EBX, regOffset(d.a));
+            as.dword(d.b);
+            break;
+
+        case DecodedOp::STORE: {
+            const uint32_t page = d.a >> DataMemory::kPageShift;
+            as.loadContext(EAX, regOffset(d.b));
+            as.loadPage(offsetof(JitContext, write_directory), page);
+            as.byte(0x48);                                         // test rcx, rcx
+            as.byte(0x85);
+            as.byte(0xC9);
+            size_t to_store = as.jumpIf(CC_NE);
+            // Not writable in place: report the page and return; the host re-enters at this store
+            as.byte(0xC7);                                         // mov dword [rbx + pc], index
+            as.memoryOperand(0, EBX, offsetof(JitContext, pc));
+            as.dword(index);
+            as.byte(0xC7);                                         // mov dword [rbx + fault_page], page
+            as.memoryOperand(0, EBX, offsetof(JitContext, fault_page));
+            as.dword(page);
+            fixups.emplace_back(as.jump(), program_size + 1);
+            as.patch(to_store, as.position());
+            as.byte(0x89);                                         // mov [rcx + offset*4], eax
+            as.memoryOperand(EAX, ECX, static_cast<int32_t>((d.a & DataMemory::kPageMask) * 4));
+            break;
+        }
+
+        case DecodedOp::ADD:
+        case DecodedOp::SUB:
+            as.loadContext(EAX, regOffset(d.b));
+            as.byte(d.op == DecodedOp::ADD ? 0x03 : 0x2B);        // add/sub eax, [rbx + disp]
+            as.memoryOperand(EAX, EBX, regOffset(d.c));
+            if (live & CF_BIT) as.setFlag(CC_B, flagOffset(1));    // carry / borrow
+            if (live & NF_BIT) as.setFlag(CC_S, flagOffset(2));
+            as.storeContext(EAX, regOffset(d.a));
+            break;
+
+        case DecodedOp::MUL:
+            as.loadContext(EAX, regOffset(d.b));
+            as.byte(0xF7);                                         // mul dword [rbx + disp]
+            as.memoryOperand(4, EBX, regOffset(d.c));
+            if (live & OF_BIT) as.setFlag(CC_O, flagOffset(3));    // set when edx != 0
+            as.storeContext(EAX, regOffset(d.a));
+            if (live & NF_BIT) {
+                as.byte(0x85);                                     // test eax, eax
+                as.byte(0xC0);
+                as.setFlag(CC_S, flagOffset(2));
+            }
+            break;
+
+        case DecodedOp::DIV: {
+            as.loadContext(ECX, regOffset(d.c));
+            as.byte(0x85);                                         // test ecx, ecx
+            as.byte(0xC9);
+            size_t to_zero = as.jumpIf(CC_E);
+            as.loadContext(EAX, regOffset(d.b));
+            as.byte(0x31);                                         // xor edx, edx
+            as.byte(0xD2);
+            as.byte(0xF7);                                         // div ecx
+            as.byte(0xF1);
+            as.storeContext(EAX, regOffset(d.a));
+            if (live & NF_BIT) {
+                as.byte(0x85);                                     // test eax, eax
+                as.byte(0xC0);
+                as.setFlag(CC_S, flagOffset(2));
+            }
+            if (live & DF_BIT) as.storeContextByte(flagOffset(4), 0);
+            size_t to_join = as.jump();
+            as.patch(to_zero, as.position());
+            if (live & DF_BIT) as.storeContextByte(flagOffset(4), 1);
+            as.patch(to_join, as.position());
+            if (live & OF_BIT) as.storeContextByte(flagOffset(3), 0);
+            if (live & CF_BIT) as.storeContextByte(flagOffset(1), 0);
+            break;
+        }
+
+        case DecodedOp::CMP:
+            if (live & ZF_BIT) {
+                as.loadContext(EAX, regOffset(d.b));
+                as.byte(0x3B);                                     // cmp eax, [rbx + disp]
+                as.memoryOperand(EAX, EBX, regOffset(d.c));
+                as.setFlag(CC_E, flagOffset(0));
+            }
+            break;
+
+        case DecodedOp::CMP_INVALID:
+            if (live & ZF_BIT) as.storeContextByte(flagOffset(0), 0);
+            break;
+
+        case DecodedOp::JMP:
+            fixups.emplace_back(as.jump(), d.a);
+            break;
+
+        case DecodedOp::JZ:
+            as.byte(0x80);                                         // cmp byte [rbx + ZF], 0
+            as.memoryOperand(7, EBX, flagOffset(0));
+            as.byte(0);
+            fixups.emplace_back(as.jumpIf(CC_NE), d.a);
+            break;
+
+        case DecodedOp::MOV:
+            as.loadContext(EAX, regOffset(d.b));
+            as.storeContext(EAX, regOffset(d.a));
+            break;
+
+        case DecodedOp::CHECK_FLAG:
+            as.byte(0x0F);                                         // movzx eax, byte [rbx + disp]
+            as.byte(0xB6);
+            as.memoryOperand(EAX, EBX, flagOffset(d.b));
+            as.storeContext(EAX, regOffset(d.a));
+            break;
+
+        case DecodedOp::ATOMIC_ADD:
+        case DecodedOp::CAS:
+        case DecodedOp::VLOAD:
+        case DecodedOp::VSTORE:
+        case DecodedOp::VADD:
+        case DecodedOp::VSUB:
+        case DecodedOp::VMUL:
+        case DecodedOp::VREDUCE:
+        case DecodedOp::VSETVL:
+        case DecodedOp::MEMCPY:
+        case DecodedOp::MEMSET:
+        case DecodedOp::MEMCMP:
+        case DecodedOp::HOSTCALL:
+            // Returned to the host, which executes the instruction and re-enters after it
+            as.byte(0xC7);                                         // mov dword [rbx + pc], index
+            as.memoryOperand(0, EBX, offsetof(JitContext, pc));
+            as.dword(index);
+            as.byte(0xC7);                                         // mov dword [rbx + fault_page], kHostOp
+            as.memoryOperand(0, EBX, offsetof(JitContext, fault_page));
+            as.dword(JitContext::kHostOp);
+            fixups.emplace_back(as.jump(), program_size + 1);
+            break;
+
+        case DecodedOp::FENCE:
+            as.byte(0x0F);                                         // mfence
+            as.byte(0xAE);
+            as.byte(0xF0);
+            break;
+
+        case DecodedOp::HART_ID:
+            as.loadContext(EAX, offsetof(JitContext, hart_id));
+            as.storeContext(EAX, regOffset(d.a));
+            break;
+
+        case DecodedOp::CMP_JZ:
+        case DecodedOp::FLAG_CMP_JZ:
+        case DecodedOp::COUNT:
+            break;  // rejected by JitProgram::compile
+    }
+}
+
+using EntryFunction = void (*)(JitContext*, const void*);
+
+}  // namespace
+
+/**
+ * @brief Reports whether this build can generate and run native code.
+ *
+ * @return True on x86-64 Linux/macOS hosts.
+ */
+bool JitProgram::isSupported() {
+    return RISC_JIT_X86_64 != 0;
+}
+
+/**
+ * @brief Translates a decoded program into native x86-64 code.
+ *
+ * Layout of the generated code:
+ * - an entry trampoline (push rbx; mov rbx, rdi; jmp rsi),
+ * - the translation of every guest instruction in program order, so that
+ *   fall-through between blocks needs no jump and taken jumps are direct,
+ * - a halt stub that sets pc to the program size and returns to the host,
+ * - an exit stub that returns with pc and fault_page already set by a store.
+ *
+ * @param decoded The decoded program (including the EXIT sentinel).
+ * @param data_size Size of the guest data memory.
+ * @return The compiled program, or nullptr if translation is not possible.
+ */
+std::shared_ptr<const JitProgram> JitProgram::compile(const std::vector<DecodedInstruction>& decoded,
+                                                      size_t data_size) {
+#if RISC_JIT_X86_64
+    // Direct addresses are encoded as 32-bit displacements
+    if (decoded.empty() || data_size > static_cast<size_t>(INT32_MAX) / 4) return nullptr;
+    for (const DecodedInstruction& d : decoded) {
+        if (isFusedOp(d.op)) return nullptr;  // translate unfused programs only
+    }
+
+    const uint32_t program_size = static_cast<uint32_t>(decoded.size() - 1);
+    std::vector<uint8_t> live = liveFlagsOut(decoded);
+
+    Assembler as;
+    as.byte(0x53);                                                  // push rbx
+    as.byte(0x48); as.byte(0x89); as.byte(0xFB);                    // mov rbx, rdi
+    as.byte(0xFF); as.byte(0xE6);                                   // jmp rsi
+
+    std::shared_ptr<JitProgram> jit(new JitProgram());
+    jit->entry_offsets.resize(program_size + 2);
+    std::vector<std::pair<size_t, uint32_t>> fixups;
+    for (uint32_t i = 0; i < program_size; ++i) {
+        jit->entry_offsets[i] = static_cast<uint32_t>(as.position());
+        emitInstruction(as, decoded[i], i, live[i], program_size, fixups);
+    }
+
+    // Halt stub, also reached by falling off the end of the program
+    jit->entry_offsets[program_size] = static_cast<uint32_t>(as.position());
+    as.byte(0xC7);                                                  // mov dword [rbx + pc], size
+    as.memoryOperand(0, EBX, offsetof(JitContext, pc));
+    as.dword(program_size);
+    jit->entry_offsets[program_size + 1] = static_cast<uint32_t>(as.position());
+    as.byte(0x5B);                                                  // pop rbx (exit stub)
+    as.byte(0xC3);                                                  // ret
+
+    for (const auto& [displacement_at, target] : fixups) {
+        as.patch(displacement_at, jit->entry_offsets[target]);
+    }
+
+    if (!jit->map(as.bytes.data(), as.bytes.size())) return nullptr;
+    jit->block_count = countBlocks(decoded);
+    return jit;
+#else
+    (void)decoded;
+    (void)data_size;
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief Recreates a compiled program from saved machine code.
+ *
+ * @param code The generated machine code.
+ * @param length Its length in bytes.
+ * @param entry_offsets Native offset of each guest instruction, the halt stub and the exit stub.
+ * @param block_count Number of basic blocks.
+ * @return The program, or nullptr if it cannot be mapped or an offset is out of range.
+ */
+std::shared_ptr<const JitProgram> JitProgram::load(const uint8_t* code, size_t length,
+                                                   std::vector<uint32_t> entry_offsets, size_t block_count) {
+#if RISC_JIT_X86_64
+    if (length == 0 || entry_offsets.size() < 2) return nullptr;
+    for (uint32_t offset : entry_offsets) {
+        if (offset >= length) return nullptr;
+    }
+    std::shared_ptr<JitProgram> jit(new JitProgram());
+    if (!jit->map(code, length)) return nullptr;
+    jit->entry_offsets = std::move(entry_offsets);
+    jit->block_count = block_count;
+    return jit;
+#else
+    (void)code;
+    (void)length;
+    (void)entry_offsets;
+    (void)block_count;
+    return nullptr;
+#endif
+}
+
+/**
+ * @brief Copies machine code into a new read-only executable mapping.
+ *
+ * @param bytes The machine code.
+ * @param length Its length in bytes.
+ * @return False if the mapping could not be created.
+ */
+bool JitProgram::map(const uint8_t* bytes, size_t length) {
+#if RISC_JIT_X86_64
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t mapped = (length + page - 1) / page * page;
+    void* memory = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) return false;
+    std::memcpy(memory, bytes, length);
+    if (mprotect(memory, mapped, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, mapped);
+        return false;
+    }
+    code = memory;
+    code_size = mapped;
+    code_length = length;
+    return true;
+#else
+    (void)bytes;
+    (void)length;
+    return false;
+#endif
+}
+
+/**
+ * @brief Releases the executable mapping.
+ */
+JitProgram::~JitProgram() {
+#if RISC_JIT_X86_64
+    if (code) munmap(code, code_size);
+#endif
+}
+
+/**
+ * @brief Runs translated code from the given guest program counter.
+ *
+ * @param ctx Guest state, updated in place.
+ * @param pc Program counter to start at.
+ */
+void JitProgram::enter(JitContext& ctx, uint32_t pc) const {
+    auto entry = reinterpret_cast<EntryFunction>(code);
+    entry(&ctx, static_cast<const uint8_t*>(code) + entry_offsets[pc]);
+}
+
+/**
+ * @brief Gets the number of basic blocks found in the program.
+ *
+ * @return The number of block leaders.
+ */
+size_t JitProgram::blockCount() const {
+    return block_count;
+}
+
+/**
+ * @brief Gets the size of the executable mapping.
+ *
+ * @return The mapped code size in bytes.
+ */
+size_t JitProgram::codeSize() const {
+    return code_size;
+}
@@ -1,17 +1,18 @@
 /**
  * @file logging.hpp
- * @brief Provides logging macros for the RISC emulator.
+ * @brief Provides error logging macros for the RISC emulator.
+ *
+ * Per-instruction tracing is not done here: RiscMachine::startTrace() records
+ * every executed instruction into a binary trace at runtime (see trace.hpp).
  */
 
 #pragma once
 
 // Define DEBUG_LOGGING to enable logging
-//#define DEBUG_LOGGING 
+//#define DEBUG_LOGGING
 
 #ifdef DEBUG_LOGGING
-    #define LOG_INFO(x) std::cout << x << std::endl
     #define LOG_ERROR(x) std::cerr << x << std::endl
 #else
-    #define LOG_INFO(x)  // No-op
     #define LOG_ERROR(x) // No-op
-#endif
\ No newline at end of file
+#endif
@@ -7,16 +7,21 @@
 #include "logging.hpp"
 #include <iostream>
 #include <cstring>
+#include <algorithm>
+#include <thread>
 
 /**
  * @brief Constructs a RiscMachine with specified program and data memory sizes.
  * 
  * @param program_size The size of the program memory.
  * @param data_size The size of the data memory.
+ * @param engine The execution engine used by run().
  */
-RiscMachine::RiscMachine(size_t program_size, size_t data_size) {
-    program_memory.resize(program_size);
-    data_memory.resize(data_size);
+RiscMachine::RiscMachine(size_t program_size, size_t data_size, ExecutionEngine engine)
+    : data_memory(data_size), engine(engine) {
+    auto loaded = std::make_shared<LoadedProgram>();
+    loaded->instructions.resize(program_size);
+    prepareProgram(std::move(loaded));
 }
 
 /**
@@ -25,22 +30,606 @@ RiscMachine::RiscMachine(size_t program_size, size_t data_size) {
  * @param program A vector of instructions to load into the program memory.
  */
 void RiscMachine::loadProgram(const std::vector<Instruction>& program) {
-    program_memory = program;
+    auto loaded = std::make_shared<LoadedProgram>();
+    loaded->instructions = program;
+    prepareProgram(std::move(loaded));
+}
+
+/**
+ * @brief Loads a mapped program file; its instructions are not copied.
+ * 
+ * @param program A program opened with MappedProgram::open().
+ */
+void RiscMachine::loadProgram(std::shared_ptr<const MappedProgram> program) {
+    if (program) {
+        const uint32_t* image = program->data();
+        for (size_t i = 0; i < program->dataCount(); ++i) {
+            const uint64_t address = static_cast<uint64_t>(program->dataBase()) + i;
+            if (address >= data_memory.size()) break;
+            data_memory.write(static_cast<uint32_t>(address), image[i]);
+            if (recording.recorder) recording.recorder->write(static_cast<uint32_t>(address), image[i]);
+        }
+    }
+    auto loaded = std::make_shared<LoadedProgram>();
+    loaded->mapped = std::move(program);
+    prepareProgram(std::move(loaded));
+}
+
+/**
+ * @brief Decodes or translates a new program for the selected engine and resets the machine.
+ *
+ * @param loaded The program; its instructions or mapping must already be set.
+ */
+void RiscMachine::prepareProgram(std::shared_ptr<LoadedProgram> loaded) {
+    if (loaded->mapped) {
+        program_code = loaded->mapped->instructions();
+        program_length = loaded->mapped->instructionCount();
+    } else {
+        program_code = loaded->instructions.data();
+        program_length = loaded->instructions.size();
+    }
+    // Verifying a program for the switch engine, or translating a short one, is cheaper than a cache lookup
+    const bool cached = translation_cache && engine != ExecutionEngine::Switch &&
+                        program_length >= translation_cache->options().min_instructions;
+    const TranslationKey key{static_cast<uint32_t>(engine), static_cast<uint32_t>(data_registers.size()),
+                             data_memory.size(), fusion_enabled, reduction_enabled};
+    ProgramTranslation translation;
+    if (!cached || !translation_cache->lookup(program_code, program_length, key, translation)) {
+        translation = translateProgram();
+        if (cached) translation_cache->store(program_code, program_length, key, translation);
+    }
+    loaded->verification = std::move(translation.verification);
+    loaded->reductions = std::move(translation.reductions);
+    loaded->packed = std::move(translation.packed);
+    loaded->jit = std::move(translation.jit);
+    // A mapped file can still change after it was verified, so the switch engine keeps checking it
+    loaded->unchecked = loaded->verification.verified() && !loaded->mapped;
+    program = std::move(loaded);
+    if (recording.recorder) {
+        recording.recorder->program(static_cast<uint32_t>(program_length),
+                                    programChecksum(program_code, program_length));
+    }
+    fused_dispatches_saved = 0;
+    reduced_iterations = 0;
+    stats.reset(stats_enabled ? program_length : 0);
     pc = 0;  // Reset the program counter to the start of the program
-    status_register = {};  // Reset the status register
+    status_register.reset();  // Reset the status register
     data_registers.fill(0);  // Clear all data registers
+    vector_unit.reset();  // Clear the vector registers; VLMAX is kept
+}
+
+/**
+ * @brief Verifies, decodes and translates the current program for the selected engine.
+ *
+ * @return The load-time results; the packed code's handlers are not yet bound.
+ */
+ProgramTranslation RiscMachine::translateProgram() const {
+    ProgramTranslation translation;
+    translation.verification = verifyProgram(program_code, program_length, data_registers.size(), data_memory.size());
+    if (reduction_enabled) {
+        translation.reductions = findReductionLoops(program_code, program_length, data_registers.size());
+    }
+    if (engine != ExecutionEngine::Switch) {
+        std::vector<DecodedInstruction> decoded =
+            decodeProgram(program_code, program_length, data_registers.size(), data_memory.size());
+        markReductionLoops(decoded, translation.reductions);
+        if (engine == ExecutionEngine::Jit) {
+            translation.jit = JitProgram::compile(decoded, data_memory.size());
+        }
+        // Threaded engine (also the JIT fallback and its budgeted runs): fuse, then pack
+        if (fusion_enabled) fuseProgram(decoded);
+        translation.packed = packProgram(decoded);
+    }
+    return translation;
 }
 
 /**
  * @brief Executes the loaded program until a HALT instruction is encountered or the program ends.
  */
 void RiscMachine::run() {
-    while (pc < program_memory.size()) {
-        Instruction instr = program_memory[pc];  // Fetch the next instruction
+    if (recording.recorder) {
+        // Recording logs the state around the run; the run itself is not instrumented
+        ReplayRecorder& recorder = *recording.recorder;
+        if (recording.image_pending) {
+            recorder.image(pc, data_registers, flagBits(), vector_unit, data_memory);
+            recording.image_pending = false;
+        }
+        recorder.run();
+        dispatchCached();
+        recorder.end(pc, stateDigest(pc, data_registers, flagBits()));
+        return;
+    }
+    dispatchCached();
+}
+
+/**
+ * @brief Executes at most @p max_steps instructions.
+ *
+ * @param max_steps Maximum number of instructions to execute.
+ * @return Halted, Faulted, or BudgetExhausted if the program can continue.
+ */
+RunStatus RiscMachine::run(uint64_t max_steps) {
+    if (recording.recorder) {
+        ReplayRecorder& recorder = *recording.recorder;
+        if (recording.image_pending) {
+            recorder.image(pc, data_registers, flagBits(), vector_unit, data_memory);
+            recording.image_pending = false;
+        }
+        recorder.run(max_steps);
+        const RunStatus status = dispatch(max_steps);
+        recorder.end(pc, stateDigest(pc, data_registers, flagBits()));
+        return status;
+    }
+    return dispatch(max_steps);
+}
+
+/**
+ * @brief Runs the program on @p hart_count harts over one shared data memory.
+ *
+ * The extra harts are copies of this machine whose data memory is replaced by
+ * a shared view; they start on their own threads, hart 0 runs here.
+ *
+ * @param hart_count Number of harts.
+ * @return The final state of every hart.
+ */
+std::vector<HartState> RiscMachine::runHarts(size_t hart_count) {
+    hart_count = std::max<size_t>(hart_count, 1);
+    std::vector<std::unique_ptr<RiscMachine>> harts;
+    for (size_t id = 1; id < hart_count; ++id) {
+        auto hart = std::make_unique<RiscMachine>(*this);
+        // Drop the copy-on-write share before the pages are made writable in place
+        hart->data_memory = DataMemory();
+        hart->hart_id = static_cast<uint32_t>(id);
+        hart->stats_enabled = false;
+        harts.push_back(std::move(hart));
+    }
+    for (auto& hart : harts) {
+        hart->data_memory = data_memory.sharedView();
+    }
+
+    std::vector<std::thread> threads;
+    threads.reserve(harts.size());
+    for (auto& hart : harts) {
+        threads.emplace_back([&hart] { hart->dispatch(); });
+    }
+    dispatch();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    if (recording.recorder) recording.image_pending = true;
+
+    std::vector<HartState> states(hart_count);
+    for (size_t id = 0; id < hart_count; ++id) {
+        const RiscMachine& hart = id == 0 ? *this : *harts[id - 1];
+        states[id].registers = hart.data_registers;
+        states[id].flags = hart.getStatusRegister();
+        states[id].pc = hart.pc;
+    }
+    return states;
+}
+
+/**
+ * @brief Runs the loaded program on the engine selected for this run.
+ */
+void RiscMachine::dispatch() {
+    // Tracing and profiling replace the selected engine for the whole run
+    if (tracer.writer) {
+        if (stats_enabled) {
+            runInstrumented<true, true>();
+        } else {
+            runInstrumented<false, true>();
+        }
+        return;
+    }
+    if (stats_enabled) {
+        runInstrumented<true, false>();
+        return;
+    }
+    if (program->jit) {
+        runJit();
+        return;
+    }
+    if (!program->packed.empty()) {
+        runThreaded();
+        return;
+    }
+    if (program->unchecked) {
+        runSwitch<false>();
+    } else {
+        runSwitch<true>();
+    }
+}
+
+namespace {
+
+/**
+ * @brief Makes a StatusRegister from flag bits (bit i holds the flag with CHECK_FLAG index i).
+ */
+StatusRegister statusFromBits(uint32_t bits) {
+    StatusRegister status{};
+    status.ZF = bits & 1;
+    status.CF = (bits >> 1) & 1;
+    status.NF = (bits >> 2) & 1;
+    status.OF = (bits >> 3) & 1;
+    status.DF = (bits >> 4) & 1;
+    return status;
+}
+
+}  // namespace
+
+/**
+ * @brief Answers the run from the run cache, or runs it recording its footprint and caches it.
+ *
+ * Falls back to dispatch() whenever the run cannot be memoised.
+ */
+void RiscMachine::dispatchCached() {
+    // Profiling and tracing need every instruction executed
+    if (!run_cache || stats_enabled || tracer.writer || pc >= program_length) {
+        dispatch();
+        return;
+    }
+    LoadedProgram& loaded = *program;
+    std::call_once(loaded.run_key_made, [&] {
+        loaded.run_hash = RunCache::programHash(program_code, program_length);
+        loaded.memoisable = RunCache::isMemoisable(program_code, program_length);
+    });
+    if (!loaded.memoisable || loaded.footprint_overflowed.load(std::memory_order_relaxed)) {
+        dispatch();
+        return;
+    }
+
+    RunKey key;
+    key.program_hash = loaded.run_hash;
+    key.program_length = program_length;
+    key.code = program_code;
+    key.data_size = data_memory.size();
+    key.start.registers = data_registers;
+    key.start.flags = flagBits();
+    key.start.pc = pc;
+    RunState outcome;
+    if (run_cache->lookup(key, data_memory, outcome)) {
+        data_registers = outcome.registers;
+        status_register.set(statusFromBits(outcome.flags));
+        pc = outcome.pc;
+        load_fault = load_fault || outcome.faulted;
+        return;
+    }
+
+    // load_fault is sticky across runs; record whether this run faults on its own
+    const bool faulted_before = load_fault;
+    load_fault = false;
+    RunFootprint footprint(run_cache->options().max_footprint);
+    if (loaded.unchecked) {
+        runFootprint<false>(footprint);
+    } else {
+        runFootprint<true>(footprint);
+    }
+    outcome.registers = data_registers;
+    outcome.flags = flagBits();
+    outcome.pc = pc;
+    outcome.faulted = load_fault;
+    if (footprint.overflowed()) loaded.footprint_overflowed.store(true, std::memory_order_relaxed);
+    run_cache->store(key, footprint, data_memory, outcome);
+    load_fault = load_fault || faulted_before;
+}
+
+/**
+ * @brief Runs at most @p max_steps instructions on a budgeted engine.
+ *
+ * Tracing and profiling select the instrumented variant as in dispatch().
+ * Otherwise a program with threaded code runs there while at least one
+ * program length of steps remains, and the switch engine executes the rest.
+ *
+ * @param max_steps Maximum number of instructions to execute.
+ * @return Why the run stopped.
+ */
+RunStatus RiscMachine::dispatch(uint64_t max_steps) {
+    load_fault = false;
+    if (tracer.writer) {
+        if (stats_enabled) {
+            last_run_steps = runInstrumented<true, true, true>(max_steps);
+        } else {
+            last_run_steps = runInstrumented<false, true, true>(max_steps);
+        }
+    } else if (stats_enabled) {
+        last_run_steps = runInstrumented<true, false, true>(max_steps);
+    } else {
+        uint64_t steps = program->packed.empty() ? 0 : runThreaded<true>(max_steps);
+        if (pc < program_length && steps < max_steps) {
+            steps += runInstrumented<false, false, true>(max_steps - steps);
+        }
+        last_run_steps = steps;
+    }
+    if (pc < program_length) return RunStatus::BudgetExhausted;
+    return load_fault ? RunStatus::Faulted : RunStatus::Halted;
+}
+
+/**
+ * @brief Runs the switch engine with instrumentation, checking operands unless the program is verified.
+ *
+ * @tparam Profiled Whether each instruction, jump outcome and flag write is counted.
+ * @tparam Traced Whether each instruction is pushed to the trace.
+ * @tparam Budgeted Whether to stop after @p max_steps instructions.
+ * @param max_steps Instruction budget (Budgeted only).
+ * @return Instructions executed (Budgeted only).
+ */
+template <bool Profiled, bool Traced, bool Budgeted>
+uint64_t RiscMachine::runInstrumented(uint64_t max_steps) {
+    if (program->unchecked) {
+        return runSwitch<false, Profiled, Traced, Budgeted>(max_steps);
+    }
+    return runSwitch<true, Profiled, Traced, Budgeted>(max_steps);
+}
+
+/**
+ * @brief Fetches and executes instructions until HALT or the end of the program.
+ *
+ * @tparam Checked Whether operands are range-checked on every execution.
+ * @tparam Profiled Whether each instruction, jump outcome and flag write is counted.
+ * @tparam Traced Whether each instruction is pushed to the trace.
+ * @tparam Budgeted Whether to stop after @p max_steps instructions.
+ * @param max_steps Instruction budget (Budgeted only).
+ * @return Instructions executed (Budgeted only).
+ */
+template <bool Checked, bool Profiled, bool Traced, bool Budgeted>
+uint64_t RiscMachine::runSwitch(uint64_t max_steps) {
+    TraceWriter* const trace = Traced ? tracer.writer.get() : nullptr;
+    TraceRecord record;
+    uint64_t steps = 0;
+    while (pc < program_length) {
+        Instruction instr = program_code[pc];  // Fetch the next instruction
+        if constexpr (!Profiled && !Traced) {
+            if (instr.opcode == Opcode::LOAD && instr.src2 == 1 && !program->reductions.empty()) {
+                steps += reduceAt(pc, Budgeted ? max_steps - steps : UINT64_MAX);
+            }
+        }
+        if constexpr (Budgeted) {
+            if (steps == max_steps) break;
+            ++steps;
+        }
+        if constexpr (Profiled) {
+            const uint32_t at = pc;
+            stats.recordInstruction(at, instr.opcode);
+            if (instr.opcode == Opcode::JMP) {
+                // Same condition as execute(); an invalid jump falls through
+                const bool taken = instr.dst < program_length &&
+                                   (instr.src1 == 0 || (instr.src1 == 1 && status_register.zero()));
+                stats.recordJump(at, taken);
+            }
+        }
+        if constexpr (Traced) record.pc = pc;
         pc++;  // Increment the program counter
-        execute(instr);  // Execute the instruction
+        execute<Checked>(instr);  // Execute the instruction
+        if constexpr (Profiled) {
+            stats.recordFlags(instr, data_registers.size(), status_register);
+        }
+        if constexpr (Traced) {
+            record.opcode = static_cast<uint8_t>(instr.opcode);
+            record.dst = instr.dst;
+            record.src1 = instr.src1;
+            record.src2 = instr.src2;
+            switch (instr.opcode) {
+                case Opcode::HALT:
+                case Opcode::CMP:
+                case Opcode::JMP:
+                case Opcode::FENCE:
+                case Opcode::VLOAD:
+                case Opcode::VSTORE:
+                case Opcode::VADD:
+                case Opcode::VSUB:
+                case Opcode::VMUL:
+                case Opcode::MEMCPY:
+                case Opcode::MEMSET:
+                case Opcode::MEMCMP:
+                case Opcode::HOSTCALL:
+                    record.result = 0;
+                    break;
+                case Opcode::STORE:
+                    record.result = instr.src1 < data_registers.size() ? data_registers[instr.src1] : 0;
+                    break;
+                default:
+                    record.result = instr.dst < data_registers.size() ? data_registers[instr.dst] : 0;
+                    break;
+            }
+            record.flags = static_cast<uint8_t>(flagBits());
+            trace->push(record);
+        }
         if (instr.opcode == Opcode::HALT) break;  // Stop execution on HALT
     }
+    return steps;
+}
+
+/**
+ * @brief Fetches and executes instructions like runSwitch(), recording each memory access first.
+ *
+ * Reduction loops are not offloaded, so every access goes through here. The
+ * validity checks mirror execute(): an access is recorded exactly when it
+ * happens, except that CAS and MEMCMP record every word they may touch, which
+ * only makes the footprint stricter.
+ *
+ * @tparam Checked Whether operands are range-checked on every execution.
+ * @param footprint Receives the accessed words.
+ */
+template <bool Checked>
+void RiscMachine::runFootprint(RunFootprint& footprint) {
+    const uint64_t size = data_memory.size();
+    auto reg = [this](uint32_t index) { return index < data_registers.size(); };
+    while (pc < program_length) {
+        const Instruction instr = program_code[pc];
+        switch (instr.opcode) {
+            case Opcode::LOAD:
+                if (!reg(instr.dst)) break;
+                if (instr.src2 == 0 && instr.src1 < size) {
+                    footprint.read(instr.src1, data_memory);
+                } else if (instr.src2 == 1 && reg(instr.src1) && data_registers[instr.src1] < size) {
+                    footprint.read(data_registers[instr.src1], data_memory);
+                }
+                break;
+            case Opcode::STORE:
+                if (instr.dst < size && reg(instr.src1)) footprint.write(instr.dst);
+                break;
+            case Opcode::ATOMIC_ADD:
+            case Opcode::CAS:
+                if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2) && data_registers[instr.src1] < size) {
+                    footprint.read(data_registers[instr.src1], data_memory);
+                    footprint.write(data_registers[instr.src1]);
+                }
+                break;
+            case Opcode::MEMCPY:
+            case Opcode::MEMSET:
+            case Opcode::MEMCMP: {
+                if (!reg(instr.dst) || !reg(instr.src1) || !reg(instr.src2)) break;
+                const uint32_t lhs = data_registers[instr.dst];
+                const uint32_t rhs = data_registers[instr.src1];
+                const uint32_t count = data_registers[instr.src2];
+                if (count == 0 || uint64_t(lhs) + count > size ||
+                    (instr.opcode != Opcode::MEMSET && uint64_t(rhs) + count > size)) {
+                    break;  // touches nothing, or faults before touching memory
+                }
+                if (instr.opcode == Opcode::MEMCPY) {
+                    footprint.readRange(rhs, count, data_memory);
+                    footprint.writeRange(lhs, count);
+                } else if (instr.opcode == Opcode::MEMSET) {
+                    footprint.writeRange(lhs, count);
+                } else {
+                    footprint.readRange(lhs, count, data_memory);
+                    footprint.readRange(rhs, count, data_memory);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        pc++;
+        execute<Checked>(instr);
+        if (instr.opcode == Opcode::HALT) break;
+    }
+}
+
+namespace {
+
+/**
+ * @brief Gets the flags of translated code as a StatusRegister.
+ */
+StatusRegister contextFlags(const JitContext& ctx) {
+    StatusRegister flags{};
+    flags.ZF = ctx.flags[0];
+    flags.CF = ctx.flags[1];
+    flags.NF = ctx.flags[2];
+    flags.OF = ctx.flags[3];
+    flags.DF = ctx.flags[4];
+    return flags;
+}
+
+}  // namespace
+
+/**
+ * @brief Runs the loaded program as native code.
+ *
+ * Guest state is copied into a JitContext, the translated code runs until the
+ * program halts, faults or falls off the end, and the state is copied back.
+ * A store to a page without a write pointer leaves native code; the page is
+ * made writable and execution resumes at the store. Atomic, vector and bulk
+ * memory instructions and host calls also leave native code; the host
+ * executes them and resumes after them.
+ */
+void RiscMachine::runJit() {
+    if (pc >= program_length) return;
+
+    JitContext ctx{};
+    std::copy(data_registers.begin(), data_registers.end(), ctx.regs);
+    for (uint32_t i = 0; i < 5; ++i) {
+        ctx.flags[i] = static_cast<uint8_t>(status_register.read(i));
+    }
+    ctx.directory = data_memory.directoryTable();
+    ctx.write_directory = data_memory.writeDirectoryTable();
+    ctx.memory_size = data_memory.size();
+    ctx.hart_id = hart_id;
+
+    uint32_t entry = pc;
+    for (;;) {
+        ctx.fault_page = JitContext::kNoFault;
+        program->jit->enter(ctx, entry);
+        if (ctx.fault_page == JitContext::kNoFault) break;
+        if (ctx.fault_page == JitContext::kHostOp && program_code[ctx.pc].opcode == Opcode::HOSTCALL) {
+            LazyFlags flags;
+            flags.set(contextFlags(ctx));
+            if (!callHost(program_code[ctx.pc].dst, ctx.regs, flags)) {
+                LOG_ERROR("Error: Host call " << program_code[ctx.pc].dst << " failed at PC=" << ctx.pc);
+                ctx.pc = static_cast<uint32_t>(program_length);
+                break;
+            }
+            for (uint32_t i = 0; i < 5; ++i) ctx.flags[i] = static_cast<uint8_t>(flags.read(i));
+            entry = ctx.pc + 1;
+            continue;
+        }
+        if (ctx.fault_page == JitContext::kHostOp && program_code[ctx.pc].opcode >= Opcode::MEMCPY) {
+            // Bulk memory instruction with valid registers
+            const Instruction& instr = program_code[ctx.pc];
+            LazyFlags flags;
+            flags.set(contextFlags(ctx));
+            if (!executeBulk(instr.opcode, ctx.regs[instr.dst], ctx.regs[instr.src1], ctx.regs[instr.src2], flags)) {
+                LOG_ERROR("Error: Bulk memory access to out of bounds address at PC=" << ctx.pc);
+                ctx.pc = static_cast<uint32_t>(program_length);
+                break;
+            }
+            for (uint32_t i = 0; i < 5; ++i) ctx.flags[i] = static_cast<uint8_t>(flags.read(i));
+            entry = ctx.pc + 1;
+            continue;
+        }
+        if (ctx.fault_page == JitContext::kHostOp && program_code[ctx.pc].opcode >= Opcode::VLOAD) {
+            // Vector instruction with valid registers (the decoder made the others NOPs)
+            if (!executeVector(program_code[ctx.pc], ctx.regs)) {
+                LOG_ERROR("Error: Vector access to out of bounds address at PC=" << ctx.pc);
+                ctx.pc = static_cast<uint32_t>(program_length);
+                break;
+            }
+            entry = ctx.pc + 1;
+            continue;
+        }
+        if (ctx.fault_page == JitContext::kHostOp) {
+            // ATOMIC_ADD or CAS with valid registers
+            const Instruction& instr = program_code[ctx.pc];
+            const uint32_t address = ctx.regs[instr.src1];
+            if (address >= data_memory.size()) {
+                LOG_ERROR("Error: Atomic access to out of bounds address at PC=" << ctx.pc);
+                ctx.pc = static_cast<uint32_t>(program_length);
+                break;
+            }
+            if (instr.opcode == Opcode::ATOMIC_ADD) {
+                ctx.regs[instr.dst] = data_memory.fetchAdd(address, ctx.regs[instr.src2]);
+            } else {
+                uint32_t expected = ctx.regs[instr.dst];
+                ctx.flags[0] = data_memory.compareExchange(address, expected, ctx.regs[instr.src2]);
+                ctx.regs[instr.dst] = expected;
+            }
+            entry = ctx.pc + 1;
+            continue;
+        }
+        if (ctx.fault_page != JitContext::kReduction) {
+            data_memory.makeWritable(ctx.fault_page);
+            entry = ctx.pc;
+            continue;
+        }
+        // Reduction loop head: run its clean iterations, then the head load, and resume after it
+        const ReductionLoop& loop = *std::find_if(program->reductions.begin(), program->reductions.end(),
+                                                  [&](const ReductionLoop& l) { return l.head == ctx.pc; });
+        LazyFlags flags;
+        flags.set(contextFlags(ctx));
+        reduced_iterations += runReductionLoop(loop, ctx.regs, flags, data_memory);
+        for (uint32_t i = 0; i < 5; ++i) ctx.flags[i] = static_cast<uint8_t>(flags.read(i));
+        const uint32_t address = ctx.regs[loop.pointer];
+        if (address >= data_memory.size()) {
+            ctx.pc = static_cast<uint32_t>(program_length);  // fault, as in translated code
+            break;
+        }
+        ctx.regs[loop.value] = data_memory.read(address);
+        entry = ctx.pc + 1;
+    }
+
+    std::copy(ctx.regs, ctx.regs + data_registers.size(), data_registers.begin());
+    status_register.set(contextFlags(ctx));
+    pc = ctx.pc;
 }
 
 /**
@@ -50,8 +639,19 @@ void RiscMachine::run() {
  */
 void RiscMachine::reset() {
     pc = 0;  // Reset the program counter
-    status_register = {};  // Reset the status register
+    status_register.reset();  // Reset the status register
     data_registers.fill(0);  // Clear all data registers
+    if (recording.recorder) recording.recorder->reset();
+}
+
+/**
+ * @brief Clears the data memory.
+ * 
+ * Sets every word of data memory to zero; registers and the program are untouched.
+ */
+void RiscMachine::clearMemory() {
+    data_memory.clear();
+    if (recording.recorder) recording.recorder->clear();
 }
 
 /**
@@ -71,14 +671,25 @@ void RiscMachine::reset() {
  * - JMP: Conditional and unconditional jumps.
  * - MOV: Copies data between registers.
  * - CHECK_FLAG: Reads specific status flags into a register.
+ * - ATOMIC_ADD/CAS/FENCE/HART_ID: Shared-memory operations for multi-hart runs.
+ * - VLOAD/VSTORE/VADD/VSUB/VMUL/VREDUCE/VSETVL: Vector operations on the vector unit.
+ * - MEMCPY/MEMSET/MEMCMP: Bulk copy, fill and compare of data memory.
+ * - HOSTCALL: Calls a native function bound on the machine.
  * 
+ * @tparam Checked False only for programs the verifier proved valid: register,
+ *         immediate address and jump target operands are then used unchecked.
  * @param instr The instruction to execute, containing the opcode and operands.
  */
+template <bool Checked>
 void RiscMachine::execute(const Instruction& instr) {
+    // On the unchecked path the verifier has proven these operands in range
+    auto reg = [this](uint32_t index) { return !Checked || index < data_registers.size(); };
+    auto vreg = [](uint32_t index) { return !Checked || index < VectorUnit::kRegisters; };
+    auto addr = [this](uint32_t address) { return !Checked || address < data_memory.size(); };
+
     switch (instr.opcode) {
         case Opcode::HALT:
-            LOG_INFO("HALT instruction encountered. Stopping execution.");
-            pc = program_memory.size();  // Halt the program by setting PC out of bounds
+            pc = program_length;  // Halt the program by setting PC out of bounds
             break;
 
         case Opcode::LOAD:
@@ -99,6 +710,7 @@ void RiscMachine::execute(const Instruction& instr) {
         //         R0 = 100;  // R0 holds address
         //         {Opcode::LOAD, 4, 0, 1}
         //         → R4 = RAM[R0]
+        //       An address outside data memory is a fault and halts the program.
         //
         //   • Immediate Mode (src2 == 2): src1 is treated as a literal value
         //       Example:
@@ -108,13 +720,19 @@ void RiscMachine::execute(const Instruction& instr) {
         // - This supports both traditional memory access and immediate constant assignment.
         // - Enables pointer logic and constant register initialization in programs.
         // ─────────────────────────────────────────────────────────────────────────────
-            if (instr.dst < data_registers.size()) {
+            if (reg(instr.dst)) {
                 uint32_t value = 0;
         
-                if (instr.src2 == 0 && instr.src1 < data_memory.size()) {
-                    value = data_memory[instr.src1]; // direct mode
-                } else if (instr.src2 == 1 && instr.src1 < data_registers.size()) {
-                    value = data_memory[data_registers[instr.src1]]; // indirect mode
+                if (instr.src2 == 0 && addr(instr.src1)) {
+                    value = data_memory.read(instr.src1); // direct mode
+                } else if (instr.src2 == 1 && reg(instr.src1)) {
+                    if (data_registers[instr.src1] >= data_memory.size()) {
+                        LOG_ERROR("Error: Indirect load from out of bounds address at PC=" << pc-1);
+                        pc = program_length;  // Fault: halt the program
+                        load_fault = true;
+                        break;
+                    }
+                    value = data_memory.read(data_registers[instr.src1]); // indirect mode
                 } else if (instr.src2 == 2) {
                     // Immediate value
                     value = instr.src1;
@@ -122,22 +740,17 @@ void RiscMachine::execute(const Instruction& instr) {
                     break; // invalid
                 }
                 data_registers[instr.dst] = value;
-                LOG_INFO("Loading R" << instr.dst << " value "<< value);
             }
             break;
 
         case Opcode::STORE:
-            if (instr.dst < data_memory.size() && instr.src1 < data_registers.size()){
-                data_memory[instr.dst] = data_registers[instr.src1];
-                LOG_INFO("Storing R" << instr.src1 << " value " << data_registers[instr.src1] 
-                          << " into RAM[" << instr.dst << "]" );
+            if (addr(instr.dst) && reg(instr.src1)) {
+                data_memory.write(instr.dst, data_registers[instr.src1]);
             }
             break;
 
         case Opcode::ADD:
-            if (instr.dst < data_registers.size() &&
-                instr.src1 < data_registers.size() &&
-                instr.src2 < data_registers.size()) {
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
         
                 uint32_t a = data_registers[instr.src1];
                 uint32_t b = data_registers[instr.src2];
@@ -145,22 +758,14 @@ void RiscMachine::execute(const Instruction& instr) {
         
                 data_registers[instr.dst] = static_cast<uint32_t>(result);
                 
-                // Carry flag: result exceeded 32 bits
-                status_register.CF = (result > UINT32_MAX);
-
-                // Negative flag: result MSB is 1
-                status_register.NF = (result >> 31) & 1;
-        
-                LOG_INFO("Adding R" << instr.src1 << " - " << data_registers[instr.src1]
-                         << " and R" << instr.src2 << " - " << data_registers[instr.src2]
-                         << " into R" << instr.dst << (status_register.CF ? " [CARRY]" : ""));
+                // Carry flag (result exceeded 32 bits) and negative flag (result MSB is 1)
+                // are evaluated from the operands when read
+                status_register.setAdd(a, b);
             }
             break;
 
         case Opcode::SUB:
-            if (instr.dst < data_registers.size() &&
-            instr.src1 < data_registers.size() &&
-            instr.src2 < data_registers.size()) {
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
 
                 uint32_t lhs = data_registers[instr.src1];
                 uint32_t rhs = data_registers[instr.src2];
@@ -168,102 +773,241 @@ void RiscMachine::execute(const Instruction& instr) {
 
                 data_registers[instr.dst] = result;
 
-                // Carry flag (in subtraction, CF = borrow occurred → if lhs < rhs)
-                status_register.CF = (lhs < rhs);
-
-                // Negative flag (set if MSB is 1 → interpreted as signed negative)
-                status_register.NF = ((result >> 31) & 1);
+                // Carry flag (in subtraction, CF = borrow occurred → if lhs < rhs) and
+                // negative flag (set if MSB is 1) are evaluated from the operands when read
+                status_register.setSub(lhs, rhs);
             }
             break;
 
         case Opcode::CMP:
-            if (instr.src1 < data_registers.size() && instr.src2 < data_registers.size()) {
-                status_register.ZF = (data_registers[instr.src1] == data_registers[instr.src2]) ? 1 : 0;
+            if (reg(instr.src1) && reg(instr.src2)) {
+                status_register.setZero(data_registers[instr.src1] == data_registers[instr.src2]);
             }else {
                 LOG_ERROR("Error: Compare instruction with invalid register indices at PC=" << pc-1);
-                status_register.ZF = 0; // Reset ZF on error
+                status_register.setZero(false); // Reset ZF on error
             }
             break;
 
         case Opcode::JMP:
-            if (instr.dst < program_memory.size()) {
-                if (instr.src1 == 0 || (instr.src1 == 1 && status_register.ZF)) {
+            if (!Checked || instr.dst < program_length) {
+                if (instr.src1 == 0 || (instr.src1 == 1 && status_register.zero())) {
                     pc = instr.dst;
-                    LOG_INFO("Jumping to address " << instr.dst << " at PC=" << pc-1);
                 }
             }else{
                 LOG_ERROR("Error: Jump to out of bounds address at PC=" << pc-1);
-                //pc = program_memory.size(); // Halt the program by setting PC out of bounds   
+                //pc = program_length; // Halt the program by setting PC out of bounds   
             }
             break;
 
         case Opcode::MUL:
-            if (instr.dst < data_registers.size() && 
-                instr.src1 < data_registers.size() && 
-                instr.src2 < data_registers.size()){
-                    uint64_t result = static_cast<uint64_t>(data_registers[instr.src1]) * data_registers[instr.src2];
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
+                    uint32_t lhs = data_registers[instr.src1];
+                    uint32_t rhs = data_registers[instr.src2];
+                    uint64_t result = static_cast<uint64_t>(lhs) * rhs;
                     data_registers[instr.dst] = static_cast<uint32_t>(result);
 
-                    // Set overflow flag if result doesn't fit in 32 bits
-                    status_register.OF = (result > UINT32_MAX);
-                    status_register.NF = (result >> 31) & 1;
-
-                    LOG_INFO( "MUL: R" << instr.dst << " = " << data_registers[instr.src1]
-                    << " * " << data_registers[instr.src2]
-                    << " = " << result
-                    << (status_register.OF ? " [OVERFLOW]" : ""));
+                    // Overflow flag (result doesn't fit in 32 bits) and negative flag
+                    // are evaluated from the operands when read
+                    status_register.setMul(lhs, rhs);
                 }      
             break;
 
         case Opcode::DIV:
-            if (instr.dst < data_registers.size() && 
-                instr.src1 < data_registers.size() && 
-                instr.src2 < data_registers.size()) {
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
 
                     uint32_t dividend = data_registers[instr.src1];
                     uint32_t divisor = data_registers[instr.src2];
                     // Check for division by zero                    
                     if (divisor== 0) {
                         LOG_ERROR("Error: Division by zero at PC=" << pc-1);
-                        status_register.DF = 1; // Set division by zero flag
-                        //pc = program_memory.size(); // Halt the program by setting PC out of bounds
+                        // Set division by zero flag; no meaningful overflow or carry for unsigned div
+                        status_register.setDivByZero();
+                        //pc = program_length; // Halt the program by setting PC out of bounds
                     } else {
                         uint32_t result = dividend / divisor;
                         data_registers[instr.dst] = result;
 
-                        status_register.NF = (result >> 31) & 1;
-                        status_register.DF = 0;
+                        // NF from the quotient, DF, OF and CF cleared
+                        status_register.setDiv(result);
                     }
-                    // No meaningful overflow or carry for unsigned div
-                    status_register.OF = 0;
-                    status_register.CF = 0;
             }
             break;
         
         case Opcode::MOV:
-            if (instr.dst < data_registers.size() && instr.src1 < data_registers.size()) {
+            if (reg(instr.dst) && reg(instr.src1)) {
                 data_registers[instr.dst] = data_registers[instr.src1];
             }
             break;
         
         case Opcode::CHECK_FLAG:
-        if (instr.dst < data_registers.size()) {
-            uint32_t value = 0;
-            switch (instr.src1) {
-                case 0: value = status_register.ZF; break; // Zero Flag
-                case 1: value = status_register.CF; break; // Carry Flag
-                case 2: value = status_register.NF; break; // Negative Flag
-                case 3: value = status_register.OF; break; // Overflow Flag
-                case 4: value = status_register.DF; break; // Division by Zero Flag
-                default: value = 0; break;  // unknown flag
-            }
+        if (reg(instr.dst)) {
+            // 0: ZF, 1: CF, 2: NF, 3: OF, 4: DF; unknown flags read as 0
+            uint32_t value = status_register.read(instr.src1);
             data_registers[instr.dst] = value;
-    
-            LOG_INFO("CHECK_FLAG: R" << instr.dst << " = flag[" << instr.src1 << "] = " << value);
         }
         break;
+
+        case Opcode::ATOMIC_ADD:
+        case Opcode::CAS:
+            // Read-modify-write of RAM[R[src1]]; like an indirect LOAD, a bad address faults
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2)) {
+                const uint32_t address = data_registers[instr.src1];
+                if (address >= data_memory.size()) {
+                    LOG_ERROR("Error: Atomic access to out of bounds address at PC=" << pc-1);
+                    pc = program_length;  // Fault: halt the program
+                    load_fault = true;
+                    break;
+                }
+                if (instr.opcode == Opcode::ATOMIC_ADD) {
+                    data_registers[instr.dst] = data_memory.fetchAdd(address, data_registers[instr.src2]);
+                } else {
+                    uint32_t expected = data_registers[instr.dst];
+                    status_register.setZero(data_memory.compareExchange(address, expected, data_registers[instr.src2]));
+                    data_registers[instr.dst] = expected;
+                }
+            }
+            break;
+
+        case Opcode::FENCE:
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            break;
+
+        case Opcode::HART_ID:
+            if (reg(instr.dst)) {
+                data_registers[instr.dst] = hart_id;
+            }
+            break;
+
+        case Opcode::VLOAD:
+        case Opcode::VSTORE:
+        case Opcode::VADD:
+        case Opcode::VSUB:
+        case Opcode::VMUL:
+        case Opcode::VREDUCE:
+        case Opcode::VSETVL: {
+            // Operand kinds differ per opcode: V = vector register, R = scalar register
+            const bool valid =
+                instr.opcode == Opcode::VLOAD ? vreg(instr.dst) && reg(instr.src1) && reg(instr.src2)
+              : instr.opcode == Opcode::VSTORE ? reg(instr.dst) && vreg(instr.src1) && reg(instr.src2)
+              : instr.opcode == Opcode::VREDUCE ? reg(instr.dst) && vreg(instr.src1)
+              : instr.opcode == Opcode::VSETVL ? reg(instr.dst) && reg(instr.src1)
+              : vreg(instr.dst) && vreg(instr.src1) && vreg(instr.src2);
+            if (valid && !executeVector(instr, data_registers.data())) {
+                LOG_ERROR("Error: Vector access to out of bounds address at PC=" << pc-1);
+                pc = program_length;  // Fault: halt the program
+                load_fault = true;
+            }
+            break;
+        }
+
+        case Opcode::MEMCPY:
+        case Opcode::MEMSET:
+        case Opcode::MEMCMP:
+            if (reg(instr.dst) && reg(instr.src1) && reg(instr.src2) &&
+                !executeBulk(instr.opcode, data_registers[instr.dst], data_registers[instr.src1],
+                             data_registers[instr.src2], status_register)) {
+                LOG_ERROR("Error: Bulk memory access to out of bounds address at PC=" << pc-1);
+                pc = program_length;  // Fault: halt the program
+                load_fault = true;
+            }
+            break;
+
+        case Opcode::HOSTCALL:
+            if (!callHost(instr.dst, data_registers.data(), status_register)) {
+                LOG_ERROR("Error: Host call " << instr.dst << " failed at PC=" << pc-1);
+                pc = program_length;  // Fault: halt the program
+                load_fault = true;
+            }
+            break;
+    }
+}
+
+/**
+ * @brief Executes a vector instruction on the vector unit.
+ *
+ * @param instr The instruction; its register operands have been checked.
+ * @param regs The scalar registers (the machine's, or a JitContext's).
+ * @return False if a vector access faulted; memory and registers are then unchanged.
+ */
+bool RiscMachine::executeVector(const Instruction& instr, uint32_t* regs) {
+    switch (instr.opcode) {
+        case Opcode::VLOAD:
+            return vector_unit.load(instr.dst, data_memory, regs[instr.src1], regs[instr.src2]);
+        case Opcode::VSTORE:
+            return vector_unit.store(instr.src1, data_memory, regs[instr.dst], regs[instr.src2]);
+        case Opcode::VADD:
+            vector_unit.add(instr.dst, instr.src1, instr.src2);
+            return true;
+        case Opcode::VSUB:
+            vector_unit.sub(instr.dst, instr.src1, instr.src2);
+            return true;
+        case Opcode::VMUL:
+            vector_unit.mul(instr.dst, instr.src1, instr.src2);
+            return true;
+        case Opcode::VREDUCE:
+            regs[instr.dst] = vector_unit.reduce(instr.src1);
+            return true;
+        case Opcode::VSETVL:
+            regs[instr.dst] = vector_unit.setLength(regs[instr.src1]);
+            return true;
+        default:
+            return true;
+    }
+}
+
+/**
+ * @brief Calls a bound host function with this machine's memory and hart index.
+ *
+ * @param id Call ID.
+ * @param regs The scalar registers.
+ * @param flags The status flags.
+ * @return False if nothing is bound to @p id or the function returned false.
+ */
+bool RiscMachine::callHost(uint32_t id, uint32_t* regs, LazyFlags& flags) {
+    const HostFunction* function = host_calls ? host_calls->find(id) : nullptr;
+    if (!function) return false;
+    HostCall call{regs, data_registers.size(), HostMemory(data_memory), flags, hart_id};
+    return (*function)(call);
+}
+
+/**
+ * @brief Executes MEMCPY, MEMSET or MEMCMP after checking both ranges.
+ *
+ * @param op The opcode.
+ * @param lhs Destination or first range address.
+ * @param rhs Source address, fill value or second range address.
+ * @param count Number of words.
+ * @param flags Status flags; MEMCMP sets ZF, CF and NF.
+ * @return False if a range extends beyond data memory; nothing is then changed.
+ */
+bool RiscMachine::executeBulk(Opcode op, uint32_t lhs, uint32_t rhs, uint32_t count, LazyFlags& flags) {
+    if (count == 0) {
+        if (op == Opcode::MEMCMP) {
+            flags.setZero(true);
+            flags.setSub(0, 0);
+        }
+        return true;
+    }
+    const uint64_t size = data_memory.size();
+    if (uint64_t(lhs) + count > size || (op != Opcode::MEMSET && uint64_t(rhs) + count > size)) return false;
+    switch (op) {
+        case Opcode::MEMCPY:
+            data_memory.copy(lhs, rhs, count);
+            break;
+        case Opcode::MEMSET:
+            data_memory.fill(lhs, rhs, count);
+            break;
+        default: {
+            const uint32_t at = data_memory.compare(lhs, rhs, count);
+            const bool equal = at == count;
+            flags.setZero(equal);
+            flags.setSub(equal ? 0 : data_memory.read(lhs + at), equal ? 0 : data_memory.read(rhs + at));
+            break;
+        }
     }
+    return true;
 }
+
 /**
  * @brief Sets a value in the data memory at the specified address.
  * 
@@ -271,8 +1015,10 @@ void RiscMachine::execute(const Instruction& instr) {
  * @param value The value to set at the specified address.
  */
 void RiscMachine::setMemoryValue(uint32_t address, uint32_t value) {
-    if (address < data_memory.size())
-        data_memory[address] = value;
+    if (address < data_memory.size()) {
+        data_memory.write(address, value);
+        if (recording.recorder) recording.recorder->write(address, value);
+    }
 }
 
 /**
@@ -283,15 +1029,381 @@ void RiscMachine::setMemoryValue(uint32_t address, uint32_t value) {
  */
 uint32_t RiscMachine::getMemoryValue(uint32_t address) const {
     if (address < data_memory.size())
-        return data_memory[address];
+        return data_memory.read(address);
     return 0;
 }
 
+/**
+ * @brief Writes a range of data memory after one bounds check.
+ *
+ * @param address First address to write.
+ * @param values The words to write.
+ * @param count Number of words.
+ * @return False if the range extends beyond data memory.
+ */
+bool RiscMachine::writeMemory(uint32_t address, const uint32_t* values, size_t count) {
+    if (uint64_t(address) + count > data_memory.size()) return false;
+    data_memory.writeRange(address, values, count);
+    if (recording.recorder) {
+        for (size_t i = 0; i < count; ++i) recording.recorder->write(address + static_cast<uint32_t>(i), values[i]);
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a range of data memory after one bounds check.
+ *
+ * @param address First address to read.
+ * @param values Receives the words.
+ * @param count Number of words.
+ * @return False if the range extends beyond data memory.
+ */
+bool RiscMachine::readMemory(uint32_t address, uint32_t* values, size_t count) const {
+    if (uint64_t(address) + count > data_memory.size()) return false;
+    data_memory.readRange(address, values, count);
+    return true;
+}
+
+/**
+ * @brief Binds a host function; the table is copied first if forks or snapshots share it.
+ *
+ * @param id Call ID.
+ * @param function The function, or an empty function to unbind.
+ */
+void RiscMachine::bindHostCall(uint32_t id, HostFunction function) {
+    auto table = host_calls ? std::make_shared<HostCallTable>(*host_calls) : std::make_shared<HostCallTable>();
+    table->bind(id, std::move(function));
+    host_calls = std::move(table);
+}
+
+/**
+ * @brief Replaces all host call bindings.
+ *
+ * @param table The bindings.
+ */
+void RiscMachine::setHostCalls(HostCallTable table) {
+    host_calls = std::make_shared<const HostCallTable>(std::move(table));
+}
+
+/**
+ * @brief Gets the host call bindings.
+ *
+ * @return The bindings; an empty table if none were made.
+ */
+const HostCallTable& RiscMachine::getHostCalls() const {
+    static const HostCallTable empty;
+    return host_calls ? *host_calls : empty;
+}
+
 /**
  * @brief Retrieves the current status register of the machine.
  * 
  * @return The current status register containing flags such as ZF, CF, NF, OF, and DF.
  */
 StatusRegister RiscMachine::getStatusRegister() const {
-    return status_register;
-}
\ No newline at end of file
+    return status_register.get();
+}
+
+/**
+ * @brief Sets VLMAX; a recording logs the vector state with the next run.
+ *
+ * @param elements Requested maximum vector length.
+ */
+void RiscMachine::setVectorLength(uint32_t elements) {
+    vector_unit.setMaxLength(elements);
+    if (recording.recorder) recording.image_pending = true;
+}
+
+/**
+ * @brief Retrieves the maximum vector length.
+ *
+ * @return VLMAX in elements.
+ */
+uint32_t RiscMachine::getVectorLength() const {
+    return vector_unit.maxLength();
+}
+
+/**
+ * @brief Retrieves a vector register.
+ *
+ * @param index Vector register index.
+ * @return The register's elements, or zeros for an invalid index.
+ */
+VectorUnit::Register RiscMachine::getVectorRegister(uint32_t index) const {
+    return index < VectorUnit::kRegisters ? vector_unit.at(index) : VectorUnit::Register{};
+}
+
+/**
+ * @brief Retrieves the execution engine selected at construction.
+ * 
+ * @return The engine used by run().
+ */
+ExecutionEngine RiscMachine::getEngine() const {
+    return engine;
+}
+
+/**
+ * @brief Checks whether the loaded program is executed as native code.
+ * 
+ * @return True if the JIT engine translated the current program.
+ */
+bool RiscMachine::isJitCompiled() const {
+    return program->jit != nullptr;
+}
+
+/**
+ * @brief Enables or disables macro-op fusion for programs loaded afterwards.
+ * 
+ * @param enabled True to fuse compare-and-branch sequences at load time.
+ */
+void RiscMachine::setFusionEnabled(bool enabled) {
+    fusion_enabled = enabled;
+}
+
+/**
+ * @brief Sets the persistent translation cache used by subsequent loadProgram() calls.
+ *
+ * @param cache The cache, or nullptr to translate every program afresh.
+ */
+void RiscMachine::setTranslationCache(std::shared_ptr<TranslationCache> cache) {
+    translation_cache = std::move(cache);
+}
+
+/**
+ * @brief Gets the persistent translation cache.
+ *
+ * @return The cache, or nullptr if none is set.
+ */
+const std::shared_ptr<TranslationCache>& RiscMachine::getTranslationCache() const {
+    return translation_cache;
+}
+
+/**
+ * @brief Shares a run cache with this machine.
+ *
+ * @param cache The cache, or nullptr to execute every run.
+ */
+void RiscMachine::setRunCache(std::shared_ptr<RunCache> cache) {
+    run_cache = std::move(cache);
+}
+
+/**
+ * @brief Gets the run cache.
+ *
+ * @return The cache, or nullptr.
+ */
+const std::shared_ptr<RunCache>& RiscMachine::getRunCache() const {
+    return run_cache;
+}
+
+/**
+ * @brief Retrieves the number of dispatches avoided by fused superinstructions.
+ * 
+ * @return The number of instructions executed inside fused records without their own dispatch.
+ */
+uint64_t RiscMachine::getFusedDispatchesSaved() const {
+    return fused_dispatches_saved;
+}
+
+/**
+ * @brief Enables or disables reduction-loop offloading for programs loaded afterwards.
+ * 
+ * @param enabled True to recognise reduction loops at load time.
+ */
+void RiscMachine::setReductionEnabled(bool enabled) {
+    reduction_enabled = enabled;
+}
+
+/**
+ * @brief Retrieves the number of iterations run by the reduction kernel.
+ * 
+ * @return Loop iterations executed as bulk sums since the program was loaded.
+ */
+uint64_t RiscMachine::getReducedIterations() const {
+    return reduced_iterations;
+}
+
+/**
+ * @brief Gets the number of instructions the last run(max_steps) executed.
+ *
+ * @return Executed instructions.
+ */
+uint64_t RiscMachine::getLastRunSteps() const {
+    return last_run_steps;
+}
+
+/**
+ * @brief Runs the clean iterations of the reduction loop at a program counter.
+ * 
+ * @param at Program counter of the indirect LOAD about to execute.
+ * @param max_steps Maximum number of instructions the iterations may cover.
+ * @return Instructions covered by the executed iterations.
+ */
+uint64_t RiscMachine::reduceAt(uint32_t at, uint64_t max_steps) {
+    for (const ReductionLoop& loop : program->reductions) {
+        if (loop.head == at) {
+            const uint64_t iterations = runReductionLoop(loop, data_registers.data(), status_register, data_memory,
+                                                         max_steps / loop.length);
+            reduced_iterations += iterations;
+            return iterations * loop.length;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Retrieves the verifier's findings for the loaded program.
+ * 
+ * @return The report produced when the program was loaded.
+ */
+const VerificationReport& RiscMachine::getVerificationReport() const {
+    return program->verification;
+}
+
+/**
+ * @brief Enables or disables guest profiling for subsequent runs.
+ * 
+ * @param enabled True to collect statistics.
+ */
+void RiscMachine::setStatsEnabled(bool enabled) {
+    if (enabled && !stats_enabled) stats.reset(program_length);
+    if (!enabled) stats.reset(0);
+    stats_enabled = enabled;
+}
+
+/**
+ * @brief Checks whether guest profiling is enabled.
+ * 
+ * @return True if run() collects statistics.
+ */
+bool RiscMachine::isStatsEnabled() const {
+    return stats_enabled;
+}
+
+/**
+ * @brief Retrieves the collected guest profile.
+ * 
+ * @return The statistics of all runs since profiling was enabled or the program was loaded.
+ */
+const ExecutionStats& RiscMachine::getStats() const {
+    return stats;
+}
+
+/**
+ * @brief Clears the collected guest profile.
+ */
+void RiscMachine::resetStats() {
+    stats.reset(stats_enabled ? program_length : 0);
+}
+
+/**
+ * @brief Creates the trace file and starts its writer thread.
+ * 
+ * @param path Path of the trace file.
+ * @param capacity Ring capacity in records.
+ * @param error Receives a description of the problem if the file cannot be created.
+ * @return True if tracing started.
+ */
+bool RiscMachine::startTrace(const std::string& path, size_t capacity, std::string* error) {
+    stopTrace();
+    tracer.writer = TraceWriter::open(path, capacity, error);
+    return tracer.writer != nullptr;
+}
+
+/**
+ * @brief Flushes and closes the trace file.
+ * 
+ * @return False if writing the trace failed.
+ */
+bool RiscMachine::stopTrace() {
+    if (!tracer.writer) return true;
+    const bool written = tracer.writer->close();
+    tracer.writer.reset();
+    return written;
+}
+
+/**
+ * @brief Checks whether a trace is being recorded.
+ * 
+ * @return True while tracing.
+ */
+bool RiscMachine::isTracing() const {
+    return tracer.writer != nullptr;
+}
+
+/**
+ * @brief Creates the replay log; the program, and the state image at the next run, are logged.
+ * 
+ * @param path Path of the log file.
+ * @param error Receives a description of the problem if the file cannot be created.
+ * @return True if recording started.
+ */
+bool RiscMachine::startRecording(const std::string& path, std::string* error) {
+    stopRecording();
+    recording.recorder = ReplayRecorder::open(path, data_memory.size(), error);
+    if (!recording.recorder) return false;
+    recording.recorder->program(static_cast<uint32_t>(program_length), programChecksum(program_code, program_length));
+    recording.image_pending = true;
+    return true;
+}
+
+/**
+ * @brief Flushes and closes the replay log.
+ * 
+ * @return False if writing the log failed.
+ */
+bool RiscMachine::stopRecording() {
+    if (!recording.recorder) return true;
+    const bool written = recording.recorder->close();
+    recording.recorder.reset();
+    return written;
+}
+
+/**
+ * @brief Checks whether executions are being recorded.
+ * 
+ * @return True while recording.
+ */
+bool RiscMachine::isRecording() const {
+    return recording.recorder != nullptr;
+}
+
+/**
+ * @brief Captures the machine state; data pages become copy-on-write.
+ * 
+ * @return The snapshot.
+ */
+MachineSnapshot RiscMachine::snapshot() const {
+    MachineSnapshot snapshot;
+    snapshot.state = std::make_shared<const RiscMachine>(*this);
+    return snapshot;
+}
+
+/**
+ * @brief Replaces the machine state with a snapshot.
+ * 
+ * @param snapshot The state to return to; a default-constructed snapshot is ignored.
+ */
+void RiscMachine::restore(const MachineSnapshot& snapshot) {
+    if (!snapshot.state) return;
+    *this = *snapshot.state;
+    recording.image_pending = true;  // the restored state is not derivable from the log
+}
+
+/**
+ * @brief Creates a machine sharing this machine's program and data pages.
+ * 
+ * @return The forked machine.
+ */
+RiscMachine RiscMachine::fork() const {
+    return *this;
+}
+
+/**
+ * @brief Retrieves the number of data pages copied on write.
+ * 
+ * @return The number of pages duplicated since the memory was last shared into this machine.
+ */
+uint64_t RiscMachine::getCopiedPages() const {
+    return data_memory.copiedPages();
+}
@@ -10,31 +10,61 @@
 #pragma once
 
 #include "instruction.hpp"
+#include "data_memory.hpp"
+#include "decoder.hpp"
+#include "flags.hpp"
+#include "host_call.hpp"
+#include "jit.hpp"
+#include "program_file.hpp"
+#include "reduction.hpp"
+#include "replay_log.hpp"
+#include "run_cache.hpp"
+#include "stats.hpp"
+#include "trace.hpp"
+#include "translation_cache.hpp"
+#include "vector_unit.hpp"
+#include "verifier.hpp"
 #include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
 #include <vector>
 #include <cstdint>
+#include <cstddef>
 
 /**
- * @struct StatusRegister
- * @brief Represents the status register flags for the RISC machine.
- *
- * Contains individual flag bits for zero, carry, negative, overflow, and division by zero.
+ * @enum ExecutionEngine
+ * @brief Selects how a RiscMachine dispatches instructions.
+ */
+enum class ExecutionEngine {
+    Switch,   /**< Reference engine: fetch each Instruction and dispatch through a switch */
+    Threaded, /**< Decode once at load time and dispatch with computed-goto threading */
+    Jit       /**< Translate basic blocks to native code; falls back to Threaded if unavailable */
+};
+
+/**
+ * @enum RunStatus
+ * @brief Why RiscMachine::run(max_steps) returned.
+ */
+enum class RunStatus {
+    Halted,          /**< HALT executed or the program counter left the program */
+    BudgetExhausted, /**< max_steps instructions executed; run() again to continue */
+    Faulted          /**< An indirect LOAD addressed memory outside data memory */
+};
+
+/**
+ * @struct HartState
+ * @brief Architectural state of one hart after RiscMachine::runHarts().
  */
-struct StatusRegister {
-    /** @brief Zero flag compare (1 if result is zero) */
-    uint32_t ZF : 1;
-    /** @brief Carry flag (1 if carry occurred) */
-    uint32_t CF : 1;
-    /** @brief Negative flag (1 if result is negative) */
-    uint32_t NF : 1;
-    /** @brief Overflow flag (1 if overflow occurred) */
-    uint32_t OF : 1;
-    /** @brief Division by zero flag (1 if division by zero occurred) */
-    uint32_t DF : 1;
-    /** @brief Reserved bits (unused) */
-    uint32_t reserved : 28;
+struct HartState {
+    std::array<uint32_t, 16> registers{}; /**< R0–R15 */
+    StatusRegister flags{};               /**< Status flags */
+    uint32_t pc = 0;                      /**< Program counter; the program length once the hart halted */
 };
 
+class MachineSnapshot;
+
 /**
  * @file machine.hpp
  * @brief Defines the RiscMachine class, which emulates a simple RISC architecture.
@@ -42,6 +72,10 @@ struct StatusRegister {
  * This file contains the declaration of the RiscMachine class, which provides
  * methods for loading and executing programs, manipulating memory, and accessing
  * the status register in a simulated RISC environment.
+ *
+ * Copying a machine is cheap: the loaded program is shared and data memory is
+ * copy-on-write, so a copy costs the registers plus one page-directory entry per
+ * 2 MiB of data memory. Pages are duplicated when either machine first writes them.
  */
 
 class RiscMachine {
@@ -50,8 +84,10 @@ public:
      * @brief Constructs a RiscMachine instance.
      * @param program_size The initial size of the program memory (default: 256).
      * @param data_size The initial size of the data memory (default: 1024).
+     * @param engine The execution engine used by run() (default: Switch).
      */
-    RiscMachine(size_t program_size = 256, size_t data_size = 1024);
+    RiscMachine(size_t program_size = 256, size_t data_size = 1024,
+                ExecutionEngine engine = ExecutionEngine::Switch);
 
     /**
      * @brief Loads a program into the program memory.
@@ -59,16 +95,85 @@ public:
      */
     void loadProgram(const std::vector<Instruction>& program);
 
+    /**
+     * @brief Loads a memory-mapped program file without copying its instructions.
+     *
+     * The switch engine executes directly from the mapped pages; the machine keeps
+     * a reference to @p program for as long as it stays loaded. Because the file
+     * could still be changed under the mapping, the switch engine checks the
+     * operands of every mapped instruction even when the program verified; the
+     * other engines run their own decoded copy. The file's data image, if any, is
+     * copied into data memory (words outside memory are dropped).
+     *
+     * @param program A program opened with MappedProgram::open().
+     */
+    void loadProgram(std::shared_ptr<const MappedProgram> program);
+
     /**
      * @brief Executes the loaded program from the current program counter.
+     *
+     * With a run cache (setRunCache()), a run that was cached before is not
+     * executed; its final state is applied instead.
      */
     void run();
 
+    /**
+     * @brief Executes at most @p max_steps instructions from the current program counter.
+     *
+     * Stops early at HALT, at the end of the program or on a fault. A run that
+     * exhausts its budget leaves the machine exactly between two instructions;
+     * calling run() or run(max_steps) again continues as if it had never
+     * stopped. Budgeted runs execute on the threaded engine when the program was
+     * translated for it or for the JIT (which keeps the threaded form for
+     * this), counting steps at branches; the last steps, fewer than the program
+     * length, run on the switch engine so the run stops on the exact
+     * instruction. Switch machines, and profiled or traced runs, use the
+     * switch engine throughout. Offloaded reduction loops count every
+     * iteration they cover and never exceed the budget. Invalid jump targets remain no-ops,
+     * as in run(); the verifier reports them at load time.
+     *
+     * @param max_steps Maximum number of instructions to execute.
+     * @return Whether the program halted, faulted or ran out of budget.
+     */
+    RunStatus run(uint64_t max_steps);
+
+    /**
+     * @brief Gets the number of instructions the last run(max_steps) executed.
+     * @return Executed instructions, including those covered by offloaded reduction loops.
+     */
+    uint64_t getLastRunSteps() const;
+
+    /**
+     * @brief Runs the loaded program on several harts that share this machine's data memory.
+     *
+     * Hart 0 is this machine and runs on the calling thread; harts 1 to
+     * @p hart_count - 1 each run on their own host thread, starting from a copy
+     * of this machine's pc, registers and flags. HART_ID tells them apart.
+     * Every hart runs on the selected engine until it halts or faults, and the
+     * call returns once all have. Memory accesses follow the model described
+     * in instruction.hpp. Pages are still allocated on first write: a hart
+     * that stores to a new page publishes it atomically, so harts never race
+     * on allocation and memory use stays proportional to the pages touched.
+     *
+     * Only hart 0 is profiled or traced. Multi-hart runs are not deterministic,
+     * so a recording machine logs the state they leave as a new image instead
+     * of the run itself.
+     *
+     * @param hart_count Number of harts (0 is treated as 1).
+     * @return The final state of every hart, indexed by hart ID.
+     */
+    std::vector<HartState> runHarts(size_t hart_count);
+
     /**
      * @brief Resets the machine state, including registers and memory.
      */
     void reset();
 
+    /**
+     * @brief Sets every word of data memory to zero.
+     */
+    void clearMemory();
+
     /**
      * @brief Sets a value in data memory at the specified address.
      * @param address The memory address to set.
@@ -83,24 +188,524 @@ public:
      */
     uint32_t getMemoryValue(uint32_t address) const;
 
+    /**
+     * @brief Writes consecutive words of data memory with one bounds check.
+     *
+     * Copies page by page, so loading a large input costs about as much as a
+     * memcpy. A recording machine logs every word like setMemoryValue().
+     *
+     * @param address First address to write.
+     * @param values The words to write.
+     * @param count Number of words.
+     * @return False, writing nothing, if the range extends beyond data memory.
+     */
+    bool writeMemory(uint32_t address, const uint32_t* values, size_t count);
+
+    /**
+     * @brief Writes a vector of words to consecutive addresses of data memory.
+     * @param address First address to write.
+     * @param values The words to write.
+     * @return False, writing nothing, if the range extends beyond data memory.
+     */
+    bool writeMemory(uint32_t address, const std::vector<uint32_t>& values) {
+        return writeMemory(address, values.data(), values.size());
+    }
+
+    /**
+     * @brief Reads consecutive words of data memory with one bounds check.
+     * @param address First address to read.
+     * @param values Receives @p count words.
+     * @param count Number of words.
+     * @return False, reading nothing, if the range extends beyond data memory.
+     */
+    bool readMemory(uint32_t address, uint32_t* values, size_t count) const;
+
+    /**
+     * @brief Reads consecutive words of data memory into a vector.
+     * @param address First address to read.
+     * @param values Receives values.size() words.
+     * @return False, reading nothing, if the range extends beyond data memory.
+     */
+    bool readMemory(uint32_t address, std::vector<uint32_t>& values) const {
+        return readMemory(address, values.data(), values.size());
+    }
+
+    /**
+     * @brief Binds a host function to a HOSTCALL call ID.
+     *
+     * Bindings are shared with forks and snapshots taken afterwards; binding
+     * again does not affect them.
+     *
+     * @param id Call ID.
+     * @param function The function; an empty function unbinds the ID.
+     */
+    void bindHostCall(uint32_t id, HostFunction function);
+
+    /**
+     * @brief Replaces all host call bindings, e.g. with HostCallTable::builtins().
+     * @param table The bindings.
+     */
+    void setHostCalls(HostCallTable table);
+
+    /**
+     * @brief Gets the host call bindings.
+     * @return The bindings (empty if none were made).
+     */
+    const HostCallTable& getHostCalls() const;
+
     /**
      * @brief Gets the current status register.
      * @return The current StatusRegister value.
      */
     StatusRegister getStatusRegister() const;
 
+    /**
+     * @brief Sets the maximum vector length (VLMAX) and makes it the active length.
+     *
+     * VSETVL never raises the active length above VLMAX. Takes effect
+     * immediately; reset() keeps it.
+     *
+     * @param elements Elements per vector register; clamped to [1, VectorUnit::kMaxLength].
+     */
+    void setVectorLength(uint32_t elements);
+
+    /**
+     * @brief Gets the maximum vector length (VLMAX).
+     * @return Elements per vector register.
+     */
+    uint32_t getVectorLength() const;
+
+    /**
+     * @brief Gets a vector register.
+     * @param index Register index (V0–V7).
+     * @return All VectorUnit::kMaxLength elements, or zeros if @p index is out of range.
+     */
+    VectorUnit::Register getVectorRegister(uint32_t index) const;
+
+    /**
+     * @brief Gets the execution engine selected at construction.
+     * @return The engine used by run().
+     */
+    ExecutionEngine getEngine() const;
+
+    /**
+     * @brief Checks whether the loaded program runs as native code.
+     * @return True if the engine is Jit and translation succeeded.
+     */
+    bool isJitCompiled() const;
+
+    /**
+     * @brief Enables or disables macro-op fusion for subsequently loaded programs.
+     *
+     * Fusion is used by the threaded engine and is enabled by default.
+     *
+     * @param enabled True to fuse compare-and-branch sequences at load time.
+     */
+    void setFusionEnabled(bool enabled);
+
+    /**
+     * @brief Shares a persistent translation cache for subsequently loaded programs.
+     *
+     * With a cache, loadProgram() on the threaded and JIT engines first looks
+     * for a saved translation of the program for this machine's configuration
+     * and uses it instead of verifying, decoding, fusing and translating the
+     * program again; on a miss it translates the program and saves the result.
+     * The switch engine, and programs shorter than
+     * TranslationCacheOptions::min_instructions, do not use the cache. Forks
+     * share the cache.
+     *
+     * @param cache The cache, or nullptr (the default) to translate every program afresh.
+     */
+    void setTranslationCache(std::shared_ptr<TranslationCache> cache);
+
+    /**
+     * @brief Gets the persistent translation cache.
+     * @return The cache, or nullptr if none is set.
+     */
+    const std::shared_ptr<TranslationCache>& getTranslationCache() const;
+
+    /**
+     * @brief Shares a cache that memoises runs of pure programs (see run_cache.hpp).
+     *
+     * With a cache, run() first looks for a cached run of the loaded program
+     * from the current registers, flags and pc whose input footprint matches
+     * data memory, and applies its final registers, flags and memory writes
+     * instead of executing. On a miss the program runs on a footprint-recording
+     * instantiation of the switch engine, with every instruction executed, and
+     * the run is cached. The cache is bypassed by run(max_steps), runHarts(),
+     * profiled and traced runs, and programs with host calls or vector
+     * instructions; a program whose footprint once exceeds
+     * RunCacheOptions::max_footprint bypasses it until it is loaded again.
+     * A hit executes nothing, so it leaves the reduction and fusion counters
+     * unchanged and logs no errors. Forks share the cache.
+     *
+     * @param cache The cache, or nullptr (the default) to execute every run.
+     */
+    void setRunCache(std::shared_ptr<RunCache> cache);
+
+    /**
+     * @brief Gets the run cache.
+     * @return The cache, or nullptr if none is set.
+     */
+    const std::shared_ptr<RunCache>& getRunCache() const;
+
+    /**
+     * @brief Gets the number of dispatches avoided by fused superinstructions.
+     *
+     * Counts every instruction that executed as part of a fused record rather
+     * than through its own dispatch since the program was loaded.
+     *
+     * @return The number of dispatches removed by fusion.
+     */
+    uint64_t getFusedDispatchesSaved() const;
+
+    /**
+     * @brief Enables or disables reduction-loop offloading for subsequently loaded programs.
+     *
+     * Array-sum loops (see reduction.hpp) are recognised at load time and, on
+     * every engine, run as one vectorised sum over data memory instead of
+     * instruction by instruction. Profiled and traced runs always execute every
+     * instruction. Enabled by default.
+     *
+     * @param enabled True to recognise reduction loops at load time.
+     */
+    void setReductionEnabled(bool enabled);
+
+    /**
+     * @brief Gets the number of loop iterations executed by the reduction kernel.
+     * @return Iterations offloaded since the program was loaded.
+     */
+    uint64_t getReducedIterations() const;
+
+    /**
+     * @brief Gets the load-time verification result of the current program.
+     *
+     * Programs without issues run on the switch engine without per-instruction
+     * operand checks; only indirect LOAD addresses are still checked. Mapped
+     * programs are always checked.
+     *
+     * @return The diagnostics of the verifier.
+     */
+    const VerificationReport& getVerificationReport() const;
+
+    /**
+     * @brief Enables or disables guest profiling.
+     *
+     * While enabled, run() executes on a counting instantiation of the switch
+     * engine whatever engine was selected (results are identical); the selected
+     * engine runs unmodified again once profiling is disabled. Enabling clears
+     * the statistics, and loading a program clears them as well.
+     *
+     * @param enabled True to collect statistics in subsequent runs.
+     */
+    void setStatsEnabled(bool enabled);
+
+    /**
+     * @brief Checks whether guest profiling is enabled.
+     * @return True if run() collects statistics.
+     */
+    bool isStatsEnabled() const;
+
+    /**
+     * @brief Gets the statistics collected since profiling was enabled or the program was loaded.
+     * @return The profile; empty if profiling is disabled.
+     */
+    const ExecutionStats& getStats() const;
+
+    /**
+     * @brief Clears the collected statistics.
+     */
+    void resetStats();
+
+    /**
+     * @brief Starts recording every executed instruction to a binary trace file.
+     *
+     * While tracing, run() executes on a recording instantiation of the switch
+     * engine (results are identical) that pushes one TraceRecord per instruction
+     * into a lock-free ring buffer; a background thread writes the ring to
+     * @p path. Render the file with RiscTraceDump or readTraceFile(). A trace
+     * already in progress is stopped first. Copies, forks and snapshots do not
+     * trace, and restore() keeps the current trace running.
+     *
+     * @param path Path of the trace file to create.
+     * @param capacity Ring capacity in records.
+     * @param error Receives a description of the problem if the file cannot be created (optional).
+     * @return True if tracing started.
+     */
+    bool startTrace(const std::string& path, size_t capacity = kDefaultTraceCapacity,
+                    std::string* error = nullptr);
+
+    /**
+     * @brief Stops tracing and waits until the trace file is complete.
+     * @return True if every record was written (also true if no trace was running).
+     */
+    bool stopTrace();
+
+    /**
+     * @brief Checks whether instructions are being traced.
+     * @return True between startTrace() and stopTrace().
+     */
+    bool isTracing() const;
+
+    /**
+     * @brief Starts recording this machine's executions to a replay log.
+     *
+     * Only non-derivable state is logged: the loaded program's hash, the full
+     * state image at the first run (and after restore()), host changes through
+     * setMemoryValue(), clearMemory(), reset() and loadProgram(), and the end
+     * state of every run. Runs execute on the selected engine unchanged.
+     * replayRecording() re-executes the log. A recording already in progress is
+     * stopped first; copies, forks and snapshots do not record.
+     *
+     * @param path Path of the log file to create.
+     * @param error Receives a description of the problem if the file cannot be created (optional).
+     * @return True if recording started.
+     */
+    bool startRecording(const std::string& path, std::string* error = nullptr);
+
+    /**
+     * @brief Stops recording and closes the replay log.
+     * @return True if the whole log was written (also true if nothing was recorded).
+     */
+    bool stopRecording();
+
+    /**
+     * @brief Checks whether executions are being recorded.
+     * @return True between startRecording() and stopRecording().
+     */
+    bool isRecording() const;
+
+    /**
+     * @brief Captures the complete machine state.
+     *
+     * The snapshot shares the program and all data pages with the machine; the
+     * machine copies a page the first time it writes it after the snapshot.
+     *
+     * @return A snapshot that restore() can return to any number of times.
+     */
+    MachineSnapshot snapshot() const;
+
+    /**
+     * @brief Returns to a previously captured state.
+     *
+     * Registers, flags, pc, data memory, the loaded program and the engine are all
+     * replaced by those of the snapshot.
+     *
+     * @param snapshot A snapshot taken from this or any other machine.
+     */
+    void restore(const MachineSnapshot& snapshot);
+
+    /**
+     * @brief Creates an independent machine in the same state.
+     *
+     * The child shares the program and, until either side writes them, the data
+     * pages of this machine. It continues from the current pc when run.
+     *
+     * @return The forked machine.
+     */
+    RiscMachine fork() const;
+
+    /**
+     * @brief Gets the number of data pages this machine copied on write.
+     * @return Pages duplicated since the machine was created, forked or restored.
+     */
+    uint64_t getCopiedPages() const;
+
 private:
+    friend class ReplayPlayer;  // rebuilds recorded state images
+
+    /**
+     * @struct LoadedProgram
+     * @brief A loaded program and everything derived from it; shared between forks.
+     */
+    struct LoadedProgram {
+        std::vector<Instruction> instructions;  // owned program storage
+        std::shared_ptr<const MappedProgram> mapped;  // keeps a mapped program alive
+        std::vector<PackedInstruction> packed;  // threaded engine (and JIT fallback)
+        std::once_flag packed_bound;  // handler addresses filled in
+        std::shared_ptr<const JitProgram> jit;  // JIT engine only
+        VerificationReport verification;  // result of verifying the program
+        bool unchecked = false;  // verified and not mapped: the switch engine skips operand checks
+        std::vector<ReductionLoop> reductions;  // loops run by runReductionLoop()
+        std::once_flag run_key_made;  // run_hash and memoisable computed
+        uint64_t run_hash = 0;  // RunCache::programHash() of the instructions
+        bool memoisable = false;  // RunCache::isMemoisable()
+        std::atomic<bool> footprint_overflowed{false};  // a run exceeded the run cache's max_footprint
+    };
+
+
     /**
      * @brief Executes a single instruction.
+     * @tparam Checked Whether operands are range-checked (false for verified programs).
      * @param instr The instruction to execute.
      */
+    template <bool Checked>
     void execute(const Instruction& instr);
 
+    /**
+     * @brief Runs the program on the engine selected for this run (tracing, profiling or the configured engine).
+     */
+    void dispatch();
+
+    /**
+     * @brief Runs the program through the run cache if it applies, otherwise like dispatch().
+     */
+    void dispatchCached();
+
+    /**
+     * @brief Evaluates all flags.
+     * @return Bit i holds the flag with CHECK_FLAG index i (ZF, CF, NF, OF, DF).
+     */
+    uint32_t flagBits() const {
+        return status_register.read(0) | status_register.read(1) << 1 | status_register.read(2) << 2 |
+               status_register.read(3) << 3 | status_register.read(4) << 4;
+    }
+
+    /**
+     * @brief Runs the budgeted program on the engine selected for this run (always a switch engine).
+     * @param max_steps Maximum number of instructions to execute.
+     * @return Why the run stopped.
+     */
+    RunStatus dispatch(uint64_t max_steps);
+
+    /**
+     * @brief Runs the program with the switch engine.
+     * @tparam Checked Whether operands are range-checked (false for verified programs).
+     * @tparam Profiled Whether every instruction is recorded in stats.
+     * @tparam Traced Whether every instruction is pushed to the trace.
+     * @tparam Budgeted Whether to stop after @p max_steps instructions.
+     * @param max_steps Instruction budget (Budgeted only).
+     * @return Instructions executed (Budgeted only).
+     */
+    template <bool Checked, bool Profiled = false, bool Traced = false, bool Budgeted = false>
+    uint64_t runSwitch(uint64_t max_steps = 0);
+
+    /**
+     * @brief Runs the program with an instrumented switch engine.
+     * @tparam Profiled Whether every instruction is recorded in stats.
+     * @tparam Traced Whether every instruction is pushed to the trace.
+     * @tparam Budgeted Whether to stop after @p max_steps instructions.
+     * @param max_steps Instruction budget (Budgeted only).
+     * @return Instructions executed (Budgeted only).
+     */
+    template <bool Profiled, bool Traced, bool Budgeted = false>
+    uint64_t runInstrumented(uint64_t max_steps = 0);
+
+    /**
+     * @brief Runs the program with a switch engine that records the run's input footprint.
+     * @tparam Checked Whether operands are range-checked (false for verified programs).
+     * @param footprint Receives the words read before being written and the words written.
+     */
+    template <bool Checked>
+    void runFootprint(RunFootprint& footprint);
+
+    /**
+     * @brief Prepares the engine for a newly loaded program and resets the machine.
+     * @param loaded The program; its instructions or mapping must already be set.
+     */
+    void prepareProgram(std::shared_ptr<LoadedProgram> loaded);
+
+    /**
+     * @brief Runs the reduction loop whose head is at @p at, if there is one.
+     * @param at Program counter of an indirect LOAD about to execute.
+     * @param max_steps Maximum number of instructions the iterations may cover.
+     * @return The number of instructions the executed iterations cover.
+     */
+    uint64_t reduceAt(uint32_t at, uint64_t max_steps = UINT64_MAX);
+
+    /**
+     * @brief Executes a vector instruction whose register operands are valid.
+     *
+     * Shared by the switch engine and the host side of translated code.
+     *
+     * @param instr VLOAD … VSETVL.
+     * @param regs The scalar registers.
+     * @return False if a VLOAD or VSTORE element lies outside data memory.
+     */
+    bool executeVector(const Instruction& instr, uint32_t* regs);
+
+    /**
+     * @brief Executes a bulk memory instruction on register values.
+     *
+     * Shared by every engine except the wide machine.
+     *
+     * @param op MEMCPY, MEMSET or MEMCMP.
+     * @param lhs R[dst]: the destination (MEMCPY, MEMSET) or first range (MEMCMP).
+     * @param rhs R[src1]: the source, fill value or second range.
+     * @param count R[src2]: number of words.
+     * @param flags Receives the MEMCMP flags.
+     * @return False, touching nothing, if a range extends beyond data memory.
+     */
+    bool executeBulk(Opcode op, uint32_t lhs, uint32_t rhs, uint32_t count, LazyFlags& flags);
+
+    /**
+     * @brief Verifies, decodes and translates the current program for the selected engine.
+     * @return The load-time results that a TranslationCache saves.
+     */
+    ProgramTranslation translateProgram() const;
+
+    /**
+     * @brief Runs the host function bound to a call ID (HOSTCALL).
+     *
+     * @param id Call ID.
+     * @param regs The scalar registers (the machine's, or a JitContext's).
+     * @param flags The status flags.
+     * @return False if no function is bound or the function faulted.
+     */
+    bool callHost(uint32_t id, uint32_t* regs, LazyFlags& flags);
+
+    /**
+     * @brief Runs the decoded program with the threaded engine.
+     * @tparam Budgeted Whether to count steps and stop at a branch once fewer
+     *         than the program length remain of @p max_steps.
+     * @param max_steps Instruction budget (Budgeted only).
+     * @return Instructions executed (Budgeted only).
+     */
+    template <bool Budgeted = false>
+    uint64_t runThreaded(uint64_t max_steps = 0);
+
+    /**
+     * @brief Runs the native translation of the program.
+     */
+    void runJit();
+
     std::array<uint32_t, 16> data_registers{};  // R0–R15
-    StatusRegister status_register{};
+    LazyFlags status_register;  // evaluated on demand
+    VectorUnit vector_unit;  // V0–V7, VLMAX and vl
+    std::shared_ptr<TranslationCache> translation_cache;  // null: translate every program at load time
+    std::shared_ptr<RunCache> run_cache;  // null: execute every run
+    std::shared_ptr<const HostCallTable> host_calls;  // null: nothing bound; shared with forks and snapshots
 
     uint32_t pc = 0;  // program counter
 
-    std::vector<Instruction> program_memory;
-    std::vector<uint32_t> data_memory;
+    std::shared_ptr<LoadedProgram> program;  // shared with forks and snapshots
+    const Instruction* program_code = nullptr;  // program being executed (owned or mapped)
+    size_t program_length = 0;
+    DataMemory data_memory;  // copy-on-write pages
+
+    ExecutionEngine engine = ExecutionEngine::Switch;
+    bool fusion_enabled = true;
+    uint64_t fused_dispatches_saved = 0;
+    bool reduction_enabled = true;
+    uint64_t reduced_iterations = 0;
+    bool load_fault = false;  // set by the switch and budgeted threaded engines when an access faults
+    uint64_t last_run_steps = 0;  // instructions executed by the last run(max_steps)
+    uint32_t hart_id = 0;  // HART_ID of this machine; non-zero only for the extra harts of runHarts()
+    bool stats_enabled = false;
+    ExecutionStats stats;  // filled only while stats_enabled
+    TraceHandle tracer;  // set while tracing; not carried into copies, forks or snapshots
+    RecorderHandle recording;  // set while recording; not carried into copies, forks or snapshots
+};
+
+/**
+ * @class MachineSnapshot
+ * @brief An immutable copy of a RiscMachine's state, taken by RiscMachine::snapshot().
+ *
+ * Snapshots share their program and data pages; copying one is cheap, and one
+ * snapshot may be restored by several threads at once.
+ */
+class MachineSnapshot {
+private:
+    friend class RiscMachine;
+    std::shared_ptr<const RiscMachine> state;
 };
\ No newline at end of file
@@ -51,10 +51,7 @@ int main() {
     machine.setMemoryValue(302, 0);   // result
 
     // array values
-    machine.setMemoryValue(400, 10);
-    machine.setMemoryValue(401, 20);
-    machine.setMemoryValue(402, 30);
-    machine.setMemoryValue(403, 40);
+    machine.writeMemory(400, {10, 20, 30, 40});
 
     auto sum_program = createSumListProgram(300, 301, 302);
     machine.loadProgram(sum_program);
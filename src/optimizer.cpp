@@ -0,0 +1,748 @@
+/**
+ * @file optimizer.cpp
+ * @brief Implementation of the guest program optimizer.
+ */
+
+#include "optimizer.hpp"
+#include "vector_unit.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Register r is bit r of a mask; flag f (CHECK_FLAG index) is bit 32 + f
+constexpr uint32_t kMaxRegisters = 32;
+constexpr uint64_t regBit(uint32_t r) { return uint64_t(1) << r; }
+constexpr uint64_t flagBit(uint32_t flag) { return uint64_t(1) << (kMaxRegisters + flag); }
+constexpr uint64_t kZF = flagBit(0), kCF = flagBit(1), kNF = flagBit(2), kOF = flagBit(3), kDF = flagBit(4);
+constexpr uint64_t kAllFlags = kZF | kCF | kNF | kOF | kDF;
+
+// Observable when the program halts, faults or falls off the end: flags (and memory)
+constexpr uint64_t kExitLive = kAllFlags;
+
+/**
+ * @brief Dimensions of the machine the program is optimized for.
+ */
+struct Target {
+    size_t registers;
+    size_t data_size;
+    size_t length;  // of the program being analysed
+};
+
+enum class Kind { Nop, Halt, Jump, Branch, Other };
+enum class Divisor { Unknown, Zero, NonZero };
+
+/**
+ * @brief What one instruction reads and writes.
+ */
+struct Effects {
+    Kind kind = Kind::Other;
+    uint64_t uses = 0;         // registers and flags read
+    uint64_t defs = 0;         // registers and flags always written
+    uint64_t may_defs = 0;     // registers and flags possibly written (includes defs)
+    bool side_effect = false;  // writes memory or may fault
+    bool may_exit = false;     // indirect LOAD: halts on an out-of-range address
+};
+
+/**
+ * @brief Derives the effects of an instruction, following RiscMachine::execute.
+ *
+ * Instructions whose operands are out of range do nothing and are Nop; an
+ * invalid CMP still clears ZF.
+ */
+Effects effectsOf(const Instruction& in, const Target& target, Divisor divisor = Divisor::Unknown) {
+    auto reg = [&](uint32_t r) { return r < target.registers; };
+    auto vreg = [](uint32_t v) { return v < VectorUnit::kRegisters; };
+    Effects e;
+    switch (in.opcode) {
+        case Opcode::HALT:
+            e.kind = Kind::Halt;
+            break;
+        case Opcode::LOAD:
+            if (!reg(in.dst)) {
+                e.kind = Kind::Nop;
+            } else if (in.src2 == 0 && in.src1 < target.data_size) {
+                e.defs = regBit(in.dst);
+            } else if (in.src2 == 1 && reg(in.src1)) {
+                e.uses = regBit(in.src1);
+                e.defs = regBit(in.dst);
+                e.side_effect = e.may_exit = true;
+            } else if (in.src2 == 2) {
+                e.defs = regBit(in.dst);
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::STORE:
+            if (in.dst < target.data_size && reg(in.src1)) {
+                e.uses = regBit(in.src1);
+                e.side_effect = true;
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::DIV:
+            if (!reg(in.dst) || !reg(in.src1) || !reg(in.src2)) {
+                e.kind = Kind::Nop;
+                break;
+            }
+            e.uses = regBit(in.src1) | regBit(in.src2);
+            if (in.opcode == Opcode::ADD || in.opcode == Opcode::SUB) {
+                e.defs = regBit(in.dst) | kCF | kNF;
+            } else if (in.opcode == Opcode::MUL) {
+                e.defs = regBit(in.dst) | kOF | kNF;
+            } else {
+                // Division by zero leaves the destination and NF unchanged
+                e.defs = kDF | kOF | kCF;
+                if (divisor == Divisor::NonZero) e.defs |= regBit(in.dst) | kNF;
+                if (divisor == Divisor::Unknown) e.may_defs = regBit(in.dst) | kNF;
+            }
+            break;
+        case Opcode::CMP:
+            if (reg(in.src1) && reg(in.src2)) e.uses = regBit(in.src1) | regBit(in.src2);
+            e.defs = kZF;
+            break;
+        case Opcode::JMP:
+            if (in.dst < target.length && in.src1 == 0) {
+                e.kind = Kind::Jump;
+            } else if (in.dst < target.length && in.src1 == 1) {
+                e.kind = Kind::Branch;
+                e.uses = kZF;
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::MOV:
+            if (reg(in.dst) && reg(in.src1)) {
+                e.uses = regBit(in.src1);
+                e.defs = regBit(in.dst);
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::CHECK_FLAG:
+            if (reg(in.dst)) {
+                if (in.src1 < 5) e.uses = flagBit(in.src1);
+                e.defs = regBit(in.dst);
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::VLOAD:
+        case Opcode::VSTORE:
+            // Vector registers are not tracked; the accesses may fault like an indirect LOAD
+            if (in.opcode == Opcode::VLOAD ? vreg(in.dst) && reg(in.src1) && reg(in.src2)
+                                           : reg(in.dst) && vreg(in.src1) && reg(in.src2)) {
+                e.uses = regBit(in.opcode == Opcode::VLOAD ? in.src1 : in.dst) | regBit(in.src2);
+                e.side_effect = e.may_exit = true;
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::VADD:
+        case Opcode::VSUB:
+        case Opcode::VMUL:
+            if (vreg(in.dst) && vreg(in.src1) && vreg(in.src2)) {
+                e.side_effect = true;
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::VREDUCE:
+            if (reg(in.dst) && vreg(in.src1)) {
+                e.defs = regBit(in.dst);
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::VSETVL:
+            if (reg(in.dst) && reg(in.src1)) {
+                e.uses = regBit(in.src1);
+                e.defs = regBit(in.dst);
+                e.side_effect = true;  // sets vl
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::MEMCPY:
+        case Opcode::MEMSET:
+        case Opcode::MEMCMP:
+            // Memory is not tracked; the ranges may fault like an indirect LOAD
+            if (reg(in.dst) && reg(in.src1) && reg(in.src2)) {
+                e.uses = regBit(in.dst) | regBit(in.src1) | regBit(in.src2);
+                if (in.opcode == Opcode::MEMCMP) e.defs = kZF | kCF | kNF;
+                e.side_effect = e.may_exit = true;
+            } else {
+                e.kind = Kind::Nop;
+            }
+            break;
+        case Opcode::HOSTCALL: {
+            // The host function may read and write any register, flag or word of memory, or fault
+            const uint64_t registers = target.registers >= kMaxRegisters ? regBit(kMaxRegisters) - 1
+                                                                         : regBit(static_cast<uint32_t>(target.registers)) - 1;
+            e.uses = e.may_defs = registers | kAllFlags;
+            e.side_effect = e.may_exit = true;
+            break;
+        }
+        default:
+            e.kind = Kind::Nop;
+            break;
+    }
+    e.may_defs |= e.defs;
+    return e;
+}
+
+// ─── Control-flow graph ──────────────────────────────────────────────────────
+
+/**
+ * @brief A maximal straight-line run of instructions.
+ */
+struct Block {
+    size_t begin = 0;
+    size_t end = 0;                                  // one past the last instruction
+    std::vector<std::pair<size_t, int8_t>> successors;  // (block, ZF on that edge or -1)
+    bool exits = false;                              // can halt or fall off the end
+};
+
+/**
+ * @brief Splits a program into basic blocks at jump targets and after jumps and HALT.
+ */
+std::vector<Block> buildCfg(const std::vector<Instruction>& program, const Target& target) {
+    const size_t length = program.size();
+    std::vector<bool> leader(length + 1, false);
+    leader[0] = true;
+    for (size_t i = 0; i < length; ++i) {
+        const Effects e = effectsOf(program[i], target);
+        if (e.kind == Kind::Jump || e.kind == Kind::Branch) leader[program[i].dst] = true;
+        if (e.kind == Kind::Jump || e.kind == Kind::Branch || e.kind == Kind::Halt) leader[i + 1] = true;
+    }
+
+    std::vector<Block> blocks;
+    std::vector<size_t> block_of(length);
+    for (size_t i = 0; i < length; ++i) {
+        if (leader[i]) {
+            if (!blocks.empty()) blocks.back().end = i;
+            blocks.emplace_back();
+            blocks.back().begin = i;
+        }
+        block_of[i] = blocks.size() - 1;
+    }
+    if (!blocks.empty()) blocks.back().end = length;
+
+    for (Block& block : blocks) {
+        const size_t last = block.end - 1;
+        const Instruction& in = program[last];
+        const Effects e = effectsOf(in, target);
+        auto fallThrough = [&](int8_t zf) {
+            if (last + 1 < length) {
+                block.successors.emplace_back(block_of[last + 1], zf);
+            } else {
+                block.exits = true;
+            }
+        };
+        switch (e.kind) {
+            case Kind::Halt:
+                block.exits = true;
+                break;
+            case Kind::Jump:
+                block.successors.emplace_back(block_of[in.dst], -1);
+                break;
+            case Kind::Branch:
+                block.successors.emplace_back(block_of[in.dst], 1);
+                fallThrough(0);
+                break;
+            default:
+                fallThrough(-1);
+                break;
+        }
+    }
+    return blocks;
+}
+
+// ─── Constant and copy propagation ──────────────────────────────────────────
+
+/**
+ * @brief What is known about one register.
+ *
+ * Copy(r) means "equal to register r", where r is itself Unknown: every copy
+ * refers directly to the register that holds the original value.
+ */
+struct Value {
+    enum Kind : uint8_t { Unknown, Const, Copy } kind = Unknown;
+    uint32_t value = 0;  // the constant, or the register copied
+
+    bool operator==(const Value& other) const { return kind == other.kind && value == other.value; }
+    bool operator!=(const Value& other) const { return !(*this == other); }
+};
+
+/**
+ * @brief Abstract machine state at a program point.
+ */
+struct State {
+    bool reached = false;
+    int8_t zf = -1;  // 0, 1 or unknown
+    std::array<Value, kMaxRegisters> regs{};
+
+    /** @brief The value of register r, as a constant or as the register holding it. */
+    Value canonical(uint32_t r) const {
+        return regs[r].kind == Value::Unknown ? Value{Value::Copy, r} : regs[r];
+    }
+
+    /** @brief Checks whether register r is known to hold @p v (a canonical value). */
+    bool holds(uint32_t r, const Value& v) const { return canonical(r) == v; }
+
+    /**
+     * @brief Records that register r now holds @p v (canonical, or Unknown for a new value).
+     */
+    void define(uint32_t r, Value v) {
+        if (v.kind != Value::Unknown && holds(r, v)) return;
+        // Registers that copied r keep the old value; the first becomes their root
+        int root = -1;
+        for (uint32_t q = 0; q < kMaxRegisters; ++q) {
+            if (q == r || regs[q].kind != Value::Copy || regs[q].value != r) continue;
+            if (root < 0) {
+                root = static_cast<int>(q);
+                regs[q] = Value{};
+            } else {
+                regs[q] = Value{Value::Copy, static_cast<uint32_t>(root)};
+            }
+        }
+        regs[r] = v;
+    }
+
+    /**
+     * @brief Merges another predecessor's state into this one.
+     * @return True if this state changed.
+     */
+    bool join(const State& other) {
+        if (!other.reached) return false;
+        if (!reached) {
+            *this = other;
+            return true;
+        }
+        bool changed = false;
+        if (zf != other.zf && zf != -1) {
+            zf = -1;
+            changed = true;
+        }
+        for (uint32_t r = 0; r < kMaxRegisters; ++r) {
+            if (regs[r] != other.regs[r] && regs[r].kind != Value::Unknown) {
+                regs[r] = Value{};
+                changed = true;
+            }
+        }
+        return changed;
+    }
+
+    /** @brief Classifies the divisor of a DIV. */
+    Divisor divisor(const Instruction& in, const Target& target) const {
+        if (in.opcode != Opcode::DIV || in.src2 >= target.registers) return Divisor::Unknown;
+        const Value v = canonical(in.src2);
+        if (v.kind != Value::Const) return Divisor::Unknown;
+        return v.value ? Divisor::NonZero : Divisor::Zero;
+    }
+
+    /**
+     * @brief Computes the result of an arithmetic instruction with constant operands.
+     * @param result Receives the result.
+     * @return False unless both operands are constants (and a DIV divisor is non-zero).
+     */
+    bool constantResult(const Instruction& in, uint32_t& result) const {
+        const Value a = canonical(in.src1);
+        const Value b = canonical(in.src2);
+        if (a.kind != Value::Const || b.kind != Value::Const) return false;
+        switch (in.opcode) {
+            case Opcode::ADD: result = a.value + b.value; return true;
+            case Opcode::SUB: result = a.value - b.value; return true;
+            case Opcode::MUL: result = a.value * b.value; return true;
+            case Opcode::DIV:
+                if (!b.value) return false;
+                result = a.value / b.value;
+                return true;
+            default: return false;
+        }
+    }
+
+    /**
+     * @brief Applies one instruction.
+     */
+    void apply(const Instruction& in, const Target& target) {
+        const Effects e = effectsOf(in, target);
+        if (e.kind == Kind::Nop) return;
+        switch (in.opcode) {
+            case Opcode::LOAD:
+                define(in.dst, in.src2 == 2 ? Value{Value::Const, in.src1} : Value{});
+                break;
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::DIV: {
+                if (divisor(in, target) == Divisor::Zero) break;
+                uint32_t result;
+                define(in.dst, constantResult(in, result) ? Value{Value::Const, result} : Value{});
+                break;
+            }
+            case Opcode::CMP:
+                if (e.uses) {
+                    const Value a = canonical(in.src1);
+                    const Value b = canonical(in.src2);
+                    if (a == b) {
+                        zf = 1;
+                    } else if (a.kind == Value::Const && b.kind == Value::Const) {
+                        zf = 0;
+                    } else {
+                        zf = -1;
+                    }
+                } else {
+                    zf = 0;  // invalid CMP clears ZF
+                }
+                break;
+            case Opcode::MOV:
+                define(in.dst, canonical(in.src1));
+                break;
+            case Opcode::VREDUCE:
+            case Opcode::VSETVL:
+                define(in.dst, Value{});
+                break;
+            case Opcode::MEMCMP:
+                zf = -1;
+                break;
+            case Opcode::HOSTCALL:
+                for (uint32_t r = 0; r < target.registers; ++r) define(r, Value{});
+                zf = -1;
+                break;
+            case Opcode::CHECK_FLAG:
+                if (in.src1 == 0 && zf >= 0) {
+                    define(in.dst, Value{Value::Const, static_cast<uint32_t>(zf)});
+                } else if (in.src1 >= 5) {
+                    define(in.dst, Value{Value::Const, 0});
+                } else {
+                    define(in.dst, Value{});
+                }
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+/**
+ * @brief Computes the state at the entry of every block; unreached blocks stay !reached.
+ */
+std::vector<State> propagate(const std::vector<Instruction>& program, const std::vector<Block>& blocks,
+                             const Target& target) {
+    std::vector<State> entry(blocks.size());
+    if (blocks.empty()) return entry;
+    entry[0].reached = true;
+    std::vector<size_t> worklist{0};
+    std::vector<bool> queued(blocks.size(), false);
+    queued[0] = true;
+    while (!worklist.empty()) {
+        const size_t b = worklist.back();
+        worklist.pop_back();
+        queued[b] = false;
+        State state = entry[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) state.apply(program[i], target);
+        for (const auto& [successor, zf] : blocks[b].successors) {
+            State edge = state;
+            if (zf >= 0) edge.zf = zf;
+            if (entry[successor].join(edge) && !queued[successor]) {
+                queued[successor] = true;
+                worklist.push_back(successor);
+            }
+        }
+    }
+    return entry;
+}
+
+// ─── Passes ──────────────────────────────────────────────────────────────────
+
+/**
+ * @brief Removes instructions and remaps jump targets.
+ *
+ * A jump to a removed instruction goes to the next kept one; a jump past the
+ * last kept instruction targets a HALT appended at the end, which behaves like
+ * falling off the end of the program.
+ */
+std::vector<Instruction> compact(const std::vector<Instruction>& program, const std::vector<bool>& keep) {
+    std::vector<uint32_t> new_index(program.size() + 1);
+    uint32_t kept = 0;
+    for (size_t i = 0; i < program.size(); ++i) {
+        new_index[i] = kept;
+        kept += keep[i];
+    }
+    new_index[program.size()] = kept;
+
+    std::vector<Instruction> result;
+    result.reserve(kept + 1);
+    bool needs_halt = false;
+    for (size_t i = 0; i < program.size(); ++i) {
+        if (!keep[i]) continue;
+        Instruction in = program[i];
+        if (in.opcode == Opcode::JMP && in.dst < program.size()) {
+            in.dst = new_index[in.dst];
+            needs_halt |= in.dst == kept;
+        }
+        result.push_back(in);
+    }
+    if (needs_halt) result.push_back({Opcode::HALT, 0, 0, 0});
+    return result;
+}
+
+/**
+ * @brief Removes unreachable blocks and rewrites instructions using propagated constants and copies.
+ */
+std::vector<Instruction> propagatePass(const std::vector<Instruction>& program, const Target& target,
+                                       OptimizationReport& report) {
+    const std::vector<Block> blocks = buildCfg(program, target);
+    const std::vector<State> entry = propagate(program, blocks, target);
+    std::vector<Instruction> rewritten = program;
+    std::vector<bool> keep(program.size(), true);
+
+    auto propagateOperand = [&](const State& state, uint32_t& r) {
+        const Value v = state.canonical(r);
+        if (v.kind == Value::Copy && v.value != r) {
+            r = v.value;
+            ++report.copies_propagated;
+        }
+    };
+
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (!entry[b].reached) {
+            for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) keep[i] = false;
+            report.unreachable_removed += blocks[b].end - blocks[b].begin;
+            continue;
+        }
+        State state = entry[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            const Instruction& in = program[i];
+            Instruction& out = rewritten[i];
+            const Effects e = effectsOf(in, target);
+            if (e.kind == Kind::Branch && state.zf >= 0) {
+                if (state.zf) {
+                    out.src1 = 0;  // always taken
+                } else {
+                    keep[i] = false;  // never taken
+                }
+                ++report.branches_folded;
+            } else if (e.kind == Kind::Other) {
+                switch (in.opcode) {
+                    case Opcode::LOAD:
+                        if (in.src2 == 2 && state.holds(in.dst, Value{Value::Const, in.src1})) {
+                            keep[i] = false;
+                            ++report.constants_folded;
+                        } else if (in.src2 == 1) {
+                            propagateOperand(state, out.src1);
+                        }
+                        break;
+                    case Opcode::STORE:
+                        propagateOperand(state, out.src1);
+                        break;
+                    case Opcode::ADD:
+                    case Opcode::SUB:
+                    case Opcode::MUL:
+                    case Opcode::DIV:
+                    case Opcode::CMP:
+                        if (e.uses) {
+                            propagateOperand(state, out.src1);
+                            propagateOperand(state, out.src2);
+                        }
+                        break;
+                    case Opcode::MOV: {
+                        const Value v = state.canonical(in.src1);
+                        if (state.holds(in.dst, v)) {
+                            keep[i] = false;
+                            ++report.constants_folded;
+                        } else if (v.kind == Value::Const) {
+                            out = {Opcode::LOAD, in.dst, v.value, 2};
+                            ++report.constants_folded;
+                        } else {
+                            propagateOperand(state, out.src1);
+                        }
+                        break;
+                    }
+                    case Opcode::CHECK_FLAG:
+                        if (in.src1 == 0 && state.zf >= 0) {
+                            out = {Opcode::LOAD, in.dst, static_cast<uint32_t>(state.zf), 2};
+                            ++report.constants_folded;
+                        } else if (in.src1 >= 5) {
+                            out = {Opcode::LOAD, in.dst, 0, 2};
+                            ++report.constants_folded;
+                        }
+                        break;
+                    default:
+                        break;
+                }
+            }
+            state.apply(in, target);
+        }
+    }
+    return compact(rewritten, keep);
+}
+
+/**
+ * @brief Removes dead register, flag and memory writes and no-ops; folds arithmetic whose flags are dead.
+ */
+std::vector<Instruction> deadCodePass(const std::vector<Instruction>& program, const Target& target,
+                                      OptimizationReport& report) {
+    const std::vector<Block> blocks = buildCfg(program, target);
+    const std::vector<State> entry = propagate(program, blocks, target);
+
+    // Per-instruction states, for DIV divisors and constant results
+    std::vector<State> before(program.size());
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        State state = entry[b];
+        for (size_t i = blocks[b].begin; i < blocks[b].end; ++i) {
+            before[i] = state;
+            state.apply(program[i], target);
+        }
+    }
+    auto effects = [&](size_t i) { return effectsOf(program[i], target, before[i].divisor(program[i], target)); };
+
+    // Backward liveness of registers and flags at block exits
+    auto transfer = [&](size_t i, uint64_t live) {
+        const Effects e = effects(i);
+        return (live & ~e.defs) | e.uses | (e.may_exit ? kExitLive : 0);
+    };
+    std::vector<uint64_t> live_out(blocks.size(), 0);
+    for (bool changed = true; changed;) {
+        changed = false;
+        for (size_t b = blocks.size(); b-- > 0;) {
+            uint64_t out = blocks[b].exits ? kExitLive : 0;
+            for (const auto& edge : blocks[b].successors) {
+                const size_t successor = edge.first;
+                uint64_t live = live_out[successor];
+                for (size_t i = blocks[successor].end; i-- > blocks[successor].begin;) live = transfer(i, live);
+                out |= live;
+            }
+            if (out != live_out[b]) {
+                live_out[b] = out;
+                changed = true;
+            }
+        }
+    }
+
+    std::vector<Instruction> rewritten = program;
+    std::vector<bool> keep(program.size(), true);
+    for (size_t b = 0; b < blocks.size(); ++b) {
+        if (!entry[b].reached) continue;
+        uint64_t live = live_out[b];
+        std::vector<uint32_t> overwritten;  // addresses stored later in the block before being read
+        for (size_t i = blocks[b].end; i-- > blocks[b].begin;) {
+            const Instruction& in = program[i];
+            Effects e = effects(i);
+            if (e.kind == Kind::Nop || (e.kind == Kind::Other && !e.side_effect && !(e.may_defs & live))) {
+                keep[i] = false;
+                ++report.dead_removed;
+                continue;
+            }
+            uint32_t result;
+            if ((in.opcode == Opcode::ADD || in.opcode == Opcode::SUB || in.opcode == Opcode::MUL ||
+                 in.opcode == Opcode::DIV) &&
+                !(e.may_defs & kAllFlags & live) && before[i].constantResult(in, result)) {
+                rewritten[i] = {Opcode::LOAD, in.dst, result, 2};
+                e = effectsOf(rewritten[i], target);
+                ++report.constants_folded;
+            }
+            if (in.opcode == Opcode::STORE) {
+                if (std::find(overwritten.begin(), overwritten.end(), in.dst) != overwritten.end()) {
+                    keep[i] = false;
+                    ++report.dead_removed;
+                    continue;
+                }
+                overwritten.push_back(in.dst);
+            } else if (in.opcode == Opcode::LOAD && in.src2 == 0) {
+                overwritten.erase(std::remove(overwritten.begin(), overwritten.end(), in.src1), overwritten.end());
+            } else if (e.may_exit || e.kind == Kind::Halt) {
+                overwritten.clear();
+            }
+            live = (live & ~e.defs) | e.uses | (e.may_exit ? kExitLive : 0);
+        }
+    }
+    return compact(rewritten, keep);
+}
+
+/**
+ * @brief Retargets jumps that land on unconditional jumps and removes jumps to the next instruction.
+ */
+std::vector<Instruction> jumpPass(const std::vector<Instruction>& program, const Target& target,
+                                  OptimizationReport& report) {
+    std::vector<Instruction> rewritten = program;
+    std::vector<bool> keep(program.size(), true);
+    for (size_t i = 0; i < program.size(); ++i) {
+        const Kind kind = effectsOf(program[i], target).kind;
+        if (kind != Kind::Jump && kind != Kind::Branch) continue;
+        uint32_t destination = program[i].dst;
+        for (size_t hops = 0; hops < program.size(); ++hops) {
+            const Instruction& next = program[destination];
+            if (effectsOf(next, target).kind != Kind::Jump || next.dst == destination) break;
+            destination = next.dst;
+        }
+        if (destination != program[i].dst) {
+            rewritten[i].dst = destination;
+            ++report.jumps_threaded;
+        }
+        if (destination == i + 1) {
+            keep[i] = false;
+            ++report.jumps_threaded;
+        }
+    }
+    return compact(rewritten, keep);
+}
+
+}  // namespace
+
+/**
+ * @brief Formats the report.
+ *
+ * @return Instruction counts before and after, then the count of each rewrite.
+ */
+std::string OptimizationReport::toString() const {
+    std::ostringstream out;
+    out << instructions_before << " -> " << instructions_after << " instructions (unreachable "
+        << unreachable_removed << ", dead " << dead_removed << ", constants " << constants_folded << ", copies "
+        << copies_propagated << ", branches " << branches_folded << ", jumps " << jumps_threaded << ')';
+    return out.str();
+}
+
+/**
+ * @brief Runs all passes until the program stops changing.
+ *
+ * @param program The program.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The optimized program and report.
+ */
+OptimizedProgram optimizeProgram(const std::vector<Instruction>& program, size_t register_count, size_t data_size) {
+    OptimizedProgram result;
+    result.program = program;
+    result.report.instructions_before = program.size();
+    const bool shared_memory = std::any_of(program.begin(), program.end(), [](const Instruction& in) {
+        return in.opcode >= Opcode::ATOMIC_ADD && in.opcode <= Opcode::HART_ID;
+    });
+    if (register_count <= kMaxRegisters && !program.empty() && !shared_memory) {
+        Target target{register_count, data_size, 0};
+        // Each pass strictly removes or simplifies, so this converges; the bound is a safety net
+        for (int round = 0; round < 64; ++round) {
+            std::vector<Instruction> before = result.program;
+            for (auto pass : {propagatePass, deadCodePass, jumpPass}) {
+                target.length = result.program.size();
+                if (result.program.empty()) break;
+                result.program = pass(result.program, target, result.report);
+            }
+            const bool unchanged = result.program.size() == before.size() &&
+                std::equal(before.begin(), before.end(), result.program.begin(), [](const Instruction& a, const Instruction& b) {
+                    return a.opcode == b.opcode && a.dst == b.dst && a.src1 == b.src1 && a.src2 == b.src2;
+                });
+            if (unchanged) break;
+        }
+    }
+    result.report.instructions_after = result.program.size();
+    return result;
+}
@@ -0,0 +1,81 @@
+/**
+ * @file optimizer.hpp
+ * @brief Declares the guest program optimizer.
+ *
+ * optimizeProgram() rewrites a program into an equivalent one that executes
+ * fewer instructions. It builds the control-flow graph from the JMP targets
+ * and repeats, until nothing changes:
+ *
+ * - constant and copy propagation over the graph (register values, register
+ *   copies and ZF, refined along the taken and fall-through edges of every
+ *   conditional jump), folding known branches, flag reads and arithmetic and
+ *   dropping loads and moves of values a register already holds;
+ * - liveness of registers and flags, removing writes nothing reads, stores
+ *   overwritten before any load, and instructions that have no effect;
+ * - removal of unreachable code and jump threading;
+ * - compaction, remapping every jump target.
+ *
+ * Equivalence: started at pc 0 with any registers, flags and data memory, the
+ * optimized program halts (or faults) exactly when the original does and leaves
+ * the same data memory and status flags. Register contents at exit are not
+ * preserved; they are not observable outside the machine.
+ *
+ * Programs that use the shared-memory opcodes (ATOMIC_ADD, CAS, FENCE,
+ * HART_ID) are returned unchanged: other harts may read or write memory
+ * between any two of their instructions. Vector registers are not tracked:
+ * vector instructions are kept, and only their scalar operands take part.
+ * Bulk memory instructions are kept too; their register operands take part.
+ * HOSTCALL is kept and treated as reading and possibly writing every
+ * register, flag and memory word.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * @struct OptimizationReport
+ * @brief What optimizeProgram() changed.
+ */
+struct OptimizationReport {
+    size_t instructions_before = 0;  /**< Static size of the input program */
+    size_t instructions_after = 0;   /**< Static size of the optimized program */
+    size_t unreachable_removed = 0;  /**< Instructions no path from the entry reaches */
+    size_t dead_removed = 0;         /**< Writes nothing reads, overwritten stores and no-op instructions */
+    size_t constants_folded = 0;     /**< Computations and flag reads replaced by immediates, redundant loads and moves */
+    size_t copies_propagated = 0;    /**< Register operands replaced by the register they were copied from */
+    size_t branches_folded = 0;      /**< Conditional jumps whose outcome was known */
+    size_t jumps_threaded = 0;       /**< Jumps retargeted past other jumps, or removed as jumps to the next instruction */
+
+    /**
+     * @brief Formats the report.
+     * @return e.g. "24 -> 19 instructions (unreachable 2, dead 1, ...)".
+     */
+    std::string toString() const;
+};
+
+/**
+ * @struct OptimizedProgram
+ * @brief Result of optimizeProgram().
+ */
+struct OptimizedProgram {
+    std::vector<Instruction> program;  /**< The optimized program */
+    OptimizationReport report;         /**< Instruction counts and applied rewrites */
+};
+
+/**
+ * @brief Optimizes a program for a machine of the given dimensions.
+ *
+ * Operand validity (and therefore which instructions are no-ops) depends on the
+ * machine, as for verifyProgram(); the result is only equivalent on a machine
+ * with the same register count and data memory size.
+ *
+ * @param program The program.
+ * @param register_count Number of data registers of the target machine (at most 32).
+ * @param data_size Size of the data memory of the target machine.
+ * @return The optimized program and what was changed.
+ */
+OptimizedProgram optimizeProgram(const std::vector<Instruction>& program, size_t register_count, size_t data_size);
@@ -0,0 +1,214 @@
+/**
+ * @file program_file.cpp
+ * @brief Implementation of the binary program file reader and writer.
+ */
+
+#include "program_file.hpp"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief Stores an error description if the caller asked for one.
+ *
+ * @param error Destination supplied by the caller (may be null).
+ * @param message The description.
+ */
+static void setError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+/**
+ * @brief Checks whether the host stores integers little-endian like the file format.
+ *
+ * @return True on little-endian hosts.
+ */
+static bool hostIsLittleEndian() {
+    const uint32_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+/**
+ * @brief Computes a word-wise FNV-1a hash.
+ *
+ * @param words Pointer to the payload.
+ * @param count Number of 32-bit words.
+ * @param seed Initial hash value.
+ * @return The hash.
+ */
+uint32_t programFileChecksum(const uint32_t* words, size_t count, uint32_t seed) {
+    uint32_t hash = seed;
+    for (size_t i = 0; i < count; ++i) {
+        hash ^= words[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Maps a program file read-only and validates its header and checksum.
+ *
+ * @param path Path of the file to open.
+ * @param error Receives a description of the problem if loading fails (optional).
+ * @param verify_checksum Recompute and compare the payload checksum.
+ * @return The mapped program, or nullptr on failure.
+ */
+std::shared_ptr<const MappedProgram> MappedProgram::open(const std::string& path, std::string* error,
+                                                         bool verify_checksum) {
+    if (!hostIsLittleEndian()) {
+        setError(error, "program files are only supported on little-endian hosts");
+        return nullptr;
+    }
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        setError(error, "cannot open " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        setError(error, "cannot stat " + path + ": " + std::strerror(errno));
+        ::close(fd);
+        return nullptr;
+    }
+    const size_t file_size = static_cast<size_t>(info.st_size);
+    if (file_size < sizeof(ProgramFileHeader)) {
+        setError(error, path + ": file too small for a program header");
+        ::close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);  // the mapping keeps the file referenced
+    if (mapping == MAP_FAILED) {
+        setError(error, "cannot map " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+
+    std::shared_ptr<MappedProgram> program(new MappedProgram());
+    program->mapping = mapping;
+    program->mapping_size = file_size;
+
+    ProgramFileHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (header.magic != kProgramFileMagic) {
+        setError(error, path + ": not a program file (bad magic)");
+        return nullptr;
+    }
+    if (header.version != kProgramFileVersion) {
+        setError(error, path + ": unsupported program file version " + std::to_string(header.version));
+        return nullptr;
+    }
+    if (header.header_size != sizeof(ProgramFileHeader) || header.reserved[0] != 0 || header.reserved[1] != 0) {
+        setError(error, path + ": malformed program header");
+        return nullptr;
+    }
+    const uint64_t payload_size = static_cast<uint64_t>(header.instruction_count) * sizeof(Instruction) +
+                                  static_cast<uint64_t>(header.data_count) * sizeof(uint32_t);
+    if (payload_size != file_size - sizeof(ProgramFileHeader)) {
+        setError(error, path + ": file size does not match the header (truncated or corrupt)");
+        return nullptr;
+    }
+
+    const uint8_t* payload = static_cast<const uint8_t*>(mapping) + sizeof(ProgramFileHeader);
+    if (verify_checksum) {
+        const uint32_t checksum = programFileChecksum(reinterpret_cast<const uint32_t*>(payload),
+                                                      payload_size / sizeof(uint32_t));
+        if (checksum != header.checksum) {
+            setError(error, path + ": checksum mismatch");
+            return nullptr;
+        }
+    }
+
+    program->code = reinterpret_cast<const Instruction*>(payload);
+    program->code_count = header.instruction_count;
+    program->data_base = header.data_base;
+    program->data_count = header.data_count;
+    if (header.data_count != 0) {
+        program->data_words = reinterpret_cast<const uint32_t*>(payload + header.instruction_count * sizeof(Instruction));
+    }
+    return program;
+}
+
+/**
+ * @brief Unmaps the program file.
+ */
+MappedProgram::~MappedProgram() {
+    if (mapping) munmap(mapping, mapping_size);
+}
+
+/**
+ * @brief Copies the mapped instructions into a vector.
+ *
+ * @return The program as a vector of instructions.
+ */
+std::vector<Instruction> MappedProgram::toVector() const {
+    return std::vector<Instruction>(code, code + code_count);
+}
+
+/**
+ * @brief Writes a program file.
+ *
+ * The header is followed by the instruction records exactly as they are laid
+ * out in memory and by the data image words. The file is written under a
+ * temporary name next to @p path and renamed over it, so existing mappings of
+ * the old file keep their contents.
+ *
+ * @param path Path of the file to create or overwrite.
+ * @param program The instructions to store.
+ * @param image Initial data memory contents (may be empty).
+ * @param error Receives a description of the problem if writing fails (optional).
+ * @return True on success.
+ */
+bool writeProgramFile(const std::string& path, const std::vector<Instruction>& program,
+                      const DataImage& image, std::string* error) {
+    if (!hostIsLittleEndian()) {
+        setError(error, "program files are only supported on little-endian hosts");
+        return false;
+    }
+    if (program.size() > UINT32_MAX || image.words.size() > UINT32_MAX) {
+        setError(error, "program or data image too large for the program file format");
+        return false;
+    }
+
+    ProgramFileHeader header;
+    header.instruction_count = static_cast<uint32_t>(program.size());
+    header.data_base = image.base;
+    header.data_count = static_cast<uint32_t>(image.words.size());
+    header.checksum = programFileChecksum(reinterpret_cast<const uint32_t*>(program.data()),
+                                          program.size() * sizeof(Instruction) / sizeof(uint32_t));
+    header.checksum = programFileChecksum(image.words.data(), image.words.size(), header.checksum);
+
+    // Never rewrite the target in place: a MappedProgram of it may be executing
+    static std::atomic<uint64_t> temporary_files{0};
+    const std::string temporary = path + ".tmp-" + std::to_string(getpid()) + "-" + std::to_string(temporary_files++);
+    std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        setError(error, "cannot create " + temporary);
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(program.data()),
+              static_cast<std::streamsize>(program.size() * sizeof(Instruction)));
+    out.write(reinterpret_cast<const char*>(image.words.data()),
+              static_cast<std::streamsize>(image.words.size() * sizeof(uint32_t)));
+    out.close();
+    if (!out) {
+        std::remove(temporary.c_str());
+        setError(error, "error while writing " + temporary);
+        return false;
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        setError(error, "cannot replace " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    return true;
+}
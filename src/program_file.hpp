@@ -0,0 +1,164 @@
+/**
+ * @file program_file.hpp
+ * @brief Declares the binary program file format and its memory-mapped loader.
+ *
+ * A program file stores a program in exactly the in-memory layout of
+ * Instruction, so a mapped file can be executed without copying:
+ *
+ * | Offset | Size        | Content                                          |
+ * |--------|-------------|--------------------------------------------------|
+ * | 0      | 32          | ProgramFileHeader                                |
+ * | 32     | 16 * count  | Instructions (opcode, dst, src1, src2; u32 each) |
+ * | ...    | 4 * words   | Optional initial data-memory image               |
+ *
+ * All fields are little-endian. The checksum covers everything after the header.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief File magic, "RISC" when read as bytes. */
+constexpr uint32_t kProgramFileMagic = 0x43534952;
+
+/** @brief Current version of the program file format. */
+constexpr uint16_t kProgramFileVersion = 1;
+
+/**
+ * @struct ProgramFileHeader
+ * @brief Fixed-size header at the start of every program file.
+ */
+struct ProgramFileHeader {
+    uint32_t magic = kProgramFileMagic;      /**< Must equal kProgramFileMagic */
+    uint16_t version = kProgramFileVersion;  /**< Format version */
+    uint16_t header_size = 32;               /**< Size of this header in bytes */
+    uint32_t instruction_count = 0;          /**< Number of instructions */
+    uint32_t data_base = 0;                  /**< Data memory address of the first image word */
+    uint32_t data_count = 0;                 /**< Number of words in the data image */
+    uint32_t checksum = 0;                   /**< programFileChecksum() of the payload */
+    uint32_t reserved[2] = {0, 0};           /**< Must be zero */
+};
+
+static_assert(sizeof(ProgramFileHeader) == 32, "program file header layout");
+static_assert(sizeof(Instruction) == 16 && alignof(Instruction) == 4,
+              "program files store Instruction records verbatim");
+
+/**
+ * @struct DataImage
+ * @brief Initial contents of a contiguous range of data memory.
+ */
+struct DataImage {
+    uint32_t base = 0;             /**< Address of the first word */
+    std::vector<uint32_t> words;   /**< Values written from @c base onwards */
+};
+
+/**
+ * @class MappedProgram
+ * @brief A validated program file mapped read-only into memory.
+ *
+ * The instruction and data pointers refer directly to the mapped pages, which
+ * stay valid for the lifetime of the object. Machines that load a
+ * MappedProgram hold a shared reference to it.
+ *
+ * A mapped file must not be changed in place: writes to it show through the
+ * mapping, and a truncated file faults on access. Replace it instead, as
+ * writeProgramFile() does, so the mapping keeps the old contents.
+ */
+class MappedProgram {
+public:
+    /**
+     * @brief Maps and validates a program file.
+     *
+     * @param path Path of the file to open.
+     * @param error Receives a description of the problem if loading fails (optional).
+     * @param verify_checksum Recompute and compare the payload checksum.
+     * @return The mapped program, or nullptr if the file is missing or malformed.
+     */
+    static std::shared_ptr<const MappedProgram> open(const std::string& path,
+                                                     std::string* error = nullptr,
+                                                     bool verify_checksum = true);
+
+    ~MappedProgram();
+
+    MappedProgram(const MappedProgram&) = delete;
+    MappedProgram& operator=(const MappedProgram&) = delete;
+
+    /**
+     * @brief Gets the first instruction of the program.
+     * @return Pointer into the mapped file.
+     */
+    const Instruction* instructions() const { return code; }
+
+    /**
+     * @brief Gets the number of instructions.
+     * @return The instruction count from the header.
+     */
+    size_t instructionCount() const { return code_count; }
+
+    /**
+     * @brief Gets the data memory address of the first data image word.
+     * @return The image base address.
+     */
+    uint32_t dataBase() const { return data_base; }
+
+    /**
+     * @brief Gets the first word of the data image.
+     * @return Pointer into the mapped file (nullptr if the image is empty).
+     */
+    const uint32_t* data() const { return data_words; }
+
+    /**
+     * @brief Gets the number of words in the data image.
+     * @return The image length.
+     */
+    size_t dataCount() const { return data_count; }
+
+    /**
+     * @brief Copies the instructions into a vector.
+     * @return The program as a vector of instructions.
+     */
+    std::vector<Instruction> toVector() const;
+
+private:
+    MappedProgram() = default;
+
+    void* mapping = nullptr;
+    size_t mapping_size = 0;
+    const Instruction* code = nullptr;
+    size_t code_count = 0;
+    uint32_t data_base = 0;
+    const uint32_t* data_words = nullptr;
+    size_t data_count = 0;
+};
+
+/**
+ * @brief Computes the checksum stored in a program file header.
+ *
+ * A word-wise FNV-1a hash over the instruction records followed by the data image.
+ *
+ * @param words Pointer to the payload.
+ * @param count Number of 32-bit words in the payload.
+ * @param seed Result of the previous call when hashing a payload in pieces.
+ * @return The 32-bit checksum.
+ */
+uint32_t programFileChecksum(const uint32_t* words, size_t count, uint32_t seed = 2166136261u);
+
+/**
+ * @brief Serialises a program and an optional data image to a program file.
+ *
+ * Writes a temporary file in the same directory and renames it over @p path,
+ * so a MappedProgram of the previous file is never modified.
+ *
+ * @param path Path of the file to create or overwrite.
+ * @param program The instructions to store.
+ * @param image Initial data memory contents (may be empty).
+ * @param error Receives a description of the problem if writing fails (optional).
+ * @return True on success.
+ */
+bool writeProgramFile(const std::string& path, const std::vector<Instruction>& program,
+                      const DataImage& image = {}, std::string* error = nullptr);
@@ -0,0 +1,185 @@
+/**
+ * @file reduction.cpp
+ * @brief Implementation of reduction-loop recognition and bulk execution.
+ */
+
+#include "reduction.hpp"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Matches the loop described in reduction.hpp at one program counter.
+ *
+ * @param program The program.
+ * @param count Number of instructions.
+ * @param head Candidate loop head.
+ * @param register_count Number of data registers of the target machine.
+ * @param loop Receives the roles of the registers.
+ * @return True if the instructions from @p head form a reduction loop.
+ */
+bool matchLoop(const Instruction* program, size_t count, size_t head, size_t register_count, ReductionLoop& loop) {
+    auto at = [&](size_t i, Opcode opcode) { return i < count && program[i].opcode == opcode; };
+    // Binary operation of `self` with `other` in either operand order; returns the other operand
+    auto operand = [](const Instruction& in, uint32_t self, uint32_t& other) {
+        if (in.src1 == self) {
+            other = in.src2;
+            return true;
+        }
+        if (in.src2 == self) {
+            other = in.src1;
+            return true;
+        }
+        return false;
+    };
+
+    size_t i = head;
+    if (!at(i, Opcode::LOAD) || program[i].src2 != 1) return false;
+    loop.value = program[i].dst;
+    loop.pointer = program[i].src1;
+
+    if (!at(++i, Opcode::ADD)) return false;
+    const Instruction& add = program[i];
+    uint32_t added;
+    if (!operand(add, add.dst, added) || added != loop.value) return false;
+    loop.sum = add.dst;
+
+    bool one_known = false;
+    loop.carry_exit = at(++i, Opcode::CHECK_FLAG) && program[i].src1 == 1;
+    if (loop.carry_exit) {
+        loop.flag = program[i].dst;
+        if (!at(++i, Opcode::CMP) || !operand(program[i], loop.flag, loop.one)) return false;
+        one_known = true;
+        if (!at(++i, Opcode::JMP) || program[i].src1 != 1 || program[i].dst >= count) return false;
+        ++i;
+    }
+
+    uint32_t step;
+    if (!at(i, Opcode::ADD) || program[i].dst != loop.pointer || !operand(program[i], loop.pointer, step)) return false;
+    if (one_known && step != loop.one) return false;
+    loop.one = step;
+
+    if (!at(++i, Opcode::CMP) || !operand(program[i], loop.one, loop.counter)) return false;
+    if (!at(++i, Opcode::JMP) || program[i].src1 != 1 || program[i].dst >= count) return false;
+    if (!at(++i, Opcode::SUB)) return false;
+    const Instruction& sub = program[i];
+    if (sub.dst != loop.counter || sub.src1 != loop.counter || sub.src2 != loop.one) {
+        return false;
+    }
+    if (!at(++i, Opcode::JMP) || program[i].src1 != 0 || program[i].dst != head) return false;
+    loop.head = static_cast<uint32_t>(head);
+    loop.length = static_cast<uint32_t>(i + 1 - head);
+
+    // Every role needs its own valid register
+    std::vector<uint32_t> roles = {loop.pointer, loop.counter, loop.sum, loop.value, loop.one};
+    if (loop.carry_exit) roles.push_back(loop.flag);
+    std::sort(roles.begin(), roles.end());
+    return roles.back() < register_count && std::adjacent_find(roles.begin(), roles.end()) == roles.end();
+}
+
+/**
+ * @brief Sums words into a 64-bit total.
+ *
+ * Written as a plain widening loop so the compiler vectorises it
+ * (zero-extend to 64-bit lanes and add).
+ */
+uint64_t sumWords(const uint32_t* words, size_t count) {
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; ++i) total += words[i];
+    return total;
+}
+
+}  // namespace
+
+/**
+ * @brief Scans a program for reduction loops.
+ *
+ * @param program Pointer to the first instruction.
+ * @param count Number of instructions.
+ * @param register_count Number of data registers of the target machine.
+ * @return The loops found, ordered by head.
+ */
+std::vector<ReductionLoop> findReductionLoops(const Instruction* program, size_t count, size_t register_count) {
+    std::vector<ReductionLoop> loops;
+    for (size_t head = 0; head < count; ++head) {
+        ReductionLoop loop;
+        if (matchLoop(program, count, head, register_count, loop)) loops.push_back(loop);
+    }
+    return loops;
+}
+
+/**
+ * @brief Turns the head LOAD of every loop into a REDUCE record.
+ *
+ * @param decoded The decoded program.
+ * @param loops The loops found in the same program.
+ */
+void markReductionLoops(std::vector<DecodedInstruction>& decoded, const std::vector<ReductionLoop>& loops) {
+    for (size_t index = 0; index < loops.size(); ++index) {
+        const ReductionLoop& loop = loops[index];
+        decoded[loop.head] = {loop.value, loop.pointer, static_cast<uint32_t>(index), loop.one, DecodedOp::REDUCE};
+    }
+}
+
+/**
+ * @brief Runs the clean iterations of a loop as one sum over data memory.
+ *
+ * The number of clean iterations is bounded by the counter (iteration k leaves
+ * when the counter is 1), by the end of data memory (the load faults) and, with
+ * the carry exit, by the first element whose addition carries. Elements are
+ * non-negative, so the running sum is monotonic: whole pages are summed and
+ * only the page in which the sum first exceeds 32 bits is scanned element by
+ * element.
+ *
+ * @param loop The loop.
+ * @param regs Guest registers.
+ * @param flags Guest flags.
+ * @param memory Guest data memory.
+ * @param max_iterations Upper bound on the iterations to execute.
+ * @return The number of iterations executed.
+ */
+uint64_t runReductionLoop(const ReductionLoop& loop, uint32_t* regs, LazyFlags& flags, const DataMemory& memory,
+                          uint64_t max_iterations) {
+    if (regs[loop.one] != 1) return 0;
+    const uint32_t pointer = regs[loop.pointer];
+    const uint32_t counter = regs[loop.counter];
+    const uint32_t sum = regs[loop.sum];
+
+    const uint64_t addressable = std::min<uint64_t>(memory.size(), uint64_t(1) << 32);
+    const uint64_t limit = std::min({static_cast<uint64_t>(static_cast<uint32_t>(counter - 1)),
+                                     pointer < addressable ? addressable - pointer : 0, max_iterations});
+    // Largest total that can be added without a carry; without the exit the sum simply wraps
+    const uint64_t headroom = loop.carry_exit ? UINT32_MAX - sum : UINT64_MAX;
+
+    uint64_t done = 0;
+    uint64_t total = 0;
+    while (done < limit) {
+        const uint32_t address = static_cast<uint32_t>(pointer + done);
+        const uint32_t offset = address & DataMemory::kPageMask;
+        const uint64_t run = std::min<uint64_t>(limit - done, DataMemory::kPageWords - offset);
+        const uint32_t* words = memory.readPage(address) + offset;
+        const uint64_t chunk = sumWords(words, static_cast<size_t>(run));
+        if (total + chunk <= headroom) {
+            total += chunk;
+            done += run;
+            continue;
+        }
+        // The sum carries within this run: keep the elements before that one
+        for (size_t i = 0; total + words[i] <= headroom; ++i) {
+            total += words[i];
+            ++done;
+        }
+        break;
+    }
+    if (!done) return 0;
+
+    // State at the head after the last clean iteration: its CMP cleared ZF and its SUB set CF/NF
+    regs[loop.pointer] = static_cast<uint32_t>(pointer + done);
+    regs[loop.counter] = static_cast<uint32_t>(counter - done);
+    regs[loop.sum] = static_cast<uint32_t>(sum + total);
+    regs[loop.value] = memory.read(static_cast<uint32_t>(pointer + done - 1));
+    if (loop.carry_exit) regs[loop.flag] = 0;
+    flags.setZero(false);
+    flags.setSub(static_cast<uint32_t>(counter - done + 1), 1);
+    return done;
+}
@@ -0,0 +1,89 @@
+/**
+ * @file reduction.hpp
+ * @brief Declares recognition and bulk execution of array-sum loops.
+ *
+ * A reduction loop is the counted loop createSumListProgram() emits, with any
+ * register assignment and with or without the carry early exit:
+ *
+ *     head: LOAD     value, [pointer]       ; indirect
+ *           ADD      sum, sum, value
+ *         ( CHECK_FLAG flag, 1              ; CF
+ *           CMP      flag, one
+ *           JMP      carry_exit, 1 )        ; optional
+ *           ADD      pointer, pointer, one
+ *           CMP      counter, one
+ *           JMP      done, 1
+ *           SUB      counter, counter, one
+ *           JMP      head, 0
+ *
+ * When control reaches the head with R[one] == 1, runReductionLoop() executes
+ * every following iteration that ends back at the head ("clean" iterations:
+ * the load is in range, the add does not carry when the carry exit is present,
+ * and the counter does not reach 1) as one widened sum over the pages of data
+ * memory. It leaves registers and flags exactly as step-by-step execution would
+ * at the head; the engine then executes the last, exiting iteration normally,
+ * so the carry exit, the counter exit and a faulting load behave as before.
+ */
+
+#pragma once
+
+#include "data_memory.hpp"
+#include "decoder.hpp"
+#include "flags.hpp"
+#include "instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct ReductionLoop
+ * @brief One recognised reduction loop and the registers in each role.
+ */
+struct ReductionLoop {
+    uint32_t head = 0;       /**< Program counter of the indirect LOAD */
+    uint32_t length = 0;     /**< Instructions per iteration */
+    uint32_t pointer = 0;    /**< Register holding the address of the next element */
+    uint32_t counter = 0;    /**< Register counting down the remaining elements */
+    uint32_t sum = 0;        /**< Accumulator register */
+    uint32_t value = 0;      /**< Register receiving each element */
+    uint32_t one = 0;        /**< Register that must hold 1 */
+    uint32_t flag = 0;       /**< Register receiving CF (carry exit only) */
+    bool carry_exit = false; /**< Whether the loop leaves when the sum carries */
+};
+
+/**
+ * @brief Finds the reduction loops of a program.
+ *
+ * @param program Pointer to the first instruction.
+ * @param count Number of instructions.
+ * @param register_count Number of data registers of the target machine.
+ * @return The loops found, ordered by head.
+ */
+std::vector<ReductionLoop> findReductionLoops(const Instruction* program, size_t count, size_t register_count);
+
+/**
+ * @brief Replaces the head of every loop in a decoded program by a REDUCE record.
+ *
+ * REDUCE carries the operands of the LOAD it replaces and the loop's index in
+ * @p loops; the records of the loop body are unchanged.
+ *
+ * @param decoded A program produced by decodeProgram(), modified in place.
+ * @param loops The loops of the same program.
+ */
+void markReductionLoops(std::vector<DecodedInstruction>& decoded, const std::vector<ReductionLoop>& loops);
+
+/**
+ * @brief Executes the clean iterations of a loop whose head is about to execute.
+ *
+ * Does nothing unless R[one] == 1. Otherwise registers and flags are advanced
+ * to the state at the head after the last clean iteration.
+ *
+ * @param loop The loop.
+ * @param regs Guest registers.
+ * @param flags Guest flags.
+ * @param memory Guest data memory (only read).
+ * @param max_iterations Upper bound on the iterations to execute.
+ * @return The number of iterations executed.
+ */
+uint64_t runReductionLoop(const ReductionLoop& loop, uint32_t* regs, LazyFlags& flags, const DataMemory& memory,
+                          uint64_t max_iterations = UINT64_MAX);
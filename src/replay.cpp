@@ -0,0 +1,307 @@
+/**
+ * @file replay.cpp
+ * @brief Implementation of deterministic replay.
+ */
+
+#include "replay.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+/**
+ * @class LogReader
+ * @brief Sequential reader of a replay log.
+ */
+class LogReader {
+public:
+    explicit LogReader(std::FILE* file) : file(file) {}
+
+    /**
+     * @brief Reads one byte.
+     * @param byte Receives the byte.
+     * @return False at the end of the file.
+     */
+    bool byte(uint8_t& byte) {
+        const int c = std::getc(file);
+        if (c == EOF) return false;
+        byte = static_cast<uint8_t>(c);
+        return true;
+    }
+
+    /**
+     * @brief Reads an unsigned LEB128 varint.
+     * @param value Receives the value.
+     * @return False if the file ends inside the varint or it is too long.
+     */
+    bool varint(uint64_t& value) {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t next;
+            if (!byte(next)) return false;
+            value |= uint64_t(next & 0x7f) << shift;
+            if (!(next & 0x80)) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Reads a varint that must fit in 32 bits.
+     * @param value Receives the value.
+     * @return False on a truncated or oversized value.
+     */
+    bool word(uint32_t& value) {
+        uint64_t wide;
+        if (!varint(wide) || wide > UINT32_MAX) return false;
+        value = static_cast<uint32_t>(wide);
+        return true;
+    }
+
+    /**
+     * @brief Reads a little-endian integer of @p bytes bytes.
+     * @param bytes Width of the field.
+     * @param value Receives the value.
+     * @return False at the end of the file.
+     */
+    bool fixed(int bytes, uint64_t& value) {
+        value = 0;
+        for (int i = 0; i < bytes; ++i) {
+            uint8_t next;
+            if (!byte(next)) return false;
+            value |= uint64_t(next) << (8 * i);
+        }
+        return true;
+    }
+
+private:
+    std::FILE* file;
+};
+
+}  // namespace
+
+/**
+ * @class ReplayPlayer
+ * @brief Applies replay log events to a machine; befriended by RiscMachine.
+ */
+class ReplayPlayer {
+public:
+    static ReplayResult play(const std::string& path, const std::vector<std::vector<Instruction>>& programs,
+                             const ReplayOptions& options);
+
+private:
+    static bool loadImage(LogReader& log, RiscMachine& machine);
+};
+
+/**
+ * @brief Reads an IMAGE event and makes it the machine's state.
+ *
+ * @param log Reader positioned after the event tag.
+ * @param machine The replaying machine.
+ * @return False if the event is truncated or addresses memory outside the machine.
+ */
+bool ReplayPlayer::loadImage(LogReader& log, RiscMachine& machine) {
+    uint32_t flags;
+    if (!log.word(machine.pc)) return false;
+    for (uint32_t& value : machine.data_registers) {
+        if (!log.word(value)) return false;
+    }
+    if (!log.word(flags)) return false;
+    StatusRegister status{};
+    status.ZF = flags & 1;
+    status.CF = (flags >> 1) & 1;
+    status.NF = (flags >> 2) & 1;
+    status.OF = (flags >> 3) & 1;
+    status.DF = (flags >> 4) & 1;
+    machine.status_register.set(status);
+
+    uint32_t max_length, length;
+    if (!log.word(max_length) || !log.word(length)) return false;
+    if (max_length == 0 || max_length > VectorUnit::kMaxLength) return false;
+    machine.vector_unit.setMaxLength(max_length);
+    machine.vector_unit.reset();
+    machine.vector_unit.setLength(length);
+    uint32_t used;
+    if (!log.word(used) || used > VectorUnit::kRegisters) return false;
+    for (uint32_t i = 0; i < used; ++i) {
+        uint32_t v;
+        if (!log.word(v) || v >= VectorUnit::kRegisters) return false;
+        for (uint32_t& value : machine.vector_unit.at(v)) {
+            if (!log.word(value)) return false;
+        }
+    }
+
+    uint64_t words;
+    if (!log.varint(words)) return false;
+    machine.data_memory.clear();
+    uint64_t address = 0;
+    for (uint64_t i = 0; i < words; ++i) {
+        uint64_t gap;
+        uint32_t value;
+        if (!log.varint(gap) || !log.word(value)) return false;
+        address += gap;
+        if (address >= machine.data_memory.size()) return false;
+        machine.data_memory.write(static_cast<uint32_t>(address), value);
+        ++address;
+    }
+    return true;
+}
+
+/**
+ * @brief Rebuilds the recorded machine and re-executes every recorded run.
+ *
+ * @param path Path of the replay log.
+ * @param programs Candidate programs, matched by checksum.
+ * @param options Engine and optional trace output.
+ * @return The outcome and the final machine.
+ */
+ReplayResult ReplayPlayer::play(const std::string& path, const std::vector<std::vector<Instruction>>& programs,
+                                const ReplayOptions& options) {
+    ReplayResult result;
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        result.error = "cannot open " + path + ": " + std::strerror(errno);
+        return result;
+    }
+    std::unique_ptr<std::FILE, int (*)(std::FILE*)> closer(file, &std::fclose);
+    LogReader log(file);
+
+    uint64_t magic, version, data_size;
+    if (!log.fixed(4, magic) || !log.fixed(4, version) || !log.fixed(8, data_size)) {
+        result.error = path + ": file too small for a replay header";
+        return result;
+    }
+    if (magic != kReplayFileMagic) {
+        result.error = path + ": not a replay log (bad magic)";
+        return result;
+    }
+    if ((version & 0xffff) != kReplayFileVersion) {
+        result.error = path + ": unsupported replay log version " + std::to_string(version & 0xffff);
+        return result;
+    }
+
+    RiscMachine& machine = result.machine;
+    machine = RiscMachine(0, static_cast<size_t>(data_size), options.engine);
+    machine.setHostCalls(options.host_calls);
+    if (!options.trace_path.empty() && !machine.startTrace(options.trace_path, kDefaultTraceCapacity, &result.error)) {
+        return result;
+    }
+
+    auto fail = [&](const std::string& message) {
+        result.error = path + ": " + message;
+        result.ok = false;
+        machine.stopTrace();
+        return std::move(result);
+    };
+
+    uint32_t write_address = 0;
+    for (;;) {
+        uint8_t event;
+        if (!log.byte(event)) break;
+        switch (event) {
+            case ReplayRecorder::Program: {
+                uint32_t length, checksum;
+                if (!log.word(length) || !log.word(checksum)) return fail("truncated PROGRAM event");
+                auto match = std::find_if(programs.begin(), programs.end(), [&](const std::vector<Instruction>& p) {
+                    return p.size() == length && programChecksum(p.data(), p.size()) == checksum;
+                });
+                if (match != programs.end()) {
+                    machine.loadProgram(*match);
+                    break;
+                }
+                // A machine that never loaded a program runs its initial all-HALT program
+                const std::vector<Instruction> initial(length);
+                if (programChecksum(initial.data(), initial.size()) != checksum) {
+                    return fail("recorded program " + std::to_string(checksum) + " (" + std::to_string(length) +
+                                " instructions) was not supplied");
+                }
+                machine.loadProgram(initial);
+                break;
+            }
+            case ReplayRecorder::Image:
+                if (!loadImage(log, machine)) return fail("malformed IMAGE event");
+                break;
+            case ReplayRecorder::Write: {
+                uint64_t zigzag;
+                uint32_t value;
+                if (!log.varint(zigzag) || !log.word(value)) return fail("truncated WRITE event");
+                const int64_t delta = (zigzag & 1) ? -int64_t((zigzag + 1) >> 1) : int64_t(zigzag >> 1);
+                write_address = static_cast<uint32_t>(int64_t(write_address) + delta);
+                machine.setMemoryValue(write_address, value);
+                ++write_address;
+                break;
+            }
+            case ReplayRecorder::Clear:
+                machine.clearMemory();
+                break;
+            case ReplayRecorder::Reset:
+                machine.reset();
+                break;
+            case ReplayRecorder::Run:
+            case ReplayRecorder::RunSteps: {
+                uint64_t max_steps = 0;
+                if (event == ReplayRecorder::RunSteps) {
+                    if (!log.varint(max_steps)) return fail("truncated RUN_STEPS event");
+                    machine.run(max_steps);
+                } else {
+                    machine.run();
+                }
+                uint8_t end;
+                uint32_t pc, digest;
+                if (!log.byte(end)) break;  // recording stopped inside run()
+                if (end != ReplayRecorder::End || !log.word(pc) || !log.word(digest)) {
+                    return fail("RUN event without END");
+                }
+                const uint32_t replayed = stateDigest(machine.pc, machine.data_registers, machine.flagBits());
+                if (!result.diverged && (pc != machine.pc || digest != replayed)) {
+                    result.diverged = true;
+                    result.diverged_run = result.runs;
+                    result.error = path + ": run " + std::to_string(result.runs) + " ended at pc " +
+                                   std::to_string(machine.pc) + " instead of the recorded pc " + std::to_string(pc) +
+                                   (digest != replayed ? " with different registers or flags" : "");
+                }
+                ++result.runs;
+                break;
+            }
+            default:
+                return fail("unknown event " + std::to_string(event));
+        }
+    }
+
+    if (!machine.stopTrace() && result.error.empty()) result.error = "cannot write " + options.trace_path;
+    result.ok = result.error.empty();
+    return result;
+}
+
+/**
+ * @brief Re-executes a recording deterministically.
+ *
+ * @param path Path of the replay log.
+ * @param programs Candidate programs.
+ * @param options Engine and optional trace output.
+ * @return The outcome and the final machine.
+ */
+ReplayResult replayRecording(const std::string& path, const std::vector<std::vector<Instruction>>& programs,
+                             const ReplayOptions& options) {
+    return ReplayPlayer::play(path, programs, options);
+}
+
+/**
+ * @brief Compares two traces record by record.
+ *
+ * @param a First trace.
+ * @param b Second trace.
+ * @return Index of the first difference, or the common length if none.
+ */
+size_t firstTraceDivergence(const std::vector<TraceRecord>& a, const std::vector<TraceRecord>& b) {
+    const size_t common = std::min(a.size(), b.size());
+    for (size_t i = 0; i < common; ++i) {
+        const TraceRecord& x = a[i];
+        const TraceRecord& y = b[i];
+        if (x.pc != y.pc || x.opcode != y.opcode || x.flags != y.flags || x.dst != y.dst || x.src1 != y.src1 ||
+            x.src2 != y.src2 || x.result != y.result) {
+            return i;
+        }
+    }
+    return common;
+}
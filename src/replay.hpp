@@ -0,0 +1,67 @@
+/**
+ * @file replay.hpp
+ * @brief Declares deterministic replay of recorded guest executions.
+ *
+ * RiscMachine::startRecording() writes a replay log (see replay_log.hpp);
+ * replayRecording() rebuilds the recorded machine from it and re-runs every
+ * recorded run(). Replaying two logs with tracing enabled and comparing the
+ * traces with firstTraceDivergence() finds the first instruction at which two
+ * executions differ; the RiscReplay tool does both.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include "machine.hpp"
+#include "trace.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct ReplayOptions
+ * @brief How replayRecording() re-executes a log.
+ */
+struct ReplayOptions {
+    ExecutionEngine engine = ExecutionEngine::Switch;  /**< Engine of the replaying machine */
+    std::string trace_path;                            /**< Trace every replayed instruction here if set */
+    HostCallTable host_calls;                          /**< Host calls bound on the replaying machine */
+};
+
+/**
+ * @struct ReplayResult
+ * @brief Outcome of replayRecording().
+ */
+struct ReplayResult {
+    bool ok = false;                 /**< Log read completely and every run ended as recorded */
+    std::string error;               /**< Why replay stopped or diverged, if not ok */
+    uint64_t runs = 0;               /**< Runs replayed */
+    uint64_t diverged_run = 0;       /**< Index of the first run whose end state differs (if any) */
+    bool diverged = false;           /**< True if some run ended differently than recorded */
+    RiscMachine machine;             /**< The machine after the last replayed event */
+};
+
+/**
+ * @brief Re-executes a recording deterministically.
+ *
+ * Every PROGRAM event is resolved by hash against @p programs. After each run
+ * the end state is compared with the recorded END event; replay continues past
+ * a divergence but reports the first one.
+ *
+ * @param path Path of the replay log.
+ * @param programs Candidate programs; each recorded program must be among them.
+ * @param options Engine and optional trace output.
+ * @return The outcome and the final machine.
+ */
+ReplayResult replayRecording(const std::string& path, const std::vector<std::vector<Instruction>>& programs,
+                             const ReplayOptions& options = {});
+
+/**
+ * @brief Finds the first instruction at which two traces differ.
+ * @param a First trace.
+ * @param b Second trace.
+ * @return Index of the first differing record; the shorter length if one trace is a
+ *         prefix of the other; a.size() if they are identical.
+ */
+size_t firstTraceDivergence(const std::vector<TraceRecord>& a, const std::vector<TraceRecord>& b);
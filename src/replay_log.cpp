@@ -0,0 +1,211 @@
+/**
+ * @file replay_log.cpp
+ * @brief Implementation of the replay log recorder.
+ */
+
+#include "replay_log.hpp"
+#include "program_file.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+/**
+ * @brief Stores an error description if the caller asked for one.
+ *
+ * @param error Destination supplied by the caller (may be null).
+ * @param message The description.
+ */
+static void setError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+/**
+ * @brief Hashes the instruction records of a program.
+ *
+ * @param code The instructions.
+ * @param count Number of instructions.
+ * @return The checksum identifying the program in replay logs.
+ */
+uint32_t programChecksum(const Instruction* code, size_t count) {
+    static_assert(sizeof(Instruction) == 4 * sizeof(uint32_t), "instructions hash as four words");
+    return programFileChecksum(reinterpret_cast<const uint32_t*>(code), 4 * count);
+}
+
+/**
+ * @brief Hashes pc, registers and flags.
+ *
+ * @param pc Program counter.
+ * @param registers R0–R15.
+ * @param flags Flag bits.
+ * @return The digest.
+ */
+uint32_t stateDigest(uint32_t pc, const std::array<uint32_t, 16>& registers, uint32_t flags) {
+    uint32_t hash = programFileChecksum(&pc, 1);
+    hash = programFileChecksum(registers.data(), registers.size(), hash);
+    return programFileChecksum(&flags, 1, hash);
+}
+
+/**
+ * @brief Creates the log file and writes its header.
+ *
+ * The header is the magic, the format version, a reserved half-word and the
+ * data memory size as a little-endian 64-bit word.
+ *
+ * @param path Path of the file to create.
+ * @param data_size Data memory size of the recorded machine.
+ * @param error Receives a description of the problem if opening fails (optional).
+ * @return The recorder, or nullptr on failure.
+ */
+std::unique_ptr<ReplayRecorder> ReplayRecorder::open(const std::string& path, uint64_t data_size,
+                                                     std::string* error) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        setError(error, "cannot create " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    std::unique_ptr<ReplayRecorder> recorder(new ReplayRecorder(file));
+    for (int shift = 0; shift < 32; shift += 8) recorder->buffer.push_back(uint8_t(kReplayFileMagic >> shift));
+    recorder->buffer.push_back(uint8_t(kReplayFileVersion));
+    recorder->buffer.push_back(uint8_t(kReplayFileVersion >> 8));
+    recorder->buffer.push_back(0);
+    recorder->buffer.push_back(0);
+    for (int shift = 0; shift < 64; shift += 8) recorder->buffer.push_back(uint8_t(data_size >> shift));
+    return recorder;
+}
+
+/**
+ * @brief Takes ownership of the log file.
+ *
+ * @param file The open log.
+ */
+ReplayRecorder::ReplayRecorder(std::FILE* file) : file(file) {
+    buffer.reserve(kFlushSize + 256);
+}
+
+/**
+ * @brief Flushes and closes the log.
+ */
+ReplayRecorder::~ReplayRecorder() {
+    close();
+}
+
+/**
+ * @brief Appends an unsigned LEB128 varint.
+ *
+ * @param value The value.
+ */
+void ReplayRecorder::putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    put(static_cast<uint8_t>(value));
+}
+
+/**
+ * @brief Writes the buffered events to the file.
+ */
+void ReplayRecorder::flush() {
+    if (file && !buffer.empty() && std::fwrite(buffer.data(), 1, buffer.size(), file) != buffer.size()) {
+        failed = true;
+    }
+    buffer.clear();
+}
+
+/**
+ * @brief Records a program load.
+ *
+ * @param length Number of instructions.
+ * @param checksum programChecksum() of the instructions.
+ */
+void ReplayRecorder::program(uint32_t length, uint32_t checksum) {
+    put(Event::Program);
+    putVarint(length);
+    putVarint(checksum);
+}
+
+/**
+ * @brief Records registers, flags, pc, the vector unit and every non-zero word of data memory.
+ *
+ * @param pc Program counter.
+ * @param registers R0–R15.
+ * @param flags Flag bits.
+ * @param vectors Vector unit state.
+ * @param memory Data memory.
+ */
+void ReplayRecorder::image(uint32_t pc, const std::array<uint32_t, 16>& registers, uint32_t flags,
+                           const VectorUnit& vectors, const DataMemory& memory) {
+    put(Event::Image);
+    putVarint(pc);
+    for (uint32_t value : registers) putVarint(value);
+    putVarint(flags);
+    putVarint(vectors.maxLength());
+    putVarint(vectors.length());
+    // Only non-zero vector registers, each as (index, elements)
+    auto zero = [&vectors](uint32_t v) {
+        const VectorUnit::Register& r = vectors.at(v);
+        return std::all_of(r.begin(), r.end(), [](uint32_t value) { return value == 0; });
+    };
+    uint32_t used = 0;
+    for (uint32_t v = 0; v < VectorUnit::kRegisters; ++v) used += !zero(v);
+    putVarint(used);
+    for (uint32_t v = 0; v < VectorUnit::kRegisters; ++v) {
+        if (zero(v)) continue;
+        putVarint(v);
+        for (uint32_t value : vectors.at(v)) putVarint(value);
+    }
+
+    uint64_t words = 0;
+    memory.forEachResidentPage([&](uint32_t first, const uint32_t* page) {
+        for (uint32_t i = 0; i < DataMemory::kPageWords && first + i < memory.size(); ++i) words += page[i] != 0;
+    });
+    putVarint(words);
+    uint64_t next = 0;  // address after the previous non-zero word
+    memory.forEachResidentPage([&](uint32_t first, const uint32_t* page) {
+        for (uint32_t i = 0; i < DataMemory::kPageWords && first + i < memory.size(); ++i) {
+            if (!page[i]) continue;
+            putVarint(first + i - next);
+            putVarint(page[i]);
+            next = uint64_t(first) + i + 1;
+        }
+    });
+}
+
+/**
+ * @brief Records a host write, delta-encoding its address against the previous write.
+ *
+ * @param address Word address.
+ * @param value The value written.
+ */
+void ReplayRecorder::write(uint32_t address, uint32_t value) {
+    const int64_t delta = int64_t(address) - int64_t(next_write);
+    put(Event::Write);
+    putVarint(delta < 0 ? (uint64_t(-delta) << 1) - 1 : uint64_t(delta) << 1);  // zigzag
+    putVarint(value);
+    next_write = address + 1;
+}
+
+/**
+ * @brief Records how a run ended.
+ *
+ * @param pc Program counter after the run.
+ * @param digest stateDigest() after the run.
+ */
+void ReplayRecorder::end(uint32_t pc, uint32_t digest) {
+    put(Event::End);
+    putVarint(pc);
+    putVarint(digest);
+}
+
+/**
+ * @brief Writes outstanding events and closes the file.
+ *
+ * @return False if any write failed.
+ */
+bool ReplayRecorder::close() {
+    if (!file) return !failed;
+    flush();
+    if (std::fclose(file) != 0) failed = true;
+    file = nullptr;
+    return !failed;
+}
@@ -0,0 +1,169 @@
+/**
+ * @file replay_log.hpp
+ * @brief Declares the replay log format and its recorder.
+ *
+ * Guest execution is deterministic, so a recording (RiscMachine::startRecording)
+ * only holds what the machine cannot derive: the state image at the first run,
+ * the hash of every loaded program and the host's changes between runs. Guest
+ * instructions are never logged, so a recorded machine runs on its normal engine.
+ *
+ * The log is a header followed by a stream of events, each a tag byte and
+ * LEB128 varints:
+ *
+ * | Event   | Payload                                                                   |
+ * |---------|---------------------------------------------------------------------------|
+ * | PROGRAM | instruction count, programChecksum()                                      |
+ * | IMAGE   | pc, R0–R15, flag bits, VLMAX, vl, vector register count, then (index, 16 elements) per non-zero vector register, word count, then (address gap, value) per non-zero word |
+ * | WRITE   | zigzag(address − previous WRITE address − 1), value                      |
+ * | CLEAR   | —                                                                         |
+ * | RESET   | —                                                                         |
+ * | RUN     | — (followed by END once run() returns)                                   |
+ * | RUN_STEPS | max_steps of run(max_steps) (followed by END)                           |
+ * | END     | pc, stateDigest() after the run                                           |
+ *
+ * Consecutive host writes to ascending addresses therefore cost two or three
+ * bytes each, and memory images only encode non-zero words. replay.hpp
+ * re-executes a log.
+ */
+
+#pragma once
+
+#include "data_memory.hpp"
+#include "instruction.hpp"
+#include "vector_unit.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief File magic, "RRPL" when read as bytes. */
+constexpr uint32_t kReplayFileMagic = 0x4c505252;
+
+/** @brief Current version of the replay log format. */
+constexpr uint16_t kReplayFileVersion = 2;
+
+/**
+ * @brief Hashes a program the way replay logs identify it.
+ * @param code The instructions.
+ * @param count Number of instructions.
+ * @return programFileChecksum() of the instruction records.
+ */
+uint32_t programChecksum(const Instruction* code, size_t count);
+
+/**
+ * @brief Hashes the register state a run leaves behind.
+ * @param pc Program counter.
+ * @param registers R0–R15.
+ * @param flags Flag bits (bit i is CHECK_FLAG index i).
+ * @return The digest stored in END events.
+ */
+uint32_t stateDigest(uint32_t pc, const std::array<uint32_t, 16>& registers, uint32_t flags);
+
+/**
+ * @class ReplayRecorder
+ * @brief Writes the events of one recording to a replay log.
+ *
+ * Events are buffered and written in blocks; close() flushes the rest.
+ */
+class ReplayRecorder {
+public:
+    /**
+     * @brief Creates the log file and writes its header.
+     * @param path Path of the file to create (truncated if it exists).
+     * @param data_size Data memory size of the recorded machine, in words.
+     * @param error Receives a description of the problem if opening fails (optional).
+     * @return The recorder, or nullptr if the file could not be created.
+     */
+    static std::unique_ptr<ReplayRecorder> open(const std::string& path, uint64_t data_size,
+                                                std::string* error = nullptr);
+
+    /**
+     * @brief Flushes and closes the log.
+     */
+    ~ReplayRecorder();
+
+    ReplayRecorder(const ReplayRecorder&) = delete;
+    ReplayRecorder& operator=(const ReplayRecorder&) = delete;
+
+    /** @brief Records that a program was loaded. */
+    void program(uint32_t length, uint32_t checksum);
+
+    /**
+     * @brief Records the complete machine state.
+     * @param pc Program counter.
+     * @param registers R0–R15.
+     * @param flags Flag bits.
+     * @param vectors Vector registers, VLMAX and vl.
+     * @param memory Data memory; only non-zero words are written.
+     */
+    void image(uint32_t pc, const std::array<uint32_t, 16>& registers, uint32_t flags, const VectorUnit& vectors,
+               const DataMemory& memory);
+
+    /** @brief Records a host write to data memory. */
+    void write(uint32_t address, uint32_t value);
+
+    /** @brief Records that data memory was cleared. */
+    void clear() { put(Event::Clear); }
+
+    /** @brief Records that registers, flags and pc were reset. */
+    void reset() { put(Event::Reset); }
+
+    /** @brief Records the start of a run. */
+    void run() { put(Event::Run); }
+
+    /** @brief Records the start of a run limited to @p max_steps instructions. */
+    void run(uint64_t max_steps) {
+        put(Event::RunSteps);
+        putVarint(max_steps);
+    }
+
+    /** @brief Records the state a run ended in. */
+    void end(uint32_t pc, uint32_t digest);
+
+    /**
+     * @brief Writes outstanding events and closes the file.
+     * @return True if the whole log was written.
+     */
+    bool close();
+
+    /** @brief Event tags of the log format. */
+    enum Event : uint8_t { Program = 1, Image, Write, Clear, Reset, Run, End, RunSteps };
+
+private:
+    explicit ReplayRecorder(std::FILE* file);
+
+    void put(uint8_t byte) {
+        buffer.push_back(byte);
+        if (buffer.size() >= kFlushSize) flush();
+    }
+    void putVarint(uint64_t value);
+    void flush();
+
+    static constexpr size_t kFlushSize = 64 * 1024;
+
+    std::vector<uint8_t> buffer;
+    std::FILE* file;
+    uint32_t next_write = 0;  // address a sequential WRITE would use
+    bool failed = false;
+};
+
+/**
+ * @struct RecorderHandle
+ * @brief Owning pointer to a ReplayRecorder that copies do not carry over.
+ *
+ * Like TraceHandle: forks and snapshots of a recording machine do not record,
+ * and assigning a copy keeps the target's own recording.
+ */
+struct RecorderHandle {
+    std::unique_ptr<ReplayRecorder> recorder;  /**< The active recording, or null */
+    bool image_pending = false;                /**< The next run must log a state image first */
+
+    RecorderHandle() = default;
+    RecorderHandle(const RecorderHandle&) {}
+    RecorderHandle& operator=(const RecorderHandle&) { return *this; }
+    RecorderHandle(RecorderHandle&&) noexcept = default;
+    RecorderHandle& operator=(RecorderHandle&&) noexcept = default;
+};
@@ -0,0 +1,120 @@
+/**
+ * @file replay_tool.cpp
+ * @brief RiscReplay: re-executes replay logs and finds where two executions diverge.
+ *
+ * Usage:
+ *   RiscReplay <log> [--program FILE]... [--engine switch|threaded|jit] [--trace FILE]
+ *   RiscReplay --diff <log A> <log B> [--program FILE]...
+ *
+ * Programs are program files (see program_file.hpp); every program a log
+ * references must be given. The first form replays a log and reports whether
+ * each run ended as recorded. The second replays both logs with tracing,
+ * writing <log>.trace next to each, and prints the first instruction at which
+ * the two executions differ.
+ */
+
+#include "replay.hpp"
+#include "program_file.hpp"
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+int usage(const char* name) {
+    std::cerr << "usage: " << name << " <log> [--program FILE]... [--engine switch|threaded|jit] [--trace FILE]\n"
+              << "       " << name << " --diff <log A> <log B> [--program FILE]...\n";
+    return 2;
+}
+
+/**
+ * @brief Replays one log, printing an error if replay fails.
+ * @return True if the log could be replayed (diverged runs included).
+ */
+bool replay(const std::string& log, const std::vector<std::vector<Instruction>>& programs,
+            const ReplayOptions& options, ReplayResult& result) {
+    result = replayRecording(log, programs, options);
+    if (!result.ok && !result.diverged) {
+        std::cerr << result.error << '\n';
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> logs;
+    std::vector<std::vector<Instruction>> programs;
+    ReplayOptions options;
+    bool diff = false;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--diff") {
+            diff = true;
+        } else if (arg == "--program" && i + 1 < argc) {
+            std::string error;
+            auto program = MappedProgram::open(argv[++i], &error);
+            if (!program) {
+                std::cerr << error << '\n';
+                return 2;
+            }
+            programs.push_back(program->toVector());
+        } else if (arg == "--engine" && i + 1 < argc) {
+            const std::string engine = argv[++i];
+            if (engine == "switch") {
+                options.engine = ExecutionEngine::Switch;
+            } else if (engine == "threaded") {
+                options.engine = ExecutionEngine::Threaded;
+            } else if (engine == "jit") {
+                options.engine = ExecutionEngine::Jit;
+            } else {
+                return usage(argv[0]);
+            }
+        } else if (arg == "--trace" && i + 1 < argc) {
+            options.trace_path = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            return usage(argv[0]);
+        } else {
+            logs.push_back(arg);
+        }
+    }
+    if (logs.size() != (diff ? 2u : 1u)) return usage(argv[0]);
+
+    if (!diff) {
+        ReplayResult result;
+        if (!replay(logs[0], programs, options, result)) return 2;
+        std::cout << result.runs << " runs replayed\n";
+        if (result.diverged) {
+            std::cout << result.error << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    std::vector<TraceRecord> traces[2];
+    for (int side = 0; side < 2; ++side) {
+        options.trace_path = logs[side] + ".trace";
+        ReplayResult result;
+        std::string error;
+        if (!replay(logs[side], programs, options, result)) return 2;
+        if (!readTraceFile(options.trace_path, traces[side], &error)) {
+            std::cerr << error << '\n';
+            return 2;
+        }
+        std::cout << logs[side] << ": " << result.runs << " runs, " << traces[side].size() << " instructions\n";
+    }
+
+    const size_t at = firstTraceDivergence(traces[0], traces[1]);
+    if (at == traces[0].size() && at == traces[1].size()) {
+        std::cout << "executions are identical\n";
+        return 0;
+    }
+    std::cout << "first divergence at instruction " << at << ":\n";
+    if (at > 0) std::cout << "  both: " << formatTraceRecord(traces[0][at - 1]) << '\n';
+    for (int side = 0; side < 2; ++side) {
+        std::cout << "  " << (side ? 'B' : 'A') << ":    "
+                  << (at < traces[side].size() ? formatTraceRecord(traces[side][at]) : "(execution ended)") << '\n';
+    }
+    return 1;
+}
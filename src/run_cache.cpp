@@ -0,0 +1,341 @@
+/**
+ * @file run_cache.cpp
+ * @brief Implementation of the run memoisation cache.
+ */
+
+#include "run_cache.hpp"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Mixes one word into a 64-bit hash.
+ */
+uint64_t mix(uint64_t hash, uint32_t word) {
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 29);
+}
+
+/** @brief Words an instruction copy counts towards RunCacheOptions::max_words. */
+constexpr size_t kInstructionWords = sizeof(Instruction) / sizeof(uint32_t);
+
+}  // namespace
+
+/**
+ * @struct RunCache::Node
+ * @brief A trie node: either a cached run (leaf) or the next address runs read.
+ */
+struct RunCache::Node {
+    Node* parent = nullptr;
+    const RunKey* key = nullptr;  // roots only: their key in roots
+    std::vector<Instruction> program;  // roots only: the instructions of key's program
+    uint32_t value = 0;           // the value read at the parent's address that leads here
+    uint32_t address = 0;         // interior nodes: the address read next
+    std::unordered_map<uint32_t, std::unique_ptr<Node>> children;  // by the value read at address
+    bool leaf = false;
+    RunState outcome;                                   // leaves: final registers, flags and pc
+    std::vector<std::pair<uint32_t, uint32_t>> writes;  // leaves: final value of every word written
+    size_t words = 0;                                   // leaves: recorded words
+    std::list<Node*>::iterator position;                // leaves: place in recent
+};
+
+/**
+ * @brief Records a read unless the address was read or written before.
+ *
+ * @param address The address read.
+ * @param memory Data memory before the access.
+ */
+void RunFootprint::read(uint32_t address, const DataMemory& memory) {
+    if (overflow) return;
+    uint8_t& state = touched[address];
+    if (state != 0) return;  // a later read sees the first value or the run's own write
+    state = 1;
+    read_words.emplace_back(address, memory.read(address));
+    count();
+}
+
+/**
+ * @brief Records a write unless the address was written before.
+ *
+ * @param address The address written.
+ */
+void RunFootprint::write(uint32_t address) {
+    if (overflow) return;
+    uint8_t& state = touched[address];
+    if (state & 2) return;
+    state |= 2;
+    written_words.push_back(address);
+    count();
+}
+
+/**
+ * @brief Records reads of consecutive words.
+ *
+ * @param address First address.
+ * @param count Number of words.
+ * @param memory Data memory before the access.
+ */
+void RunFootprint::readRange(uint32_t address, uint32_t count, const DataMemory& memory) {
+    if (count > limit) overflow = true;
+    for (uint32_t i = 0; i < count && !overflow; ++i) read(address + i, memory);
+}
+
+/**
+ * @brief Records writes of consecutive words.
+ *
+ * @param address First address.
+ * @param count Number of words.
+ */
+void RunFootprint::writeRange(uint32_t address, uint32_t count) {
+    if (count > limit) overflow = true;
+    for (uint32_t i = 0; i < count && !overflow; ++i) write(address + i);
+}
+
+/**
+ * @brief Marks the footprint incomplete once it holds more words than the limit.
+ */
+void RunFootprint::count() {
+    if (read_words.size() + written_words.size() > limit) overflow = true;
+}
+
+/**
+ * @brief Hashes a key's program and start state.
+ */
+size_t RunCache::KeyHash::operator()(const RunKey& key) const {
+    uint64_t hash = mix(key.program_hash, static_cast<uint32_t>(key.program_length));
+    hash = mix(hash, static_cast<uint32_t>(key.data_size));
+    hash = mix(hash, key.start.pc);
+    hash = mix(hash, key.start.flags);
+    for (uint32_t value : key.start.registers) hash = mix(hash, value);
+    return static_cast<size_t>(hash ^ (hash >> 32));
+}
+
+/**
+ * @brief Creates an empty cache.
+ *
+ * @param options Limits.
+ */
+RunCache::RunCache(RunCacheOptions options) : settings(options) {}
+
+/**
+ * @brief Deletes the tries leaf by leaf, so deep ones are not destroyed recursively.
+ */
+RunCache::~RunCache() {
+    clear();
+}
+
+/**
+ * @brief Hashes every field of every instruction.
+ *
+ * @param code The program's first instruction.
+ * @param count Number of instructions.
+ * @return The hash.
+ */
+uint64_t RunCache::programHash(const Instruction* code, size_t count) {
+    uint64_t hash = mix(14695981039346656037ull, static_cast<uint32_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        hash = mix(hash, static_cast<uint32_t>(code[i].opcode));
+        hash = mix(hash, code[i].dst);
+        hash = mix(hash, code[i].src1);
+        hash = mix(hash, code[i].src2);
+    }
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * @brief Checks a program for host calls and vector instructions.
+ *
+ * @param code The program's first instruction.
+ * @param count Number of instructions.
+ * @return True if every run of the program can be memoised.
+ */
+bool RunCache::isMemoisable(const Instruction* code, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        const Opcode op = code[i].opcode;
+        if (op == Opcode::HOSTCALL || (op >= Opcode::VLOAD && op <= Opcode::VSETVL)) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Checks that a trie root was made for the instructions of a key.
+ *
+ * @param root A root of the trie.
+ * @param key A key equal to the root's, so with the same hash and length.
+ * @return True if every instruction matches.
+ */
+bool RunCache::sameProgram(const Node& root, const RunKey& key) {
+    return std::equal(root.program.begin(), root.program.end(), key.code,
+                      [](const Instruction& a, const Instruction& b) {
+                          return a.opcode == b.opcode && a.dst == b.dst && a.src1 == b.src1 && a.src2 == b.src2;
+                      });
+}
+
+/**
+ * @brief Walks the trie of the start state, reading the address of each node, to a cached run.
+ *
+ * @param key The program and start state.
+ * @param memory Data memory; receives the run's writes on a hit.
+ * @param outcome Receives the run's final state on a hit.
+ * @return True on a hit.
+ */
+bool RunCache::lookup(const RunKey& key, DataMemory& memory, RunState& outcome) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const auto root = roots.find(key);
+    Node* node = root == roots.end() ? nullptr : root->second.get();
+    if (node && !sameProgram(*node, key)) {
+        ++counters.conflicts;
+        node = nullptr;
+    }
+    while (node && !node->leaf) {
+        // Reads were recorded with this key's data size, so the address is in range
+        const auto child = node->children.find(memory.read(node->address));
+        node = child == node->children.end() ? nullptr : child->second.get();
+    }
+    if (!node) {
+        ++counters.misses;
+        return false;
+    }
+    for (const auto& word : node->writes) memory.write(word.first, word.second);
+    outcome = node->outcome;
+    recent.splice(recent.begin(), recent, node->position);
+    ++counters.hits;
+    return true;
+}
+
+/**
+ * @brief Adds the path of a run's reads to the trie of its start state and makes its end a leaf.
+ *
+ * @param key The program and start state.
+ * @param footprint The words the run read and wrote.
+ * @param memory Data memory after the run.
+ * @param outcome The run's final state.
+ * @return False if the run was not added.
+ */
+bool RunCache::store(const RunKey& key, const RunFootprint& footprint, const DataMemory& memory,
+                     const RunState& outcome) {
+    const auto& reads = footprint.reads();
+    const auto& written = footprint.writes();
+    const size_t entry_words = reads.size() + 2 * written.size();
+    std::lock_guard<std::mutex> lock(mutex);
+    if (footprint.overflowed() || reads.size() + written.size() > settings.max_footprint ||
+        entry_words > settings.max_words) {
+        ++counters.oversized;
+        return false;
+    }
+
+    // Follow the cached part of the path first, so a rejected run changes nothing
+    auto root = roots.find(key);
+    Node* node = nullptr;
+    size_t depth = 0;
+    if (root != roots.end()) {
+        node = root->second.get();
+        if (!sameProgram(*node, key)) {
+            ++counters.conflicts;
+            return false;
+        }
+        for (; depth < reads.size(); ++depth) {
+            // Runs from one state read the same address after the same values
+            const auto& word = reads[depth];
+            if (node->leaf || (!node->children.empty() && node->address != word.first)) return false;
+            const auto child = node->children.find(word.second);
+            if (child == node->children.end()) break;
+            node = child->second.get();
+        }
+        if (depth == reads.size() && !node->children.empty()) return false;
+    } else {
+        root = roots.emplace(key, std::make_unique<Node>()).first;
+        node = root->second.get();
+        node->key = &root->first;
+        node->program.assign(key.code, key.code + key.program_length);
+        words += node->program.size() * kInstructionWords;
+    }
+    for (; depth < reads.size(); ++depth) {
+        const auto& word = reads[depth];
+        node->address = word.first;
+        std::unique_ptr<Node>& child = node->children[word.second];
+        child = std::make_unique<Node>();
+        child->parent = node;
+        child->value = word.second;
+        node = child.get();
+    }
+    if (node->leaf) {
+        // Another machine stored the same run first
+        words -= node->words;
+        recent.erase(node->position);
+    }
+    node->leaf = true;
+    node->outcome = outcome;
+    node->writes.clear();
+    node->writes.reserve(written.size());
+    for (uint32_t address : written) node->writes.emplace_back(address, memory.read(address));
+    node->words = entry_words;
+    words += entry_words;
+    recent.push_front(node);
+    node->position = recent.begin();
+    ++counters.stores;
+    evict();
+    return true;
+}
+
+/**
+ * @brief Evicts the least recently used runs until the cache is within its limits.
+ */
+void RunCache::evict() {
+    while (!recent.empty() && (recent.size() > settings.max_entries || words > settings.max_words)) {
+        erase(recent.back());
+        ++counters.evictions;
+    }
+}
+
+/**
+ * @brief Deletes a leaf and every node left without runs below it.
+ *
+ * @param leaf A leaf of the trie.
+ */
+void RunCache::erase(Node* leaf) {
+    recent.erase(leaf->position);
+    words -= leaf->words;
+    leaf->leaf = false;
+    Node* node = leaf;
+    while (!node->leaf && node->children.empty()) {
+        Node* parent = node->parent;
+        if (!parent) {
+            words -= node->program.size() * kInstructionWords;
+            roots.erase(RunKey(*node->key));
+            return;
+        }
+        parent->children.erase(node->value);
+        node = parent;
+    }
+}
+
+/**
+ * @brief Deletes every run and clears the counters.
+ */
+void RunCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    while (!recent.empty()) erase(recent.back());
+    roots.clear();
+    counters = RunCacheStats();
+}
+
+/**
+ * @brief Gets the number of cached runs.
+ *
+ * @return Leaves of all tries.
+ */
+size_t RunCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return recent.size();
+}
+
+/**
+ * @brief Gets the counters.
+ *
+ * @return A copy taken under the lock.
+ */
+RunCacheStats RunCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file run_cache.hpp
+ * @brief Declares RunCache, which memoises whole runs of pure guest programs.
+ *
+ * A run of a program that neither calls the host nor uses the vector unit is
+ * a function of the machine state it starts from and of the data memory words
+ * it reads before writing them (its input footprint). A RunCache keeps such
+ * runs: the start state, the footprint with the values read, and the outcome,
+ * which is the final registers, flags and pc plus the final value of every
+ * word the run wrote.
+ *
+ * A later run of the same program from the same state whose memory holds the
+ * same values at the footprint's addresses must read, compute and write
+ * exactly the same, so the cache applies the outcome instead of executing.
+ * Footprints may depend on the data (e.g. an indirect LOAD through a pointer
+ * read from memory): the runs cached for one start state form a trie, in which
+ * each node names the next address the program reads, given the values read
+ * so far, and each edge one value read there. A lookup walks the trie reading
+ * only those addresses.
+ *
+ * The tries are keyed by a hash of the program, but each root also keeps a
+ * copy of the program's instructions, which lookups and stores compare with
+ * the caller's: two programs whose hashes collide never share runs.
+ *
+ * Entries are evicted least recently used first once the cache holds more
+ * than RunCacheOptions::max_entries runs or max_words recorded words; the
+ * instruction copies count four words per instruction.
+ */
+
+#pragma once
+
+#include "data_memory.hpp"
+#include "instruction.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @struct RunState
+ * @brief The registers, flags and program counter around a run.
+ */
+struct RunState {
+    std::array<uint32_t, 16> registers{}; /**< R0–R15 */
+    uint32_t flags = 0;                   /**< Bit i holds the flag with CHECK_FLAG index i */
+    uint32_t pc = 0;                      /**< Program counter */
+    bool faulted = false;                 /**< Whether the run faulted (outcomes only) */
+};
+
+/**
+ * @struct RunKey
+ * @brief Identifies a program and the state a run of it starts from, besides data memory.
+ */
+struct RunKey {
+    uint64_t program_hash = 0;   /**< RunCache::programHash() of the instructions */
+    uint64_t program_length = 0; /**< Number of instructions */
+    const Instruction* code = nullptr;  /**< The instructions; compared with the cached copy, not hashed */
+    uint64_t data_size = 0;      /**< Data memory size in words; decides which accesses fault */
+    RunState start;              /**< Registers, flags and pc at the start (faulted is ignored) */
+
+    bool operator==(const RunKey& other) const {
+        return program_hash == other.program_hash && program_length == other.program_length &&
+               data_size == other.data_size && start.registers == other.start.registers &&
+               start.flags == other.start.flags && start.pc == other.start.pc;
+    }
+};
+
+/**
+ * @class RunFootprint
+ * @brief Collects the words a run reads before writing them, and the words it writes.
+ *
+ * Both are recorded once per address, reads in the order the run performs
+ * them. Recording stops once more than the given number of words were seen.
+ */
+class RunFootprint {
+public:
+    /**
+     * @brief Creates an empty footprint.
+     * @param limit Number of words (read plus written) after which recording stops.
+     */
+    explicit RunFootprint(size_t limit) : limit(limit) {}
+
+    /**
+     * @brief Records a read of one word, with its value, unless the run touched it before.
+     * @param address Address less than memory.size().
+     * @param memory Data memory before the access.
+     */
+    void read(uint32_t address, const DataMemory& memory);
+
+    /**
+     * @brief Records a write of one word.
+     * @param address Address less than the data memory size.
+     */
+    void write(uint32_t address);
+
+    /**
+     * @brief Records a read of consecutive words.
+     * @param address First address; address + count must not exceed memory.size().
+     * @param count Number of words.
+     * @param memory Data memory before the access.
+     */
+    void readRange(uint32_t address, uint32_t count, const DataMemory& memory);
+
+    /**
+     * @brief Records a write of consecutive words.
+     * @param address First address; address + count must not exceed the data memory size.
+     * @param count Number of words.
+     */
+    void writeRange(uint32_t address, uint32_t count);
+
+    /**
+     * @brief Checks whether the run touched more words than the limit.
+     * @return True if the footprint is incomplete and must not be cached.
+     */
+    bool overflowed() const { return overflow; }
+
+    /**
+     * @brief Gets the words read before being written.
+     * @return (address, value) pairs in the order of the first reads.
+     */
+    const std::vector<std::pair<uint32_t, uint32_t>>& reads() const { return read_words; }
+
+    /**
+     * @brief Gets the words written.
+     * @return Addresses in the order of the first writes.
+     */
+    const std::vector<uint32_t>& writes() const { return written_words; }
+
+private:
+    void count();
+
+    size_t limit;
+    bool overflow = false;
+    std::unordered_map<uint32_t, uint8_t> touched;  // bit 0: read, bit 1: written
+    std::vector<std::pair<uint32_t, uint32_t>> read_words;
+    std::vector<uint32_t> written_words;
+};
+
+/**
+ * @struct RunCacheOptions
+ * @brief How much a RunCache may keep.
+ */
+struct RunCacheOptions {
+    size_t max_entries = 65536;              /**< Cached runs */
+    size_t max_words = size_t{1} << 22;      /**< Recorded words (read, or written with their values) over all runs */
+    size_t max_footprint = 4096;             /**< Runs touching more words (read plus written) are not cached */
+};
+
+/**
+ * @struct RunCacheStats
+ * @brief Counters of one RunCache since it was created or cleared.
+ */
+struct RunCacheStats {
+    uint64_t hits = 0;       /**< Runs answered from the cache */
+    uint64_t misses = 0;     /**< Lookups without a matching run */
+    uint64_t stores = 0;     /**< Runs added */
+    uint64_t oversized = 0;  /**< Runs not added because their footprint exceeded max_footprint */
+    uint64_t evictions = 0;  /**< Runs deleted to respect the limits */
+    uint64_t conflicts = 0;  /**< Lookups and stores rejected because another program had the same hash */
+};
+
+/**
+ * @class RunCache
+ * @brief A bounded LRU cache of program runs, keyed by start state and input footprint.
+ *
+ * One cache may be shared by many machines and used from several threads.
+ */
+class RunCache {
+public:
+    /**
+     * @brief Creates an empty cache.
+     * @param options Limits.
+     */
+    explicit RunCache(RunCacheOptions options = RunCacheOptions());
+
+    ~RunCache();
+    RunCache(const RunCache&) = delete;
+    RunCache& operator=(const RunCache&) = delete;
+
+    /**
+     * @brief Hashes a program's instructions for RunKey::program_hash.
+     * @param code The program's first instruction.
+     * @param count Number of instructions.
+     * @return A 64-bit hash.
+     */
+    static uint64_t programHash(const Instruction* code, size_t count);
+
+    /**
+     * @brief Checks whether every instruction of a program can be memoised.
+     *
+     * HOSTCALL may touch any state through native code, and vector
+     * instructions use the vector registers, which are not part of the key.
+     *
+     * @param code The program's first instruction.
+     * @param count Number of instructions.
+     * @return False if the program contains either.
+     */
+    static bool isMemoisable(const Instruction* code, size_t count);
+
+    /**
+     * @brief Looks up a run and, on a hit, applies its outcome.
+     *
+     * @param key The program and start state.
+     * @param memory Data memory at the start; on a hit, receives the run's writes.
+     * @param outcome Receives the final registers, flags, pc and fault on a hit.
+     * @return True on a hit.
+     */
+    bool lookup(const RunKey& key, DataMemory& memory, RunState& outcome);
+
+    /**
+     * @brief Adds a run, then evicts runs beyond the limits.
+     *
+     * @param key The program and start state.
+     * @param footprint The words the run read and wrote.
+     * @param memory Data memory after the run, holding the values written.
+     * @param outcome The final registers, flags, pc and fault.
+     * @return False if the footprint overflowed or exceeds max_footprint, if
+     *         another program with the same hash is cached, or if the run
+     *         contradicts a cached one. A rejected run leaves the cache unchanged.
+     */
+    bool store(const RunKey& key, const RunFootprint& footprint, const DataMemory& memory, const RunState& outcome);
+
+    /**
+     * @brief Deletes every run and clears the counters.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the number of cached runs.
+     * @return Entries currently held.
+     */
+    size_t size() const;
+
+    /**
+     * @brief Gets the counters.
+     * @return A copy of the counters.
+     */
+    RunCacheStats stats() const;
+
+    /**
+     * @brief Gets the limits.
+     * @return The options the cache was created with.
+     */
+    const RunCacheOptions& options() const { return settings; }
+
+private:
+    struct Node;
+    struct KeyHash {
+        size_t operator()(const RunKey& key) const;
+    };
+
+    static bool sameProgram(const Node& root, const RunKey& key);
+    void evict();
+    void erase(Node* leaf);
+
+    RunCacheOptions settings;
+    mutable std::mutex mutex;
+    std::unordered_map<RunKey, std::unique_ptr<Node>, KeyHash> roots;  // one trie per start state
+    std::list<Node*> recent;  // leaves, most recently used first
+    size_t words = 0;         // recorded words of all leaves
+    RunCacheStats counters;
+};
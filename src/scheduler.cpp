@@ -0,0 +1,216 @@
+/**
+ * @file scheduler.cpp
+ * @brief Implementation of the time-slicing guest scheduler.
+ */
+
+#include "scheduler.hpp"
+#include <algorithm>
+
+namespace {
+
+/**
+ * @brief Clamps a priority to [1, kStride], so every slice advances the guest's pass by at least 1.
+ */
+uint32_t clampPriority(uint32_t priority) {
+    return static_cast<uint32_t>(std::min<uint64_t>(std::max(1u, priority), Scheduler::kStride));
+}
+
+}  // namespace
+
+/**
+ * @brief Creates the worker threads; they sleep until a guest is submitted.
+ *
+ * @param options Worker count and slice length.
+ */
+Scheduler::Scheduler(SchedulerOptions options) : options(options) {
+    if (this->options.slice_steps == 0) this->options.slice_steps = 1;
+    size_t count = options.workers;
+    if (count == 0) count = std::max(1u, std::thread::hardware_concurrency());
+
+    workers.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers.emplace_back(&Scheduler::workerLoop, this);
+    }
+}
+
+/**
+ * @brief Wakes all workers with the stop request and joins them.
+ */
+Scheduler::~Scheduler() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_ready.notify_all();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Registers a guest and puts it in the run queue.
+ *
+ * @param machine The guest machine.
+ * @param priority Relative share of slices; clamped to [1, kStride].
+ * @param on_exit Exit callback.
+ * @param step_limit Instruction limit over all slices (0: unlimited).
+ * @return The guest's identifier.
+ */
+GuestId Scheduler::submit(std::unique_ptr<RiscMachine> machine, uint32_t priority, ExitCallback on_exit,
+                          uint64_t step_limit) {
+    auto guest = std::make_unique<Guest>();
+    guest->machine = std::move(machine);
+    guest->on_exit = std::move(on_exit);
+    guest->priority = clampPriority(priority);
+    guest->step_limit = step_limit;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    guest->id = next_id++;
+    guest->pass = virtual_time;
+    Guest& queued = *guest;
+    guests.emplace(queued.id, std::move(guest));
+    enqueue(queued);
+    return queued.id;
+}
+
+/**
+ * @brief Changes the priority used for a guest's future pass increments.
+ *
+ * @param id The guest.
+ * @param priority Relative share of slices; clamped to [1, kStride].
+ * @return False if the guest has already finished.
+ */
+bool Scheduler::setPriority(GuestId id, uint32_t priority) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = guests.find(id);
+    if (it == guests.end()) return false;
+    it->second->priority = clampPriority(priority);
+    return true;
+}
+
+/**
+ * @brief Marks a guest as cancelled; a worker finishes it instead of running its next slice.
+ *
+ * @param id The guest.
+ * @return False if the guest has already finished.
+ */
+bool Scheduler::cancel(GuestId id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = guests.find(id);
+    if (it == guests.end()) return false;
+    it->second->cancelled = true;
+    return true;
+}
+
+/**
+ * @brief Waits until no guest is queued or running.
+ */
+void Scheduler::wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    all_done.wait(lock, [this] { return guests.empty(); });
+    if (failure) {
+        std::exception_ptr error = failure;
+        failure = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * @brief Gets the number of guests that have not finished.
+ *
+ * @return The number of queued and running guests.
+ */
+size_t Scheduler::activeCount() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return guests.size();
+}
+
+/**
+ * @brief Gets the number of worker threads.
+ *
+ * @return The worker count.
+ */
+size_t Scheduler::workerCount() const {
+    return workers.size();
+}
+
+/**
+ * @brief Pushes a guest into the run queue at its current pass; the caller holds the mutex.
+ *
+ * @param guest The guest.
+ */
+void Scheduler::enqueue(Guest& guest) {
+    run_queue.push({guest.pass, next_sequence++, &guest});
+    work_ready.notify_one();
+}
+
+/**
+ * @brief Runs a finished guest's exit callback and forgets the guest.
+ *
+ * Called without the mutex held, so callbacks may submit further guests.
+ *
+ * @param guest The guest.
+ */
+void Scheduler::finish(Guest& guest) {
+    try {
+        if (guest.on_exit) guest.on_exit(guest.id, guest.result, *guest.machine);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!failure) failure = std::current_exception();
+    }
+    std::unique_ptr<Guest> owned;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = guests.find(guest.id);
+    owned = std::move(it->second);
+    guests.erase(it);
+    if (guests.empty()) all_done.notify_all();
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * Takes the guest with the smallest pass, runs one slice outside the lock and
+ * either requeues the guest with its pass advanced or finishes it.
+ */
+void Scheduler::workerLoop() {
+    for (;;) {
+        Guest* guest = nullptr;
+        uint64_t budget = 0;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            work_ready.wait(lock, [this] { return stopping || !run_queue.empty(); });
+            if (stopping) return;
+            guest = run_queue.top().guest;
+            run_queue.pop();
+            virtual_time = std::max(virtual_time, guest->pass);
+            if (!guest->cancelled) {
+                budget = options.slice_steps;
+                if (guest->step_limit) budget = std::min(budget, guest->step_limit - guest->result.steps);
+            }
+        }
+
+        if (budget == 0) {
+            guest->result.cancelled = true;
+            finish(*guest);
+            continue;
+        }
+
+        GuestResult& result = guest->result;
+        result.status = guest->machine->run(budget);
+        result.steps += guest->machine->getLastRunSteps();
+        ++result.slices;
+
+        bool done = result.status != RunStatus::BudgetExhausted ||
+                    (guest->step_limit && result.steps >= guest->step_limit);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!done && !guest->cancelled) {
+                guest->pass += kStride / guest->priority;
+                enqueue(*guest);
+                continue;
+            }
+            result.cancelled = !done;
+        }
+        finish(*guest);
+    }
+}
@@ -0,0 +1,196 @@
+/**
+ * @file scheduler.hpp
+ * @brief Declares Scheduler, which time-slices many guest machines over a few worker threads.
+ *
+ * Every submitted guest is a RiscMachine with its program and input already
+ * loaded. Workers repeatedly pick the runnable guest with the smallest pass
+ * value (stride scheduling), run it for one slice with run(max_steps) and put
+ * it back until it halts, faults, exhausts its step limit or is cancelled. A
+ * guest's pass advances by kStride / priority per slice, so over time each
+ * guest receives slices in proportion to its priority and no guest starves.
+ * Priorities are clamped to [1, kStride], so every slice advances the pass.
+ *
+ * Slices use the budgeted run(max_steps): Threaded and Jit guests run their
+ * threaded code (native JIT code has no budget checks), Switch guests and
+ * profiled or traced ones the switch engine. BM_FactorialSliced measures the
+ * cost of slicing against an unbudgeted run.
+ */
+
+#pragma once
+
+#include "machine.hpp"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @struct SchedulerOptions
+ * @brief Configuration of a Scheduler.
+ */
+struct SchedulerOptions {
+    size_t workers = 0;            /**< Worker threads (0: one per hardware thread) */
+    uint64_t slice_steps = 100000; /**< Instructions per time slice */
+};
+
+/** @brief Identifies a guest submitted to a Scheduler. */
+using GuestId = uint64_t;
+
+/**
+ * @struct GuestResult
+ * @brief How a scheduled guest finished.
+ */
+struct GuestResult {
+    RunStatus status = RunStatus::Halted; /**< Status of the last slice (BudgetExhausted at the step limit) */
+    uint64_t steps = 0;                   /**< Instructions executed over all slices */
+    uint64_t slices = 0;                  /**< Number of slices the guest ran */
+    bool cancelled = false;               /**< Whether cancel() stopped the guest */
+};
+
+/**
+ * @class Scheduler
+ * @brief Runs many guest machines concurrently with time slices, priorities and step limits.
+ *
+ * Example:
+ * @code
+ * Scheduler scheduler(SchedulerOptions{2, 10000});
+ * auto machine = std::make_unique<RiscMachine>();
+ * machine->loadProgram(createFactorialProgram(100, 101));
+ * machine->setMemoryValue(100, 10);
+ * scheduler.submit(std::move(machine), 1, [](GuestId, const GuestResult&, RiscMachine& m) {
+ *     std::cout << m.getMemoryValue(101) << '\n';
+ * });
+ * scheduler.wait();
+ * @endcode
+ */
+class Scheduler {
+public:
+    /**
+     * @brief Callback invoked on a worker thread when a guest finishes.
+     *
+     * The machine is destroyed when the callback returns.
+     */
+    using ExitCallback = std::function<void(GuestId, const GuestResult&, RiscMachine&)>;
+
+    /** @brief Pass increment of a priority-1 guest per slice. */
+    static constexpr uint64_t kStride = 1 << 20;
+
+    /**
+     * @brief Starts the worker threads.
+     * @param options Worker count and slice length.
+     */
+    explicit Scheduler(SchedulerOptions options = {});
+
+    /**
+     * @brief Stops and joins the worker threads.
+     *
+     * Slices in progress complete; guests that have not finished are destroyed
+     * without their exit callback.
+     */
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /**
+     * @brief Adds a guest to the run queue.
+     *
+     * The guest continues from its current program counter; it enters the
+     * queue at the current virtual time, so it neither waits for nor
+     * overtakes guests that have been running for a long time.
+     *
+     * @param machine The guest, with its program and input loaded.
+     * @param priority Relative share of slices; clamped to [1, kStride], since a larger
+     *        priority would no longer advance the guest's pass.
+     * @param on_exit Called when the guest finishes; may be empty.
+     * @param step_limit Maximum instructions over all slices (0: unlimited).
+     * @return The guest's identifier.
+     */
+    GuestId submit(std::unique_ptr<RiscMachine> machine, uint32_t priority = 1, ExitCallback on_exit = {},
+                   uint64_t step_limit = 0);
+
+    /**
+     * @brief Changes the priority of a guest from its next slice on.
+     * @param id The guest.
+     * @param priority Relative share of slices; clamped to [1, kStride], since a larger
+     *        priority would no longer advance the guest's pass.
+     * @return False if the guest has already finished.
+     */
+    bool setPriority(GuestId id, uint32_t priority);
+
+    /**
+     * @brief Stops a guest before its next slice.
+     *
+     * A slice in progress completes first; the guest then finishes with
+     * GuestResult::cancelled set.
+     *
+     * @param id The guest.
+     * @return False if the guest has already finished.
+     */
+    bool cancel(GuestId id);
+
+    /**
+     * @brief Blocks until every submitted guest has finished.
+     *
+     * Rethrows the first exception thrown by an exit callback, if any.
+     */
+    void wait();
+
+    /**
+     * @brief Gets the number of guests that have not finished.
+     * @return The number of queued and running guests.
+     */
+    size_t activeCount() const;
+
+    /**
+     * @brief Gets the number of worker threads.
+     * @return The worker count.
+     */
+    size_t workerCount() const;
+
+private:
+    struct Guest {
+        GuestId id = 0;
+        std::unique_ptr<RiscMachine> machine;
+        ExitCallback on_exit;
+        uint32_t priority = 1;
+        uint64_t step_limit = 0;
+        uint64_t pass = 0;
+        bool cancelled = false;
+        GuestResult result;
+    };
+
+    struct Entry {
+        uint64_t pass;
+        uint64_t sequence;  // FIFO among equal passes
+        Guest* guest;
+        bool operator>(const Entry& other) const {
+            return pass != other.pass ? pass > other.pass : sequence > other.sequence;
+        }
+    };
+
+    void workerLoop();
+    void enqueue(Guest& guest);
+    void finish(Guest& guest);
+
+    SchedulerOptions options;
+    std::vector<std::thread> workers;
+
+    mutable std::mutex mutex;  // guards the fields below
+    std::condition_variable work_ready;
+    std::condition_variable all_done;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> run_queue;
+    std::unordered_map<GuestId, std::unique_ptr<Guest>> guests;
+    GuestId next_id = 1;
+    uint64_t next_sequence = 0;
+    uint64_t virtual_time = 0;  // pass of the most recently started slice
+    bool stopping = false;
+    std::exception_ptr failure;
+};
@@ -0,0 +1,174 @@
+/**
+ * @file stats.cpp
+ * @brief Implementation of the guest execution profile.
+ */
+
+#include "stats.hpp"
+#include "instruction.hpp"
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+const char* const kFlagNames[kFlagCount] = {"ZF", "CF", "NF", "OF", "DF"};
+
+constexpr uint8_t bit(size_t flag) { return static_cast<uint8_t>(1u << flag); }
+
+/**
+ * @brief Formats a count as a share of the total, e.g. "12.5%".
+ */
+std::string percent(uint64_t count, uint64_t total) {
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1) << (total ? 100.0 * count / total : 0.0) << '%';
+    return out.str();
+}
+
+}  // namespace
+
+/**
+ * @brief Clears all counters.
+ *
+ * @param program_length Number of instructions of the profiled program.
+ */
+void ExecutionStats::reset(size_t program_length) {
+    *this = ExecutionStats();
+    pc_counts.assign(program_length, 0);
+}
+
+/**
+ * @brief Counts the flags an instruction wrote and which of them it set.
+ *
+ * Follows RiscMachine::execute: arithmetic with an out-of-range register writes
+ * nothing, CMP always writes ZF, CAS writes ZF, MEMCMP writes ZF, CF and NF,
+ * and DIV writes NF only for a non-zero divisor. Flags set by a host function
+ * (HOSTCALL) are not counted.
+ *
+ * @param instr The executed instruction.
+ * @param register_count Number of data registers of the machine.
+ * @param flags The flags after the instruction.
+ */
+void ExecutionStats::recordFlags(const Instruction& instr, size_t register_count, const LazyFlags& flags) {
+    const bool registers_valid =
+        instr.dst < register_count && instr.src1 < register_count && instr.src2 < register_count;
+    uint8_t written = 0;
+    switch (instr.opcode) {
+        case Opcode::ADD:
+        case Opcode::SUB:
+            if (registers_valid) written = bit(1) | bit(2);
+            break;
+        case Opcode::MUL:
+            if (registers_valid) written = bit(3) | bit(2);
+            break;
+        case Opcode::DIV:
+            if (registers_valid) written = bit(4) | bit(3) | bit(1) | (flags.divideByZero() ? 0 : bit(2));
+            break;
+        case Opcode::CMP:
+            written = bit(0);
+            break;
+        case Opcode::CAS:
+            if (registers_valid) written = bit(0);
+            break;
+        case Opcode::MEMCMP:
+            if (registers_valid) written = bit(0) | bit(1) | bit(2);
+            break;
+        default:
+            return;
+    }
+    for (size_t flag = 0; flag < kFlagCount; ++flag) {
+        if (!(written & bit(flag))) continue;
+        ++this->flags[flag].written;
+        if (flags.read(static_cast<uint32_t>(flag))) ++this->flags[flag].set;
+    }
+}
+
+/**
+ * @brief Gets the most executed program counters.
+ *
+ * @param count Maximum number of entries.
+ * @return (pc, executions) pairs in descending order of executions; PCs never executed are omitted.
+ */
+std::vector<std::pair<uint32_t, uint64_t>> ExecutionStats::hottest(size_t count) const {
+    std::vector<std::pair<uint32_t, uint64_t>> pcs;
+    for (size_t pc = 0; pc < pc_counts.size(); ++pc) {
+        if (pc_counts[pc]) pcs.emplace_back(static_cast<uint32_t>(pc), pc_counts[pc]);
+    }
+    const size_t kept = std::min(count, pcs.size());
+    std::partial_sort(pcs.begin(), pcs.begin() + kept, pcs.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    pcs.resize(kept);
+    return pcs;
+}
+
+/**
+ * @brief Formats the profile for people.
+ *
+ * @param hot_pcs Number of hot program counters to list.
+ * @return The multi-line report.
+ */
+std::string ExecutionStats::toString(size_t hot_pcs) const {
+    std::ostringstream out;
+    out << "instructions retired: " << instructions_retired << '\n';
+
+    out << "opcodes:\n";
+    for (size_t op = 0; op < kOpcodeCount; ++op) {
+        if (!opcode_counts[op]) continue;
+        out << "  " << std::left << std::setw(11) << opcodeName(static_cast<Opcode>(op)) << std::right
+            << std::setw(12) << opcode_counts[op] << "  " << percent(opcode_counts[op], instructions_retired) << '\n';
+    }
+
+    out << "hot PCs:\n";
+    for (const auto& [pc, executions] : hottest(hot_pcs)) {
+        out << "  " << std::setw(6) << pc << std::setw(12) << executions << "  "
+            << percent(executions, instructions_retired) << '\n';
+    }
+
+    out << "jump sites (taken / not taken):\n";
+    for (const auto& [pc, site] : jump_sites) {
+        out << "  " << std::setw(6) << pc << std::setw(12) << site.taken << " / " << site.not_taken << '\n';
+    }
+
+    out << "flags (set / written):\n";
+    for (size_t flag = 0; flag < kFlagCount; ++flag) {
+        out << "  " << kFlagNames[flag] << std::setw(12) << flags[flag].set << " / " << flags[flag].written << '\n';
+    }
+    return out.str();
+}
+
+/**
+ * @brief Serialises the profile.
+ *
+ * @return A JSON object with the keys instructions_retired, opcodes, pc_counts,
+ *         jump_sites and flags.
+ */
+std::string ExecutionStats::toJson() const {
+    std::ostringstream out;
+    out << "{\"instructions_retired\":" << instructions_retired;
+
+    out << ",\"opcodes\":{";
+    for (size_t op = 0; op < kOpcodeCount; ++op) {
+        out << (op ? "," : "") << '"' << opcodeName(static_cast<Opcode>(op)) << "\":" << opcode_counts[op];
+    }
+
+    out << "},\"pc_counts\":[";
+    for (size_t pc = 0; pc < pc_counts.size(); ++pc) {
+        out << (pc ? "," : "") << pc_counts[pc];
+    }
+
+    out << "],\"jump_sites\":[";
+    bool first = true;
+    for (const auto& [pc, site] : jump_sites) {
+        out << (first ? "" : ",") << "{\"pc\":" << pc << ",\"taken\":" << site.taken
+            << ",\"not_taken\":" << site.not_taken << '}';
+        first = false;
+    }
+
+    out << "],\"flags\":{";
+    for (size_t flag = 0; flag < kFlagCount; ++flag) {
+        out << (flag ? "," : "") << '"' << kFlagNames[flag] << "\":{\"written\":" << flags[flag].written
+            << ",\"set\":" << flags[flag].set << '}';
+    }
+    out << "}}";
+    return out.str();
+}
@@ -0,0 +1,111 @@
+/**
+ * @file stats.hpp
+ * @brief Declares ExecutionStats, the guest profile collected by RiscMachine.
+ *
+ * Statistics are opt-in (RiscMachine::setStatsEnabled). While enabled, run()
+ * executes on a profiling instantiation of the switch engine; the regular
+ * engines contain no counting code, so disabled statistics cost nothing.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include "flags.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** @brief Number of Opcode values (HALT … HOSTCALL). */
+constexpr size_t kOpcodeCount = static_cast<size_t>(Opcode::HOSTCALL) + 1;
+
+/** @brief Number of status flags, in CHECK_FLAG order: ZF, CF, NF, OF, DF. */
+constexpr size_t kFlagCount = 5;
+
+/**
+ * @struct JumpSiteStats
+ * @brief Outcomes of one JMP instruction.
+ */
+struct JumpSiteStats {
+    uint64_t taken = 0;      /**< Executions that transferred control */
+    uint64_t not_taken = 0;  /**< Executions that fell through (condition false or invalid jump) */
+};
+
+/**
+ * @struct FlagStats
+ * @brief How often one flag was written, and how often it was left set.
+ */
+struct FlagStats {
+    uint64_t written = 0;  /**< Instructions that wrote the flag */
+    uint64_t set = 0;      /**< Of those, writes that left the flag at 1 */
+};
+
+/**
+ * @struct ExecutionStats
+ * @brief Profile of the guest instructions executed since the program was loaded.
+ */
+struct ExecutionStats {
+    uint64_t instructions_retired = 0;                  /**< Instructions executed */
+    std::array<uint64_t, kOpcodeCount> opcode_counts{}; /**< Executions per Opcode */
+    std::vector<uint64_t> pc_counts;                    /**< Executions per program counter */
+    std::map<uint32_t, JumpSiteStats> jump_sites;       /**< JMP outcomes, keyed by PC */
+    std::array<FlagStats, kFlagCount> flags{};          /**< Writes per flag */
+
+    /**
+     * @brief Clears all counters and sizes pc_counts for a program.
+     * @param program_length Number of instructions of the program.
+     */
+    void reset(size_t program_length);
+
+    /**
+     * @brief Records one executed instruction.
+     * @param pc Address of the instruction.
+     * @param opcode Its opcode.
+     */
+    void recordInstruction(uint32_t pc, Opcode opcode) {
+        ++instructions_retired;
+        if (static_cast<size_t>(opcode) < kOpcodeCount) ++opcode_counts[static_cast<size_t>(opcode)];
+        if (pc < pc_counts.size()) ++pc_counts[pc];
+    }
+
+    /**
+     * @brief Records the outcome of a JMP.
+     * @param pc Address of the jump.
+     * @param taken True if control was transferred.
+     */
+    void recordJump(uint32_t pc, bool taken) {
+        JumpSiteStats& site = jump_sites[pc];
+        ++(taken ? site.taken : site.not_taken);
+    }
+
+    /**
+     * @brief Records the flags written by an executed instruction.
+     * @param instr The instruction (operands decide whether it wrote anything).
+     * @param register_count Number of data registers of the machine.
+     * @param flags The flags after the instruction.
+     */
+    void recordFlags(const Instruction& instr, size_t register_count, const LazyFlags& flags);
+
+    /**
+     * @brief Gets the most executed program counters.
+     * @param count Maximum number of entries.
+     * @return (pc, executions) pairs, most executed first.
+     */
+    std::vector<std::pair<uint32_t, uint64_t>> hottest(size_t count) const;
+
+    /**
+     * @brief Formats a human-readable report: totals, opcode mix, hot PCs, jump sites and flags.
+     * @param hot_pcs Number of hot program counters to list.
+     * @return The report.
+     */
+    std::string toString(size_t hot_pcs = 10) const;
+
+    /**
+     * @brief Serialises every counter as a JSON object.
+     * @return The JSON text.
+     */
+    std::string toJson() const;
+};
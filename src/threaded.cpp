@@ -0,0 +1,379 @@
+/**
+ * @file threaded.cpp
+ * @brief Threaded execution engine for the RISC emulator.
+ *
+ * The threaded engine executes the program decoded by decodeProgram() in the packed
+ * encoding produced by packProgram(). Each record carries the address of its
+ * handler, and every handler ends by jumping straight to the handler of the next
+ * record (direct threading), so there is no central dispatch loop and no
+ * per-instruction operand validation.
+ *
+ * The budgeted variant used by run(max_steps) counts retired instructions per
+ * straight-line segment: a segment's length is known from the distance between
+ * its first record and the branch that ends it, so the count is only updated,
+ * and compared with the budget, at branches. It stops at a branch once fewer
+ * than one program length of steps remain; the caller finishes that tail on
+ * the switch engine, which stops on the exact instruction.
+ */
+
+#include "machine.hpp"
+#include "logging.hpp"
+#include <iostream>
+
+// Computed goto is a GNU extension; other compilers fall back to a switch loop.
+#if defined(__GNUC__)
+#define RISC_COMPUTED_GOTO 1
+#else
+#define RISC_COMPUTED_GOTO 0
+#endif
+
+/**
+ * @brief Executes the decoded program from the current program counter.
+ *
+ * Produces exactly the same architectural state as repeatedly calling execute()
+ * on the original instructions.
+ *
+ * @tparam Budgeted Whether to count steps and stop early at a branch.
+ * @param max_steps Instruction budget (Budgeted only); the run stops at the
+ *        first branch after which fewer than the program length remain.
+ * @return Instructions executed (Budgeted only).
+ */
+template <bool Budgeted>
+uint64_t RiscMachine::runThreaded(uint64_t max_steps) {
+    std::vector<PackedInstruction>& packed = program->packed;
+    const size_t program_size = packed.size() - 1;  // minus EXIT sentinel
+    if (pc >= program_size) return 0;
+    // A segment between two branches retires at most program_size instructions
+    if (Budgeted && max_steps < program_size) return 0;
+
+#if RISC_COMPUTED_GOTO
+    // Indexed by DecodedOp
+    static const void* const handlers[] = {
+        &&op_NOP, &&op_HALT, &&op_LOAD_DIRECT, &&op_LOAD_INDIRECT, &&op_LOAD_IMM,
+        &&op_STORE, &&op_ADD, &&op_SUB, &&op_MUL, &&op_DIV, &&op_CMP, &&op_CMP_INVALID,
+        &&op_JMP, &&op_JZ, &&op_MOV, &&op_CHECK_FLAG, &&op_EXIT, &&op_CMP_JZ, &&op_FLAG_CMP_JZ, &&op_REDUCE,
+        &&op_ATOMIC_ADD, &&op_CAS, &&op_FENCE, &&op_HART_ID,
+        &&op_VLOAD, &&op_VSTORE, &&op_VADD, &&op_VSUB, &&op_VMUL, &&op_VREDUCE, &&op_VSETVL,
+        &&op_MEMCPY, &&op_MEMSET, &&op_MEMCMP, &&op_HOSTCALL
+    };
+    static_assert(sizeof(handlers) / sizeof(handlers[0]) == static_cast<size_t>(DecodedOp::COUNT),
+                  "handler table out of sync with DecodedOp");
+
+    // The packed program may be shared by forks running on other threads. Records
+    // are bound to the unbudgeted handlers; the budgeted variant looks its own up.
+    if (!Budgeted) {
+        std::call_once(program->packed_bound, [&packed] {
+            for (PackedInstruction& p : packed) {
+                p.handler = handlers[static_cast<size_t>(p.op)];
+            }
+        });
+    }
+    #define CASE(name) op_##name:
+    #define NEXT() goto *(Budgeted ? handlers[static_cast<size_t>(ip->op)] : ip->handler)
+#else
+    #define CASE(name) case DecodedOp::name:
+    #define NEXT() continue
+#endif
+
+    const PackedInstruction* const base = packed.data();
+    const PackedInstruction* ip = base + pc;
+    uint32_t* const regs = data_registers.data();
+    DataMemory& mem = data_memory;
+    const size_t data_size = mem.size();
+    LazyFlags& flags = status_register;
+    VectorUnit& vectors = vector_unit;
+    uint64_t saved_dispatches = 0;  // dispatches avoided by fused records
+    uint64_t steps = 0;                          // instructions retired before segment (Budgeted only)
+    const PackedInstruction* segment = ip;       // first record of the current straight-line segment
+    const PackedInstruction* retired_end = ip;   // where the segment's retired instructions end, at done
+
+    // Leaves the program after retiring the current record (HALT, faults)
+    #define STOP(fault)                                  \
+        {                                                \
+            retired_end = ip + 1;                        \
+            if (Budgeted && (fault)) load_fault = true;  \
+            ip = base + program_size;                    \
+            goto done;                                   \
+        }
+    // Moves to target after a branch record that retires `covered` instructions
+    #define BRANCH(target, covered)                                         \
+        {                                                                   \
+            const PackedInstruction* const next = (target);                 \
+            if (Budgeted) {                                                 \
+                steps += static_cast<uint64_t>(ip - segment) + (covered);   \
+                segment = retired_end = ip = next;                          \
+                if (steps + program_size > max_steps) goto done;            \
+            } else {                                                        \
+                ip = next;                                                  \
+            }                                                               \
+        }
+
+#if RISC_COMPUTED_GOTO
+    NEXT();
+#else
+    for (;;) {
+    switch (ip->op) {
+#endif
+
+    CASE(NOP)
+        ++ip;
+        NEXT();
+
+    CASE(HALT)
+        STOP(false);
+
+    CASE(LOAD_DIRECT)
+        regs[ip->x] = mem.read(ip->imm);
+        ++ip;
+        NEXT();
+
+    CASE(LOAD_INDIRECT) {
+        uint32_t address = regs[ip->y];
+        if (address >= data_size) {
+            LOG_ERROR("Error: Indirect load from out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        regs[ip->x] = mem.read(address);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(LOAD_IMM)
+        regs[ip->x] = ip->imm;
+        ++ip;
+        NEXT();
+
+    CASE(STORE)
+        mem.write(ip->imm, regs[ip->y]);
+        ++ip;
+        NEXT();
+
+    CASE(ADD) {
+        uint32_t lhs = regs[ip->y];
+        uint32_t rhs = regs[ip->z];
+        regs[ip->x] = lhs + rhs;
+        flags.setAdd(lhs, rhs);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(SUB) {
+        uint32_t lhs = regs[ip->y];
+        uint32_t rhs = regs[ip->z];
+        regs[ip->x] = lhs - rhs;
+        flags.setSub(lhs, rhs);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(MUL) {
+        uint32_t lhs = regs[ip->y];
+        uint32_t rhs = regs[ip->z];
+        regs[ip->x] = lhs * rhs;
+        flags.setMul(lhs, rhs);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(DIV) {
+        uint32_t divisor = regs[ip->z];
+        if (divisor == 0) {
+            flags.setDivByZero();
+        } else {
+            uint32_t result = regs[ip->y] / divisor;
+            regs[ip->x] = result;
+            flags.setDiv(result);
+        }
+        ++ip;
+        NEXT();
+    }
+
+    CASE(CMP)
+        flags.setZero(regs[ip->y] == regs[ip->z]);
+        ++ip;
+        NEXT();
+
+    CASE(CMP_INVALID)
+        flags.setZero(false);
+        ++ip;
+        NEXT();
+
+    CASE(JMP)
+        BRANCH(base + ip->imm, 1);
+        NEXT();
+
+    CASE(JZ)
+        BRANCH(flags.zero() ? base + ip->imm : ip + 1, 1);
+        NEXT();
+
+    CASE(MOV)
+        regs[ip->x] = regs[ip->y];
+        ++ip;
+        NEXT();
+
+    CASE(CHECK_FLAG) {
+        regs[ip->x] = flags.read(ip->y);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(EXIT)
+        retired_end = ip;
+        goto done;
+
+    CASE(CMP_JZ) {
+        bool zero = regs[ip->y] == regs[ip->z];
+        flags.setZero(zero);
+        saved_dispatches += 1;
+        BRANCH(zero ? base + ip->imm : ip + 2, 2);
+        NEXT();
+    }
+
+    CASE(FLAG_CMP_JZ) {
+        uint32_t value = flags.read(ip->y);
+        regs[ip->x] = value;
+        bool zero = value == regs[ip->z];
+        flags.setZero(zero);
+        saved_dispatches += 2;
+        BRANCH(zero ? base + ip->imm : ip + 3, 3);
+        NEXT();
+    }
+
+    CASE(REDUCE) {
+        // Bulk-run the clean iterations, then execute the head LOAD_INDIRECT as usual
+        const ReductionLoop& loop = program->reductions[ip->imm];
+        // Budgeted: the iterations plus the rest of this segment must fit in the budget
+        const uint64_t max_iterations =
+            !Budgeted ? UINT64_MAX
+            : max_steps - steps > program_size ? (max_steps - steps - program_size) / loop.length : 0;
+        const uint64_t iterations = runReductionLoop(loop, regs, flags, mem, max_iterations);
+        reduced_iterations += iterations;
+        if (Budgeted) steps += iterations * loop.length;
+        saved_dispatches += iterations * loop.length;
+        uint32_t address = regs[ip->y];
+        if (address >= data_size) {
+            LOG_ERROR("Error: Indirect load from out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        regs[ip->x] = mem.read(address);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(ATOMIC_ADD) {
+        uint32_t address = regs[ip->y];
+        if (address >= data_size) {
+            LOG_ERROR("Error: Atomic access to out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        regs[ip->x] = mem.fetchAdd(address, regs[ip->z]);
+        ++ip;
+        NEXT();
+    }
+
+    CASE(CAS) {
+        uint32_t address = regs[ip->y];
+        if (address >= data_size) {
+            LOG_ERROR("Error: Atomic access to out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        uint32_t expected = regs[ip->x];
+        flags.setZero(mem.compareExchange(address, expected, regs[ip->z]));
+        regs[ip->x] = expected;
+        ++ip;
+        NEXT();
+    }
+
+    CASE(FENCE)
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        ++ip;
+        NEXT();
+
+    CASE(HART_ID)
+        regs[ip->x] = hart_id;
+        ++ip;
+        NEXT();
+
+    CASE(VLOAD)
+        if (!vectors.load(ip->x, mem, regs[ip->y], regs[ip->z])) {
+            LOG_ERROR("Error: Vector access to out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        ++ip;
+        NEXT();
+
+    CASE(VSTORE)
+        if (!vectors.store(ip->y, mem, regs[ip->x], regs[ip->z])) {
+            LOG_ERROR("Error: Vector access to out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        ++ip;
+        NEXT();
+
+    CASE(VADD)
+        vectors.add(ip->x, ip->y, ip->z);
+        ++ip;
+        NEXT();
+
+    CASE(VSUB)
+        vectors.sub(ip->x, ip->y, ip->z);
+        ++ip;
+        NEXT();
+
+    CASE(VMUL)
+        vectors.mul(ip->x, ip->y, ip->z);
+        ++ip;
+        NEXT();
+
+    CASE(VREDUCE)
+        regs[ip->x] = vectors.reduce(ip->y);
+        ++ip;
+        NEXT();
+
+    CASE(VSETVL)
+        regs[ip->x] = vectors.setLength(regs[ip->y]);
+        ++ip;
+        NEXT();
+
+    CASE(MEMCPY)
+    CASE(MEMSET)
+    CASE(MEMCMP) {
+        const Opcode opcode = ip->op == DecodedOp::MEMCPY ? Opcode::MEMCPY
+                            : ip->op == DecodedOp::MEMSET ? Opcode::MEMSET : Opcode::MEMCMP;
+        if (!executeBulk(opcode, regs[ip->x], regs[ip->y], regs[ip->z], flags)) {
+            LOG_ERROR("Error: Bulk memory access to out of bounds address at PC=" << ip - base);
+            STOP(true);
+        }
+        ++ip;
+        NEXT();
+    }
+
+    CASE(HOSTCALL)
+        if (!callHost(ip->imm, regs, flags)) {
+            LOG_ERROR("Error: Host call " << ip->imm << " failed at PC=" << ip - base);
+            STOP(true);
+        }
+        ++ip;
+        NEXT();
+
+#if !RISC_COMPUTED_GOTO
+    case DecodedOp::COUNT:
+        goto done;
+    }
+    }
+#endif
+
+done:
+    pc = static_cast<uint32_t>(ip - base);
+    fused_dispatches_saved += saved_dispatches;
+    if (Budgeted) steps += static_cast<uint64_t>(retired_end - segment);
+    return steps;
+
+    #undef CASE
+    #undef NEXT
+    #undef STOP
+    #undef BRANCH
+}
+
+template uint64_t RiscMachine::runThreaded<false>(uint64_t);
+template uint64_t RiscMachine::runThreaded<true>(uint64_t);
@@ -0,0 +1,182 @@
+/**
+ * @file trace.cpp
+ * @brief Implementation of the trace ring buffer, its file writer and reader.
+ */
+
+#include "trace.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+/**
+ * @brief Stores an error description if the caller asked for one.
+ *
+ * @param error Destination supplied by the caller (may be null).
+ * @param message The description.
+ */
+static void setError(std::string* error, const std::string& message) {
+    if (error) *error = message;
+}
+
+/**
+ * @brief Creates the trace file, writes its header and starts the consumer.
+ *
+ * @param path Path of the file to create.
+ * @param capacity Ring capacity in records; rounded up to a power of two (at least 2).
+ * @param error Receives a description of the problem if opening fails (optional).
+ * @return The writer, or nullptr on failure.
+ */
+std::unique_ptr<TraceWriter> TraceWriter::open(const std::string& path, size_t capacity, std::string* error) {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        setError(error, "cannot create " + path + ": " + std::strerror(errno));
+        return nullptr;
+    }
+    const TraceFileHeader header;
+    if (std::fwrite(&header, sizeof(header), 1, file) != 1) {
+        setError(error, "cannot write " + path + ": " + std::strerror(errno));
+        std::fclose(file);
+        return nullptr;
+    }
+    size_t rounded = 2;
+    while (rounded < capacity) rounded <<= 1;
+    return std::unique_ptr<TraceWriter>(new TraceWriter(file, rounded));
+}
+
+/**
+ * @brief Allocates the ring and starts the consumer thread.
+ *
+ * @param file The open trace file; owned by the writer from now on.
+ * @param capacity Ring capacity in records, a power of two.
+ */
+TraceWriter::TraceWriter(std::FILE* file, size_t capacity)
+    : ring(new TraceRecord[capacity]), mask(capacity - 1), file(file) {
+    consumer = std::thread(&TraceWriter::drain, this);
+}
+
+/**
+ * @brief Flushes outstanding records and closes the file.
+ */
+TraceWriter::~TraceWriter() {
+    close();
+}
+
+/**
+ * @brief Waits until the consumer has written everything, then closes the file.
+ *
+ * @return True if every record was written successfully.
+ */
+bool TraceWriter::close() {
+    if (consumer.joinable()) {
+        stopping.store(true, std::memory_order_release);
+        consumer.join();
+    }
+    if (file) {
+        if (std::fclose(file) != 0) failed = true;
+        file = nullptr;
+    }
+    return !failed;
+}
+
+/**
+ * @brief Spins (yielding the CPU) until the slot at @p position is free.
+ *
+ * @param position The slot the producer is about to fill.
+ */
+void TraceWriter::waitForSpace(uint64_t position) {
+    for (;;) {
+        cached_head = head.load(std::memory_order_acquire);
+        if (position - cached_head <= mask) return;
+        std::this_thread::yield();
+    }
+}
+
+/**
+ * @brief Writes ring contents to the file until close() is called and the ring is empty.
+ *
+ * Each pass writes the largest contiguous run of published records with one
+ * fwrite. After a failed write the remaining records are consumed and
+ * discarded, so the producer never blocks on a broken file.
+ */
+void TraceWriter::drain() {
+    const uint64_t capacity = mask + 1;
+    uint64_t position = head.load(std::memory_order_relaxed);
+    for (;;) {
+        const bool last_pass = stopping.load(std::memory_order_acquire);
+        const uint64_t published = tail.load(std::memory_order_acquire);
+        if (position == published) {
+            if (last_pass) break;
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            continue;
+        }
+        const uint64_t begin = position & mask;
+        const size_t count = static_cast<size_t>(std::min(published - position, capacity - begin));
+        if (!failed && std::fwrite(&ring[begin], sizeof(TraceRecord), count, file) != count) failed = true;
+        position += count;
+        head.store(position, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Reads and validates a trace file.
+ *
+ * @param path Path of the trace.
+ * @param records Receives the records.
+ * @param error Receives a description of the problem if reading fails (optional).
+ * @return True on success.
+ */
+bool readTraceFile(const std::string& path, std::vector<TraceRecord>& records, std::string* error) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        setError(error, "cannot open " + path + ": " + std::strerror(errno));
+        return false;
+    }
+    TraceFileHeader header;
+    const TraceFileHeader expected;
+    bool ok = false;
+    if (std::fread(&header, sizeof(header), 1, file) != 1) {
+        setError(error, path + ": file too small for a trace header");
+    } else if (header.magic != kTraceFileMagic) {
+        setError(error, path + ": not a trace file (bad magic)");
+    } else if (header.version != kTraceFileVersion) {
+        setError(error, path + ": unsupported trace file version " + std::to_string(header.version));
+    } else if (header.byte_order != expected.byte_order) {
+        setError(error, path + ": trace was written on a host with a different byte order");
+    } else if (header.record_size != sizeof(TraceRecord)) {
+        setError(error, path + ": malformed trace header");
+    } else {
+        records.clear();
+        TraceRecord buffer[1024];
+        size_t count;
+        while ((count = std::fread(buffer, sizeof(TraceRecord), 1024, file)) > 0) {
+            records.insert(records.end(), buffer, buffer + count);
+        }
+        ok = !std::ferror(file);
+        if (!ok) setError(error, "cannot read " + path + ": " + std::strerror(errno));
+    }
+    std::fclose(file);
+    return ok;
+}
+
+/**
+ * @brief Formats one record as a line of text.
+ *
+ * @param record The record.
+ * @return PC, mnemonic, operands, result and the flags (a letter per set flag).
+ */
+std::string formatTraceRecord(const TraceRecord& record) {
+    static const char kFlagLetters[] = "ZCNOD";
+    std::string flags(5, '-');
+    for (size_t flag = 0; flag < flags.size(); ++flag) {
+        if (record.flags & (1u << flag)) flags[flag] = kFlagLetters[flag];
+    }
+    std::ostringstream out;
+    out << std::setw(6) << record.pc << "  " << std::left << std::setw(11)
+        << opcodeName(static_cast<Opcode>(record.opcode)) << std::right << " dst=" << record.dst
+        << " src1=" << record.src1 << " src2=" << record.src2 << "  result=" << record.result
+        << "  flags=" << flags;
+    return out.str();
+}
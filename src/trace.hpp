@@ -0,0 +1,177 @@
+/**
+ * @file trace.hpp
+ * @brief Declares the binary instruction trace: record format, writer and reader.
+ *
+ * While tracing (RiscMachine::startTrace), every executed instruction is pushed
+ * as a fixed-size TraceRecord into a single-producer/single-consumer lock-free
+ * ring buffer. A background thread drains the ring to the trace file, so the
+ * executing thread never formats text or calls into the C library per
+ * instruction. The RiscTraceDump tool renders a trace file as text.
+ *
+ * | Offset | Size        | Content                  |
+ * |--------|-------------|--------------------------|
+ * | 0      | 16          | TraceFileHeader          |
+ * | 16     | 24 * count  | TraceRecord, in order    |
+ *
+ * Records are stored in host byte order; the header records the byte order.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** @brief File magic, "RTRC" when read as bytes. */
+constexpr uint32_t kTraceFileMagic = 0x43525452;
+
+/** @brief Current version of the trace file format. */
+constexpr uint16_t kTraceFileVersion = 1;
+
+/** @brief Default ring capacity in records (1.5 MiB). */
+constexpr size_t kDefaultTraceCapacity = size_t(1) << 16;
+
+/**
+ * @struct TraceFileHeader
+ * @brief Fixed-size header at the start of every trace file.
+ */
+struct TraceFileHeader {
+    uint32_t magic = kTraceFileMagic;      /**< Must equal kTraceFileMagic */
+    uint16_t version = kTraceFileVersion;  /**< Format version */
+    uint16_t record_size = 24;             /**< sizeof(TraceRecord) */
+    uint32_t byte_order = 0x01020304;      /**< Written in host order; identifies the host's endianness */
+    uint32_t reserved = 0;                 /**< Must be zero */
+};
+
+/**
+ * @struct TraceRecord
+ * @brief One executed instruction.
+ */
+struct TraceRecord {
+    uint32_t pc = 0;        /**< Address of the instruction */
+    uint8_t opcode = 0;     /**< Its Opcode */
+    uint8_t flags = 0;      /**< Flags after execution; bit i is CHECK_FLAG index i (ZF, CF, NF, OF, DF) */
+    uint16_t reserved = 0;  /**< Zero */
+    uint32_t dst = 0;       /**< Operands as encoded */
+    uint32_t src1 = 0;
+    uint32_t src2 = 0;
+    uint32_t result = 0;    /**< Value written: the destination register, or the stored word for STORE; else 0 */
+};
+
+static_assert(sizeof(TraceFileHeader) == 16, "trace file header layout");
+static_assert(sizeof(TraceRecord) == 24, "trace record layout");
+
+/**
+ * @class TraceWriter
+ * @brief Lock-free ring buffer drained to a trace file by a background thread.
+ *
+ * push() may be called by one thread at a time (the thread running the
+ * machine); the writer's own thread is the only consumer. When the ring is
+ * full the producer waits for the consumer, so no record is ever dropped.
+ */
+class TraceWriter {
+public:
+    /**
+     * @brief Creates the trace file and starts the consumer thread.
+     * @param path Path of the file to create (truncated if it exists).
+     * @param capacity Ring capacity in records; rounded up to a power of two.
+     * @param error Receives a description of the problem if opening fails (optional).
+     * @return The writer, or nullptr if the file could not be created.
+     */
+    static std::unique_ptr<TraceWriter> open(const std::string& path, size_t capacity = kDefaultTraceCapacity,
+                                             std::string* error = nullptr);
+
+    /**
+     * @brief Flushes outstanding records and closes the file.
+     */
+    ~TraceWriter();
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    /**
+     * @brief Appends a record, waiting for the consumer if the ring is full.
+     * @param record The record.
+     */
+    void push(const TraceRecord& record) {
+        const uint64_t position = tail.load(std::memory_order_relaxed);
+        if (position - cached_head > mask) waitForSpace(position);
+        ring[position & mask] = record;
+        tail.store(position + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief Stops the consumer after it has written every pushed record.
+     * @return True if every record reached the file.
+     */
+    bool close();
+
+    /**
+     * @brief Gets the number of records pushed so far.
+     * @return The record count.
+     */
+    uint64_t recordCount() const { return tail.load(std::memory_order_relaxed); }
+
+private:
+    TraceWriter(std::FILE* file, size_t capacity);
+
+    /**
+     * @brief Blocks the producer until the consumer frees a slot.
+     * @param position The slot the producer is about to fill.
+     */
+    void waitForSpace(uint64_t position);
+
+    /**
+     * @brief Consumer thread: writes ring contents to the file until closed.
+     */
+    void drain();
+
+    std::unique_ptr<TraceRecord[]> ring;
+    uint64_t mask;
+    alignas(64) std::atomic<uint64_t> head{0};  // next record to write; consumer-owned
+    alignas(64) std::atomic<uint64_t> tail{0};  // next free slot; producer-owned
+    uint64_t cached_head = 0;                   // producer's last view of head
+    std::atomic<bool> stopping{false};
+    bool failed = false;                        // a write failed; consumer-owned until joined
+    std::FILE* file;
+    std::thread consumer;
+};
+
+/**
+ * @struct TraceHandle
+ * @brief Owning pointer to a TraceWriter that copies do not carry over.
+ *
+ * Keeps RiscMachine copyable: a copy of a tracing machine (a fork or snapshot)
+ * starts without a trace, and assigning a copy keeps the target's own trace.
+ */
+struct TraceHandle {
+    std::unique_ptr<TraceWriter> writer;  /**< The active trace, or null */
+
+    TraceHandle() = default;
+    TraceHandle(const TraceHandle&) {}
+    TraceHandle& operator=(const TraceHandle&) { return *this; }
+    TraceHandle(TraceHandle&&) noexcept = default;
+    TraceHandle& operator=(TraceHandle&&) noexcept = default;
+};
+
+/**
+ * @brief Reads a complete trace file.
+ * @param path Path of the trace.
+ * @param records Receives the records.
+ * @param error Receives a description of the problem if reading fails (optional).
+ * @return True on success.
+ */
+bool readTraceFile(const std::string& path, std::vector<TraceRecord>& records, std::string* error = nullptr);
+
+/**
+ * @brief Formats one record as a line of text (without newline).
+ * @param record The record.
+ * @return e.g. "     7  JMP         dst=10 src1=1 src2=0  result=0  flags=Z----".
+ */
+std::string formatTraceRecord(const TraceRecord& record);
@@ -0,0 +1,50 @@
+/**
+ * @file trace_dump.cpp
+ * @brief RiscTraceDump: renders a binary instruction trace as text.
+ *
+ * Usage: RiscTraceDump <trace file> [--from N] [--count N]
+ *
+ * Prints one line per executed instruction (see formatTraceRecord) followed
+ * by the number of records. --from skips the first N records and --count
+ * limits the output to N records.
+ */
+
+#include "trace.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    std::string path;
+    size_t from = 0;
+    size_t count = SIZE_MAX;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--from" || arg == "--count") && i + 1 < argc) {
+            const size_t value = std::strtoull(argv[++i], nullptr, 10);
+            (arg == "--from" ? from : count) = value;
+        } else if (path.empty() && arg.rfind("--", 0) != 0) {
+            path = arg;
+        } else {
+            path.clear();
+            break;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: " << argv[0] << " <trace file> [--from N] [--count N]\n";
+        return 2;
+    }
+
+    std::vector<TraceRecord> records;
+    std::string error;
+    if (!readTraceFile(path, records, &error)) {
+        std::cerr << error << '\n';
+        return 1;
+    }
+    for (size_t i = from; i < records.size() && i - from < count; ++i) {
+        std::cout << formatTraceRecord(records[i]) << '\n';
+    }
+    std::cout << records.size() << " records\n";
+    return 0;
+}
@@ -0,0 +1,454 @@
+/**
+ * @file translation_cache.cpp
+ * @brief Implementation of the on-disk translation cache.
+ */
+
+#include "translation_cache.hpp"
+#include "program_file.hpp"
+#include "stats.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr const char* kEntrySuffix = ".rtc";
+constexpr const char* kTemporaryPrefix = ".tmp-";
+
+/**
+ * @brief Describes the opcode sets and instruction size of this build, so entries of other builds are rejected.
+ */
+uint32_t translationLayout() {
+    return static_cast<uint32_t>(DecodedOp::COUNT) | static_cast<uint32_t>(kOpcodeCount) << 8 |
+           static_cast<uint32_t>(sizeof(Instruction)) << 16;
+}
+
+/**
+ * @brief Checks whether the host stores integers little-endian like the file format.
+ */
+bool hostIsLittleEndian() {
+    const uint32_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+/**
+ * @brief Appends little-endian fields to a byte buffer, padding every section to 4 bytes.
+ */
+struct Writer {
+    std::vector<uint8_t> bytes;
+
+    void u32(uint32_t value) { raw(&value, sizeof(value)); }
+
+    void raw(const void* data, size_t size) {
+        const uint8_t* begin = static_cast<const uint8_t*>(data);
+        bytes.insert(bytes.end(), begin, begin + size);
+        bytes.resize((bytes.size() + 3) & ~size_t{3}, 0);
+    }
+};
+
+/**
+ * @brief Reads what Writer wrote; any read past the end clears ok.
+ */
+struct Reader {
+    const uint8_t* pos;
+    const uint8_t* end;
+    bool ok = true;
+
+    uint32_t u32() {
+        uint32_t value = 0;
+        const uint8_t* data = take(sizeof(value));
+        if (data) std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    // Returns the next size bytes and skips their padding, or null
+    const uint8_t* take(size_t size) {
+        const size_t padded = (size + 3) & ~size_t{3};
+        if (!ok || padded < size || static_cast<size_t>(end - pos) < padded) {
+            ok = false;
+            return nullptr;
+        }
+        const uint8_t* data = pos;
+        pos += padded;
+        return data;
+    }
+};
+
+// Entries smaller than this are read; mapping and unmapping them costs more than the copy
+constexpr size_t kMapThreshold = 64 * 1024;
+
+/**
+ * @brief The bytes of an entry file: mapped if large, else read into a buffer.
+ */
+class EntryImage {
+public:
+    ~EntryImage() {
+        if (mapping != MAP_FAILED) munmap(mapping, length);
+    }
+
+    /**
+     * @brief Reads or maps the whole file.
+     * @param fd Open file descriptor; the caller closes it.
+     * @return False if the file is unreadable or smaller than a header.
+     */
+    bool load(int fd) {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(TranslationFileHeader)) return false;
+        length = static_cast<size_t>(info.st_size);
+        if (length >= kMapThreshold) {
+            mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            bytes = static_cast<const uint8_t*>(mapping);
+            return mapping != MAP_FAILED;
+        }
+        buffer.resize(length);
+        if (pread(fd, buffer.data(), length, 0) != static_cast<ssize_t>(length)) return false;
+        bytes = buffer.data();
+        return true;
+    }
+
+    const uint8_t* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    void* mapping = MAP_FAILED;
+    std::vector<uint8_t> buffer;
+    const uint8_t* bytes = nullptr;
+    size_t length = 0;
+};
+
+/**
+ * @brief Hashes a range of 32-bit words, two at a time.
+ *
+ * Only names entry files; the instructions themselves are compared on lookup.
+ */
+uint64_t hashWords(const uint32_t* words, size_t count, uint64_t hash) {
+    size_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        hash = (hash ^ (words[i] | uint64_t{words[i + 1]} << 32)) * 0x9E3779B97F4A7C15ull;
+        hash ^= hash >> 29;
+    }
+    if (i < count) hash = (hash ^ words[i]) * 0x9E3779B97F4A7C15ull;
+    return hash ^ (hash >> 32);
+}
+
+/**
+ * @brief Packs the boolean parts of a key into TranslationFileHeader::options.
+ */
+uint32_t keyOptions(const TranslationKey& key) {
+    return (key.fusion ? 1u : 0u) | (key.reduction ? 2u : 0u);
+}
+
+bool hasSuffix(const std::string& name, const std::string& suffix) {
+    return name.size() >= suffix.size() && name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief Parses the sections after the instructions.
+ *
+ * @param in Positioned after the instructions.
+ * @param header The validated header.
+ * @param translation Receives the parsed translation.
+ * @return False if a section is malformed or an index is out of range.
+ */
+bool readSections(Reader& in, const TranslationFileHeader& header, ProgramTranslation& translation) {
+    const uint32_t count = header.instruction_count;
+    translation.verification.issues.resize(header.issue_count);
+    for (VerificationIssue& issue : translation.verification.issues) {
+        issue.index = in.u32();
+        const uint32_t opcode = in.u32();
+        const uint32_t length = in.u32();
+        const uint8_t* message = in.take(length);
+        if (!message || issue.index >= count || opcode >= kOpcodeCount) return false;
+        issue.opcode = static_cast<Opcode>(opcode);
+        issue.message.assign(reinterpret_cast<const char*>(message), length);
+    }
+    translation.verification.runtime_checks.resize(header.runtime_check_count);
+    for (size_t& index : translation.verification.runtime_checks) {
+        index = in.u32();
+        if (index >= count) return false;
+    }
+    translation.reductions.resize(header.reduction_count);
+    for (ReductionLoop& loop : translation.reductions) {
+        loop.head = in.u32();
+        loop.length = in.u32();
+        loop.pointer = in.u32();
+        loop.counter = in.u32();
+        loop.sum = in.u32();
+        loop.value = in.u32();
+        loop.one = in.u32();
+        loop.flag = in.u32();
+        loop.carry_exit = in.u32() != 0;
+        if (uint64_t(loop.head) + loop.length > count) return false;
+    }
+    if (header.packed_count != 0 && header.packed_count != uint64_t(count) + 1) return false;
+    translation.packed.resize(header.packed_count);
+    for (PackedInstruction& p : translation.packed) {
+        p.imm = in.u32();
+        const uint8_t* fields = in.take(4);
+        if (!fields || fields[3] >= static_cast<uint8_t>(DecodedOp::COUNT)) return false;
+        p.x = fields[0];
+        p.y = fields[1];
+        p.z = fields[2];
+        p.op = static_cast<DecodedOp>(fields[3]);
+    }
+    if (header.jit_entry_count != 0) {
+        if (header.jit_entry_count != uint64_t(count) + 2) return false;
+        std::vector<uint32_t> entry_offsets(header.jit_entry_count);
+        for (uint32_t& offset : entry_offsets) offset = in.u32();
+        const uint8_t* code = in.take(header.jit_code_length);
+        if (!code) return false;
+        translation.jit = JitProgram::load(code, header.jit_code_length, std::move(entry_offsets),
+                                           header.jit_block_count);
+        if (!translation.jit) return false;
+    }
+    return in.ok && in.pos == in.end && (header.packed_count != 0 || header.jit_entry_count != 0);
+}
+
+}  // namespace
+
+/**
+ * @brief Creates the cache directory if it does not exist.
+ *
+ * @param options Directory and limits.
+ */
+TranslationCache::TranslationCache(TranslationCacheOptions options) : settings(std::move(options)) {
+    if (settings.directory.empty() || !hostIsLittleEndian()) return;
+    if (::mkdir(settings.directory.c_str(), 0755) != 0 && errno != EEXIST) return;
+    struct stat info;
+    open = ::stat(settings.directory.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+/**
+ * @brief Names the entry file after a hash of the instructions, the key and the translation version.
+ *
+ * @param code The program's first instruction.
+ * @param count Number of instructions.
+ * @param key The machine configuration.
+ * @return The path inside the cache directory.
+ */
+std::string TranslationCache::entryPath(const Instruction* code, size_t count, const TranslationKey& key) const {
+    const uint32_t fields[] = {kTranslationCacheVersion, translationLayout(), key.engine, key.register_count,
+                               static_cast<uint32_t>(key.data_size), static_cast<uint32_t>(key.data_size >> 32),
+                               keyOptions(key)};
+    uint64_t hash = hashWords(fields, sizeof(fields) / sizeof(uint32_t), 14695981039346656037ull);
+    hash = hashWords(reinterpret_cast<const uint32_t*>(code), count * sizeof(Instruction) / sizeof(uint32_t), hash);
+    char name[17];
+    for (int i = 0; i < 16; ++i) name[i] = "0123456789abcdef"[(hash >> (60 - 4 * i)) & 0xF];
+    name[16] = '\0';
+    return settings.directory + "/" + name + kEntrySuffix;
+}
+
+/**
+ * @brief Reads or maps the entry file, validates it and parses the translation.
+ *
+ * @param code The program's first instruction.
+ * @param count Number of instructions.
+ * @param key The machine configuration.
+ * @param translation Receives the translation on a hit.
+ * @return True on a hit.
+ */
+bool TranslationCache::lookup(const Instruction* code, size_t count, const TranslationKey& key,
+                              ProgramTranslation& translation) {
+    const std::string path = entryPath(code, count, key);
+    const int fd = open ? ::open(path.c_str(), O_RDONLY) : -1;
+    if (fd < 0) {
+        ++misses;
+        return false;
+    }
+    auto reject = [this] {
+        ++rejected;
+        ++misses;
+        return false;
+    };
+    EntryImage image;
+    const bool loaded = image.load(fd);
+    ::close(fd);  // a mapping keeps the file referenced
+    if (!loaded) return reject();
+
+    TranslationFileHeader header;
+    std::memcpy(&header, image.data(), sizeof(header));
+    const size_t code_size = count * sizeof(Instruction);
+    if (header.magic != kTranslationFileMagic || header.version != kTranslationCacheVersion ||
+        header.header_size != sizeof(TranslationFileHeader) || header.layout != translationLayout() ||
+        header.engine != key.engine || header.register_count != key.register_count ||
+        header.data_size != key.data_size || header.options != keyOptions(key) ||
+        header.instruction_count != count || header.payload_size != image.size() - sizeof(header) ||
+        header.payload_size % sizeof(uint32_t) != 0 || header.payload_size < code_size) {
+        return reject();
+    }
+    const uint8_t* payload = image.data() + sizeof(header);
+    if (count != 0 && std::memcmp(payload, code, code_size) != 0) {
+        return reject();  // another program with the same hash
+    }
+    // The instructions were just compared; the checksum covers the translation after them
+    if (programFileChecksum(reinterpret_cast<const uint32_t*>(payload + code_size),
+                            (header.payload_size - code_size) / sizeof(uint32_t)) != header.checksum) {
+        return reject();
+    }
+
+    Reader in{payload + code_size, payload + header.payload_size};
+    ProgramTranslation parsed;
+    if (!readSections(in, header, parsed)) return reject();
+
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);  // most recently used
+    translation = std::move(parsed);
+    ++hits;
+    return true;
+}
+
+/**
+ * @brief Serialises a translation to a temporary file, renames it into place and evicts old entries.
+ *
+ * @param code The program's first instruction.
+ * @param count Number of instructions.
+ * @param key The machine configuration.
+ * @param translation The translation to save.
+ * @return True if the entry was written.
+ */
+bool TranslationCache::store(const Instruction* code, size_t count, const TranslationKey& key,
+                             const ProgramTranslation& translation) {
+    if (!open || count > UINT32_MAX) return false;
+    Writer out;
+    out.raw(code, count * sizeof(Instruction));
+    for (const VerificationIssue& issue : translation.verification.issues) {
+        out.u32(static_cast<uint32_t>(issue.index));
+        out.u32(static_cast<uint32_t>(issue.opcode));
+        out.u32(static_cast<uint32_t>(issue.message.size()));
+        out.raw(issue.message.data(), issue.message.size());
+    }
+    for (size_t index : translation.verification.runtime_checks) out.u32(static_cast<uint32_t>(index));
+    for (const ReductionLoop& loop : translation.reductions) {
+        const uint32_t fields[] = {loop.head, loop.length, loop.pointer, loop.counter, loop.sum,
+                                   loop.value, loop.one, loop.flag, loop.carry_exit ? 1u : 0u};
+        for (uint32_t field : fields) out.u32(field);
+    }
+    for (const PackedInstruction& p : translation.packed) {
+        out.u32(p.imm);
+        const uint8_t fields[] = {p.x, p.y, p.z, static_cast<uint8_t>(p.op)};
+        out.raw(fields, sizeof(fields));
+    }
+    if (translation.jit) {
+        for (uint32_t offset : translation.jit->entryOffsets()) out.u32(offset);
+        out.raw(translation.jit->codeData(), translation.jit->codeLength());
+    }
+
+    TranslationFileHeader header;
+    header.engine = key.engine;
+    header.layout = translationLayout();
+    header.register_count = key.register_count;
+    header.options = keyOptions(key);
+    header.data_size = key.data_size;
+    header.instruction_count = static_cast<uint32_t>(count);
+    header.issue_count = static_cast<uint32_t>(translation.verification.issues.size());
+    header.runtime_check_count = static_cast<uint32_t>(translation.verification.runtime_checks.size());
+    header.reduction_count = static_cast<uint32_t>(translation.reductions.size());
+    header.packed_count = static_cast<uint32_t>(translation.packed.size());
+    if (translation.jit) {
+        header.jit_entry_count = static_cast<uint32_t>(translation.jit->entryOffsets().size());
+        header.jit_code_length = static_cast<uint32_t>(translation.jit->codeLength());
+        header.jit_block_count = static_cast<uint32_t>(translation.jit->blockCount());
+    }
+    if (out.bytes.size() > UINT32_MAX || sizeof(header) + out.bytes.size() > settings.max_bytes) return false;
+    header.payload_size = static_cast<uint32_t>(out.bytes.size());
+    const size_t code_size = count * sizeof(Instruction);
+    header.checksum = programFileChecksum(reinterpret_cast<const uint32_t*>(out.bytes.data() + code_size),
+                                          (out.bytes.size() - code_size) / sizeof(uint32_t));
+
+    const std::string path = entryPath(code, count, key);
+    const std::string temporary = settings.directory + "/" + kTemporaryPrefix + std::to_string(getpid()) + "-" +
+                                  std::to_string(temporary_files++);
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    if (!file) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(out.bytes.data()), static_cast<std::streamsize>(out.bytes.size()));
+    file.close();
+    if (!file || std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    ++stores;
+    evict();
+    return true;
+}
+
+/**
+ * @brief Deletes the least recently used entries until the directory is within both limits.
+ */
+void TranslationCache::evict() {
+    struct Entry {
+        std::string path;
+        uint64_t size;
+        int64_t used;  // modification time in nanoseconds
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    DIR* dir = opendir(settings.directory.c_str());
+    if (!dir) return;
+    while (const dirent* item = readdir(dir)) {
+        const std::string name = item->d_name;
+        if (!hasSuffix(name, kEntrySuffix)) continue;
+        const std::string path = settings.directory + "/" + name;
+        struct stat info;
+        if (::stat(path.c_str(), &info) != 0) continue;  // deleted by another process
+#ifdef __APPLE__
+        const timespec& modified = info.st_mtimespec;
+#else
+        const timespec& modified = info.st_mtim;
+#endif
+        entries.push_back({path, static_cast<uint64_t>(info.st_size),
+                           int64_t{modified.tv_sec} * 1000000000 + modified.tv_nsec});
+        total += static_cast<uint64_t>(info.st_size);
+    }
+    closedir(dir);
+    if (total <= settings.max_bytes && entries.size() <= settings.max_entries) return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    size_t remaining = entries.size();
+    for (const Entry& entry : entries) {
+        if (total <= settings.max_bytes && remaining <= settings.max_entries) break;
+        if (std::remove(entry.path.c_str()) == 0) ++evictions;
+        total -= entry.size;
+        --remaining;
+    }
+}
+
+/**
+ * @brief Deletes every entry and any temporary file left by an interrupted store.
+ */
+void TranslationCache::clear() {
+    if (!open) return;
+    std::vector<std::string> paths;
+    DIR* dir = opendir(settings.directory.c_str());
+    if (!dir) return;
+    while (const dirent* item = readdir(dir)) {
+        const std::string name = item->d_name;
+        if (hasSuffix(name, kEntrySuffix) || name.compare(0, std::strlen(kTemporaryPrefix), kTemporaryPrefix) == 0) {
+            paths.push_back(settings.directory + "/" + name);
+        }
+    }
+    closedir(dir);
+    for (const std::string& path : paths) std::remove(path.c_str());
+}
+
+/**
+ * @brief Gets the counters.
+ *
+ * @return A copy of the counters.
+ */
+TranslationCacheStats TranslationCache::stats() const {
+    TranslationCacheStats result;
+    result.hits = hits;
+    result.misses = misses;
+    result.rejected = rejected;
+    result.stores = stores;
+    result.evictions = evictions;
+    return result;
+}
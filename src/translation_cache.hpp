@@ -0,0 +1,221 @@
+/**
+ * @file translation_cache.hpp
+ * @brief Declares TranslationCache, a persistent on-disk cache of translated programs.
+ *
+ * Loading a program on the threaded or JIT engine verifies, decodes, fuses and
+ * packs it, and on the JIT engine also translates it to native code. A
+ * TranslationCache saves the result in a directory, one file per program and
+ * machine configuration, so that a later process loading the same program maps
+ * the file and skips that work.
+ *
+ * An entry file is named after a 64-bit hash of its key: the instructions, the
+ * engine, the register count, the data memory size, whether fusion and
+ * reduction offloading are enabled, and kTranslationCacheVersion. Its layout:
+ *
+ * | Offset | Size            | Content                                                  |
+ * |--------|-----------------|----------------------------------------------------------|
+ * | 0      | 72              | TranslationFileHeader                                    |
+ * | 72     | 16 * count      | The program's instructions, compared on every lookup     |
+ * | ...    | variable        | Verification issues (index, opcode, length, message)     |
+ * | ...    | 4 * checks      | Runtime-checked instruction indices                      |
+ * | ...    | 36 * reductions | ReductionLoop records, nine u32 fields each              |
+ * | ...    | 8 * packed      | PackedInstruction records without the handler            |
+ * | ...    | 4 * entries     | JitProgram::entryOffsets()                               |
+ * | ...    | code bytes      | JitProgram::codeData(), padded to 4 bytes                |
+ *
+ * All fields are little-endian and every section is padded to 4 bytes. A file
+ * is used only if its header, key and instructions match and the checksum over
+ * the sections after the instructions is correct; anything else is a miss.
+ * Large entries are mapped rather than read, since only their sections are
+ * copied out.
+ *
+ * Entries are written to a temporary file and renamed into place, so processes
+ * sharing a directory never see a partial entry. A hit refreshes the file's
+ * modification time; when a store takes the directory over its entry or byte
+ * limit, the least recently used entries are deleted.
+ *
+ * Cached native code is executed without being regenerated: the directory must
+ * be writable only by users trusted to provide executable code.
+ */
+
+#pragma once
+
+#include "decoder.hpp"
+#include "instruction.hpp"
+#include "jit.hpp"
+#include "reduction.hpp"
+#include "verifier.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief File magic, "RTRC" when read as bytes. */
+constexpr uint32_t kTranslationFileMagic = 0x43525452;
+
+/**
+ * @brief Version of the cached translations.
+ *
+ * Part of every key; bump it whenever the verifier, decoder, fusion, packing
+ * or JIT output changes, so that entries made by older builds are not used.
+ */
+constexpr uint16_t kTranslationCacheVersion = 1;
+
+/**
+ * @struct TranslationFileHeader
+ * @brief Fixed-size header at the start of every cache entry file.
+ */
+struct TranslationFileHeader {
+    uint32_t magic = kTranslationFileMagic;      /**< Must equal kTranslationFileMagic */
+    uint16_t version = kTranslationCacheVersion; /**< Translation version */
+    uint16_t header_size = 72;                   /**< Size of this header in bytes */
+    uint32_t layout = 0;                         /**< translationLayout() of the writing build */
+    uint32_t engine = 0;                         /**< Key: ExecutionEngine */
+    uint32_t register_count = 0;                 /**< Key: number of data registers */
+    uint32_t options = 0;                        /**< Key: bit 0 fusion, bit 1 reduction offloading */
+    uint64_t data_size = 0;                      /**< Key: data memory size in words */
+    uint32_t instruction_count = 0;              /**< Number of program instructions */
+    uint32_t issue_count = 0;                    /**< Verification issues */
+    uint32_t runtime_check_count = 0;            /**< Runtime-checked instruction indices */
+    uint32_t reduction_count = 0;                /**< Reduction loops */
+    uint32_t packed_count = 0;                   /**< Packed records, including the EXIT sentinel */
+    uint32_t jit_entry_count = 0;                /**< JIT entry offsets (0 if not compiled) */
+    uint32_t jit_code_length = 0;                /**< JIT code bytes */
+    uint32_t jit_block_count = 0;                /**< JIT basic blocks */
+    uint32_t payload_size = 0;                   /**< Bytes after the header */
+    uint32_t checksum = 0;                       /**< programFileChecksum() of the payload after the instructions */
+};
+
+static_assert(sizeof(TranslationFileHeader) == 72, "translation file header layout");
+
+/**
+ * @struct TranslationKey
+ * @brief The machine configuration a translation was made for, besides the program itself.
+ */
+struct TranslationKey {
+    uint32_t engine = 0;          /**< ExecutionEngine, as an integer */
+    uint32_t register_count = 0;  /**< Number of data registers */
+    uint64_t data_size = 0;       /**< Data memory size in words */
+    bool fusion = false;          /**< Whether fusion was enabled */
+    bool reduction = false;       /**< Whether reduction loops were recognised */
+};
+
+/**
+ * @struct ProgramTranslation
+ * @brief Everything RiscMachine derives from a program at load time.
+ */
+struct ProgramTranslation {
+    VerificationReport verification;        /**< Result of verifyProgram() */
+    std::vector<ReductionLoop> reductions;  /**< Result of findReductionLoops() */
+    std::vector<PackedInstruction> packed;  /**< Threaded engine code; handlers not yet bound */
+    std::shared_ptr<const JitProgram> jit;  /**< Native code (JIT engine only) */
+};
+
+/**
+ * @struct TranslationCacheOptions
+ * @brief Where a TranslationCache keeps its entries and how much it may keep.
+ */
+struct TranslationCacheOptions {
+    std::string directory;                 /**< Entry directory; created if missing (its parent must exist) */
+    uint64_t max_bytes = uint64_t{256} << 20; /**< Total size of all entries */
+    size_t max_entries = 4096;             /**< Number of entries */
+    /** Shorter programs are translated afresh: a lookup costs a few system calls, more than translating them */
+    size_t min_instructions = 256;
+};
+
+/**
+ * @struct TranslationCacheStats
+ * @brief Counters of one TranslationCache object since it was created.
+ */
+struct TranslationCacheStats {
+    uint64_t hits = 0;       /**< Lookups answered from an entry */
+    uint64_t misses = 0;     /**< Lookups with no usable entry */
+    uint64_t rejected = 0;   /**< Misses because an entry was corrupt or belonged to another key */
+    uint64_t stores = 0;     /**< Entries written */
+    uint64_t evictions = 0;  /**< Entries deleted to respect the limits */
+};
+
+/**
+ * @class TranslationCache
+ * @brief Saves and restores ProgramTranslations in a directory.
+ *
+ * One object may be shared by many machines and used from several threads;
+ * several processes may share one directory.
+ */
+class TranslationCache {
+public:
+    /**
+     * @brief Opens (and if needed creates) a cache directory.
+     * @param options Directory and limits.
+     */
+    explicit TranslationCache(TranslationCacheOptions options);
+
+    /**
+     * @brief Checks whether the directory exists and is usable.
+     * @return False if it could not be created; every lookup then misses and nothing is stored.
+     */
+    bool isOpen() const { return open; }
+
+    /**
+     * @brief Looks up the translation of a program.
+     *
+     * @param code The program's first instruction.
+     * @param count Number of instructions.
+     * @param key The machine configuration.
+     * @param translation Receives the translation on a hit.
+     * @return True on a hit.
+     */
+    bool lookup(const Instruction* code, size_t count, const TranslationKey& key, ProgramTranslation& translation);
+
+    /**
+     * @brief Saves the translation of a program, then evicts entries beyond the limits.
+     *
+     * @param code The program's first instruction.
+     * @param count Number of instructions.
+     * @param key The machine configuration.
+     * @param translation The translation to save.
+     * @return False if the entry could not be written or alone exceeds max_bytes.
+     */
+    bool store(const Instruction* code, size_t count, const TranslationKey& key,
+               const ProgramTranslation& translation);
+
+    /**
+     * @brief Deletes every entry in the directory.
+     */
+    void clear();
+
+    /**
+     * @brief Gets the path of the entry file for a program and key.
+     * @param code The program's first instruction.
+     * @param count Number of instructions.
+     * @param key The machine configuration.
+     * @return The path, whether or not the entry exists.
+     */
+    std::string entryPath(const Instruction* code, size_t count, const TranslationKey& key) const;
+
+    /**
+     * @brief Gets the counters.
+     * @return A copy of the counters.
+     */
+    TranslationCacheStats stats() const;
+
+    /**
+     * @brief Gets the directory and limits.
+     * @return The options the cache was created with.
+     */
+    const TranslationCacheOptions& options() const { return settings; }
+
+private:
+    void evict();
+
+    TranslationCacheOptions settings;
+    bool open = false;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> rejected{0};
+    std::atomic<uint64_t> stores{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> temporary_files{0};  // names temporary files uniquely within the process
+};
@@ -0,0 +1,77 @@
+/**
+ * @file vector_unit.cpp
+ * @brief Implementation of vector loads and stores.
+ */
+
+#include "vector_unit.hpp"
+#include <cstring>
+
+namespace {
+
+/**
+ * @brief Checks that every element address of a vector access is in data memory.
+ *
+ * @param memory Data memory.
+ * @param address Address of element 0.
+ * @param stride Distance between elements.
+ * @param length Number of elements (at least 1).
+ * @return True if the last (highest) element address is in range.
+ */
+bool inRange(const DataMemory& memory, uint32_t address, uint32_t stride, uint32_t length) {
+    return uint64_t(address) + uint64_t(length - 1) * stride < memory.size();
+}
+
+/**
+ * @brief Checks whether a contiguous access stays within one page.
+ */
+bool withinPage(uint32_t address, uint32_t stride, uint32_t length) {
+    return stride == 1 && (address & DataMemory::kPageMask) + length <= DataMemory::kPageWords;
+}
+
+}  // namespace
+
+/**
+ * @brief Loads the active elements of a register; a contiguous load within one page is one copy.
+ *
+ * @param v Destination register.
+ * @param memory Data memory.
+ * @param address Address of element 0.
+ * @param stride Distance between elements, in words.
+ * @return False if an element address is outside data memory.
+ */
+bool VectorUnit::load(uint32_t v, const DataMemory& memory, uint32_t address, uint32_t stride) {
+    const uint32_t length = active_length;
+    if (length == 0) return true;
+    if (!inRange(memory, address, stride, length)) return false;
+    Register& dst = registers[v];
+    if (withinPage(address, stride, length)) {
+        std::memcpy(dst.data(), memory.readPage(address) + (address & DataMemory::kPageMask),
+                    length * sizeof(uint32_t));
+    } else {
+        for (uint32_t i = 0; i < length; ++i) dst[i] = memory.read(address + i * stride);
+    }
+    return true;
+}
+
+/**
+ * @brief Stores the active elements of a register; a contiguous store within one page is one copy.
+ *
+ * @param v Source register.
+ * @param memory Data memory.
+ * @param address Address of element 0.
+ * @param stride Distance between elements, in words.
+ * @return False if an element address is outside data memory.
+ */
+bool VectorUnit::store(uint32_t v, DataMemory& memory, uint32_t address, uint32_t stride) const {
+    const uint32_t length = active_length;
+    if (length == 0) return true;
+    if (!inRange(memory, address, stride, length)) return false;
+    const Register& src = registers[v];
+    if (withinPage(address, stride, length)) {
+        std::memcpy(memory.writePage(address) + (address & DataMemory::kPageMask), src.data(),
+                    length * sizeof(uint32_t));
+    } else {
+        for (uint32_t i = 0; i < length; ++i) memory.write(address + i * stride, src[i]);
+    }
+    return true;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file vector_unit.hpp
+ * @brief Declares VectorUnit, the vector register file of a RiscMachine.
+ *
+ * A machine has kRegisters vector registers V0–V7 of kMaxLength 32-bit
+ * elements. The maximum vector length (VLMAX) is configurable from 1 to
+ * kMaxLength elements. VSETVL sets the active length vl = min(requested, VLMAX),
+ * and every vector instruction processes the elements [0, vl). Elements at and
+ * beyond vl keep their values, so a strip-mined loop can accumulate into a
+ * register with a short last strip and reduce it at full length afterwards.
+ *
+ * The element loops always cover kMaxLength elements and select on the element
+ * index, so they compile to straight-line SIMD code: four SSE2 operations per
+ * register on baseline x86-64, two AVX2 operations with -DRISC_NATIVE_ARCH=ON.
+ */
+
+#pragma once
+
+#include "data_memory.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdint>
+
+/**
+ * @class VectorUnit
+ * @brief Vector registers, VLMAX and the active vector length.
+ *
+ * Register indices passed to the operations must be less than kRegisters.
+ */
+class VectorUnit {
+public:
+    static constexpr uint32_t kRegisters = 8;       /**< Number of vector registers */
+    static constexpr uint32_t kMaxLength = 16;      /**< Largest supported VLMAX, in elements */
+    static constexpr uint32_t kDefaultLength = 8;   /**< VLMAX of a new machine (one AVX2 register) */
+
+    using Register = std::array<uint32_t, kMaxLength>;
+
+    /**
+     * @brief Gets VLMAX.
+     * @return The maximum vector length, in elements.
+     */
+    uint32_t maxLength() const { return max_length; }
+
+    /**
+     * @brief Sets VLMAX and makes it the active length.
+     * @param elements Requested maximum length; clamped to [1, kMaxLength].
+     */
+    void setMaxLength(uint32_t elements) {
+        max_length = std::min(std::max(elements, 1u), kMaxLength);
+        active_length = max_length;
+    }
+
+    /**
+     * @brief Gets the active vector length.
+     * @return vl, in elements.
+     */
+    uint32_t length() const { return active_length; }
+
+    /**
+     * @brief Sets the active vector length (VSETVL).
+     * @param requested Number of elements the program still has to process.
+     * @return The new active length, min(@p requested, VLMAX).
+     */
+    uint32_t setLength(uint32_t requested) {
+        active_length = std::min(requested, max_length);
+        return active_length;
+    }
+
+    /**
+     * @brief Gets a vector register.
+     * @param v Register index.
+     * @return Its kMaxLength elements.
+     */
+    const Register& at(uint32_t v) const { return registers[v]; }
+    Register& at(uint32_t v) { return registers[v]; }
+
+    /**
+     * @brief Zeroes every register and makes VLMAX the active length again.
+     */
+    void reset() {
+        registers = {};
+        active_length = max_length;
+    }
+
+    /**
+     * @brief Loads vl elements from RAM[address + i * stride] into a register (VLOAD).
+     *
+     * @param v Destination register.
+     * @param memory Data memory.
+     * @param address Address of element 0.
+     * @param stride Distance between elements, in words (1: contiguous).
+     * @return False, leaving the register unchanged, if an element lies outside data memory.
+     */
+    bool load(uint32_t v, const DataMemory& memory, uint32_t address, uint32_t stride);
+
+    /**
+     * @brief Stores vl elements of a register to RAM[address + i * stride] (VSTORE).
+     *
+     * Elements are stored in ascending order, so with a stride of 0 the last one wins.
+     *
+     * @param v Source register.
+     * @param memory Data memory.
+     * @param address Address of element 0.
+     * @param stride Distance between elements, in words (1: contiguous).
+     * @return False, storing nothing, if an element lies outside data memory.
+     */
+    bool store(uint32_t v, DataMemory& memory, uint32_t address, uint32_t stride) const;
+
+    /** @brief V[d] = V[a] + V[b] element-wise (VADD). */
+    void add(uint32_t d, uint32_t a, uint32_t b) {
+        combine(d, a, b, [](uint32_t x, uint32_t y) { return x + y; });
+    }
+
+    /** @brief V[d] = V[a] - V[b] element-wise (VSUB). */
+    void sub(uint32_t d, uint32_t a, uint32_t b) {
+        combine(d, a, b, [](uint32_t x, uint32_t y) { return x - y; });
+    }
+
+    /** @brief V[d] = V[a] * V[b] element-wise, keeping the low 32 bits (VMUL). */
+    void mul(uint32_t d, uint32_t a, uint32_t b) {
+        combine(d, a, b, [](uint32_t x, uint32_t y) { return x * y; });
+    }
+
+    /**
+     * @brief Sums the first vl elements of a register (VREDUCE).
+     * @param v Source register.
+     * @return The wrapping 32-bit sum.
+     */
+    uint32_t reduce(uint32_t v) const {
+        const Register& src = registers[v];
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < kMaxLength; ++i) sum += i < active_length ? src[i] : 0;
+        return sum;
+    }
+
+private:
+    /**
+     * @brief Applies a binary operation to the first vl elements.
+     *
+     * The result is built in a local so the loop does not need alias checks
+     * when @p d is also a source.
+     */
+    template <typename Op>
+    void combine(uint32_t d, uint32_t a, uint32_t b, Op op) {
+        const Register& lhs = registers[a];
+        const Register& rhs = registers[b];
+        Register& dst = registers[d];
+        alignas(64) Register result;
+        for (uint32_t i = 0; i < kMaxLength; ++i) result[i] = i < active_length ? op(lhs[i], rhs[i]) : dst[i];
+        dst = result;
+    }
+
+    alignas(64) std::array<Register, kRegisters> registers{};
+    uint32_t max_length = kDefaultLength;
+    uint32_t active_length = kDefaultLength;
+};
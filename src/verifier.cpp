@@ -0,0 +1,236 @@
+/**
+ * @file verifier.cpp
+ * @brief Implementation of the load-time program verifier.
+ */
+
+#include "verifier.hpp"
+#include "vector_unit.hpp"
+#include <sstream>
+
+/**
+ * @brief Formats all issues, one per line.
+ *
+ * @return The diagnostics.
+ */
+std::string VerificationReport::toString() const {
+    std::ostringstream out;
+    for (const VerificationIssue& issue : issues) {
+        out << issue.index << ": " << opcodeName(issue.opcode) << ": " << issue.message << '\n';
+    }
+    return out.str();
+}
+
+namespace {
+
+/**
+ * @brief Collects the issues of one instruction.
+ */
+class InstructionChecker {
+public:
+    InstructionChecker(VerificationReport& report, size_t index, const Instruction& instr,
+                       size_t register_count, size_t data_size, size_t program_size)
+        : report(report), index(index), instr(instr), register_count(register_count),
+          data_size(data_size), program_size(program_size) {}
+
+    void reg(uint32_t value, const char* role) {
+        if (value >= register_count) {
+            std::ostringstream message;
+            message << role << " register R" << value << " out of range (" << register_count << " registers)";
+            add(message.str());
+        }
+    }
+
+    void vreg(uint32_t value, const char* role) {
+        if (value >= VectorUnit::kRegisters) {
+            std::ostringstream message;
+            message << role << " vector register V" << value << " out of range (" << VectorUnit::kRegisters
+                    << " registers)";
+            add(message.str());
+        }
+    }
+
+    void address(uint32_t value) {
+        if (value >= data_size) {
+            std::ostringstream message;
+            message << "address " << value << " outside data memory (" << data_size << " words)";
+            add(message.str());
+        }
+    }
+
+    void target(uint32_t value) {
+        if (value >= program_size) {
+            std::ostringstream message;
+            message << "jump target " << value << " outside program (" << program_size << " instructions)";
+            add(message.str());
+        }
+    }
+
+    void add(const std::string& message) {
+        report.issues.push_back({index, instr.opcode, message});
+    }
+
+private:
+    VerificationReport& report;
+    size_t index;
+    const Instruction& instr;
+    size_t register_count;
+    size_t data_size;
+    size_t program_size;
+};
+
+}  // namespace
+
+/**
+ * @brief Verifies every instruction of a program.
+ *
+ * Mirrors the operand checks of RiscMachine::execute: each check that execute()
+ * would perform at run time is either proven here or reported as an issue.
+ *
+ * @param program Pointer to the first instruction.
+ * @param count Number of instructions.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The verification report.
+ */
+VerificationReport verifyProgram(const Instruction* program, size_t count,
+                                 size_t register_count, size_t data_size) {
+    VerificationReport report;
+    for (size_t i = 0; i < count; ++i) {
+        const Instruction& instr = program[i];
+        InstructionChecker check(report, i, instr, register_count, data_size, count);
+
+        switch (instr.opcode) {
+            case Opcode::HALT:
+                break;
+
+            case Opcode::LOAD:
+                check.reg(instr.dst, "destination");
+                if (instr.src2 == 0) {
+                    check.address(instr.src1);
+                } else if (instr.src2 == 1) {
+                    check.reg(instr.src1, "address");
+                    report.runtime_checks.push_back(i);
+                } else if (instr.src2 != 2) {
+                    check.add("unknown addressing mode " + std::to_string(instr.src2));
+                }
+                break;
+
+            case Opcode::STORE:
+                check.address(instr.dst);
+                check.reg(instr.src1, "source");
+                break;
+
+            case Opcode::ADD:
+            case Opcode::SUB:
+            case Opcode::MUL:
+            case Opcode::DIV:
+                check.reg(instr.dst, "destination");
+                check.reg(instr.src1, "source");
+                check.reg(instr.src2, "source");
+                break;
+
+            case Opcode::CMP:
+                check.reg(instr.src1, "source");
+                check.reg(instr.src2, "source");
+                break;
+
+            case Opcode::JMP:
+                check.target(instr.dst);
+                if (instr.src1 > 1) {
+                    check.add("unknown jump condition " + std::to_string(instr.src1));
+                }
+                break;
+
+            case Opcode::MOV:
+                check.reg(instr.dst, "destination");
+                check.reg(instr.src1, "source");
+                break;
+
+            case Opcode::CHECK_FLAG:
+                check.reg(instr.dst, "destination");
+                if (instr.src1 > 4) {
+                    check.add("unknown flag index " + std::to_string(instr.src1));
+                }
+                break;
+
+            case Opcode::ATOMIC_ADD:
+            case Opcode::CAS:
+                check.reg(instr.dst, "destination");
+                check.reg(instr.src1, "address");
+                check.reg(instr.src2, "source");
+                report.runtime_checks.push_back(i);
+                break;
+
+            case Opcode::FENCE:
+                break;
+
+            case Opcode::HART_ID:
+                check.reg(instr.dst, "destination");
+                break;
+
+            case Opcode::VLOAD:
+                check.vreg(instr.dst, "destination");
+                check.reg(instr.src1, "address");
+                check.reg(instr.src2, "stride");
+                report.runtime_checks.push_back(i);
+                break;
+
+            case Opcode::VSTORE:
+                check.reg(instr.dst, "address");
+                check.vreg(instr.src1, "source");
+                check.reg(instr.src2, "stride");
+                report.runtime_checks.push_back(i);
+                break;
+
+            case Opcode::VADD:
+            case Opcode::VSUB:
+            case Opcode::VMUL:
+                check.vreg(instr.dst, "destination");
+                check.vreg(instr.src1, "source");
+                check.vreg(instr.src2, "source");
+                break;
+
+            case Opcode::VREDUCE:
+                check.reg(instr.dst, "destination");
+                check.vreg(instr.src1, "source");
+                break;
+
+            case Opcode::VSETVL:
+                check.reg(instr.dst, "destination");
+                check.reg(instr.src1, "source");
+                break;
+
+            case Opcode::MEMCPY:
+            case Opcode::MEMSET:
+            case Opcode::MEMCMP:
+                check.reg(instr.dst, "address");
+                check.reg(instr.src1, instr.opcode == Opcode::MEMSET ? "value" : "address");
+                check.reg(instr.src2, "count");
+                report.runtime_checks.push_back(i);
+                break;
+
+            case Opcode::HOSTCALL:
+                // The binding is looked up at run time
+                report.runtime_checks.push_back(i);
+                break;
+
+            default:
+                check.add("unknown opcode " + std::to_string(static_cast<int>(instr.opcode)));
+                break;
+        }
+    }
+    return report;
+}
+
+/**
+ * @brief Verifies a program stored in a vector.
+ *
+ * @param program The program to verify.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The verification report.
+ */
+VerificationReport verifyProgram(const std::vector<Instruction>& program,
+                                 size_t register_count, size_t data_size) {
+    return verifyProgram(program.data(), program.size(), register_count, data_size);
+}
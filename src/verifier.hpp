@@ -0,0 +1,69 @@
+/**
+ * @file verifier.hpp
+ * @brief Declares the load-time program verifier.
+ *
+ * The verifier checks every instruction once, before execution, against the
+ * machine it will run on: register indices, immediate data addresses, jump
+ * targets, addressing modes, jump conditions and flag indices. A program in
+ * which every operand is proven in range can run on the switch engine's
+ * unchecked path. Register-indirect LOAD addresses are only known at run time
+ * and keep their check on both paths.
+ */
+
+#pragma once
+
+#include "instruction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @struct VerificationIssue
+ * @brief One operand that could not be proven valid.
+ */
+struct VerificationIssue {
+    size_t index = 0;      /**< Position of the instruction in the program */
+    Opcode opcode = Opcode::HALT; /**< Opcode of the instruction */
+    std::string message;   /**< Human-readable description of the problem */
+};
+
+/**
+ * @struct VerificationReport
+ * @brief Result of verifying a program.
+ */
+struct VerificationReport {
+    std::vector<VerificationIssue> issues;  /**< Instructions that could not be proven safe */
+    std::vector<size_t> runtime_checks;     /**< Indirect LOADs, atomics, vector and bulk memory accesses and host calls checked at run time */
+
+    /**
+     * @brief Checks whether every operand was proven in range.
+     * @return True if the program may run without per-instruction operand checks.
+     */
+    bool verified() const { return issues.empty(); }
+
+    /**
+     * @brief Formats all issues, one per line.
+     * @return The diagnostics, e.g. "3: ADD: source register R16 out of range (16 registers)".
+     */
+    std::string toString() const;
+};
+
+/**
+ * @brief Verifies a program for a machine of the given dimensions.
+ *
+ * @param program Pointer to the first instruction.
+ * @param count Number of instructions.
+ * @param register_count Number of data registers of the target machine.
+ * @param data_size Size of the data memory of the target machine.
+ * @return The diagnostics for every instruction that could not be proven safe.
+ */
+VerificationReport verifyProgram(const Instruction* program, size_t count,
+                                 size_t register_count, size_t data_size);
+
+/**
+ * @brief Verifies a program stored in a vector.
+ * @see verifyProgram(const Instruction*, size_t, size_t, size_t)
+ */
+VerificationReport verifyProgram(const std::vector<Instruction>& program,
+                                 size_t register_count, size_t data_size);
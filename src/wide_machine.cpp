@@ -0,0 +1,696 @@
+/**
+ * @file wide_machine.cpp
+ * @brief Implementation of the lockstep structure-of-arrays machine.
+ */
+
+#include "wide_machine.hpp"
+#include <algorithm>
+
+/**
+ * @brief Constructs a wide machine with zeroed lanes.
+ *
+ * @param data_size Data memory size of every lane.
+ */
+template <size_t Lanes>
+WideMachine<Lanes>::WideMachine(size_t data_size)
+    : data_size(data_size), memory(data_size * Lanes, 0) {}
+
+/**
+ * @brief Decodes the program once for all lanes and resets the lane state.
+ *
+ * @param program A vector of instructions to load.
+ */
+template <size_t Lanes>
+void WideMachine<Lanes>::loadProgram(const std::vector<Instruction>& program) {
+    decoded = decodeProgram(program, regs.size(), data_size);
+    program_size = static_cast<uint32_t>(program.size());
+    reset();
+}
+
+/**
+ * @brief Resets registers, flags and program counters of all lanes.
+ */
+template <size_t Lanes>
+void WideMachine<Lanes>::reset() {
+    for (Vector& r : regs) r.fill(0);
+    for (Vector& f : flags) f.fill(0);
+    for (auto& v : vregs) {
+        for (Vector& element : v) element.fill(0);
+    }
+    vl.fill(VectorUnit::kDefaultLength);
+    pc.fill(0);
+}
+
+/**
+ * @brief Writes one word of a lane's data memory.
+ *
+ * @param lane The lane to write.
+ * @param address The memory address to set.
+ * @param value The value to write.
+ */
+template <size_t Lanes>
+void WideMachine<Lanes>::setMemoryValue(size_t lane, uint32_t address, uint32_t value) {
+    if (lane < Lanes && address < data_size)
+        memory[static_cast<size_t>(address) * Lanes + lane] = value;
+}
+
+/**
+ * @brief Reads one word of a lane's data memory.
+ *
+ * @param lane The lane to read.
+ * @param address The memory address to read.
+ * @return The stored value, or 0 if lane or address are out of bounds.
+ */
+template <size_t Lanes>
+uint32_t WideMachine<Lanes>::getMemoryValue(size_t lane, uint32_t address) const {
+    if (lane < Lanes && address < data_size)
+        return memory[static_cast<size_t>(address) * Lanes + lane];
+    return 0;
+}
+
+/**
+ * @brief Assembles the status register of one lane from the flag vectors.
+ *
+ * @param lane The lane to read.
+ * @return The lane's flags.
+ */
+template <size_t Lanes>
+StatusRegister WideMachine<Lanes>::getStatusRegister(size_t lane) const {
+    StatusRegister sr{};
+    if (lane >= Lanes) return sr;
+    sr.ZF = flags[0][lane];
+    sr.CF = flags[1][lane];
+    sr.NF = flags[2][lane];
+    sr.OF = flags[3][lane];
+    sr.DF = flags[4][lane];
+    return sr;
+}
+
+/**
+ * @brief Configures the scalar fallback.
+ *
+ * @param min_lanes Minimum useful group size (0 disables the fallback).
+ * @param patience Number of poorly utilised steps tolerated.
+ */
+template <size_t Lanes>
+void WideMachine<Lanes>::setScalarFallback(size_t min_lanes, uint64_t patience) {
+    fallback_min_lanes = min_lanes;
+    fallback_patience = patience;
+}
+
+/**
+ * @brief Gets the counters of the last run.
+ *
+ * @return Vector and scalar step counts.
+ */
+template <size_t Lanes>
+const WideStats& WideMachine<Lanes>::getStats() const {
+    return stats;
+}
+
+/**
+ * @brief Runs all lanes to completion.
+ *
+ * Each step picks the lowest program counter among the active lanes and
+ * executes that instruction for every lane sitting at it. Lanes that branched
+ * ahead wait until the group reaches them again, which reconverges both sides
+ * of an if/else and the exit of a loop.
+ *
+ * While every active lane is in the executing group, the group's program
+ * counter is tracked once instead of per lane, and the lane program counters
+ * are only written back when control flow may split the group.
+ */
+template <size_t Lanes>
+void WideMachine<Lanes>::run() {
+    stats = WideStats{};
+    if (decoded.empty()) return;
+
+    Vector mask{};
+    uint32_t at = 0;
+    size_t group = 0;
+    size_t active = 0;
+    size_t first_lane = 0;
+    bool resync = true;
+    uint64_t poor_steps = 0;
+
+    for (;;) {
+        if (resync) {
+            at = program_size;
+            active = 0;
+            for (size_t l = 0; l < Lanes; ++l) {
+                at = std::min(at, pc[l]);
+                active += pc[l] < program_size;
+            }
+            if (active == 0) break;
+
+            group = 0;
+            for (size_t l = 0; l < Lanes; ++l) {
+                mask[l] = (pc[l] == at) ? 1u : 0u;
+                group += mask[l];
+            }
+            first_lane = 0;
+            while (!mask[first_lane]) ++first_lane;
+
+            if (group < fallback_min_lanes && group < active) {
+                if (++poor_steps > fallback_patience) {
+                    stats.scalar_fallback = true;
+                    for (size_t l = 0; l < Lanes; ++l) runLaneScalar(l);
+                    break;
+                }
+            } else {
+                poor_steps = 0;
+            }
+            resync = false;
+        }
+
+        const DecodedInstruction& d = decoded[at];
+        bool straight = (group == Lanes) ? executeMasked<true>(d, at, mask)
+                                         : executeMasked<false>(d, at, mask);
+        ++stats.vector_steps;
+        stats.lane_instructions += group;
+
+        if (straight) {
+            // The whole group moved on to the next instruction
+            ++at;
+            if (group != active || at >= program_size) {
+                for (size_t l = 0; l < Lanes; ++l) pc[l] = mask[l] ? at : pc[l];
+                resync = true;
+            }
+        } else if (group == active) {
+            // Control flow: stay in lockstep if every lane went the same way
+            uint32_t target = pc[first_lane];
+            bool uniform = target < program_size;
+            for (size_t l = 0; l < Lanes; ++l) uniform &= !mask[l] || pc[l] == target;
+            if (uniform) {
+                at = target;
+            } else {
+                resync = true;
+            }
+        } else {
+            resync = true;
+        }
+    }
+}
+
+/**
+ * @brief Executes one decoded instruction for all lanes selected by @p mask.
+ *
+ * Unselected lanes keep their state. The lane loops are branch-free selects
+ * except where a lane may fault or divide by zero. Straight-line instructions
+ * leave the lane program counters to the caller; control flow writes them.
+ *
+ * @tparam Full True when every lane is selected, so no select is needed.
+ * @param d The instruction at program counter @p at.
+ * @param at The program counter of the executing lanes.
+ * @param mask 1 for lanes that execute, 0 otherwise.
+ * @return True if all selected lanes continue at @p at + 1 (pc not written).
+ */
+template <size_t Lanes>
+template <bool Full>
+bool WideMachine<Lanes>::executeMasked(const DecodedInstruction& d, uint32_t at, const Vector& mask) {
+    const uint32_t next = at + 1;
+    auto pick = [&mask](size_t l, uint32_t selected, uint32_t kept) {
+        return (Full || mask[l]) ? selected : kept;
+    };
+
+    switch (d.op) {
+        case DecodedOp::NOP:
+            return true;
+
+        case DecodedOp::HALT:
+        case DecodedOp::EXIT:
+            for (size_t l = 0; l < Lanes; ++l) pc[l] = pick(l, program_size, pc[l]);
+            return false;
+
+        case DecodedOp::LOAD_DIRECT: {
+            const uint32_t* row = &memory[static_cast<size_t>(d.b) * Lanes];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) dst[l] = pick(l, row[l], dst[l]);
+            return true;
+        }
+
+        case DecodedOp::LOAD_INDIRECT: {
+            // Gather; lanes with an out-of-bounds address fault and halt
+            Vector& dst = regs[d.a];
+            const Vector address = regs[d.b];
+            for (size_t l = 0; l < Lanes; ++l) {
+                if (!Full && !mask[l]) continue;
+                if (address[l] >= data_size) {
+                    pc[l] = program_size;
+                    continue;
+                }
+                dst[l] = memory[static_cast<size_t>(address[l]) * Lanes + l];
+                pc[l] = next;
+            }
+            return false;
+        }
+
+        case DecodedOp::LOAD_IMM: {
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) dst[l] = pick(l, d.b, dst[l]);
+            return true;
+        }
+
+        case DecodedOp::STORE: {
+            uint32_t* row = &memory[static_cast<size_t>(d.a) * Lanes];
+            const Vector& src = regs[d.b];
+            for (size_t l = 0; l < Lanes; ++l) row[l] = pick(l, src[l], row[l]);
+            return true;
+        }
+
+        case DecodedOp::ADD: {
+            const Vector lhs = regs[d.b];
+            const Vector rhs = regs[d.c];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) {
+                uint32_t result = lhs[l] + rhs[l];
+                dst[l] = pick(l, result, dst[l]);
+                flags[1][l] = pick(l, result < lhs[l] ? 1u : 0u, flags[1][l]);
+                flags[2][l] = pick(l, result >> 31, flags[2][l]);
+            }
+            return true;
+        }
+
+        case DecodedOp::SUB: {
+            const Vector lhs = regs[d.b];
+            const Vector rhs = regs[d.c];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) {
+                uint32_t result = lhs[l] - rhs[l];
+                dst[l] = pick(l, result, dst[l]);
+                flags[1][l] = pick(l, lhs[l] < rhs[l] ? 1u : 0u, flags[1][l]);
+                flags[2][l] = pick(l, result >> 31, flags[2][l]);
+            }
+            return true;
+        }
+
+        case DecodedOp::MUL: {
+            const Vector lhs = regs[d.b];
+            const Vector rhs = regs[d.c];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) {
+                uint64_t result = static_cast<uint64_t>(lhs[l]) * rhs[l];
+                uint32_t low = static_cast<uint32_t>(result);
+                dst[l] = pick(l, low, dst[l]);
+                flags[3][l] = pick(l, (result >> 32) != 0 ? 1u : 0u, flags[3][l]);
+                flags[2][l] = pick(l, low >> 31, flags[2][l]);
+            }
+            return true;
+        }
+
+        case DecodedOp::DIV: {
+            const Vector lhs = regs[d.b];
+            const Vector rhs = regs[d.c];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) {
+                if (!Full && !mask[l]) continue;
+                if (rhs[l] == 0) {
+                    flags[4][l] = 1;
+                } else {
+                    uint32_t result = lhs[l] / rhs[l];
+                    dst[l] = result;
+                    flags[2][l] = result >> 31;
+                    flags[4][l] = 0;
+                }
+                flags[3][l] = 0;
+                flags[1][l] = 0;
+            }
+            return true;
+        }
+
+        case DecodedOp::CMP: {
+            const Vector& lhs = regs[d.b];
+            const Vector& rhs = regs[d.c];
+            for (size_t l = 0; l < Lanes; ++l) {
+                flags[0][l] = pick(l, lhs[l] == rhs[l] ? 1u : 0u, flags[0][l]);
+            }
+            return true;
+        }
+
+        case DecodedOp::CMP_INVALID:
+            for (size_t l = 0; l < Lanes; ++l) flags[0][l] = pick(l, 0u, flags[0][l]);
+            return true;
+
+        case DecodedOp::JMP:
+            for (size_t l = 0; l < Lanes; ++l) pc[l] = pick(l, d.a, pc[l]);
+            return false;
+
+        case DecodedOp::JZ: {
+            // The only instruction that can split a group
+            const Vector& zf = flags[0];
+            Vector target;
+            for (size_t l = 0; l < Lanes; ++l) target[l] = pick(l, zf[l] ? d.a : next, pc[l]);
+            pc = target;
+            return false;
+        }
+
+        case DecodedOp::MOV: {
+            const Vector src = regs[d.b];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) dst[l] = pick(l, src[l], dst[l]);
+            return true;
+        }
+
+        case DecodedOp::CHECK_FLAG: {
+            const Vector& flag = flags[d.b];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) dst[l] = pick(l, flag[l], dst[l]);
+            return true;
+        }
+
+        case DecodedOp::ATOMIC_ADD:
+        case DecodedOp::CAS: {
+            // Every lane is a single hart with its own memory: a plain read-modify-write
+            Vector& dst = regs[d.a];
+            const Vector address = regs[d.b];
+            const Vector src = regs[d.c];
+            for (size_t l = 0; l < Lanes; ++l) {
+                if (!Full && !mask[l]) continue;
+                if (address[l] >= data_size) {
+                    pc[l] = program_size;
+                    continue;
+                }
+                uint32_t& word = memory[static_cast<size_t>(address[l]) * Lanes + l];
+                const uint32_t old = word;
+                if (d.op == DecodedOp::ATOMIC_ADD) {
+                    word = old + src[l];
+                } else {
+                    flags[0][l] = old == dst[l];
+                    if (old == dst[l]) word = src[l];
+                }
+                dst[l] = old;
+                pc[l] = next;
+            }
+            return false;
+        }
+
+        case DecodedOp::HART_ID: {
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) dst[l] = pick(l, 0u, dst[l]);
+            return true;
+        }
+
+        case DecodedOp::FENCE:
+            return true;  // lanes share no memory
+
+        case DecodedOp::VLOAD:
+        case DecodedOp::VSTORE:
+            // Per-lane gather/scatter; lanes with an out-of-bounds element fault and halt
+            for (size_t l = 0; l < Lanes; ++l) {
+                if (!Full && !mask[l]) continue;
+                pc[l] = vectorAccess(d, l) ? next : program_size;
+            }
+            return false;
+
+        case DecodedOp::MEMCPY:
+        case DecodedOp::MEMSET:
+        case DecodedOp::MEMCMP:
+            // Lengths differ per lane; lanes with an out-of-bounds range fault and halt
+            for (size_t l = 0; l < Lanes; ++l) {
+                if (!Full && !mask[l]) continue;
+                pc[l] = bulkAccess(d, l) ? next : program_size;
+            }
+            return false;
+
+        case DecodedOp::HOSTCALL:
+            // No host functions are bound to lanes: the call faults like an unbound ID
+            for (size_t l = 0; l < Lanes; ++l) {
+                if (!Full && !mask[l]) continue;
+                pc[l] = program_size;
+            }
+            return false;
+
+        case DecodedOp::VADD:
+        case DecodedOp::VSUB:
+        case DecodedOp::VMUL: {
+            auto& dst = vregs[d.a];
+            const auto& lhs = vregs[d.b];
+            const auto& rhs = vregs[d.c];
+            for (uint32_t e = 0; e < VectorUnit::kMaxLength; ++e) {
+                for (size_t l = 0; l < Lanes; ++l) {
+                    const uint32_t result = d.op == DecodedOp::VADD ? lhs[e][l] + rhs[e][l]
+                                          : d.op == DecodedOp::VSUB ? lhs[e][l] - rhs[e][l]
+                                                                    : lhs[e][l] * rhs[e][l];
+                    dst[e][l] = e < vl[l] ? pick(l, result, dst[e][l]) : dst[e][l];
+                }
+            }
+            return true;
+        }
+
+        case DecodedOp::VREDUCE: {
+            const auto& src = vregs[d.b];
+            Vector sum{};
+            for (uint32_t e = 0; e < VectorUnit::kMaxLength; ++e) {
+                for (size_t l = 0; l < Lanes; ++l) sum[l] += e < vl[l] ? src[e][l] : 0;
+            }
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) dst[l] = pick(l, sum[l], dst[l]);
+            return true;
+        }
+
+        case DecodedOp::VSETVL: {
+            const Vector requested = regs[d.b];
+            Vector& dst = regs[d.a];
+            for (size_t l = 0; l < Lanes; ++l) {
+                vl[l] = pick(l, std::min(requested[l], VectorUnit::kDefaultLength), vl[l]);
+                dst[l] = pick(l, vl[l], dst[l]);
+            }
+            return true;
+        }
+
+        default:
+            // Fused operations are never produced for wide machines
+            return true;
+    }
+}
+
+/**
+ * @brief Runs one lane to completion on the scalar path.
+ *
+ * Used when the lanes have diverged so far that lockstep execution no longer pays off.
+ *
+ * @param lane The lane to run.
+ */
+template <size_t Lanes>
+void WideMachine<Lanes>::runLaneScalar(size_t lane) {
+    const size_t l = lane;
+    auto reg = [&](uint32_t index) -> uint32_t& { return regs[index][l]; };
+
+    while (pc[l] < program_size) {
+        const DecodedInstruction& d = decoded[pc[l]];
+        uint32_t next = pc[l] + 1;
+        ++stats.scalar_steps;
+
+        switch (d.op) {
+            case DecodedOp::HALT:
+            case DecodedOp::EXIT:
+                next = program_size;
+                break;
+            case DecodedOp::LOAD_DIRECT:
+                reg(d.a) = memory[static_cast<size_t>(d.b) * Lanes + l];
+                break;
+            case DecodedOp::LOAD_INDIRECT: {
+                uint32_t address = reg(d.b);
+                if (address >= data_size) {
+                    next = program_size;
+                    break;
+                }
+                reg(d.a) = memory[static_cast<size_t>(address) * Lanes + l];
+                break;
+            }
+            case DecodedOp::LOAD_IMM:
+                reg(d.a) = d.b;
+                break;
+            case DecodedOp::STORE:
+                memory[static_cast<size_t>(d.a) * Lanes + l] = reg(d.b);
+                break;
+            case DecodedOp::ADD: {
+                uint64_t result = static_cast<uint64_t>(reg(d.b)) + reg(d.c);
+                reg(d.a) = static_cast<uint32_t>(result);
+                flags[1][l] = result > UINT32_MAX;
+                flags[2][l] = (result >> 31) & 1;
+                break;
+            }
+            case DecodedOp::SUB: {
+                uint32_t lhs = reg(d.b);
+                uint32_t rhs = reg(d.c);
+                reg(d.a) = lhs - rhs;
+                flags[1][l] = lhs < rhs;
+                flags[2][l] = (lhs - rhs) >> 31;
+                break;
+            }
+            case DecodedOp::MUL: {
+                uint64_t result = static_cast<uint64_t>(reg(d.b)) * reg(d.c);
+                reg(d.a) = static_cast<uint32_t>(result);
+                flags[3][l] = result > UINT32_MAX;
+                flags[2][l] = (result >> 31) & 1;
+                break;
+            }
+            case DecodedOp::DIV: {
+                uint32_t divisor = reg(d.c);
+                if (divisor == 0) {
+                    flags[4][l] = 1;
+                } else {
+                    uint32_t result = reg(d.b) / divisor;
+                    reg(d.a) = result;
+                    flags[2][l] = result >> 31;
+                    flags[4][l] = 0;
+                }
+                flags[3][l] = 0;
+                flags[1][l] = 0;
+                break;
+            }
+            case DecodedOp::CMP:
+                flags[0][l] = reg(d.b) == reg(d.c);
+                break;
+            case DecodedOp::CMP_INVALID:
+                flags[0][l] = 0;
+                break;
+            case DecodedOp::JMP:
+                next = d.a;
+                break;
+            case DecodedOp::JZ:
+                if (flags[0][l]) next = d.a;
+                break;
+            case DecodedOp::MOV:
+                reg(d.a) = reg(d.b);
+                break;
+            case DecodedOp::CHECK_FLAG:
+                reg(d.a) = flags[d.b][l];
+                break;
+            case DecodedOp::ATOMIC_ADD:
+            case DecodedOp::CAS: {
+                uint32_t address = reg(d.b);
+                if (address >= data_size) {
+                    next = program_size;
+                    break;
+                }
+                uint32_t& word = memory[static_cast<size_t>(address) * Lanes + l];
+                const uint32_t old = word;
+                if (d.op == DecodedOp::ATOMIC_ADD) {
+                    word = old + reg(d.c);
+                } else {
+                    flags[0][l] = old == reg(d.a);
+                    if (old == reg(d.a)) word = reg(d.c);
+                }
+                reg(d.a) = old;
+                break;
+            }
+            case DecodedOp::HART_ID:
+                reg(d.a) = 0;
+                break;
+            case DecodedOp::FENCE:
+                break;
+            case DecodedOp::VLOAD:
+            case DecodedOp::VSTORE:
+                if (!vectorAccess(d, l)) next = program_size;
+                break;
+            case DecodedOp::MEMCPY:
+            case DecodedOp::MEMSET:
+            case DecodedOp::MEMCMP:
+                if (!bulkAccess(d, l)) next = program_size;
+                break;
+            case DecodedOp::HOSTCALL:
+                next = program_size;
+                break;
+            case DecodedOp::VADD:
+            case DecodedOp::VSUB:
+            case DecodedOp::VMUL:
+                for (uint32_t e = 0; e < vl[l]; ++e) {
+                    const uint32_t lhs = vregs[d.b][e][l];
+                    const uint32_t rhs = vregs[d.c][e][l];
+                    vregs[d.a][e][l] = d.op == DecodedOp::VADD ? lhs + rhs
+                                     : d.op == DecodedOp::VSUB ? lhs - rhs : lhs * rhs;
+                }
+                break;
+            case DecodedOp::VREDUCE: {
+                uint32_t sum = 0;
+                for (uint32_t e = 0; e < vl[l]; ++e) sum += vregs[d.b][e][l];
+                reg(d.a) = sum;
+                break;
+            }
+            case DecodedOp::VSETVL:
+                vl[l] = std::min(reg(d.b), VectorUnit::kDefaultLength);
+                reg(d.a) = vl[l];
+                break;
+            default:
+                break;
+        }
+        pc[l] = next;
+    }
+}
+
+/**
+ * @brief Executes a VLOAD or VSTORE for one lane.
+ *
+ * @param d The decoded VLOAD or VSTORE.
+ * @param lane The lane.
+ * @return False, touching nothing, if an element lies outside the lane's data memory.
+ */
+template <size_t Lanes>
+bool WideMachine<Lanes>::vectorAccess(const DecodedInstruction& d, size_t lane) {
+    const size_t l = lane;
+    const uint32_t length = vl[l];
+    if (length == 0) return true;
+    const bool load = d.op == DecodedOp::VLOAD;
+    const uint32_t address = regs[load ? d.b : d.a][l];
+    const uint32_t stride = regs[d.c][l];
+    if (uint64_t(address) + uint64_t(length - 1) * stride >= data_size) return false;
+    auto& v = vregs[load ? d.a : d.b];
+    for (uint32_t e = 0; e < length; ++e) {
+        uint32_t& word = memory[(static_cast<size_t>(address) + static_cast<size_t>(e) * stride) * Lanes + l];
+        if (load) {
+            v[e][l] = word;
+        } else {
+            word = v[e][l];
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Executes a MEMCPY, MEMSET or MEMCMP for one lane.
+ *
+ * @param d The decoded bulk memory instruction.
+ * @param lane The lane.
+ * @return False, touching nothing, if a range extends beyond the lane's data memory.
+ */
+template <size_t Lanes>
+bool WideMachine<Lanes>::bulkAccess(const DecodedInstruction& d, size_t lane) {
+    const size_t l = lane;
+    const uint32_t lhs = regs[d.a][l];
+    const uint32_t rhs = regs[d.b][l];
+    const uint32_t count = regs[d.c][l];
+    auto word = [&](uint64_t address) -> uint32_t& { return memory[address * Lanes + l]; };
+    if (count && (uint64_t(lhs) + count > data_size ||
+                  (d.op != DecodedOp::MEMSET && uint64_t(rhs) + count > data_size))) {
+        return false;
+    }
+    switch (d.op) {
+        case DecodedOp::MEMCPY:
+            if (lhs > rhs && lhs - rhs < count) {
+                for (uint32_t i = count; i-- > 0;) word(uint64_t(lhs) + i) = word(uint64_t(rhs) + i);
+            } else {
+                for (uint32_t i = 0; i < count; ++i) word(uint64_t(lhs) + i) = word(uint64_t(rhs) + i);
+            }
+            break;
+        case DecodedOp::MEMSET:
+            for (uint32_t i = 0; i < count; ++i) word(uint64_t(lhs) + i) = rhs;
+            break;
+        default: {
+            uint32_t a = 0, b = 0;
+            for (uint32_t i = 0; i < count && a == b; ++i) {
+                a = word(uint64_t(lhs) + i);
+                b = word(uint64_t(rhs) + i);
+            }
+            flags[0][l] = a == b;
+            flags[1][l] = a < b;
+            flags[2][l] = (a - b) >> 31;
+            break;
+        }
+    }
+    return true;
+}
+
+template class WideMachine<8>;
+template class WideMachine<16>;
@@ -0,0 +1,144 @@
+/**
+ * @file wide_machine.hpp
+ * @brief Declares WideMachine, which runs one program on many data sets in lockstep.
+ *
+ * A WideMachine holds the state of several independent RISC machines ("lanes")
+ * in structure-of-arrays form: register Rn of all lanes is one contiguous vector,
+ * each flag is one vector, and data memory is interleaved so that the same
+ * address of every lane is contiguous. All lanes share one decoded program.
+ *
+ * At every step the lanes whose program counter equals the lowest active program
+ * counter execute the instruction together under a lane mask; lanes that took a
+ * different branch wait and rejoin when the others catch up (min-PC reconvergence).
+ * The per-lane loops are written so the compiler can map them onto SSE/AVX2/AVX-512
+ * (build with -DRISC_NATIVE_ARCH=ON to target the host's vector extensions).
+ * When too few lanes run together for too long, the remaining lanes finish one
+ * at a time on a scalar path.
+ */
+
+#pragma once
+
+#include "decoder.hpp"
+#include "machine.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @struct WideStats
+ * @brief Execution counters of a WideMachine run.
+ */
+struct WideStats {
+    uint64_t vector_steps = 0;       /**< Instructions executed for a group of lanes */
+    uint64_t lane_instructions = 0;  /**< Sum of lanes executing in every vector step */
+    uint64_t scalar_steps = 0;       /**< Instructions executed on the scalar fallback path */
+    bool scalar_fallback = false;    /**< Whether the last run fell back to scalar execution */
+};
+
+/**
+ * @class WideMachine
+ * @brief Lockstep execution of one program across @p Lanes machine instances.
+ *
+ * Each lane behaves exactly like a RiscMachine with the same data memory size
+ * and the default vector length (VectorUnit::kDefaultLength) that ran the
+ * program on its own. Lanes have no host calls bound, so HOSTCALL faults the
+ * lane, as it does on a RiscMachine with nothing bound.
+ *
+ * @tparam Lanes Number of lanes (instantiated for 8 and 16).
+ */
+template <size_t Lanes>
+class WideMachine {
+public:
+    /**
+     * @brief Constructs a wide machine with zeroed lanes.
+     * @param data_size Data memory size of every lane (default: 1024).
+     */
+    explicit WideMachine(size_t data_size = 1024);
+
+    /**
+     * @brief Loads a program for all lanes and resets registers, flags and PCs.
+     * @param program A vector of instructions to load.
+     */
+    void loadProgram(const std::vector<Instruction>& program);
+
+    /**
+     * @brief Runs all lanes until each has halted, faulted or left the program.
+     */
+    void run();
+
+    /**
+     * @brief Resets registers, flags and program counters of all lanes.
+     */
+    void reset();
+
+    /**
+     * @brief Sets a value in the data memory of one lane.
+     * @param lane The lane to write.
+     * @param address The memory address to set.
+     * @param value The value to write.
+     */
+    void setMemoryValue(size_t lane, uint32_t address, uint32_t value);
+
+    /**
+     * @brief Retrieves a value from the data memory of one lane.
+     * @param lane The lane to read.
+     * @param address The memory address to read.
+     * @return The stored value, or 0 if the address is out of bounds.
+     */
+    uint32_t getMemoryValue(size_t lane, uint32_t address) const;
+
+    /**
+     * @brief Gets the status register of one lane.
+     * @param lane The lane to read.
+     * @return The lane's flags.
+     */
+    StatusRegister getStatusRegister(size_t lane) const;
+
+    /**
+     * @brief Configures when execution falls back to the scalar path.
+     *
+     * If fewer than @p min_lanes lanes execute together for more than
+     * @p patience consecutive steps, the remaining lanes are finished one by one.
+     *
+     * @param min_lanes Minimum useful group size (0 disables the fallback).
+     * @param patience Number of poorly utilised steps tolerated.
+     */
+    void setScalarFallback(size_t min_lanes, uint64_t patience = 64);
+
+    /**
+     * @brief Gets the counters of the last run.
+     * @return Vector and scalar step counts.
+     */
+    const WideStats& getStats() const;
+
+    /** @brief Number of lanes. */
+    static constexpr size_t lanes = Lanes;
+
+private:
+    using Vector = std::array<uint32_t, Lanes>;
+
+    template <bool Full>
+    bool executeMasked(const DecodedInstruction& d, uint32_t at, const Vector& mask);
+    void runLaneScalar(size_t lane);
+    bool vectorAccess(const DecodedInstruction& d, size_t lane);
+    bool bulkAccess(const DecodedInstruction& d, size_t lane);
+
+    size_t data_size;
+    std::vector<DecodedInstruction> decoded;
+    uint32_t program_size = 0;
+
+    alignas(64) std::array<Vector, 16> regs{};  // regs[r][lane]
+    alignas(64) std::array<Vector, 5> flags{};  // ZF, CF, NF, OF, DF (CHECK_FLAG order)
+    alignas(64) Vector pc{};
+    alignas(64) std::array<std::array<Vector, VectorUnit::kMaxLength>, VectorUnit::kRegisters> vregs{};  // vregs[v][element][lane]
+    alignas(64) Vector vl{};                    // active vector length of each lane
+    std::vector<uint32_t> memory;               // memory[address * Lanes + lane]
+
+    size_t fallback_min_lanes = Lanes / 4;
+    uint64_t fallback_patience = 64;
+    WideStats stats;
+};
+
+extern template class WideMachine<8>;
+extern template class WideMachine<16>;
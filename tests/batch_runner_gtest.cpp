@@ -0,0 +1,135 @@
+/**
+ * @file batch_runner_gtest.cpp
+ * @brief Unit tests for the multi-threaded BatchRunner.
+ */
+
+#include "../src/batch_runner.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+
+// Reference implementation of the factorial program (wraps at 32 bits like the guest)
+static uint32_t factorial(uint32_t n) {
+    uint32_t result = 1;
+    for (uint32_t i = 2; i <= n; ++i) result *= i;
+    return result;
+}
+
+static void setFactorialInput(RiscMachine& machine, uint32_t n) {
+    machine.setMemoryValue(100, n);
+}
+
+static uint32_t getFactorialResult(const RiscMachine& machine) {
+    return machine.getMemoryValue(101);
+}
+
+TEST(BatchRunnerTest, ResultsInInputOrder) {
+    BatchRunner runner(BatchOptions{4, 3});
+    EXPECT_EQ(runner.workerCount(), 4u);
+
+    std::vector<uint32_t> inputs;
+    for (uint32_t n = 0; n < 1000; ++n) inputs.push_back(n % 20);
+
+    auto results = runner.run(createFactorialProgram(100, 101), inputs,
+                              setFactorialInput, getFactorialResult);
+    ASSERT_EQ(results.size(), inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        uint32_t expected = inputs[i] == 0 ? 1 : factorial(inputs[i]);
+        EXPECT_EQ(results[i], expected) << "input index " << i;
+    }
+}
+
+TEST(BatchRunnerTest, RunnerIsReusableAcrossBatches) {
+    BatchRunner runner(BatchOptions{3});
+    for (uint32_t batch = 1; batch <= 5; ++batch) {
+        std::vector<uint32_t> inputs(batch * 7, batch);
+        auto results = runner.run(createFibonacciProgram(100, 101), inputs,
+                                  setFactorialInput, getFactorialResult);
+        uint32_t expected[] = {0, 1, 1, 2, 3, 5};
+        for (uint32_t value : results) EXPECT_EQ(value, expected[batch]);
+    }
+}
+
+TEST(BatchRunnerTest, StructuredInputsAndOutputs) {
+    struct List { std::vector<uint32_t> values; };
+    struct Sum { uint32_t value = 0; bool carry = false; };
+
+    std::vector<List> inputs = {{{1, 2, 3}}, {{UINT32_MAX, 1}}, {{10, 20, 30, 40}}, {{7}}};
+    BatchRunner runner(BatchOptions{2, 1, 256, 1024, ExecutionEngine::Switch});
+    auto results = runner.run(createSumListProgram(300, 301, 302), inputs,
+        [](RiscMachine& machine, const List& list) {
+            machine.setMemoryValue(300, 400);
+            machine.setMemoryValue(301, static_cast<uint32_t>(list.values.size()));
+            for (size_t i = 0; i < list.values.size(); ++i) {
+                machine.setMemoryValue(400 + static_cast<uint32_t>(i), list.values[i]);
+            }
+        },
+        [](const RiscMachine& machine) {
+            return Sum{machine.getMemoryValue(302), machine.getStatusRegister().CF == 1};
+        });
+
+    ASSERT_EQ(results.size(), 4u);
+    EXPECT_EQ(results[0].value, 6u);
+    EXPECT_TRUE(results[1].carry);
+    EXPECT_EQ(results[2].value, 100u);
+    EXPECT_EQ(results[3].value, 7u);
+}
+
+TEST(BatchRunnerTest, MemoryClearedBetweenJobs) {
+    // The program stores RAM[200] + 1; only the first job writes RAM[200]
+    std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 200, 0},
+        {Opcode::LOAD, 1, 1, 2},
+        {Opcode::ADD, 0, 0, 1},
+        {Opcode::STORE, 201, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    std::vector<uint32_t> inputs = {41, 0, 0, 0};
+    BatchRunner runner(BatchOptions{1});
+    auto results = runner.run(program, inputs,
+        [](RiscMachine& machine, uint32_t value) {
+            if (value != 0) machine.setMemoryValue(200, value);
+        },
+        [](const RiscMachine& machine) { return machine.getMemoryValue(201); });
+    EXPECT_EQ(results, (std::vector<uint32_t>{42, 1, 1, 1}));
+}
+
+TEST(BatchRunnerTest, EveryJobRunsExactlyOnce) {
+    std::atomic<size_t> calls{0};
+    std::vector<uint32_t> inputs(10007, 3);
+    BatchRunner runner(BatchOptions{8, 0});
+    auto results = runner.run(createFactorialProgram(100, 101), inputs,
+        [&calls](RiscMachine& machine, uint32_t n) {
+            calls.fetch_add(1, std::memory_order_relaxed);
+            machine.setMemoryValue(100, n);
+        },
+        getFactorialResult);
+    EXPECT_EQ(calls.load(), inputs.size());
+    for (uint32_t value : results) EXPECT_EQ(value, 6u);
+}
+
+TEST(BatchRunnerTest, EmptyInput) {
+    BatchRunner runner(BatchOptions{2});
+    std::vector<uint32_t> inputs;
+    auto results = runner.run(createFactorialProgram(100, 101), inputs,
+                              setFactorialInput, getFactorialResult);
+    EXPECT_TRUE(results.empty());
+}
+
+TEST(BatchRunnerTest, CallbackExceptionIsRethrown) {
+    BatchRunner runner(BatchOptions{4, 1});
+    std::vector<uint32_t> inputs(100, 1);
+    inputs[57] = 0;
+    auto throwing_init = [](RiscMachine& machine, uint32_t n) {
+        if (n == 0) throw std::runtime_error("bad input");
+        machine.setMemoryValue(100, n);
+    };
+    EXPECT_THROW(runner.run(createFactorialProgram(100, 101), inputs, throwing_init, getFactorialResult),
+                 std::runtime_error);
+
+    // The runner stays usable after a failed batch
+    inputs[57] = 2;
+    auto results = runner.run(createFactorialProgram(100, 101), inputs, throwing_init, getFactorialResult);
+    EXPECT_EQ(results[57], 2u);
+}
@@ -0,0 +1,233 @@
+/**
+ * @file bulk_memory_gtest.cpp
+ * @brief Unit tests for the bulk memory instructions and the range transfer API.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/optimizer.hpp"
+#include "../src/replay.hpp"
+#include "../src/wide_machine.hpp"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+class BulkMemoryTest : public ::testing::TestWithParam<ExecutionEngine> {
+protected:
+    // R0 = lhs, R1 = rhs (or value), R2 = count, then `op`, then RAM[10] = flags ZF, CF, NF in bits 0-2
+    static std::vector<Instruction> bulkProgram(Opcode op, uint32_t lhs, uint32_t rhs, uint32_t count) {
+        return {
+            {Opcode::LOAD, 0, lhs, 2},
+            {Opcode::LOAD, 1, rhs, 2},
+            {Opcode::LOAD, 2, count, 2},
+            {op, 0, 1, 2},
+            {Opcode::CHECK_FLAG, 3, 0, 0},
+            {Opcode::CHECK_FLAG, 4, 1, 0},
+            {Opcode::CHECK_FLAG, 5, 2, 0},
+            {Opcode::ADD, 4, 4, 4},
+            {Opcode::ADD, 5, 5, 5},
+            {Opcode::ADD, 5, 5, 5},
+            {Opcode::ADD, 3, 3, 4},
+            {Opcode::ADD, 3, 3, 5},
+            {Opcode::STORE, 10, 3, 0},
+            {Opcode::HALT, 0, 0, 0}
+        };
+    }
+};
+
+TEST_P(BulkMemoryTest, CopyAcrossPages) {
+    RiscMachine machine(256, 8 * DataMemory::kPageWords, GetParam());
+    std::vector<uint32_t> input(3000);
+    std::iota(input.begin(), input.end(), 1u);
+    ASSERT_TRUE(machine.writeMemory(100, input));
+    machine.loadProgram(bulkProgram(Opcode::MEMCPY, 3500, 100, 3000));
+    machine.run();
+    std::vector<uint32_t> copied(3000);
+    ASSERT_TRUE(machine.readMemory(3500, copied));
+    EXPECT_EQ(copied, input);
+    EXPECT_EQ(machine.getMemoryValue(99), 0u);
+    EXPECT_EQ(machine.getMemoryValue(6500), 0u);
+}
+
+TEST_P(BulkMemoryTest, OverlappingCopiesBehaveLikeMemmove) {
+    for (uint32_t to : {1000u, 1200u}) {
+        RiscMachine machine(256, 4 * DataMemory::kPageWords, GetParam());
+        std::vector<uint32_t> input(2000);
+        std::iota(input.begin(), input.end(), 0u);
+        ASSERT_TRUE(machine.writeMemory(1100, input));
+        machine.loadProgram(bulkProgram(Opcode::MEMCPY, to, 1100, 2000));
+        machine.run();
+        for (uint32_t i = 0; i < 2000; ++i) ASSERT_EQ(machine.getMemoryValue(to + i), i) << "to " << to;
+    }
+}
+
+TEST_P(BulkMemoryTest, Fill) {
+    RiscMachine machine(256, 4 * DataMemory::kPageWords, GetParam());
+    machine.loadProgram(bulkProgram(Opcode::MEMSET, 1000, 0xABCD, 2048));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(999), 0u);
+    EXPECT_EQ(machine.getMemoryValue(1000), 0xABCDu);
+    EXPECT_EQ(machine.getMemoryValue(3047), 0xABCDu);
+    EXPECT_EQ(machine.getMemoryValue(3048), 0u);
+}
+
+TEST_P(BulkMemoryTest, CompareSetsFlagsLikeSubOfFirstDifference) {
+    struct Case {
+        uint32_t lhs_value;
+        uint32_t rhs_value;
+        uint32_t flags;  // ZF | CF << 1 | NF << 2
+    };
+    const Case cases[] = {
+        {5, 5, 1},            // equal
+        {3, 5, 2 | 4},        // lhs < rhs: borrow, negative difference
+        {5, 3, 0},
+        {0x80000000u, 0, 4},  // lhs > rhs, difference has the top bit set
+    };
+    for (const Case& c : cases) {
+        RiscMachine machine(256, 4 * DataMemory::kPageWords, GetParam());
+        std::vector<uint32_t> lhs(1500, 9), rhs(1500, 9);
+        lhs[1234] = c.lhs_value;
+        rhs[1234] = c.rhs_value;
+        lhs[1400] = 1;  // after the first difference: ignored
+        rhs[1400] = c.lhs_value == c.rhs_value ? 1 : 2;
+        ASSERT_TRUE(machine.writeMemory(100, lhs));
+        ASSERT_TRUE(machine.writeMemory(2000, rhs));
+        machine.loadProgram(bulkProgram(Opcode::MEMCMP, 100, 2000, 1500));
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(10), c.flags) << c.lhs_value << " vs " << c.rhs_value;
+    }
+}
+
+TEST_P(BulkMemoryTest, OutOfBoundsRangesFaultBeforeTouchingMemory) {
+    const uint32_t size = 2 * DataMemory::kPageWords;
+    const Opcode opcodes[] = {Opcode::MEMCPY, Opcode::MEMSET, Opcode::MEMCMP};
+    for (Opcode op : opcodes) {
+        RiscMachine machine(256, size, GetParam());
+        machine.setMemoryValue(size - 1, 5);
+        machine.setMemoryValue(10, 77);
+        machine.loadProgram(bulkProgram(op, size - 100, 0, 101));  // one word beyond the end
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(size - 1), 5u);
+        EXPECT_EQ(machine.getMemoryValue(10), 77u);  // halted before the flags were stored
+    }
+    // The source range of a copy is checked too; a zero count never faults
+    RiscMachine machine(256, size, GetParam());
+    machine.loadProgram(bulkProgram(Opcode::MEMCPY, 0, size - 1, 2));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(10), 0u);
+    machine.loadProgram(bulkProgram(Opcode::MEMCMP, UINT32_MAX, UINT32_MAX, 0));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(10), 1u);  // equal
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, BulkMemoryTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Switch: return "Switch";
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 default: return "Jit";
+                             }
+                         });
+
+TEST(MemoryTransferTest, RangesAreCheckedOnce) {
+    RiscMachine machine(256, 1024);
+    const std::vector<uint32_t> values = {1, 2, 3, 4};
+    EXPECT_TRUE(machine.writeMemory(1020, values));
+    EXPECT_FALSE(machine.writeMemory(1021, values));
+    EXPECT_FALSE(machine.writeMemory(UINT32_MAX, values));
+    EXPECT_EQ(machine.getMemoryValue(1023), 4u);
+
+    std::vector<uint32_t> out(4);
+    EXPECT_TRUE(machine.readMemory(1020, out));
+    EXPECT_EQ(out, values);
+    out.assign(5, 9);
+    EXPECT_FALSE(machine.readMemory(1020, out));
+    EXPECT_EQ(out[0], 9u);
+    EXPECT_TRUE(machine.writeMemory(1024, nullptr, 0));
+}
+
+TEST(MemoryTransferTest, RecordedWritesReplay) {
+    const std::string path = ::testing::TempDir() + "risc_bulk_transfer.replay";
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 500, 2},
+        {Opcode::LOAD, 1, 100, 2},
+        {Opcode::LOAD, 2, 50, 2},
+        {Opcode::MEMCPY, 0, 1, 2},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    RiscMachine machine;
+    machine.loadProgram(program);
+    ASSERT_TRUE(machine.startRecording(path));
+    std::vector<uint32_t> values(50);
+    std::iota(values.begin(), values.end(), 7u);
+    ASSERT_TRUE(machine.writeMemory(100, values));
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    ReplayResult result = replayRecording(path, {program});
+    std::remove(path.c_str());
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_FALSE(result.diverged);
+    EXPECT_EQ(result.machine.getMemoryValue(549), 56u);
+}
+
+TEST(MemoryTransferTest, OptimizerKeepsBulkInstructions) {
+    // The first STORE is read by the MEMCPY; the flags of MEMCMP reach the exit
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 42, 2},
+        {Opcode::STORE, 100, 0, 0},
+        {Opcode::LOAD, 1, 100, 2},
+        {Opcode::LOAD, 2, 200, 2},
+        {Opcode::LOAD, 3, 1, 2},
+        {Opcode::MEMCPY, 2, 1, 3},
+        {Opcode::STORE, 100, 3, 0},
+        {Opcode::MEMCMP, 1, 2, 3},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    const OptimizedProgram optimized = optimizeProgram(program, 16, 1024);
+    RiscMachine machine;
+    machine.loadProgram(optimized.program);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(200), 42u);
+    EXPECT_EQ(machine.getMemoryValue(100), 1u);
+    EXPECT_FALSE(machine.getStatusRegister().ZF);
+    EXPECT_TRUE(machine.getStatusRegister().CF);
+}
+
+TEST(MemoryTransferTest, WideMachineLanesMatchRiscMachine) {
+    WideMachine<8> wide(1024);
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 0, 0},        // R0 = RAM[0]: copy destination
+        {Opcode::LOAD, 1, 100, 2},
+        {Opcode::LOAD, 2, 1, 0},        // R2 = RAM[1]: word count
+        {Opcode::MEMCPY, 0, 1, 2},
+        {Opcode::MEMCMP, 0, 1, 2},
+        {Opcode::CHECK_FLAG, 3, 0, 0},
+        {Opcode::STORE, 2, 3, 0},       // RAM[2] = equal
+        {Opcode::LOAD, 4, 300, 2},
+        {Opcode::MEMSET, 4, 2, 2},      // RAM[300 ..] = count
+        {Opcode::HALT, 0, 0, 0}
+    };
+    for (size_t lane = 0; lane < 8; ++lane) {
+        wide.setMemoryValue(lane, 0, 110 + static_cast<uint32_t>(lane));  // overlaps the source
+        wide.setMemoryValue(lane, 1, static_cast<uint32_t>(lane * 20));
+        for (uint32_t i = 0; i < 200; ++i) wide.setMemoryValue(lane, 100 + i, i * 3 + static_cast<uint32_t>(lane));
+    }
+    wide.setMemoryValue(7, 1, 1000);  // lane 7 faults
+    wide.loadProgram(program);
+    wide.run();
+    for (size_t lane = 0; lane < 8; ++lane) {
+        RiscMachine machine(256, 1024);
+        machine.setMemoryValue(0, 110 + static_cast<uint32_t>(lane));
+        machine.setMemoryValue(1, lane == 7 ? 1000 : static_cast<uint32_t>(lane * 20));
+        for (uint32_t i = 0; i < 200; ++i) machine.setMemoryValue(100 + i, i * 3 + static_cast<uint32_t>(lane));
+        machine.loadProgram(program);
+        machine.run();
+        for (uint32_t address = 0; address < 400; ++address) {
+            ASSERT_EQ(wide.getMemoryValue(lane, address), machine.getMemoryValue(address))
+                << "lane " << lane << " address " << address;
+        }
+        EXPECT_EQ(wide.getStatusRegister(lane).ZF, machine.getStatusRegister().ZF);
+    }
+}
@@ -0,0 +1,243 @@
+/**
+ * @file constexpr_machine_gtest.cpp
+ * @brief Unit tests for the constexpr interpreter and compile-time specialised programs.
+ */
+
+#include "../src/algorithms.hpp"
+#include "../src/constexpr_machine.hpp"
+#include "../src/machine.hpp"
+#include <gtest/gtest.h>
+#include <memory>
+#include <vector>
+
+namespace {
+
+constexpr size_t kDataSize = 1024;
+
+constexpr auto kFactorial = factorialProgram(100, 101);
+constexpr auto kSumList = sumListProgram(100, 101, 102);
+constexpr auto kFibonacci = fibonacciProgram(100, 101);
+
+// Touches every instruction kind but HOSTCALL; RAM[100] picks the CMP outcome, RAM[300..] is the vector input
+constexpr std::array<Instruction, 35> kMixed = {{
+    {Opcode::LOAD, 0, 100, 0},
+    {Opcode::LOAD, 1, 3, 2},
+    {Opcode::ADD, 2, 0, 1},
+    {Opcode::SUB, 3, 1, 0},
+    {Opcode::MUL, 4, 0, 0},
+    {Opcode::DIV, 5, 0, 1},
+    {Opcode::CHECK_FLAG, 6, 2, 0},
+    {Opcode::CMP, 0, 1, 0},
+    {Opcode::JMP, 10, 1, 0},    // skips the MOV when RAM[100] == 3
+    {Opcode::MOV, 4, 2, 0},
+    {Opcode::STORE, 200, 4, 0},
+    {Opcode::LOAD, 8, 9, 2},
+    {Opcode::VSETVL, 9, 8, 0},  // vl = min(9, VLMAX)
+    {Opcode::LOAD, 10, 300, 2},
+    {Opcode::LOAD, 11, 1, 2},
+    {Opcode::VLOAD, 0, 10, 11},
+    {Opcode::VADD, 1, 0, 0},
+    {Opcode::VREDUCE, 12, 1, 0},
+    {Opcode::STORE, 201, 12, 0},
+    {Opcode::LOAD, 13, 400, 2},
+    {Opcode::MEMCPY, 13, 10, 8},
+    {Opcode::MEMCMP, 13, 10, 8},
+    {Opcode::CHECK_FLAG, 14, 0, 0},
+    {Opcode::STORE, 202, 14, 0},
+    {Opcode::LOAD, 15, 500, 2},
+    {Opcode::ATOMIC_ADD, 14, 15, 1},
+    {Opcode::CAS, 1, 15, 0},    // succeeds when RAM[500] was 0
+    {Opcode::HART_ID, 3, 0, 0},
+    {Opcode::FENCE, 0, 0, 0},
+    {Opcode::DIV, 6, 0, 3},     // by zero: DF, R6 unchanged
+    {Opcode::CHECK_FLAG, 2, 4, 0},
+    {Opcode::STORE, 203, 2, 0},
+    {Opcode::LOAD, 7, 15, 1},
+    {Opcode::STORE, 204, 7, 0},
+    {Opcode::HALT, 0, 0, 0}
+}};
+
+constexpr std::array<Instruction, 4> kIndirectFault = {{
+    {Opcode::LOAD, 0, 5000, 2},
+    {Opcode::LOAD, 1, 0, 1},
+    {Opcode::STORE, 10, 1, 0},
+    {Opcode::HALT, 0, 0, 0}
+}};
+
+constexpr std::array<Instruction, 3> kHostCall = {{
+    {Opcode::HOSTCALL, 7, 0, 0},
+    {Opcode::STORE, 10, 0, 0},
+    {Opcode::HALT, 0, 0, 0}
+}};
+
+template <const auto& Program>
+constexpr uint32_t interpret(uint32_t input, uint32_t result_addr) {
+    ConstexprMachine<128> machine;
+    machine.setMemoryValue(100, input);
+    machine.run(Program);
+    return machine.getMemoryValue(result_addr);
+}
+
+template <const auto& Program>
+constexpr uint32_t compiled(uint32_t input, uint32_t result_addr) {
+    ConstexprMachine<128> machine;
+    machine.setMemoryValue(100, input);
+    CompiledProgram<Program>::run(machine);
+    return machine.getMemoryValue(result_addr);
+}
+
+constexpr uint32_t sumTo(uint32_t length, bool specialised) {
+    ConstexprMachine<256> machine;
+    machine.setMemoryValue(100, 128);
+    machine.setMemoryValue(101, length);
+    for (uint32_t i = 0; i < length; ++i) machine.setMemoryValue(128 + i, i + 1);
+    if (specialised) {
+        CompiledProgram<kSumList>::run(machine);
+    } else {
+        machine.run(kSumList);
+    }
+    return machine.getMemoryValue(102);
+}
+
+constexpr bool faults(bool specialised) {
+    ConstexprMachine<64> machine;
+    const RunStatus status = specialised ? CompiledProgram<kIndirectFault>::run(machine) : machine.run(kIndirectFault);
+    return status == RunStatus::Faulted && machine.isFaulted() && machine.getPc() == kIndirectFault.size();
+}
+
+// Evaluated by the compiler
+static_assert(interpret<kFactorial>(10, 101) == 3628800, "factorial in a constant expression");
+static_assert(compiled<kFactorial>(10, 101) == 3628800, "specialised factorial in a constant expression");
+static_assert(interpret<kFibonacci>(10, 101) == 55, "fibonacci in a constant expression");
+static_assert(compiled<kFibonacci>(20, 101) == 6765, "specialised fibonacci in a constant expression");
+static_assert(sumTo(100, false) == 5050 && sumTo(100, true) == 5050, "sum in a constant expression");
+static_assert(faults(false) && faults(true), "faults in a constant expression");
+
+// Leaders: the entry, jump targets and the instructions after each JMP and HALT
+static_assert(CompiledProgram<kMixed>::isLeader(0) && CompiledProgram<kMixed>::isLeader(9) &&
+              CompiledProgram<kMixed>::isLeader(10) && !CompiledProgram<kMixed>::isLeader(1),
+              "basic blocks of kMixed");
+
+void expectSameState(RiscMachine& reference, const ConstexprMachine<kDataSize>& machine, const char* what) {
+    for (uint32_t address = 0; address < kDataSize; ++address) {
+        ASSERT_EQ(machine.getMemoryValue(address), reference.getMemoryValue(address)) << what << " RAM[" << address << "]";
+    }
+    const StatusRegister expected = reference.getStatusRegister();
+    const StatusRegister actual = machine.getStatusRegister();
+    EXPECT_EQ(actual.ZF, expected.ZF) << what;
+    EXPECT_EQ(actual.CF, expected.CF) << what;
+    EXPECT_EQ(actual.NF, expected.NF) << what;
+    EXPECT_EQ(actual.OF, expected.OF) << what;
+    EXPECT_EQ(actual.DF, expected.DF) << what;
+}
+
+}  // namespace
+
+class ConstexprMachineTest : public ::testing::TestWithParam<ExecutionEngine> {
+protected:
+    // Runs `program` on a RiscMachine and on both constexpr paths from the same memory, and compares them
+    template <const auto& Program>
+    void expectSameAsMachine(const std::vector<std::pair<uint32_t, uint32_t>>& inputs, uint32_t vlmax = 8) {
+        RiscMachine reference(256, kDataSize, GetParam());
+        reference.setVectorLength(vlmax);
+        reference.loadProgram(std::vector<Instruction>(Program.begin(), Program.end()));
+        for (const auto& word : inputs) reference.setMemoryValue(word.first, word.second);
+        const RunStatus expected = reference.run(UINT64_MAX);
+
+        auto interpreted = std::make_unique<ConstexprMachine<kDataSize>>();
+        interpreted->setVectorLength(vlmax);
+        for (const auto& word : inputs) interpreted->setMemoryValue(word.first, word.second);
+        EXPECT_EQ(interpreted->run(Program), expected);
+        expectSameState(reference, *interpreted, "interpreted");
+
+        auto specialised = std::make_unique<ConstexprMachine<kDataSize>>();
+        specialised->setVectorLength(vlmax);
+        for (const auto& word : inputs) specialised->setMemoryValue(word.first, word.second);
+        EXPECT_EQ(CompiledProgram<Program>::run(*specialised), expected);
+        expectSameState(reference, *specialised, "compiled");
+        EXPECT_EQ(specialised->getPc(), interpreted->getPc());
+        for (uint32_t r = 0; r < 16; ++r) EXPECT_EQ(specialised->getRegister(r), interpreted->getRegister(r));
+    }
+};
+
+TEST_P(ConstexprMachineTest, FactorialMatchesMachine) {
+    for (uint32_t n : {0u, 1u, 5u, 12u, 13u, 40u}) expectSameAsMachine<kFactorial>({{100, n}});
+}
+
+TEST_P(ConstexprMachineTest, FibonacciMatchesMachine) {
+    for (uint32_t n : {0u, 1u, 2u, 10u, 47u, 60u}) expectSameAsMachine<kFibonacci>({{100, n}});
+}
+
+TEST_P(ConstexprMachineTest, SumListMatchesMachine) {
+    for (uint32_t length : {0u, 1u, 100u, 800u}) {
+        std::vector<std::pair<uint32_t, uint32_t>> inputs = {{100, 200}, {101, length}};
+        for (uint32_t i = 0; i < length; ++i) inputs.emplace_back(200 + i, 0x9E3779B9u * i);
+        expectSameAsMachine<kSumList>(inputs);
+    }
+}
+
+TEST_P(ConstexprMachineTest, EveryInstructionKindMatchesMachine) {
+    for (uint32_t input : {3u, 7u, 0xFFFFFFF0u}) {
+        for (uint32_t initial : {0u, 5u}) {
+            for (uint32_t vlmax : {4u, 8u, 16u}) {
+                std::vector<std::pair<uint32_t, uint32_t>> inputs = {{100, input}, {500, initial}};
+                for (uint32_t i = 0; i < 16; ++i) inputs.emplace_back(300 + i, i * 11 + 1);
+                expectSameAsMachine<kMixed>(inputs, vlmax);
+            }
+        }
+    }
+}
+
+TEST_P(ConstexprMachineTest, FaultsMatchMachine) {
+    expectSameAsMachine<kIndirectFault>({{10, 42}});
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, ConstexprMachineTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             return info.param == ExecutionEngine::Switch     ? "Switch"
+                                    : info.param == ExecutionEngine::Threaded ? "Threaded"
+                                                                              : "Jit";
+                         });
+
+TEST(ConstexprMachineStandaloneTest, BudgetStopsAndResumes) {
+    ConstexprMachine<128> machine;
+    machine.setMemoryValue(100, 10);
+    EXPECT_EQ(machine.run(kFactorial, 5), RunStatus::BudgetExhausted);
+    EXPECT_EQ(machine.getPc(), 5u);
+    EXPECT_EQ(machine.getMemoryValue(101), 0u);
+
+    // The specialised program resumes mid-block
+    ASSERT_FALSE(CompiledProgram<kFactorial>::isLeader(5));
+    EXPECT_EQ(CompiledProgram<kFactorial>::run(machine), RunStatus::Halted);
+    EXPECT_EQ(machine.getMemoryValue(101), 3628800u);
+    EXPECT_EQ(machine.getPc(), kFactorial.size());
+}
+
+TEST(ConstexprMachineStandaloneTest, HostCallsAlwaysFault) {
+    ConstexprMachine<64> interpreted;
+    interpreted.setMemoryValue(10, 42);
+    EXPECT_EQ(interpreted.run(kHostCall), RunStatus::Faulted);
+    EXPECT_EQ(interpreted.getMemoryValue(10), 42u);
+
+    ConstexprMachine<64> specialised;
+    specialised.setMemoryValue(10, 42);
+    EXPECT_EQ(CompiledProgram<kHostCall>::run(specialised), RunStatus::Faulted);
+    EXPECT_EQ(specialised.getMemoryValue(10), 42u);
+}
+
+TEST(ConstexprMachineStandaloneTest, ResetKeepsMemory) {
+    ConstexprMachine<128> machine;
+    machine.setMemoryValue(100, 6);
+    machine.run(kFactorial);
+    EXPECT_EQ(machine.getMemoryValue(101), 720u);
+    EXPECT_EQ(machine.run(kFactorial), RunStatus::Halted);  // already at the end
+    machine.reset();
+    EXPECT_EQ(machine.getPc(), 0u);
+    machine.setMemoryValue(100, 7);
+    machine.run(kFactorial);
+    EXPECT_EQ(machine.getMemoryValue(101), 5040u);
+    machine.clearMemory();
+    EXPECT_EQ(machine.getMemoryValue(101), 0u);
+    EXPECT_EQ(machine.getMemoryValue(5000), 0u);
+}
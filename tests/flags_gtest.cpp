@@ -0,0 +1,113 @@
+/**
+ * @file flags_gtest.cpp
+ * @brief Unit tests for the lazily evaluated condition flags.
+ */
+
+#include "../src/flags.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+// Eagerly evaluated flags with the semantics of RiscMachine::execute
+struct EagerFlags {
+    uint32_t zf = 0, cf = 0, nf = 0, of = 0, df = 0;
+
+    void add(uint32_t a, uint32_t b) {
+        uint64_t result = static_cast<uint64_t>(a) + b;
+        cf = result > UINT32_MAX;
+        nf = (result >> 31) & 1;
+    }
+    void sub(uint32_t a, uint32_t b) {
+        cf = a < b;
+        nf = ((a - b) >> 31) & 1;
+    }
+    void mul(uint32_t a, uint32_t b) {
+        uint64_t result = static_cast<uint64_t>(a) * b;
+        of = result > UINT32_MAX;
+        nf = (result >> 31) & 1;
+    }
+    void div(uint32_t a, uint32_t b) {
+        if (b == 0) {
+            df = 1;
+        } else {
+            nf = ((a / b) >> 31) & 1;
+            df = 0;
+        }
+        of = 0;
+        cf = 0;
+    }
+};
+
+static void expectSame(const LazyFlags& lazy, const EagerFlags& eager) {
+    StatusRegister sr = lazy.get();
+    EXPECT_EQ(sr.ZF, eager.zf);
+    EXPECT_EQ(sr.CF, eager.cf);
+    EXPECT_EQ(sr.NF, eager.nf);
+    EXPECT_EQ(sr.OF, eager.of);
+    EXPECT_EQ(sr.DF, eager.df);
+    EXPECT_EQ(lazy.read(1), eager.cf);
+    EXPECT_EQ(lazy.read(2), eager.nf);
+    EXPECT_EQ(lazy.read(3), eager.of);
+    EXPECT_EQ(lazy.read(5), 0u);
+}
+
+TEST(LazyFlagsTest, StartsCleared) {
+    LazyFlags flags;
+    expectSame(flags, EagerFlags{});
+}
+
+TEST(LazyFlagsTest, NegativeComesFromLastWriter) {
+    LazyFlags flags;
+    EagerFlags eager;
+    flags.setMul(0x10000, 0x8000);  // product 2^31: NF = 1, OF = 0
+    eager.mul(0x10000, 0x8000);
+    flags.setAdd(UINT32_MAX, 2);    // carry, NF = 0; OF still from MUL
+    eager.add(UINT32_MAX, 2);
+    expectSame(flags, eager);
+
+    flags.setDivByZero();           // NF unchanged, CF/OF cleared
+    eager.div(5, 0);
+    expectSame(flags, eager);
+}
+
+TEST(LazyFlagsTest, SetReplacesPendingState) {
+    LazyFlags flags;
+    flags.setAdd(UINT32_MAX, 1);
+    StatusRegister sr{};
+    sr.NF = 1;
+    sr.OF = 1;
+    flags.set(sr);
+    EXPECT_EQ(flags.carry(), 0u);
+    EXPECT_EQ(flags.negative(), 1u);
+    EXPECT_EQ(flags.overflowed(), 1u);
+}
+
+TEST(LazyFlagsTest, RandomSequencesMatchEagerEvaluation) {
+    std::mt19937 rng(1234);
+    auto operand = [&rng]() -> uint32_t {
+        switch (rng() % 4) {
+            case 0: return rng() % 4;
+            case 1: return UINT32_MAX - rng() % 4;
+            case 2: return 0x80000000u + rng() % 4 - 2;
+            default: return static_cast<uint32_t>(rng());
+        }
+    };
+    for (int sequence = 0; sequence < 200; ++sequence) {
+        LazyFlags flags;
+        EagerFlags eager;
+        for (int step = 0; step < 50; ++step) {
+            uint32_t a = operand();
+            uint32_t b = operand();
+            switch (rng() % 5) {
+                case 0: flags.setAdd(a, b); eager.add(a, b); break;
+                case 1: flags.setSub(a, b); eager.sub(a, b); break;
+                case 2: flags.setMul(a, b); eager.mul(a, b); break;
+                case 3:
+                    if (b == 0) flags.setDivByZero(); else flags.setDiv(a / b);
+                    eager.div(a, b);
+                    break;
+                default: flags.setZero(a == b); eager.zf = (a == b); break;
+            }
+            expectSame(flags, eager);
+        }
+    }
+}
@@ -0,0 +1,209 @@
+/**
+ * @file hart_gtest.cpp
+ * @brief Unit tests for multi-hart execution over shared data memory.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include "../src/data_memory.hpp"
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+
+class HartTest : public ::testing::TestWithParam<ExecutionEngine> {};
+
+TEST_P(HartTest, HartsHaveTheirOwnIdsAndRegisters) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram({
+        {Opcode::HART_ID, 0, 0, 0},
+        {Opcode::LOAD, 1, 100, 2},
+        {Opcode::ADD, 1, 1, 0},
+        {Opcode::LOAD, 2, 1, 2},
+        {Opcode::ATOMIC_ADD, 3, 1, 2},  // RAM[100 + hart] += 1
+        {Opcode::HALT, 0, 0, 0}
+    });
+    std::vector<HartState> harts = machine.runHarts(4);
+    ASSERT_EQ(harts.size(), 4u);
+    for (uint32_t id = 0; id < 4; ++id) {
+        EXPECT_EQ(harts[id].registers[0], id);
+        EXPECT_EQ(harts[id].registers[3], 0u);
+        EXPECT_EQ(harts[id].pc, 6u);
+        EXPECT_EQ(machine.getMemoryValue(100 + id), 1u);
+    }
+    EXPECT_EQ(machine.getMemoryValue(104), 0u);
+}
+
+TEST_P(HartTest, AtomicAddCountsEveryIncrement) {
+    constexpr uint32_t kHarts = 4;
+    constexpr uint32_t kIterations = 20000;
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setMemoryValue(100, kIterations);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 0},      // R0 = iterations
+        {Opcode::LOAD, 1, 1, 2},        // R1 = 1
+        {Opcode::LOAD, 2, 200, 2},      // R2 = counter address
+        {Opcode::LOAD, 4, 0, 2},        // R4 = 0
+        {Opcode::CMP, 0, 0, 4},         // loop @ pc = 4
+        {Opcode::JMP, 9, 1, 0},
+        {Opcode::ATOMIC_ADD, 3, 2, 1},
+        {Opcode::SUB, 0, 0, 1},
+        {Opcode::JMP, 4, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.runHarts(kHarts);
+    EXPECT_EQ(machine.getMemoryValue(200), kHarts * kIterations);
+}
+
+TEST_P(HartTest, CasSpinlockProtectsPlainCounter) {
+    constexpr uint32_t kHarts = 3;
+    constexpr uint32_t kIterations = 2000;
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setMemoryValue(100, kIterations);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 0},      // R0 = iterations
+        {Opcode::LOAD, 1, 1, 2},        // R1 = 1
+        {Opcode::LOAD, 2, 300, 2},      // R2 = lock address
+        {Opcode::LOAD, 4, 0, 2},        // R4 = 0
+        {Opcode::CMP, 0, 0, 4},         // loop @ pc = 4
+        {Opcode::JMP, 18, 1, 0},
+        {Opcode::LOAD, 3, 0, 2},        // acquire @ pc = 6: R3 = 0 (expected)
+        {Opcode::CAS, 3, 2, 1},
+        {Opcode::JMP, 10, 1, 0},
+        {Opcode::JMP, 6, 0, 0},
+        {Opcode::FENCE, 0, 0, 0},       // critical section @ pc = 10
+        {Opcode::LOAD, 5, 301, 0},
+        {Opcode::ADD, 5, 5, 1},
+        {Opcode::STORE, 301, 5, 0},
+        {Opcode::FENCE, 0, 0, 0},
+        {Opcode::STORE, 300, 4, 0},     // release
+        {Opcode::SUB, 0, 0, 1},
+        {Opcode::JMP, 4, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.runHarts(kHarts);
+    EXPECT_EQ(machine.getMemoryValue(301), kHarts * kIterations);
+    EXPECT_EQ(machine.getMemoryValue(300), 0u);
+}
+
+TEST_P(HartTest, HartsAllocatePagesOnFirstWrite) {
+    constexpr uint32_t kHarts = 4;
+    RiscMachine machine(256, 1u << 22, GetParam());  // 4096 pages
+    machine.loadProgram({
+        {Opcode::HART_ID, 0, 0, 0},
+        {Opcode::LOAD, 1, DataMemory::kPageWords * 7, 2},
+        {Opcode::MUL, 1, 1, 0},         // R1 = hart * 7 pages
+        {Opcode::LOAD, 2, 1, 2},
+        {Opcode::ADD, 3, 0, 2},         // R3 = hart + 1
+        {Opcode::MEMSET, 1, 3, 2},      // RAM[R1] = hart + 1
+        {Opcode::LOAD, 4, 5000, 2},
+        {Opcode::ATOMIC_ADD, 5, 4, 2},  // every hart races to allocate the page of 5000
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.runHarts(kHarts);
+    for (uint32_t id = 0; id < kHarts; ++id) {
+        EXPECT_EQ(machine.getMemoryValue(id * DataMemory::kPageWords * 7), id + 1) << "hart " << id;
+    }
+    EXPECT_EQ(machine.getMemoryValue(5000), kHarts);
+}
+
+TEST_P(HartTest, ParallelSumList) {
+    constexpr uint32_t kLength = 100003;
+    RiscMachine machine(256, 200000, GetParam());
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < kLength; ++i) {
+        machine.setMemoryValue(1000 + i, i * 2654435761u);
+        expected += i * 2654435761u;
+    }
+    machine.setMemoryValue(100, 1000);
+    machine.setMemoryValue(101, kLength);
+    machine.loadProgram(createParallelSumListProgram(100, 101, 102, 103));
+    for (uint32_t harts : {1u, 2u, 4u, 7u}) {
+        machine.setMemoryValue(102, harts);
+        machine.setMemoryValue(103, 0);
+        machine.reset();
+        machine.runHarts(harts);
+        EXPECT_EQ(machine.getMemoryValue(103), expected) << harts << " harts";
+    }
+}
+
+TEST_P(HartTest, ParallelFibonacciTable) {
+    constexpr uint32_t kEntries = 40;
+    for (uint32_t harts : {1u, 3u}) {
+        RiscMachine machine(256, 1024, GetParam());
+        machine.setMemoryValue(100, kEntries);
+        machine.setMemoryValue(101, harts);
+        machine.loadProgram(createParallelFibonacciTableProgram(100, 101, 200, 102));
+        machine.runHarts(harts);
+        uint32_t previous = 0, current = 1;
+        EXPECT_EQ(machine.getMemoryValue(200), 0u);
+        for (uint32_t i = 1; i < kEntries; ++i) {
+            EXPECT_EQ(machine.getMemoryValue(200 + i), current) << "entry " << i;
+            uint32_t next = previous + current;
+            previous = current;
+            current = next;
+        }
+        EXPECT_EQ(machine.getMemoryValue(102), kEntries);
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, HartTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Switch: return "Switch";
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 default: return "Jit";
+                             }
+                         });
+
+TEST(ParallelSumListTest, EmptySlicesPublishZero) {
+    RiscMachine machine;
+    machine.setMemoryValue(100, 500);
+    machine.setMemoryValue(101, 0);
+    machine.setMemoryValue(102, 2);
+    machine.loadProgram(createParallelSumListProgram(100, 101, 102, 103));
+    std::vector<HartState> harts = machine.runHarts(2);
+    EXPECT_EQ(harts[1].registers[4], 1u);
+    EXPECT_EQ(machine.getMemoryValue(103), 0u);
+}
+
+TEST(SharedViewTest, ViewsAllocateOnlyThePagesTheyWrite) {
+    constexpr uint32_t kThreads = 4;
+    DataMemory memory(64 * DataMemory::kPageWords);
+    memory.write(3, 7);
+    const DataMemory snapshot(memory);
+
+    std::vector<DataMemory> views;
+    for (uint32_t i = 0; i < kThreads; ++i) views.push_back(memory.sharedView());
+    // The written page was made exclusive; the others stay unallocated
+    EXPECT_EQ(memory.residentPages(), 1u);
+
+    std::vector<std::thread> threads;
+    for (uint32_t i = 0; i < kThreads; ++i) {
+        threads.emplace_back([&views, i] {
+            DataMemory& view = views[i];
+            view.write((10 + i) * DataMemory::kPageWords, i + 1);  // a page of its own
+            view.fetchAdd(20 * DataMemory::kPageWords + i, 1);     // a page every thread races for
+            view.write(3, 8);
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    EXPECT_EQ(memory.residentPages(), 1u + kThreads + 1u);
+    for (uint32_t i = 0; i < kThreads; ++i) {
+        for (const DataMemory* reader : {&memory, &views[0], &views[kThreads - 1]}) {
+            EXPECT_EQ(reader->read((10 + i) * DataMemory::kPageWords), i + 1);
+            EXPECT_EQ(reader->read(20 * DataMemory::kPageWords + i), 1u);
+        }
+    }
+    EXPECT_EQ(memory.read(3), 8u);
+    EXPECT_EQ(snapshot.read(3), 7u);
+    EXPECT_EQ(snapshot.residentPages(), 1u);
+
+    // Once the views are gone, a copy is copy-on-write again
+    views.clear();
+    DataMemory copy(memory);
+    copy.write(3, 9);
+    EXPECT_EQ(copy.copiedPages(), 1u);
+    EXPECT_EQ(memory.read(3), 8u);
+}
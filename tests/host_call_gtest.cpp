@@ -0,0 +1,250 @@
+/**
+ * @file host_call_gtest.cpp
+ * @brief Unit tests for HOSTCALL, the host call registry and the built-in kernels.
+ */
+
+#include "../src/algorithms.hpp"
+#include "../src/host_call.hpp"
+#include "../src/machine.hpp"
+#include "../src/optimizer.hpp"
+#include "../src/replay.hpp"
+#include "../src/wide_machine.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+class HostCallTest : public ::testing::TestWithParam<ExecutionEngine> {
+protected:
+    // R0 = a, R1 = b, HOSTCALL id, then RAM[10] = R0, RAM[11] = R2, RAM[12] = ZF
+    static std::vector<Instruction> callProgram(uint32_t id, uint32_t a, uint32_t b) {
+        return {
+            {Opcode::LOAD, 0, a, 2},
+            {Opcode::LOAD, 1, b, 2},
+            {Opcode::HOSTCALL, id, 0, 0},
+            {Opcode::CHECK_FLAG, 3, 0, 0},
+            {Opcode::STORE, 10, 0, 0},
+            {Opcode::STORE, 11, 2, 0},
+            {Opcode::STORE, 12, 3, 0},
+            {Opcode::HALT, 0, 0, 0}
+        };
+    }
+
+    static std::vector<uint32_t> randomWords(size_t count, uint32_t seed) {
+        std::vector<uint32_t> words(count);
+        for (uint32_t& word : words) {
+            seed = seed * 1103515245u + 12345u;
+            word = seed;
+        }
+        return words;
+    }
+};
+
+TEST_P(HostCallTest, FunctionReadsAndWritesRegistersMemoryAndFlags) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.bindHostCall(7, [](HostCall& call) {
+        uint32_t word = 0;
+        if (!call.memory.load(call.registers[1], word)) return false;
+        call.registers[0] += word;
+        call.registers[2] = static_cast<uint32_t>(call.register_count);
+        StatusRegister status = call.getFlags();
+        status.ZF = true;
+        call.setFlags(status);
+        return call.memory.store(20, call.registers[0]);
+    });
+    machine.setMemoryValue(100, 35);
+    machine.loadProgram(callProgram(7, 7, 100));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(10), 42u);
+    EXPECT_EQ(machine.getMemoryValue(11), 16u);
+    EXPECT_EQ(machine.getMemoryValue(12), 1u);
+    EXPECT_EQ(machine.getMemoryValue(20), 42u);
+}
+
+TEST_P(HostCallTest, UnboundAndFailingCallsFault) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram(callProgram(3, 1, 2));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(10), 0u);  // halted before the stores
+
+    machine.bindHostCall(3, [](HostCall& call) { return call.memory.store(5000, 1); });  // out of bounds
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(10), 0u);
+
+    machine.bindHostCall(3, HostFunction());  // unbound again
+    EXPECT_EQ(machine.getHostCalls().find(3), nullptr);
+}
+
+TEST_P(HostCallTest, BuiltinSortMatchesGuestSort) {
+    const std::vector<uint32_t> input = randomWords(300, 11);
+    RiscMachine guest(256, 4 * DataMemory::kPageWords, GetParam());
+    guest.loadProgram(createInsertionSortProgram(0, 1));
+    guest.setMemoryValue(0, 1000);
+    guest.setMemoryValue(1, static_cast<uint32_t>(input.size()));
+    ASSERT_TRUE(guest.writeMemory(1000, input));
+    guest.run();
+
+    RiscMachine host(256, 4 * DataMemory::kPageWords, GetParam());
+    host.setHostCalls(HostCallTable::builtins());
+    host.loadProgram(callProgram(kHostSortWords, 1000, static_cast<uint32_t>(input.size())));
+    ASSERT_TRUE(host.writeMemory(1000, input));
+    host.run();
+
+    std::vector<uint32_t> expected = input;
+    std::sort(expected.begin(), expected.end());
+    std::vector<uint32_t> guest_sorted(input.size()), host_sorted(input.size());
+    ASSERT_TRUE(guest.readMemory(1000, guest_sorted));
+    ASSERT_TRUE(host.readMemory(1000, host_sorted));
+    EXPECT_EQ(guest_sorted, expected);
+    EXPECT_EQ(host_sorted, expected);
+}
+
+TEST_P(HostCallTest, BuiltinHashMatchesGuestHash) {
+    for (uint32_t length : {0u, 1u, 2500u}) {
+        const std::vector<uint32_t> input = randomWords(length, length + 3);
+        RiscMachine guest(256, 4 * DataMemory::kPageWords, GetParam());
+        guest.loadProgram(createHashListProgram(0, 1, 2));
+        guest.setMemoryValue(0, 100);
+        guest.setMemoryValue(1, length);
+        ASSERT_TRUE(guest.writeMemory(100, input));
+        guest.run();
+
+        RiscMachine host(256, 4 * DataMemory::kPageWords, GetParam());
+        host.setHostCalls(HostCallTable::builtins());
+        host.loadProgram(callProgram(kHostHashWords, 100, length));
+        ASSERT_TRUE(host.writeMemory(100, input));
+        host.run();
+        EXPECT_EQ(host.getMemoryValue(10), guest.getMemoryValue(2)) << "length " << length;
+    }
+}
+
+TEST_P(HostCallTest, BuiltinBigMultiply) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setHostCalls(HostCallTable::builtins());
+    // (2^64 - 1) * (2^32 + 1) = 2^96 + 2^64 - 2^32 - 1
+    ASSERT_TRUE(machine.writeMemory(100, {0xFFFFFFFFu, 0xFFFFFFFFu}));
+    ASSERT_TRUE(machine.writeMemory(200, {1, 1}));
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 2},
+        {Opcode::LOAD, 1, 2, 2},
+        {Opcode::LOAD, 2, 200, 2},
+        {Opcode::LOAD, 3, 2, 2},
+        {Opcode::LOAD, 4, 300, 2},
+        {Opcode::HOSTCALL, kHostBigMultiply, 0, 0},
+        {Opcode::CHECK_FLAG, 5, 0, 0},
+        {Opcode::STORE, 10, 5, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    std::vector<uint32_t> product(4);
+    ASSERT_TRUE(machine.readMemory(300, product));
+    EXPECT_EQ(product, (std::vector<uint32_t>{0xFFFFFFFFu, 0xFFFFFFFEu, 0, 1}));
+    EXPECT_EQ(machine.getMemoryValue(10), 0u);
+
+    // A product range beyond the end faults without writing
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 2},
+        {Opcode::LOAD, 1, 2, 2},
+        {Opcode::LOAD, 2, 200, 2},
+        {Opcode::LOAD, 3, 2, 2},
+        {Opcode::LOAD, 4, 1021, 2},
+        {Opcode::HOSTCALL, kHostBigMultiply, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(1021), 0u);
+}
+
+TEST_P(HostCallTest, ForksShareBindingsUntilRebound) {
+    RiscMachine parent(256, 1024, GetParam());
+    parent.bindHostCall(1, [](HostCall& call) { call.registers[0] = 5; return true; });
+    parent.loadProgram(callProgram(1, 0, 0));
+    RiscMachine child = parent.fork();
+    parent.bindHostCall(1, [](HostCall& call) { call.registers[0] = 6; return true; });
+    child.run();
+    parent.run();
+    EXPECT_EQ(child.getMemoryValue(10), 5u);
+    EXPECT_EQ(parent.getMemoryValue(10), 6u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, HostCallTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Switch: return "Switch";
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 default: return "Jit";
+                             }
+                         });
+
+TEST(HostCallRegistryTest, HartsCallWithTheirOwnIndex) {
+    RiscMachine machine(256, 1024);
+    machine.bindHostCall(0, [](HostCall& call) { return call.memory.store(100 + call.hart_id, call.hart_id + 1); });
+    machine.loadProgram({{Opcode::HOSTCALL, 0, 0, 0}, {Opcode::HALT, 0, 0, 0}});
+    machine.runHarts(4);
+    for (uint32_t hart = 0; hart < 4; ++hart) EXPECT_EQ(machine.getMemoryValue(100 + hart), hart + 1);
+}
+
+TEST(HostCallRegistryTest, ReplayUsesTheGivenBindings) {
+    const std::string path = ::testing::TempDir() + "risc_host_call.replay";
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 100, 2},
+        {Opcode::LOAD, 1, 50, 2},
+        {Opcode::HOSTCALL, kHostHashWords, 0, 0},
+        {Opcode::STORE, 10, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    RiscMachine machine;
+    machine.setHostCalls(HostCallTable::builtins());
+    machine.loadProgram(program);
+    ASSERT_TRUE(machine.startRecording(path));
+    for (uint32_t i = 0; i < 50; ++i) machine.setMemoryValue(100 + i, i * i);
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    ReplayOptions options;
+    options.host_calls = HostCallTable::builtins();
+    ReplayResult result = replayRecording(path, {program}, options);
+    ReplayResult unbound = replayRecording(path, {program});
+    std::remove(path.c_str());
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.machine.getMemoryValue(10), machine.getMemoryValue(10));
+    EXPECT_TRUE(unbound.diverged);
+}
+
+TEST(HostCallRegistryTest, OptimizerKeepsHostCallsAndTheirInputs) {
+    // The host function reads R2, which is otherwise dead, and sets ZF
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 2, 9, 2},
+        {Opcode::LOAD, 1, 0, 2},
+        {Opcode::CMP, 0, 1, 1},
+        {Opcode::HOSTCALL, 0, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    };
+    const OptimizedProgram optimized = optimizeProgram(program, 16, 1024);
+    RiscMachine machine;
+    machine.bindHostCall(0, [](HostCall& call) {
+        call.flags.setZero(false);
+        return call.memory.store(50, call.registers[2]);
+    });
+    machine.loadProgram(optimized.program);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(50), 9u);
+    EXPECT_FALSE(machine.getStatusRegister().ZF);
+}
+
+TEST(HostCallRegistryTest, WideMachineLanesFault) {
+    WideMachine<8> wide(1024);
+    wide.loadProgram({
+        {Opcode::LOAD, 0, 1, 2},
+        {Opcode::STORE, 0, 0, 0},
+        {Opcode::HOSTCALL, 0, 0, 0},
+        {Opcode::STORE, 1, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    wide.run();
+    for (size_t lane = 0; lane < 8; ++lane) {
+        EXPECT_EQ(wide.getMemoryValue(lane, 0), 1u);
+        EXPECT_EQ(wide.getMemoryValue(lane, 1), 0u);
+    }
+}
@@ -11,6 +11,7 @@
 #include "../src/algorithms.hpp"
 #include "../src/instruction.hpp"
 #include <gtest/gtest.h>
+#include <random>
 
 class RiscMachineTest : public ::testing::Test {
 protected:
@@ -350,3 +351,384 @@ TEST_F(FibonacciTest, FibOf48_Overflow) {
 
     EXPECT_TRUE(machine.getStatusRegister().CF);
 }
+
+
+// Execution Engine Test Region
+
+class EngineTest : public ::testing::TestWithParam<ExecutionEngine> {
+    protected:
+        // Runs the same program on the switch engine and the engine under test and
+        // compares the observable state (data memory and status register).
+        void expectSameResult(const std::vector<Instruction>& program,
+                              const std::vector<std::pair<uint32_t, uint32_t>>& memory) {
+            RiscMachine reference(512, 512, ExecutionEngine::Switch);
+            RiscMachine tested(512, 512, GetParam());
+            for (const auto& [address, value] : memory) {
+                reference.setMemoryValue(address, value);
+                tested.setMemoryValue(address, value);
+            }
+            reference.loadProgram(program);
+            tested.loadProgram(program);
+            reference.run();
+            tested.run();
+
+            for (uint32_t address = 0; address < 512; ++address) {
+                ASSERT_EQ(tested.getMemoryValue(address), reference.getMemoryValue(address))
+                    << "memory differs at address " << address;
+            }
+            StatusRegister expected = reference.getStatusRegister();
+            StatusRegister actual = tested.getStatusRegister();
+            EXPECT_EQ(actual.ZF, expected.ZF);
+            EXPECT_EQ(actual.CF, expected.CF);
+            EXPECT_EQ(actual.NF, expected.NF);
+            EXPECT_EQ(actual.OF, expected.OF);
+            EXPECT_EQ(actual.DF, expected.DF);
+        }
+    };
+
+TEST(EngineSelection, SelectedAtConstruction) {
+    RiscMachine machine(256, 1024, ExecutionEngine::Threaded);
+    EXPECT_EQ(machine.getEngine(), ExecutionEngine::Threaded);
+    EXPECT_EQ(RiscMachine().getEngine(), ExecutionEngine::Switch);
+}
+
+TEST(EngineSelection, JitCompilesWhenSupported) {
+    RiscMachine machine(256, 1024, ExecutionEngine::Jit);
+    machine.loadProgram(createFibonacciProgram(100, 101));
+    EXPECT_EQ(machine.isJitCompiled(), JitProgram::isSupported());
+
+    RiscMachine interpreted(256, 1024, ExecutionEngine::Threaded);
+    interpreted.loadProgram(createFibonacciProgram(100, 101));
+    EXPECT_FALSE(interpreted.isJitCompiled());
+}
+
+TEST_P(EngineTest, Factorial) {
+    for (uint32_t n : {0u, 1u, 5u, 12u, 13u, 100000u}) {
+        expectSameResult(createFactorialProgram(100, 101), {{100, n}});
+    }
+}
+
+TEST_P(EngineTest, Fibonacci) {
+    for (uint32_t n : {0u, 1u, 6u, 47u, 48u}) {
+        expectSameResult(createFibonacciProgram(100, 101), {{100, n}});
+    }
+}
+
+TEST_P(EngineTest, SumList) {
+    expectSameResult(createSumListProgram(300, 301, 302),
+                     {{300, 400}, {301, 4}, {400, 10}, {401, 20}, {402, 30}, {403, 40}});
+    expectSameResult(createSumListProgram(300, 301, 302),
+                     {{300, 400}, {301, 2}, {400, UINT32_MAX - 10}, {401, 20}});
+    expectSameResult(createSumListProgram(300, 301, 302), {{300, 400}, {301, 0}});
+}
+
+TEST_P(EngineTest, InvalidOperandsAreIgnored) {
+    expectSameResult({
+        {Opcode::LOAD, 0, 7, 2},
+        {Opcode::LOAD, 20, 100, 0},     // invalid destination register
+        {Opcode::LOAD, 1, 9999, 0},     // address out of range
+        {Opcode::LOAD, 1, 100, 3},      // unknown addressing mode
+        {Opcode::STORE, 9999, 0, 0},    // address out of range
+        {Opcode::ADD, 2, 0, 16},        // invalid source register
+        {Opcode::CMP, 0, 0, 0},         // ZF = 1
+        {Opcode::CMP, 0, 0, 99},        // invalid compare clears ZF
+        {Opcode::JMP, 500, 0, 0},       // jump target out of range
+        {Opcode::JMP, 11, 7, 0},        // unknown condition never jumps
+        {Opcode::CHECK_FLAG, 3, 9, 0},  // unknown flag reads as 0
+        {Opcode::STORE, 101, 3, 0},
+        {Opcode::HALT, 0, 0, 0}
+    }, {{100, 5}});
+}
+
+TEST_P(EngineTest, WideOperandsSurvivePacking) {
+    expectSameResult({
+        {Opcode::LOAD, 15, UINT32_MAX, 2},  // full 32-bit immediate
+        {Opcode::LOAD, 14, 511, 0},         // last data address
+        {Opcode::ADD, 13, 15, 14},
+        {Opcode::STORE, 511, 13, 0},
+        {Opcode::STORE, 510, 15, 0},
+        {Opcode::CHECK_FLAG, 12, 1, 0},
+        {Opcode::STORE, 509, 12, 0},
+        {Opcode::HALT, 0, 0, 0}
+    }, {{511, 2}});
+}
+
+TEST_P(EngineTest, IndirectLoadOutOfBoundsHalts) {
+    expectSameResult({
+        {Opcode::LOAD, 0, 600, 2},      // R0 = 600 (beyond data memory)
+        {Opcode::LOAD, 1, 0, 1},        // R1 = RAM[R0] → fault
+        {Opcode::STORE, 100, 0, 0},     // never executed
+        {Opcode::HALT, 0, 0, 0}
+    }, {});
+}
+
+TEST_P(EngineTest, RandomForwardPrograms) {
+    std::mt19937 rng(1234);
+    auto next = [&rng](uint32_t bound) { return static_cast<uint32_t>(rng() % bound); };
+    const Opcode opcodes[] = {Opcode::LOAD, Opcode::STORE, Opcode::ADD, Opcode::SUB,
+                              Opcode::CMP, Opcode::JMP, Opcode::MUL, Opcode::DIV,
+                              Opcode::MOV, Opcode::CHECK_FLAG};
+    for (int iteration = 0; iteration < 200; ++iteration) {
+        std::vector<Instruction> program;
+        const uint32_t length = 40;
+        for (uint32_t i = 0; i < length; ++i) {
+            Instruction instr{opcodes[next(10)]};
+            switch (instr.opcode) {
+                case Opcode::LOAD: {
+                    uint32_t mode = next(3);
+                    uint32_t operand = mode == 0 ? 100 + next(8)
+                                     : mode == 1 ? next(8)
+                                     : static_cast<uint32_t>(rng());
+                    instr = {Opcode::LOAD, next(8), operand, mode};
+                    break;
+                }
+                case Opcode::STORE:
+                    instr = {Opcode::STORE, 100 + next(16), next(8), 0};
+                    break;
+                case Opcode::JMP:
+                    // Forward jumps only, so every program terminates
+                    instr = {Opcode::JMP, i + 1 + next(length - i), next(2), 0};
+                    break;
+                case Opcode::CHECK_FLAG:
+                    instr = {Opcode::CHECK_FLAG, next(8), next(6), 0};
+                    break;
+                default:
+                    instr = {instr.opcode, next(8), next(8), next(8)};
+                    break;
+            }
+            program.push_back(instr);
+        }
+        program.push_back({Opcode::HALT, 0, 0, 0});
+
+        std::vector<std::pair<uint32_t, uint32_t>> memory;
+        for (uint32_t address = 100; address < 108; ++address) {
+            memory.emplace_back(address, next(4) == 0 ? UINT32_MAX - next(4) : next(64));
+        }
+        expectSameResult(program, memory);
+    }
+}
+
+TEST_P(EngineTest, JumpIntoFusedSequence) {
+    // PC 3 (JMP after CMP) and PC 5 (CMP after CHECK_FLAG) are also entered directly
+    expectSameResult({
+        {Opcode::LOAD, 0, 100, 0},
+        {Opcode::LOAD, 1, 1, 2},
+        {Opcode::CMP, 0, 0, 1},
+        {Opcode::JMP, 10, 1, 0},
+        {Opcode::CHECK_FLAG, 2, 0, 0},
+        {Opcode::CMP, 0, 2, 1},
+        {Opcode::JMP, 12, 1, 0},
+        {Opcode::SUB, 0, 0, 1},
+        {Opcode::CMP, 0, 0, 1},
+        {Opcode::JMP, 3, 0, 0},
+        {Opcode::LOAD, 2, 1, 2},
+        {Opcode::JMP, 5, 0, 0},
+        {Opcode::STORE, 101, 0, 0},
+        {Opcode::STORE, 102, 2, 0},
+        {Opcode::HALT, 0, 0, 0}
+    }, {{100, 3}});
+}
+
+TEST_P(EngineTest, AtomicOpcodes) {
+    expectSameResult({
+        {Opcode::LOAD, 0, 100, 2},      // R0 = 100
+        {Opcode::LOAD, 1, 5, 2},
+        {Opcode::ATOMIC_ADD, 2, 0, 1},  // R2 = 7, RAM[100] = 12
+        {Opcode::STORE, 101, 2, 0},
+        {Opcode::LOAD, 3, 12, 2},
+        {Opcode::LOAD, 4, 40, 2},
+        {Opcode::CAS, 3, 0, 4},         // succeeds: RAM[100] = 40, ZF = 1
+        {Opcode::CHECK_FLAG, 5, 0, 0},
+        {Opcode::STORE, 102, 5, 0},
+        {Opcode::CAS, 3, 0, 1},         // fails: R3 = 40, ZF = 0
+        {Opcode::STORE, 103, 3, 0},
+        {Opcode::FENCE, 0, 0, 0},
+        {Opcode::HART_ID, 6, 0, 0},
+        {Opcode::LOAD, 7, 9, 2},
+        {Opcode::ADD, 7, 7, 6},
+        {Opcode::STORE, 104, 7, 0},
+        {Opcode::HALT, 0, 0, 0}
+    }, {{100, 7}});
+
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setMemoryValue(100, 7);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 2},
+        {Opcode::LOAD, 1, 5, 2},
+        {Opcode::ATOMIC_ADD, 2, 0, 1},
+        {Opcode::STORE, 101, 2, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(100), 12u);
+    EXPECT_EQ(machine.getMemoryValue(101), 7u);
+}
+
+TEST_P(EngineTest, AtomicOutOfBoundsFaults) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 5000, 2},
+        {Opcode::ATOMIC_ADD, 1, 0, 0},
+        {Opcode::STORE, 100, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(100), 0u);
+}
+
+TEST_P(EngineTest, BudgetedSlicesMatchOneRun) {
+    struct Case {
+        std::vector<Instruction> program;
+        uint32_t n;
+        bool reduction;
+    };
+    const std::vector<Case> cases = {
+        {createFibonacciProgram(100, 101), 40, true},  // fused records
+        {createFactorialProgram(100, 101), 30, true},
+        {createSumListProgram(100, 101, 102), 3000, true},
+        {createSumListProgram(100, 101, 102), 3000, false},
+    };
+    for (const Case& c : cases) {
+        for (uint64_t budget : {1u, 5u, 16u, 77u, 1000u, 1u << 20}) {
+            RiscMachine whole(256, 4096, GetParam());
+            RiscMachine sliced(256, 4096, GetParam());
+            for (RiscMachine* m : {&whole, &sliced}) {
+                m->setReductionEnabled(c.reduction);
+                m->loadProgram(c.program);
+                for (uint32_t i = 0; i < 3000; ++i) m->setMemoryValue(1000 + i, i * 7);
+                m->setMemoryValue(100, c.n == 3000 ? 1000 : c.n);
+                m->setMemoryValue(101, c.n);
+            }
+            whole.setStatsEnabled(true);
+            whole.run();
+            uint64_t steps = 0;
+            RunStatus status;
+            do {
+                status = sliced.run(budget);
+                EXPECT_LE(sliced.getLastRunSteps(), budget);
+                steps += sliced.getLastRunSteps();
+            } while (status == RunStatus::BudgetExhausted);
+            EXPECT_EQ(status, RunStatus::Halted);
+            for (uint32_t address : {101u, 102u}) {
+                EXPECT_EQ(sliced.getMemoryValue(address), whole.getMemoryValue(address)) << "budget " << budget;
+            }
+            EXPECT_EQ(sliced.getStatusRegister().ZF, whole.getStatusRegister().ZF);
+            EXPECT_EQ(sliced.getStatusRegister().CF, whole.getStatusRegister().CF);
+            EXPECT_EQ(steps, whole.getStats().instructions_retired) << "budget " << budget;
+        }
+    }
+
+    // Large budgets run on the threaded code, whose fused records save dispatches
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram(createFibonacciProgram(100, 101));
+    machine.setMemoryValue(100, 40);
+    EXPECT_EQ(machine.run(100000), RunStatus::Halted);
+    EXPECT_GT(machine.getFusedDispatchesSaved(), 0u);
+
+    // A fault on the threaded code is reported like on the switch engine
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 5000, 2},
+        {Opcode::LOAD, 1, 0, 1},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    EXPECT_EQ(machine.run(100), RunStatus::Faulted);
+    EXPECT_EQ(machine.getLastRunSteps(), 2u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, EngineTest,
+                         ::testing::Values(ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             return info.param == ExecutionEngine::Jit ? "Jit" : "Threaded";
+                         });
+
+
+// Macro-op Fusion Test Region
+
+class FusionTest : public ::testing::Test {
+    protected:
+        RiscMachine fused{512, 512, ExecutionEngine::Threaded};
+        RiscMachine unfused{512, 512, ExecutionEngine::Threaded};
+
+        void SetUp() override {
+            unfused.setFusionEnabled(false);
+        }
+
+        void runBoth(const std::vector<Instruction>& program, uint32_t n) {
+            for (RiscMachine* machine : {&fused, &unfused}) {
+                machine->setMemoryValue(100, n);
+                machine->loadProgram(program);
+                machine->run();
+            }
+        }
+    };
+
+TEST_F(FusionTest, FibonacciCountsRemovedDispatches) {
+    runBoth(createFibonacciProgram(100, 101), 10);
+    EXPECT_EQ(fused.getMemoryValue(101), 55);
+    EXPECT_EQ(unfused.getMemoryValue(101), 55);
+    EXPECT_EQ(unfused.getFusedDispatchesSaved(), 0u);
+
+    // Per loop iteration: CMP+JMP saves one dispatch, CHECK_FLAG+CMP+JMP saves two;
+    // the initial n == 0 and n == 1 checks save one each, the final exit check one.
+    EXPECT_EQ(fused.getFusedDispatchesSaved(), 2u + 9u * 3u + 1u);
+}
+
+TEST_F(FusionTest, StatisticResetOnLoad) {
+    runBoth(createFactorialProgram(100, 101), 5);
+    EXPECT_GT(fused.getFusedDispatchesSaved(), 0u);
+    fused.loadProgram(createFactorialProgram(100, 101));
+    EXPECT_EQ(fused.getFusedDispatchesSaved(), 0u);
+}
+
+TEST_F(FusionTest, OverflowCheckMatchesUnfused) {
+    runBoth(createFibonacciProgram(100, 101), 48);
+    EXPECT_EQ(fused.getMemoryValue(101), unfused.getMemoryValue(101));
+    EXPECT_EQ(fused.getStatusRegister().CF, 1u);
+    EXPECT_EQ(fused.getStatusRegister().ZF, unfused.getStatusRegister().ZF);
+}
+
+TEST_F(RiscMachineTest, BudgetedRunStopsAndResumes) {
+    machine.loadProgram({{Opcode::JMP, 0, 0, 0}});  // spins forever
+    EXPECT_EQ(machine.run(1000), RunStatus::BudgetExhausted);
+    EXPECT_EQ(machine.getLastRunSteps(), 1000u);
+    EXPECT_EQ(machine.run(0), RunStatus::BudgetExhausted);
+    EXPECT_EQ(machine.getLastRunSteps(), 0u);
+
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 5000, 2},  // beyond data memory
+        {Opcode::LOAD, 1, 0, 1},     // fault
+        {Opcode::HALT, 0, 0, 0}
+    });
+    EXPECT_EQ(machine.run(1), RunStatus::BudgetExhausted);
+    EXPECT_EQ(machine.run(10), RunStatus::Faulted);
+    EXPECT_EQ(machine.getLastRunSteps(), 1u);
+    machine.reset();
+    machine.loadProgram({{Opcode::HALT, 0, 0, 0}});
+    EXPECT_EQ(machine.run(10), RunStatus::Halted);
+}
+
+TEST_F(RiscMachineTest, BudgetedSlicesMatchOneRun) {
+    for (bool reduction : {true, false}) {
+        RiscMachine whole(256, 4096);
+        RiscMachine sliced(256, 4096);
+        for (RiscMachine* m : {&whole, &sliced}) {
+            m->setReductionEnabled(reduction);
+            m->loadProgram(createSumListProgram(100, 101, 102));
+            for (uint32_t i = 0; i < 3000; ++i) m->setMemoryValue(1000 + i, i * 7);
+            m->setMemoryValue(100, 1000);
+            m->setMemoryValue(101, 3000);
+        }
+        whole.setStatsEnabled(true);
+        whole.run();
+        uint64_t steps = 0;
+        RunStatus status;
+        do {
+            status = sliced.run(77);
+            EXPECT_LE(sliced.getLastRunSteps(), 77u);
+            steps += sliced.getLastRunSteps();
+        } while (status == RunStatus::BudgetExhausted);
+        EXPECT_EQ(status, RunStatus::Halted);
+        EXPECT_EQ(sliced.getMemoryValue(102), whole.getMemoryValue(102));
+        EXPECT_EQ(steps, whole.getStats().instructions_retired);
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ * @file optimizer_gtest.cpp
+ * @brief Unit tests for the guest program optimizer.
+ */
+
+#include "../src/optimizer.hpp"
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <functional>
+#include <random>
+
+namespace {
+
+constexpr size_t kRegisters = 16;
+
+/**
+ * @brief Runs a program on a fresh machine prepared by @p setup.
+ * @return The machine after the run, with stats enabled.
+ */
+RiscMachine runProgram(const std::vector<Instruction>& program, size_t data_size,
+                       const std::function<void(RiscMachine&)>& setup) {
+    RiscMachine machine(256, data_size);
+    machine.loadProgram(program);
+    setup(machine);
+    machine.setStatsEnabled(true);
+    machine.run();
+    return machine;
+}
+
+/**
+ * @brief Checks that the optimized program leaves the same memory and flags.
+ * @return Dynamic instruction counts of the original and optimized program.
+ */
+std::pair<uint64_t, uint64_t> expectEquivalent(const std::vector<Instruction>& program, size_t data_size,
+                                               const std::function<void(RiscMachine&)>& setup) {
+    const OptimizedProgram optimized = optimizeProgram(program, kRegisters, data_size);
+    const RiscMachine before = runProgram(program, data_size, setup);
+    const RiscMachine after = runProgram(optimized.program, data_size, setup);
+    for (uint32_t address = 0; address < data_size; ++address) {
+        EXPECT_EQ(before.getMemoryValue(address), after.getMemoryValue(address)) << "address " << address;
+    }
+    const StatusRegister a = before.getStatusRegister();
+    const StatusRegister b = after.getStatusRegister();
+    EXPECT_EQ(a.ZF, b.ZF);
+    EXPECT_EQ(a.CF, b.CF);
+    EXPECT_EQ(a.NF, b.NF);
+    EXPECT_EQ(a.OF, b.OF);
+    EXPECT_EQ(a.DF, b.DF);
+    return {before.getStats().instructions_retired, after.getStats().instructions_retired};
+}
+
+}  // namespace
+
+TEST(OptimizerTest, SamplePrograms) {
+    for (uint32_t n : {0u, 1u, 2u, 7u, 12u}) {
+        auto counts = expectEquivalent(createFactorialProgram(100, 101), 1024,
+                                       [&](RiscMachine& m) { m.setMemoryValue(100, n); });
+        EXPECT_LE(counts.second, counts.first);
+        counts = expectEquivalent(createFibonacciProgram(100, 101), 1024,
+                                  [&](RiscMachine& m) { m.setMemoryValue(100, n); });
+        EXPECT_LE(counts.second, counts.first);
+        counts = expectEquivalent(createSumListProgram(100, 101, 102), 1024, [&](RiscMachine& m) {
+            m.setMemoryValue(100, 200);
+            m.setMemoryValue(101, n);
+            for (uint32_t i = 0; i < n; ++i) m.setMemoryValue(200 + i, i * 3 + 1);
+        });
+        EXPECT_LE(counts.second, counts.first);
+    }
+}
+
+TEST(OptimizerTest, CollapsesMoveChains) {
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 10, 0},
+        {Opcode::MOV, 1, 0, 0},
+        {Opcode::MOV, 2, 1, 0},
+        {Opcode::MOV, 3, 2, 0},
+        {Opcode::STORE, 11, 3, 0},
+        {Opcode::HALT, 0, 0, 0},
+    };
+    const OptimizedProgram optimized = optimizeProgram(program, kRegisters, 1024);
+    ASSERT_EQ(optimized.program.size(), 3u) << optimized.report.toString();
+    EXPECT_EQ(optimized.program[1].opcode, Opcode::STORE);
+    EXPECT_EQ(optimized.program[1].src1, 0u);
+    EXPECT_GT(optimized.report.copies_propagated, 0u);
+    EXPECT_EQ(optimized.report.dead_removed, 3u);
+    expectEquivalent(program, 1024, [](RiscMachine& m) { m.setMemoryValue(10, 42); });
+}
+
+TEST(OptimizerTest, FoldsConstantsAndBranches) {
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 6, 2},
+        {Opcode::LOAD, 1, 7, 2},
+        {Opcode::MUL, 2, 0, 1},     // 42; OF and NF are overwritten below
+        {Opcode::LOAD, 0, 6, 2},    // redundant
+        {Opcode::CMP, 0, 0, 0},
+        {Opcode::JMP, 8, 1, 0},     // always taken
+        {Opcode::LOAD, 2, 0, 2},    // unreachable
+        {Opcode::STORE, 5, 2, 0},
+        {Opcode::ADD, 3, 2, 0},     // CF and NF reach the exit
+        {Opcode::MUL, 3, 2, 0},
+        {Opcode::STORE, 4, 2, 0},
+        {Opcode::HALT, 0, 0, 0},
+    };
+    const OptimizedProgram optimized = optimizeProgram(program, kRegisters, 64);
+    EXPECT_GE(optimized.report.branches_folded, 1u);
+    EXPECT_EQ(optimized.report.unreachable_removed, 2u);
+    EXPECT_GE(optimized.report.constants_folded, 2u);
+    EXPECT_LT(optimized.program.size(), 8u) << optimized.report.toString();
+    for (const Instruction& in : optimized.program) {
+        EXPECT_FALSE(in.opcode == Opcode::JMP && in.src1 == 1);  // CMP stays: ZF is observable
+    }
+    const auto counts = expectEquivalent(program, 64, [](RiscMachine&) {});
+    EXPECT_LT(counts.second, counts.first);
+}
+
+TEST(OptimizerTest, RemovesUnreachableTail) {
+    const auto fibonacci = createFibonacciProgram(100, 101);
+    const OptimizedProgram optimized = optimizeProgram(fibonacci, kRegisters, 1024);
+    EXPECT_GT(optimized.report.unreachable_removed, 0u);
+    EXPECT_LT(optimized.program.size(), fibonacci.size());
+    EXPECT_EQ(optimized.report.instructions_before, fibonacci.size());
+    EXPECT_EQ(optimized.report.instructions_after, optimized.program.size());
+}
+
+TEST(OptimizerTest, RemovesOverwrittenStores) {
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 1, 0},
+        {Opcode::LOAD, 1, 2, 0},
+        {Opcode::STORE, 9, 0, 0},  // dead
+        {Opcode::STORE, 8, 0, 0},  // read back below
+        {Opcode::LOAD, 2, 8, 0},
+        {Opcode::STORE, 8, 1, 0},
+        {Opcode::STORE, 9, 1, 0},
+        {Opcode::STORE, 10, 2, 0},
+        {Opcode::HALT, 0, 0, 0},
+    };
+    const OptimizedProgram optimized = optimizeProgram(program, kRegisters, 64);
+    EXPECT_EQ(optimized.program.size(), program.size() - 1) << optimized.report.toString();
+    expectEquivalent(program, 64, [](RiscMachine& m) {
+        m.setMemoryValue(1, 11);
+        m.setMemoryValue(2, 22);
+    });
+}
+
+TEST(OptimizerTest, KeepsDivisionByZeroSemantics) {
+    const std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 50, 2},
+        {Opcode::LOAD, 1, 0, 2},
+        {Opcode::DIV, 0, 0, 1},  // leaves R0 and sets DF
+        {Opcode::STORE, 3, 0, 0},
+        {Opcode::HALT, 0, 0, 0},
+    };
+    const OptimizedProgram optimized = optimizeProgram(program, kRegisters, 64);
+    const RiscMachine after = runProgram(optimized.program, 64, [](RiscMachine&) {});
+    EXPECT_EQ(after.getMemoryValue(3), 50u);
+    EXPECT_TRUE(after.getStatusRegister().DF);
+}
+
+TEST(OptimizerTest, RandomForwardPrograms) {
+    constexpr size_t kDataSize = 64;
+    std::mt19937 random(20240517);
+    auto pick = [&](uint32_t bound) { return static_cast<uint32_t>(random() % bound); };
+    for (int round = 0; round < 400; ++round) {
+        const size_t length = 4 + pick(28);
+        std::vector<Instruction> program(length);
+        for (size_t i = 0; i < length; ++i) {
+            Instruction& in = program[i];
+            in.opcode = static_cast<Opcode>(pick(11));
+            in.dst = pick(18);
+            in.src1 = pick(18);
+            in.src2 = pick(18);
+            switch (in.opcode) {
+                case Opcode::LOAD:
+                    in.src2 = pick(4);
+                    in.src1 = in.src2 == 1 ? pick(18) : pick(kDataSize + 4);
+                    break;
+                case Opcode::STORE:
+                    in.dst = pick(kDataSize + 4);
+                    break;
+                case Opcode::JMP:
+                    // Forward only, so every program terminates; sometimes past the end
+                    in.dst = static_cast<uint32_t>(i + 1 + pick(static_cast<uint32_t>(length - i + 1)));
+                    in.src1 = pick(3);
+                    break;
+                case Opcode::CHECK_FLAG:
+                    in.src1 = pick(7);
+                    break;
+                case Opcode::HALT:
+                    if (pick(3)) in.opcode = Opcode::ADD;
+                    break;
+                default:
+                    break;
+            }
+        }
+        std::vector<uint32_t> memory(kDataSize);
+        for (uint32_t& value : memory) value = pick(4) ? pick(8) : pick(100);
+        SCOPED_TRACE("round " + std::to_string(round));
+        const auto counts = expectEquivalent(program, kDataSize, [&](RiscMachine& m) {
+            for (uint32_t address = 0; address < kDataSize; ++address) m.setMemoryValue(address, memory[address]);
+        });
+        EXPECT_LE(counts.second, counts.first);
+    }
+}
+
+TEST(OptimizerTest, SharedMemoryProgramsAreLeftUnchanged) {
+    const std::vector<Instruction> program = createParallelFibonacciTableProgram(100, 101, 200, 102);
+    OptimizedProgram optimized = optimizeProgram(program, kRegisters, 1024);
+    ASSERT_EQ(optimized.program.size(), program.size());
+    for (size_t i = 0; i < program.size(); ++i) {
+        EXPECT_EQ(optimized.program[i].opcode, program[i].opcode);
+        EXPECT_EQ(optimized.program[i].dst, program[i].dst);
+        EXPECT_EQ(optimized.program[i].src1, program[i].src1);
+        EXPECT_EQ(optimized.program[i].src2, program[i].src2);
+    }
+}
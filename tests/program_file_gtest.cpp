@@ -0,0 +1,165 @@
+/**
+ * @file program_file_gtest.cpp
+ * @brief Unit tests for the binary program file format and mapped loading.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/program_file.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+
+class ProgramFileTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        path = ::testing::TempDir() + "risc_" + info->name() + ".bin";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+
+    // Overwrites one byte of the written file
+    void patchByte(std::streamoff offset, char value) {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(offset);
+        file.put(value);
+    }
+};
+
+TEST_F(ProgramFileTest, RoundTrip) {
+    auto program = createFibonacciProgram(100, 101);
+    ASSERT_TRUE(writeProgramFile(path, program, DataImage{100, {10}}));
+
+    std::string error;
+    auto mapped = MappedProgram::open(path, &error);
+    ASSERT_NE(mapped, nullptr) << error;
+    ASSERT_EQ(mapped->instructionCount(), program.size());
+    for (size_t i = 0; i < program.size(); ++i) {
+        const Instruction& instr = mapped->instructions()[i];
+        EXPECT_EQ(instr.opcode, program[i].opcode);
+        EXPECT_EQ(instr.dst, program[i].dst);
+        EXPECT_EQ(instr.src1, program[i].src1);
+        EXPECT_EQ(instr.src2, program[i].src2);
+    }
+    EXPECT_EQ(mapped->dataBase(), 100u);
+    ASSERT_EQ(mapped->dataCount(), 1u);
+    EXPECT_EQ(mapped->data()[0], 10u);
+    EXPECT_EQ(mapped->toVector().size(), program.size());
+}
+
+TEST_F(ProgramFileTest, MappedProgramRunsOnEveryEngine) {
+    ASSERT_TRUE(writeProgramFile(path, createFactorialProgram(100, 101), DataImage{100, {10}}));
+    auto mapped = MappedProgram::open(path);
+    ASSERT_NE(mapped, nullptr);
+
+    for (ExecutionEngine engine : {ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit}) {
+        RiscMachine machine(256, 1024, engine);
+        machine.loadProgram(mapped);
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(101), 3628800u);
+    }
+    // Machines keep their own reference; the mapping outlives the caller's handle
+    RiscMachine machine;
+    machine.loadProgram(MappedProgram::open(path));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 3628800u);
+}
+
+TEST_F(ProgramFileTest, MappedProgramChangedAfterLoadStaysChecked) {
+    ASSERT_TRUE(writeProgramFile(path, {
+        {Opcode::LOAD, 0, 42, 2},
+        {Opcode::STORE, 100, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    }));
+    auto mapped = MappedProgram::open(path);
+    ASSERT_NE(mapped, nullptr);
+    RiscMachine machine(256, 1024, ExecutionEngine::Switch);
+    machine.loadProgram(mapped);
+    ASSERT_TRUE(machine.getVerificationReport().verified());
+
+    // Move the STORE far outside data memory behind the verifier's back
+    patchByte(sizeof(ProgramFileHeader) + sizeof(Instruction) + offsetof(Instruction, dst) + 3, 0x7f);
+    if (mapped->instructions()[1].dst == 100) GTEST_SKIP() << "file change not visible through the mapping";
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(100), 0u);
+}
+
+TEST_F(ProgramFileTest, RewritingKeepsExistingMappings) {
+    ASSERT_TRUE(writeProgramFile(path, createFactorialProgram(100, 101), DataImage{100, {10}}));
+    auto mapped = MappedProgram::open(path);
+    ASSERT_NE(mapped, nullptr);
+    RiscMachine machine(256, 1024, ExecutionEngine::Switch);
+    machine.loadProgram(mapped);
+
+    ASSERT_TRUE(writeProgramFile(path, {{Opcode::HALT, 0, 0, 0}}));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 3628800u);
+    EXPECT_EQ(mapped->instructionCount(), createFactorialProgram(100, 101).size());
+    auto replaced = MappedProgram::open(path);
+    ASSERT_NE(replaced, nullptr);
+    EXPECT_EQ(replaced->instructionCount(), 1u);
+}
+
+TEST_F(ProgramFileTest, DataImageOutsideMemoryIsClipped) {
+    ASSERT_TRUE(writeProgramFile(path, {{Opcode::HALT, 0, 0, 0}}, DataImage{14, {1, 2, 3, 4}}));
+    RiscMachine machine(16, 16);
+    machine.loadProgram(MappedProgram::open(path));
+    EXPECT_EQ(machine.getMemoryValue(14), 1u);
+    EXPECT_EQ(machine.getMemoryValue(15), 2u);
+}
+
+TEST_F(ProgramFileTest, EmptyProgram) {
+    ASSERT_TRUE(writeProgramFile(path, {}));
+    auto mapped = MappedProgram::open(path);
+    ASSERT_NE(mapped, nullptr);
+    EXPECT_EQ(mapped->instructionCount(), 0u);
+    EXPECT_EQ(mapped->data(), nullptr);
+
+    RiscMachine machine;
+    machine.loadProgram(mapped);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(0), 0u);
+}
+
+TEST_F(ProgramFileTest, RejectsMissingFile) {
+    std::string error;
+    EXPECT_EQ(MappedProgram::open(path + ".missing", &error), nullptr);
+    EXPECT_NE(error.find("cannot open"), std::string::npos);
+}
+
+TEST_F(ProgramFileTest, RejectsBadMagic) {
+    ASSERT_TRUE(writeProgramFile(path, createFactorialProgram(100, 101)));
+    patchByte(0, 'X');
+    std::string error;
+    EXPECT_EQ(MappedProgram::open(path, &error), nullptr);
+    EXPECT_NE(error.find("magic"), std::string::npos);
+}
+
+TEST_F(ProgramFileTest, RejectsCorruptPayload) {
+    ASSERT_TRUE(writeProgramFile(path, createFactorialProgram(100, 101)));
+    patchByte(sizeof(ProgramFileHeader) + 4, 7);
+    std::string error;
+    EXPECT_EQ(MappedProgram::open(path, &error), nullptr);
+    EXPECT_NE(error.find("checksum"), std::string::npos);
+    EXPECT_NE(MappedProgram::open(path, nullptr, false), nullptr);
+}
+
+TEST_F(ProgramFileTest, RejectsTruncatedFile) {
+    auto program = createFactorialProgram(100, 101);
+    ASSERT_TRUE(writeProgramFile(path, program));
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(bytes.data(), static_cast<std::streamsize>(bytes.size() - 8));
+    }
+    std::string error;
+    EXPECT_EQ(MappedProgram::open(path, &error), nullptr);
+    EXPECT_NE(error.find("size"), std::string::npos);
+}
@@ -0,0 +1,155 @@
+/**
+ * @file reduction_gtest.cpp
+ * @brief Unit tests for reduction-loop offloading.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <functional>
+
+namespace {
+
+constexpr size_t kDataSize = 1 << 16;
+
+/**
+ * @brief The createSumListProgram() loop with R3 loaded from memory and exits that dump R0–R6.
+ *
+ * Inputs: 100 = array address, 101 = length, 102 = initial sum, 103 = step.
+ * Outputs: 110–116 = R0–R6, where R6 is 1 after the carry exit and 2 after the counter exit.
+ */
+std::vector<Instruction> createDumpingSumProgram() {
+    std::vector<Instruction> program = {
+        {Opcode::LOAD, 0, 100, 0},
+        {Opcode::LOAD, 1, 101, 0},
+        {Opcode::LOAD, 2, 102, 0},
+        {Opcode::LOAD, 3, 103, 0},
+        {Opcode::LOAD, 4, 0, 1},     // head
+        {Opcode::ADD, 2, 2, 4},
+        {Opcode::CHECK_FLAG, 5, 1, 0},
+        {Opcode::CMP, 0, 5, 3},
+        {Opcode::JMP, 14, 1, 0},     // carry exit
+        {Opcode::ADD, 0, 0, 3},
+        {Opcode::CMP, 0, 1, 3},
+        {Opcode::JMP, 16, 1, 0},     // counter exit
+        {Opcode::SUB, 1, 1, 3},
+        {Opcode::JMP, 4, 0, 0},
+        {Opcode::LOAD, 6, 1, 2},
+        {Opcode::JMP, 17, 0, 0},
+        {Opcode::LOAD, 6, 2, 2},
+    };
+    for (uint32_t r = 0; r <= 6; ++r) program.push_back({Opcode::STORE, 110 + r, r, 0});
+    program.push_back({Opcode::HALT, 0, 0, 0});
+    return program;
+}
+
+}  // namespace
+
+class ReductionTest : public ::testing::TestWithParam<ExecutionEngine> {
+protected:
+    /**
+     * @brief Runs a program with and without offloading and expects identical results.
+     * @return Iterations the offloading machine ran in bulk.
+     */
+    uint64_t expectSameAsStepping(const std::vector<Instruction>& program,
+                                  const std::function<void(RiscMachine&)>& setup) {
+        RiscMachine offloaded(256, kDataSize, GetParam());
+        RiscMachine stepped(256, kDataSize, GetParam());
+        stepped.setReductionEnabled(false);
+        for (RiscMachine* machine : {&offloaded, &stepped}) {
+            machine->loadProgram(program);
+            setup(*machine);
+            machine->run();
+        }
+        for (uint32_t address = 100; address < 120; ++address) {
+            EXPECT_EQ(offloaded.getMemoryValue(address), stepped.getMemoryValue(address)) << "address " << address;
+        }
+        const StatusRegister a = offloaded.getStatusRegister();
+        const StatusRegister b = stepped.getStatusRegister();
+        EXPECT_EQ(a.ZF, b.ZF);
+        EXPECT_EQ(a.CF, b.CF);
+        EXPECT_EQ(a.NF, b.NF);
+        EXPECT_EQ(a.OF, b.OF);
+        EXPECT_EQ(a.DF, b.DF);
+        EXPECT_EQ(stepped.getReducedIterations(), 0u);
+        return offloaded.getReducedIterations();
+    }
+
+    /** @brief Sets up the dumping program's inputs and fills the array with @p value. */
+    static std::function<void(RiscMachine&)> inputs(uint32_t address, uint32_t length, uint32_t sum, uint32_t step,
+                                                    uint32_t count, uint32_t value) {
+        return [=](RiscMachine& m) {
+            m.setMemoryValue(100, address);
+            m.setMemoryValue(101, length);
+            m.setMemoryValue(102, sum);
+            m.setMemoryValue(103, step);
+            for (uint32_t i = 0; i < count && address + i < kDataSize; ++i) m.setMemoryValue(address + i, value + i % 7);
+        };
+    }
+};
+
+TEST_P(ReductionTest, SumsLongArrays) {
+    RiscMachine machine(256, 1 << 22, GetParam());
+    machine.loadProgram(createSumListProgram(100, 101, 102));
+    const uint32_t length = 3'000'000;
+    for (uint32_t i = 0; i < length; ++i) machine.setMemoryValue(1000 + i, i & 0xff);
+    machine.setMemoryValue(100, 1000);
+    machine.setMemoryValue(101, length);
+    machine.run();
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < length; ++i) expected += i & 0xff;
+    EXPECT_EQ(machine.getMemoryValue(102), expected);
+    EXPECT_EQ(machine.getReducedIterations(), length - 1);  // the last iteration leaves the loop
+}
+
+TEST_P(ReductionTest, CounterExit) {
+    const auto program = createDumpingSumProgram();
+    EXPECT_EQ(expectSameAsStepping(program, inputs(5000, 3000, 17, 1, 3000, 3)), 2999u);
+    EXPECT_EQ(expectSameAsStepping(program, inputs(5000, 1, 0, 1, 1, 3)), 0u);
+    EXPECT_EQ(expectSameAsStepping(program, inputs(5000, 2, 0, 1, 2, 3)), 1u);
+    // Array crossing pages that were never written
+    EXPECT_GT(expectSameAsStepping(program, inputs(1000, 9000, 0, 1, 10, 1)), 0u);
+}
+
+TEST_P(ReductionTest, CarryExit) {
+    const auto program = createDumpingSumProgram();
+    EXPECT_GT(expectSameAsStepping(program, inputs(5000, 3000, 5, 1, 3000, 0x01000000)), 0u);
+    expectSameAsStepping(program, inputs(5000, 3000, UINT32_MAX - 3, 1, 3000, 2));
+    expectSameAsStepping(program, inputs(5000, 3000, UINT32_MAX, 1, 3000, 1));
+}
+
+TEST_P(ReductionTest, FaultingLoad) {
+    const auto program = createDumpingSumProgram();
+    EXPECT_GT(expectSameAsStepping(program, inputs(kDataSize - 100, 500, 0, 1, 100, 1)), 0u);
+    expectSameAsStepping(program, inputs(kDataSize + 5, 500, 0, 1, 0, 1));
+    // A zero counter only stops at the end of memory
+    expectSameAsStepping(program, inputs(kDataSize - 4000, 0, 0, 1, 4000, 1));
+}
+
+TEST_P(ReductionTest, OtherStepsRunNormally) {
+    const auto program = createDumpingSumProgram();
+    EXPECT_EQ(expectSameAsStepping(program, inputs(5000, 300, 0, 2, 600, 1)), 0u);
+}
+
+TEST_P(ReductionTest, InstrumentedRunsStep) {
+    RiscMachine machine(256, kDataSize, GetParam());
+    machine.loadProgram(createSumListProgram(100, 101, 102));
+    for (uint32_t i = 0; i < 100; ++i) machine.setMemoryValue(1000 + i, i);
+    machine.setMemoryValue(100, 1000);
+    machine.setMemoryValue(101, 100);
+    machine.setStatsEnabled(true);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(102), 4950u);
+    EXPECT_EQ(machine.getReducedIterations(), 0u);
+    EXPECT_EQ(machine.getStats().instructions_retired, 1004u);  // 4 + 99 * 10 + 8 + STORE + HALT
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, ReductionTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Switch: return "Switch";
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 default: return "Jit";
+                             }
+                         });
@@ -0,0 +1,228 @@
+/**
+ * @file replay_gtest.cpp
+ * @brief Unit tests for deterministic record/replay.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/replay.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+class ReplayTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        path = ::testing::TempDir() + "risc_" + info->name() + ".replay";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+        std::remove((path + ".a").c_str());
+        std::remove((path + ".b").c_str());
+    }
+
+    static std::streamoff fileSize(const std::string& file) {
+        return std::ifstream(file, std::ios::binary | std::ios::ate).tellg();
+    }
+};
+
+TEST_F(ReplayTest, ReplayReproducesEveryRun) {
+    const auto factorial = createFactorialProgram(100, 101);
+    RiscMachine machine(256, 1024, ExecutionEngine::Jit);
+    ASSERT_TRUE(machine.startRecording(path));
+    EXPECT_TRUE(machine.isRecording());
+    machine.loadProgram(factorial);
+    machine.setMemoryValue(100, 5);
+    machine.run();
+    machine.reset();
+    machine.setMemoryValue(100, 7);
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+    EXPECT_FALSE(machine.isRecording());
+    EXPECT_EQ(machine.getMemoryValue(101), 5040u);
+
+    for (ExecutionEngine engine : {ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit}) {
+        ReplayResult result = replayRecording(path, {factorial}, {engine, "", {}});
+        EXPECT_TRUE(result.ok) << result.error;
+        EXPECT_FALSE(result.diverged);
+        EXPECT_EQ(result.runs, 2u);
+        EXPECT_EQ(result.machine.getMemoryValue(101), 5040u);
+    }
+}
+
+TEST_F(ReplayTest, BudgetedRunsReplayWithTheirBudget) {
+    const auto factorial = createFactorialProgram(100, 101);
+    RiscMachine machine;
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.loadProgram(factorial);
+    machine.setMemoryValue(100, 9);
+    EXPECT_EQ(machine.run(10), RunStatus::BudgetExhausted);
+    EXPECT_EQ(machine.run(10), RunStatus::BudgetExhausted);
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    ReplayResult result = replayRecording(path, {factorial}, {ExecutionEngine::Jit, "", {}});
+    EXPECT_TRUE(result.ok) << result.error;
+    EXPECT_FALSE(result.diverged);
+    EXPECT_EQ(result.runs, 3u);
+    EXPECT_EQ(result.machine.getMemoryValue(101), 362880u);
+}
+
+TEST_F(ReplayTest, StateBeforeRecordingIsCapturedOnce) {
+    const auto sum = createSumListProgram(100, 101, 102);
+    RiscMachine machine(256, 1 << 20);
+    for (uint32_t i = 0; i < 100; ++i) machine.setMemoryValue(5000 + i, i + 1);
+    machine.setMemoryValue(100, 5000);
+    machine.setMemoryValue(101, 100);
+    machine.loadProgram(sum);
+
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.run();
+    machine.run();  // halted: nothing to do, but still a recorded run
+    ASSERT_TRUE(machine.stopRecording());
+
+    ReplayResult result = replayRecording(path, {sum});
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.runs, 2u);
+    EXPECT_EQ(result.machine.getMemoryValue(102), 5050u);
+    EXPECT_EQ(result.machine.getMemoryValue(5099), 100u);
+
+    // Only non-zero words are imaged: header + program + ~100 words, not 4 MiB
+    EXPECT_LT(fileSize(path), 1024);
+}
+
+TEST_F(ReplayTest, HostWritesAreDeltaEncoded) {
+    RiscMachine machine(256, 1 << 16);
+    machine.loadProgram({{Opcode::HALT, 0, 0, 0}});
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.run();
+    for (uint32_t i = 0; i < 1000; ++i) machine.setMemoryValue(30000 + i, 7);
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    // One tag, one-byte delta and one-byte value per sequential write
+    EXPECT_LT(fileSize(path), 3 * 1000 + 100);
+    ReplayResult result = replayRecording(path, {{{Opcode::HALT, 0, 0, 0}}});
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.machine.getMemoryValue(30999), 7u);
+}
+
+TEST_F(ReplayTest, RestoreIsRecordedAsNewImage) {
+    const auto factorial = createFactorialProgram(100, 101);
+    RiscMachine machine;
+    machine.loadProgram(factorial);
+    machine.setMemoryValue(100, 4);
+    MachineSnapshot start = machine.snapshot();
+
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.run();
+    RiscMachine fork = machine.fork();
+    EXPECT_FALSE(fork.isRecording());
+    machine.restore(start);
+    EXPECT_TRUE(machine.isRecording());
+    machine.setMemoryValue(100, 6);
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    ReplayResult result = replayRecording(path, {factorial});
+    ASSERT_TRUE(result.ok) << result.error;
+    EXPECT_EQ(result.runs, 2u);
+    EXPECT_EQ(result.machine.getMemoryValue(101), 720u);
+}
+
+TEST_F(ReplayTest, ReportsMissingProgramsAndBadLogs) {
+    RiscMachine machine;
+    machine.loadProgram(createFactorialProgram(100, 101));
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    ReplayResult result = replayRecording(path, {createFibonacciProgram(100, 101)});
+    EXPECT_FALSE(result.ok);
+    EXPECT_NE(result.error.find("was not supplied"), std::string::npos) << result.error;
+
+    std::ofstream(path, std::ios::binary) << "not a replay log at all";
+    result = replayRecording(path, {});
+    EXPECT_FALSE(result.ok);
+    EXPECT_NE(result.error.find("bad magic"), std::string::npos) << result.error;
+}
+
+TEST_F(ReplayTest, DiffFindsFirstDivergentInstruction) {
+    const auto sum = createSumListProgram(100, 101, 102);
+    const std::string logs[2] = {path + ".a", path + ".b"};
+    for (int side = 0; side < 2; ++side) {
+        RiscMachine machine;
+        machine.loadProgram(sum);
+        machine.setMemoryValue(100, 200);
+        machine.setMemoryValue(101, 4);
+        for (uint32_t i = 0; i < 4; ++i) machine.setMemoryValue(200 + i, i == 2 && side ? 99 : i);
+        ASSERT_TRUE(machine.startRecording(logs[side]));
+        machine.run();
+        ASSERT_TRUE(machine.stopRecording());
+    }
+
+    std::vector<TraceRecord> traces[2];
+    for (int side = 0; side < 2; ++side) {
+        const std::string trace = logs[side] + ".trace";
+        ReplayResult result = replayRecording(logs[side], {sum}, {ExecutionEngine::Switch, trace, {}});
+        ASSERT_TRUE(result.ok) << result.error;
+        ASSERT_TRUE(readTraceFile(trace, traces[side]));
+        std::remove(trace.c_str());
+    }
+    ASSERT_EQ(traces[0].size(), traces[1].size());
+    const size_t at = firstTraceDivergence(traces[0], traces[1]);
+    ASSERT_LT(at, traces[0].size());
+    EXPECT_EQ(traces[0][at].opcode, static_cast<uint8_t>(Opcode::LOAD));  // loads the third element
+    EXPECT_EQ(traces[0][at].result, 2u);
+    EXPECT_EQ(traces[1][at].result, 99u);
+    EXPECT_EQ(firstTraceDivergence(traces[0], traces[0]), traces[0].size());
+}
+
+TEST_F(ReplayTest, DetectsRunsEndingDifferently) {
+    const auto factorial = createFactorialProgram(100, 101);
+    RiscMachine machine;
+    machine.loadProgram(factorial);
+    machine.setMemoryValue(100, 5);
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+
+    // Corrupt the recorded end-state digest (last byte of the log)
+    std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekg(-1, std::ios::end);
+    const char last = static_cast<char>(file.get());
+    file.seekp(-1, std::ios::end);
+    file.put(static_cast<char>(last ^ 1));
+    file.close();
+
+    ReplayResult result = replayRecording(path, {factorial});
+    EXPECT_FALSE(result.ok);
+    EXPECT_TRUE(result.diverged);
+    EXPECT_EQ(result.diverged_run, 0u);
+    EXPECT_EQ(result.machine.getMemoryValue(101), 120u);
+}
+
+TEST_F(ReplayTest, VectorLengthIsPartOfTheImage) {
+    const auto sum = createVectorSumListProgram(100, 101, 102);
+    RiscMachine machine;
+    ASSERT_TRUE(machine.startRecording(path));
+    machine.loadProgram(sum);
+    machine.setVectorLength(3);
+    for (uint32_t i = 0; i < 20; ++i) machine.setMemoryValue(200 + i, i);
+    machine.setMemoryValue(100, 200);
+    machine.setMemoryValue(101, 20);
+    machine.run();
+    ASSERT_TRUE(machine.stopRecording());
+    EXPECT_EQ(machine.getMemoryValue(102), 190u);
+
+    // The program leaves VLMAX in a register, so a replay with the default length would diverge
+    ReplayResult result = replayRecording(path, {sum}, {ExecutionEngine::Threaded, "", {}});
+    EXPECT_TRUE(result.ok) << result.error;
+    EXPECT_FALSE(result.diverged);
+    EXPECT_EQ(result.machine.getVectorLength(), 3u);
+    EXPECT_EQ(result.machine.getMemoryValue(102), 190u);
+}
@@ -0,0 +1,341 @@
+/**
+ * @file run_cache_gtest.cpp
+ * @brief Unit tests for memoising runs with RunCache.
+ */
+
+#include "../src/algorithms.hpp"
+#include "../src/machine.hpp"
+#include "../src/run_cache.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+class RunCacheTest : public ::testing::TestWithParam<ExecutionEngine> {
+protected:
+    // Runs the factorial program from its start on n, returning n!
+    static uint32_t factorial(RiscMachine& machine, uint32_t n) {
+        machine.reset();
+        machine.setMemoryValue(100, n);
+        machine.run();
+        return machine.getMemoryValue(101);
+    }
+
+    // R0 = RAM[0]; R1 = RAM[R0]; CMP R1, R2; RAM[1] = R1; RAM[2] = R1 + R1; R3 = RAM[2]; RAM[3] = R3
+    static std::vector<Instruction> pointerProgram() {
+        return {
+            {Opcode::LOAD, 0, 0, 0},
+            {Opcode::LOAD, 1, 0, 1},
+            {Opcode::CMP, 0, 1, 2},
+            {Opcode::STORE, 1, 1, 0},
+            {Opcode::ADD, 4, 1, 1},
+            {Opcode::STORE, 2, 4, 0},
+            {Opcode::LOAD, 3, 2, 0},   // reads its own write: not part of the footprint
+            {Opcode::STORE, 3, 3, 0},
+            {Opcode::HALT, 0, 0, 0}
+        };
+    }
+
+    // Runs pointerProgram() with RAM[0] = pointer and RAM[pointer] = value
+    static void chase(RiscMachine& machine, uint32_t pointer, uint32_t value) {
+        machine.reset();
+        machine.setMemoryValue(0, pointer);
+        machine.setMemoryValue(pointer, value);
+        machine.run();
+    }
+};
+
+TEST_P(RunCacheTest, RepeatedInputsAreAnsweredFromTheCache) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setRunCache(cache);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    EXPECT_EQ(factorial(machine, 5), 120u);
+    EXPECT_EQ(factorial(machine, 6), 720u);
+    EXPECT_EQ(factorial(machine, 5), 120u);
+    EXPECT_EQ(factorial(machine, 6), 720u);
+    EXPECT_EQ(cache->stats().misses, 2u);
+    EXPECT_EQ(cache->stats().stores, 2u);
+    EXPECT_EQ(cache->stats().hits, 2u);
+    EXPECT_EQ(cache->size(), 2u);
+
+    // Another machine loading the same program shares the entries
+    RiscMachine other(256, 1024, GetParam());
+    other.setRunCache(cache);
+    other.loadProgram(createFactorialProgram(100, 101));
+    EXPECT_EQ(factorial(other, 6), 720u);
+    EXPECT_EQ(cache->stats().hits, 3u);
+}
+
+TEST_P(RunCacheTest, HitsRestoreRegistersFlagsAndMemory) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine cached(256, 1024, GetParam());
+    cached.setRunCache(cache);
+    cached.loadProgram(pointerProgram());
+    RiscMachine fresh(256, 1024, GetParam());
+    fresh.loadProgram(pointerProgram());
+    for (int round = 0; round < 2; ++round) {  // the second round is answered from the cache
+        cached.setMemoryValue(3, 99);  // overwritten by the run
+        chase(cached, 10, 0);
+        chase(fresh, 10, 0);
+        for (uint32_t address = 0; address < 4; ++address) {
+            EXPECT_EQ(cached.getMemoryValue(address), fresh.getMemoryValue(address)) << "address " << address;
+        }
+        EXPECT_EQ(cached.getMemoryValue(3), 0u);
+        EXPECT_TRUE(cached.getStatusRegister().ZF);
+        EXPECT_EQ(cached.getStatusRegister().CF, fresh.getStatusRegister().CF);
+    }
+    EXPECT_EQ(cache->stats().hits, 1u);
+}
+
+TEST_P(RunCacheTest, FootprintsFollowDataDependentAddresses) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setRunCache(cache);
+    machine.loadProgram(pointerProgram());
+
+    chase(machine, 10, 7);
+    chase(machine, 20, 9);   // another pointer: another footprint
+    EXPECT_EQ(machine.getMemoryValue(1), 9u);
+    chase(machine, 10, 8);   // same pointer, another value behind it
+    EXPECT_EQ(machine.getMemoryValue(1), 8u);
+    EXPECT_EQ(cache->stats().hits, 0u);
+
+    machine.setMemoryValue(500, 1);  // outside every footprint
+    chase(machine, 10, 7);
+    EXPECT_EQ(machine.getMemoryValue(1), 7u);
+    EXPECT_EQ(machine.getMemoryValue(3), 14u);
+    chase(machine, 20, 9);
+    EXPECT_EQ(machine.getMemoryValue(1), 9u);
+    EXPECT_EQ(cache->stats().hits, 2u);
+    EXPECT_EQ(cache->size(), 3u);
+}
+
+TEST_P(RunCacheTest, StartStateAndMemorySizeArePartOfTheKey) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setRunCache(cache);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    factorial(machine, 5);
+
+    // Continuing after a budgeted run starts from another pc and registers
+    machine.reset();
+    EXPECT_EQ(machine.run(2), RunStatus::BudgetExhausted);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 120u);
+
+    RiscMachine larger(256, 2048, GetParam());
+    larger.setRunCache(cache);
+    larger.loadProgram(createFactorialProgram(100, 101));
+    EXPECT_EQ(factorial(larger, 5), 120u);
+    EXPECT_EQ(cache->stats().hits, 0u);
+    EXPECT_EQ(cache->stats().stores, 3u);
+}
+
+TEST_P(RunCacheTest, FaultingRunsAreCached) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setRunCache(cache);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 0, 0},
+        {Opcode::STORE, 1, 0, 0},
+        {Opcode::LOAD, 1, 0, 1},   // faults if RAM[0] >= 1024
+        {Opcode::STORE, 2, 1, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    for (int round = 0; round < 2; ++round) {
+        machine.reset();
+        machine.setMemoryValue(2, 0);
+        machine.setMemoryValue(0, 5000);
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(1), 5000u);
+        EXPECT_EQ(machine.getMemoryValue(2), 0u);
+    }
+    EXPECT_EQ(cache->stats().hits, 1u);
+}
+
+TEST_P(RunCacheTest, BulkMemoryRangesArePartOfTheFootprint) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setRunCache(cache);
+    // MEMCPY RAM[200..204) = RAM[100..104)
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 200, 2},
+        {Opcode::LOAD, 1, 100, 2},
+        {Opcode::LOAD, 2, 4, 2},
+        {Opcode::MEMCPY, 0, 1, 2},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    auto copy = [&](uint32_t last) {
+        machine.reset();
+        ASSERT_TRUE(machine.writeMemory(100, {1, 2, 3, last}));
+        machine.run();
+        std::vector<uint32_t> copied(4);
+        ASSERT_TRUE(machine.readMemory(200, copied));
+        EXPECT_EQ(copied, (std::vector<uint32_t>{1, 2, 3, last}));
+    };
+    copy(4);
+    copy(5);
+    copy(4);
+    EXPECT_EQ(cache->stats().misses, 2u);
+    EXPECT_EQ(cache->stats().hits, 1u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, RunCacheTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Switch: return "Switch";
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 default: return "Jit";
+                             }
+                         });
+
+TEST(RunCacheLimitTest, LeastRecentlyUsedRunsAreEvicted) {
+    RunCacheOptions options;
+    options.max_entries = 2;
+    auto cache = std::make_shared<RunCache>(options);
+    RiscMachine machine;
+    machine.setRunCache(cache);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    auto run = [&](uint32_t n) {
+        machine.reset();
+        machine.setMemoryValue(100, n);
+        machine.run();
+    };
+    run(1);
+    run(2);
+    run(1);  // hit: 1 becomes the most recently used
+    run(3);  // evicts 2
+    EXPECT_EQ(cache->stats().evictions, 1u);
+    run(1);
+    run(2);
+    EXPECT_EQ(cache->stats().hits, 2u);
+    EXPECT_EQ(cache->stats().misses, 4u);
+    EXPECT_EQ(cache->size(), 2u);
+}
+
+TEST(RunCacheLimitTest, LargeFootprintsBypassTheCache) {
+    RunCacheOptions options;
+    options.max_footprint = 50;
+    auto cache = std::make_shared<RunCache>(options);
+    RiscMachine machine(256, 1024, ExecutionEngine::Threaded);
+    machine.setRunCache(cache);
+    machine.loadProgram(createSumListProgram(0, 1, 2));
+    for (int round = 0; round < 2; ++round) {
+        machine.reset();
+        machine.setMemoryValue(0, 16);
+        machine.setMemoryValue(1, 100);
+        machine.setMemoryValue(2, 0);
+        for (uint32_t i = 0; i < 100; ++i) machine.setMemoryValue(16 + i, i);
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(2), 4950u);
+    }
+    EXPECT_EQ(cache->stats().oversized, 1u);
+    EXPECT_EQ(cache->stats().misses, 1u);  // the second run did not look
+    EXPECT_GT(machine.getReducedIterations(), 0u);  // and ran on the selected engine
+    EXPECT_EQ(cache->size(), 0u);
+}
+
+TEST(RunCacheLimitTest, UncapturableRunsBypassTheCache) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine;
+    machine.setRunCache(cache);
+
+    machine.bindHostCall(0, [](HostCall& call) { call.registers[0] = 1; return true; });
+    machine.loadProgram({{Opcode::HOSTCALL, 0, 0, 0}, {Opcode::STORE, 0, 0, 0}, {Opcode::HALT, 0, 0, 0}});
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(0), 1u);
+
+    machine.loadProgram({{Opcode::VSETVL, 0, 0, 0}, {Opcode::HALT, 0, 0, 0}});
+    machine.run();
+
+    machine.loadProgram(createFactorialProgram(100, 101));
+    machine.setMemoryValue(100, 4);
+    EXPECT_EQ(machine.run(1000), RunStatus::Halted);
+    machine.reset();
+    machine.setStatsEnabled(true);
+    machine.run();
+    EXPECT_EQ(machine.getStats().instructions_retired, machine.getLastRunSteps());
+    machine.setStatsEnabled(false);
+    machine.reset();
+    machine.runHarts(2);
+    EXPECT_EQ(machine.getMemoryValue(101), 24u);
+
+    EXPECT_EQ(cache->stats().misses, 0u);
+    EXPECT_EQ(cache->stats().stores, 0u);
+}
+
+TEST(RunCacheLimitTest, ClearDeletesEveryRun) {
+    auto cache = std::make_shared<RunCache>();
+    RiscMachine machine;
+    machine.setRunCache(cache);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    for (uint32_t n = 0; n < 10; ++n) {
+        machine.reset();
+        machine.setMemoryValue(100, n);
+        machine.run();
+    }
+    EXPECT_EQ(cache->size(), 10u);
+    cache->clear();
+    EXPECT_EQ(cache->size(), 0u);
+    EXPECT_EQ(cache->stats().stores, 0u);
+    machine.reset();
+    machine.run();
+    EXPECT_EQ(cache->stats().misses, 1u);
+}
+
+TEST(RunCacheLimitTest, ProgramsWithTheSameHashDoNotShareRuns) {
+    RunCache cache;
+    DataMemory memory(64);
+    const std::vector<Instruction> first = {{Opcode::LOAD, 0, 5, 0}, {Opcode::HALT, 0, 0, 0}};
+    const std::vector<Instruction> second = {{Opcode::LOAD, 0, 6, 0}, {Opcode::HALT, 0, 0, 0}};
+    RunKey key;
+    key.program_hash = 42;  // forced collision
+    key.program_length = first.size();
+    key.data_size = memory.size();
+    key.code = first.data();
+    RunFootprint footprint(16);
+    footprint.read(5, memory);
+    RunState outcome;
+    outcome.pc = 1;
+    ASSERT_TRUE(cache.store(key, footprint, memory, outcome));
+    EXPECT_TRUE(cache.lookup(key, memory, outcome));
+
+    key.code = second.data();
+    EXPECT_FALSE(cache.lookup(key, memory, outcome));
+    EXPECT_FALSE(cache.store(key, footprint, memory, outcome));
+    EXPECT_EQ(cache.stats().conflicts, 2u);
+    EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(RunCacheLimitTest, RejectedRunsLeaveTheCacheUnchanged) {
+    RunCacheOptions options;
+    options.max_entries = 1;
+    RunCache cache(options);
+    DataMemory memory(64);
+    const std::vector<Instruction> program = {{Opcode::HALT, 0, 0, 0}};
+    RunKey key;
+    key.program_length = program.size();
+    key.data_size = memory.size();
+    key.code = program.data();
+    RunState outcome;
+    RunFootprint reads_5(16);
+    reads_5.read(5, memory);
+    ASSERT_TRUE(cache.store(key, reads_5, memory, outcome));
+
+    // Same start state and value at 5, but a different first address: contradicts the cached run
+    memory.write(6, 1);
+    memory.write(7, 2);
+    RunFootprint reads_6(16);
+    reads_6.read(6, memory);
+    reads_6.read(7, memory);
+    EXPECT_FALSE(cache.store(key, reads_6, memory, outcome));
+    EXPECT_EQ(cache.size(), 1u);
+
+    // The cache still works normally after the rejection
+    RunKey other = key;
+    other.start.pc = 1;
+    ASSERT_TRUE(cache.store(other, reads_5, memory, outcome));
+    EXPECT_EQ(cache.stats().evictions, 1u);
+    EXPECT_FALSE(cache.lookup(key, memory, outcome));
+    EXPECT_TRUE(cache.lookup(other, memory, outcome));
+}
@@ -0,0 +1,141 @@
+/**
+ * @file scheduler_gtest.cpp
+ * @brief Unit tests for the time-slicing guest Scheduler.
+ */
+
+#include "../src/scheduler.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+std::unique_ptr<RiscMachine> factorialGuest(uint32_t n) {
+    auto machine = std::make_unique<RiscMachine>();
+    machine->loadProgram(createFactorialProgram(100, 101));
+    machine->setMemoryValue(100, n);
+    return machine;
+}
+
+std::unique_ptr<RiscMachine> spinningGuest() {
+    auto machine = std::make_unique<RiscMachine>();
+    machine->loadProgram({{Opcode::JMP, 0, 0, 0}});
+    return machine;
+}
+
+}  // namespace
+
+TEST(SchedulerTest, RunsManyGuestsToCompletion) {
+    Scheduler scheduler(SchedulerOptions{3, 16});
+    EXPECT_EQ(scheduler.workerCount(), 3u);
+    constexpr uint32_t kGuests = 2000;
+    std::vector<uint32_t> results(kGuests);
+    std::atomic<uint32_t> finished{0};
+    for (uint32_t i = 0; i < kGuests; ++i) {
+        scheduler.submit(factorialGuest(i % 13), 1 + i % 4, [&, i](GuestId, const GuestResult& result, RiscMachine& m) {
+            EXPECT_EQ(result.status, RunStatus::Halted);
+            EXPECT_GT(result.slices, 0u);
+            results[i] = m.getMemoryValue(101);
+            ++finished;
+        });
+    }
+    scheduler.wait();
+    EXPECT_EQ(finished.load(), kGuests);
+    EXPECT_EQ(scheduler.activeCount(), 0u);
+    for (uint32_t i = 0; i < kGuests; ++i) {
+        uint32_t expected = 1;
+        for (uint32_t k = 2; k <= i % 13; ++k) expected *= k;
+        EXPECT_EQ(results[i], expected) << "guest " << i;
+    }
+}
+
+TEST(SchedulerTest, StepLimitStopsRunawayGuests) {
+    Scheduler scheduler(SchedulerOptions{2, 1000});
+    GuestResult spun;
+    GuestResult faulted;
+    scheduler.submit(spinningGuest(), 1, [&](GuestId, const GuestResult& r, RiscMachine&) { spun = r; }, 12345);
+    auto bad = std::make_unique<RiscMachine>();
+    bad->loadProgram({{Opcode::LOAD, 0, 5000, 2}, {Opcode::LOAD, 1, 0, 1}, {Opcode::HALT, 0, 0, 0}});
+    scheduler.submit(std::move(bad), 1, [&](GuestId, const GuestResult& r, RiscMachine&) { faulted = r; });
+    scheduler.wait();
+    EXPECT_EQ(spun.status, RunStatus::BudgetExhausted);
+    EXPECT_EQ(spun.steps, 12345u);
+    EXPECT_EQ(spun.slices, 13u);
+    EXPECT_FALSE(spun.cancelled);
+    EXPECT_EQ(faulted.status, RunStatus::Faulted);
+    EXPECT_EQ(faulted.steps, 2u);
+}
+
+TEST(SchedulerTest, SlicesFollowPriority) {
+    // One worker makes the interleaving deterministic
+    Scheduler scheduler(SchedulerOptions{1, 100});
+    // Hold the worker in a callback until every guest is queued
+    std::promise<void> queued;
+    std::shared_future<void> gate = queued.get_future().share();
+    scheduler.submit(factorialGuest(1), 1, [gate](GuestId, const GuestResult&, RiscMachine&) { gate.wait(); });
+    std::mutex order_mutex;
+    std::vector<uint32_t> order;
+    std::vector<GuestId> ids;
+    for (uint32_t priority : {1u, 2u, 4u}) {
+        // Equal work: 100 slices each
+        ids.push_back(scheduler.submit(spinningGuest(), priority, [&, priority](GuestId, const GuestResult& r, RiscMachine&) {
+            EXPECT_EQ(r.slices, 100u);
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(priority);
+        }, 100 * 100));
+    }
+    queued.set_value();
+    scheduler.wait();
+    EXPECT_EQ(order, (std::vector<uint32_t>{4, 2, 1}));
+    EXPECT_FALSE(scheduler.setPriority(ids[0], 3));
+}
+
+TEST(SchedulerTest, PrioritiesAboveStrideAreClamped) {
+    Scheduler scheduler(SchedulerOptions{1, 100});
+    std::promise<void> queued;
+    std::shared_future<void> gate = queued.get_future().share();
+    scheduler.submit(factorialGuest(1), 1, [gate](GuestId, const GuestResult&, RiscMachine&) { gate.wait(); });
+    std::mutex order_mutex;
+    std::vector<int> order;
+    auto record = [&](int guest) {
+        return [&, guest](GuestId, const GuestResult&, RiscMachine&) {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back(guest);
+        };
+    };
+    // Unclamped, 3000000 would advance the long guest's pass by 0 and run all its slices first
+    scheduler.submit(spinningGuest(), 3000000, record(0), 20000 * 100);
+    const GuestId short_guest = scheduler.submit(spinningGuest(), 1, record(1), 3 * 100);
+    EXPECT_TRUE(scheduler.setPriority(short_guest, UINT32_MAX));
+    queued.set_value();
+    scheduler.wait();
+    // Both run at priority kStride, so they alternate and the short guest finishes first
+    EXPECT_EQ(order, (std::vector<int>{1, 0}));
+}
+
+TEST(SchedulerTest, CancelStopsGuest) {
+    Scheduler scheduler(SchedulerOptions{1, 50});
+    std::atomic<bool> cancelled{false};
+    const GuestId id = scheduler.submit(spinningGuest(), 1, [&](GuestId, const GuestResult& r, RiscMachine&) {
+        cancelled = r.cancelled;
+    });
+    EXPECT_TRUE(scheduler.setPriority(id, 5));
+    EXPECT_TRUE(scheduler.cancel(id));
+    scheduler.wait();
+    EXPECT_TRUE(cancelled.load());
+    EXPECT_FALSE(scheduler.cancel(id));
+}
+
+TEST(SchedulerTest, CallbackExceptionsReachWait) {
+    Scheduler scheduler(SchedulerOptions{2, 100});
+    scheduler.submit(factorialGuest(5), 1, [](GuestId, const GuestResult&, RiscMachine&) {
+        throw std::runtime_error("callback failed");
+    });
+    scheduler.submit(factorialGuest(6));
+    EXPECT_THROW(scheduler.wait(), std::runtime_error);
+    EXPECT_EQ(scheduler.activeCount(), 0u);
+}
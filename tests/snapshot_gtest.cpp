@@ -0,0 +1,214 @@
+/**
+ * @file snapshot_gtest.cpp
+ * @brief Unit tests for copy-on-write data memory, machine snapshots and fork().
+ */
+
+#include "../src/data_memory.hpp"
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+TEST(DataMemoryTest, CopiesShareUntilWritten) {
+    DataMemory memory(3 * DataMemory::kPageWords);
+    memory.write(5, 1);
+    memory.write(DataMemory::kPageWords + 5, 2);
+
+    DataMemory copy(memory);
+    EXPECT_EQ(copy.read(5), 1u);
+    EXPECT_EQ(copy.residentPages(), 2u);
+
+    copy.write(6, 3);
+    EXPECT_EQ(copy.copiedPages(), 1u);
+    EXPECT_EQ(memory.read(6), 0u);
+
+    // The original is now the only owner of page 0 and writes it in place
+    memory.write(7, 4);
+    EXPECT_EQ(memory.copiedPages(), 0u);
+    EXPECT_EQ(copy.read(7), 0u);
+
+    memory.write(DataMemory::kPageWords + 5, 9);
+    EXPECT_EQ(memory.copiedPages(), 1u);
+    EXPECT_EQ(copy.read(DataMemory::kPageWords + 5), 2u);
+}
+
+TEST(DataMemoryTest, ClearLeavesSharersIntact) {
+    DataMemory memory(2 * DataMemory::kPageWords + 1);
+    memory.write(2 * DataMemory::kPageWords, 7);
+    DataMemory copy(memory);
+    memory.clear();
+    EXPECT_EQ(memory.read(2 * DataMemory::kPageWords), 0u);
+    EXPECT_EQ(memory.residentPages(), 0u);
+    EXPECT_EQ(copy.read(2 * DataMemory::kPageWords), 7u);
+    memory.write(2 * DataMemory::kPageWords, 8);
+    EXPECT_EQ(memory.copiedPages(), 0u);
+    EXPECT_EQ(copy.read(2 * DataMemory::kPageWords), 7u);
+}
+
+TEST(DataMemoryTest, AllocatesOnlyWrittenPages) {
+    const size_t size = size_t{1} << 28;  // 1 GiB
+    DataMemory memory(size);
+    EXPECT_EQ(memory.residentPages(), 0u);
+    EXPECT_EQ(memory.read(static_cast<uint32_t>(size - 1)), 0u);
+
+    const uint32_t addresses[] = {0, 1, 4096, 1u << 20, static_cast<uint32_t>(size - 1)};
+    for (uint32_t address : addresses) memory.write(address, address + 1);
+    for (uint32_t address : addresses) EXPECT_EQ(memory.read(address), address + 1);
+    EXPECT_EQ(memory.residentPages(), 4u);
+}
+
+TEST(DataMemoryTest, WritesAcrossTablesStayCorrect) {
+    // Pages in three page tables, written round-robin
+    const uint32_t pages = 2 * DataMemory::kTablePages + 3;
+    DataMemory memory(pages * DataMemory::kPageWords);
+    for (int round = 0; round < 3; ++round) {
+        for (uint32_t page = 0; page < pages; ++page) {
+            const uint32_t address = page * DataMemory::kPageWords + static_cast<uint32_t>(round);
+            memory.write(address, address);
+        }
+    }
+    for (uint32_t page = 0; page < pages; ++page) {
+        for (uint32_t word = 0; word < 3; ++word) {
+            ASSERT_EQ(memory.read(page * DataMemory::kPageWords + word), page * DataMemory::kPageWords + word);
+        }
+    }
+    EXPECT_EQ(memory.residentPages(), pages);
+}
+
+TEST(DataMemoryTest, RangeOperationsMatchWordByWordReference) {
+    // Ranges cross page boundaries and overlap in both directions
+    const uint32_t size = 4 * DataMemory::kPageWords;
+    DataMemory memory(size);
+    std::vector<uint32_t> reference(size);
+    for (uint32_t i = 0; i < 2 * DataMemory::kPageWords; ++i) reference[i] = i * 2654435761u;
+    memory.writeRange(0, reference.data(), 2 * DataMemory::kPageWords);
+    DataMemory shared(memory);  // pages are shared: copy() must copy them before writing
+
+    const uint32_t moves[][3] = {{1500, 1000, 1200}, {900, 1400, 1300}, {3000, 10, 1000}, {5, 5, 100}};
+    for (const auto& move : moves) {
+        memory.copy(move[0], move[1], move[2]);
+        std::memmove(&reference[move[0]], &reference[move[1]], move[2] * sizeof(uint32_t));
+    }
+    memory.fill(2040, 7, 20);
+    std::fill(reference.begin() + 2040, reference.begin() + 2060, 7u);
+
+    std::vector<uint32_t> contents(size);
+    memory.readRange(0, contents.data(), size);
+    EXPECT_EQ(contents, reference);
+    EXPECT_EQ(shared.read(1500), 1500u * 2654435761u);
+
+    EXPECT_EQ(memory.compare(0, 0, size), size);
+    EXPECT_EQ(memory.compare(3000, 10, 1000), 1000u);  // copied above, unchanged since
+    memory.write(3999, 1);
+    EXPECT_EQ(memory.compare(3000, 10, 1000), 999u);
+}
+
+TEST(DataMemoryTest, ZeroFillAndZeroCopyAllocateNothing) {
+    DataMemory memory(size_t{1} << 24);
+    memory.fill(0, 0, 1u << 24);
+    memory.copy(1u << 20, 0, 1u << 20);
+    EXPECT_EQ(memory.residentPages(), 0u);
+    memory.fill(DataMemory::kPageWords - 1, 3, 2);
+    EXPECT_EQ(memory.residentPages(), 2u);
+    EXPECT_EQ(memory.read(DataMemory::kPageWords), 3u);
+}
+
+class SnapshotTest : public ::testing::TestWithParam<ExecutionEngine> {};
+
+TEST_P(SnapshotTest, RestoreReturnsToCapturedState) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram(createFactorialProgram(100, 101));
+    machine.setMemoryValue(100, 5);
+    MachineSnapshot start = machine.snapshot();
+
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 120u);
+
+    machine.restore(start);
+    EXPECT_EQ(machine.getMemoryValue(101), 0u);
+    machine.setMemoryValue(100, 6);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 720u);
+
+    machine.restore(start);
+    EXPECT_EQ(machine.getMemoryValue(100), 5u);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 120u);
+}
+
+TEST_P(SnapshotTest, ForkIsIsolatedAndCopiesOnlyWrittenPages) {
+    const size_t data_size = 1 << 20;  // 4 MiB
+    RiscMachine parent(256, data_size, GetParam());
+    parent.loadProgram(createSumListProgram(0, 1, data_size - 1));
+    const uint32_t length = 1000;
+    parent.setMemoryValue(0, 16);
+    parent.setMemoryValue(1, length);
+    for (uint32_t i = 0; i < length; ++i) parent.setMemoryValue(16 + i, i);
+    parent.setMemoryValue(data_size - 2, 7);  // makes the result page resident
+
+    RiscMachine child = parent.fork();
+    EXPECT_EQ(child.getCopiedPages(), 0u);
+    child.run();
+    EXPECT_EQ(child.getMemoryValue(data_size - 1), length * (length - 1) / 2);
+    EXPECT_EQ(child.getCopiedPages(), 1u);  // only the result page
+    EXPECT_EQ(parent.getMemoryValue(data_size - 1), 0u);
+
+    parent.setMemoryValue(1, 10);
+    parent.run();
+    EXPECT_EQ(parent.getMemoryValue(data_size - 1), 45u);
+    EXPECT_EQ(child.getMemoryValue(1), length);
+}
+
+TEST_P(SnapshotTest, ManyForksShareOneProgram) {
+    RiscMachine parent(256, 1 << 20, GetParam());
+    parent.loadProgram(createFactorialProgram(100, 101));
+    parent.setMemoryValue(101, 1);
+    MachineSnapshot base = parent.snapshot();
+    for (uint32_t n = 0; n < 1000; ++n) {
+        RiscMachine child = parent.fork();
+        child.setMemoryValue(100, n % 13);
+        child.run();
+        uint32_t expected = 1;
+        for (uint32_t k = 2; k <= n % 13; ++k) expected *= k;
+        ASSERT_EQ(child.getMemoryValue(101), expected);
+        ASSERT_EQ(child.getCopiedPages(), 1u);
+    }
+    EXPECT_EQ(parent.getMemoryValue(101), 1u);
+    parent.restore(base);
+    EXPECT_EQ(parent.getEngine(), GetParam());
+}
+
+TEST_P(SnapshotTest, SparseGigabyteAddressSpace) {
+    const uint32_t top = (1u << 28) - 1;  // last word of 1 GiB
+    RiscMachine machine(256, size_t{top} + 1, GetParam());
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 41, 2},
+        {Opcode::STORE, top, 0, 0},         // RAM[top] = 41
+        {Opcode::LOAD, 1, top, 2},
+        {Opcode::LOAD, 2, 1, 1},            // R2 = RAM[top]
+        {Opcode::LOAD, 3, 1, 2},
+        {Opcode::ADD, 2, 2, 3},
+        {Opcode::STORE, 1u << 27, 2, 0},    // RAM[128Mi] = 42
+        {Opcode::LOAD, 4, 12345678, 0},     // never written: reads zero
+        {Opcode::STORE, 0, 4, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.setMemoryValue(0, 9);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(top), 41u);
+    EXPECT_EQ(machine.getMemoryValue(1u << 27), 42u);
+    EXPECT_EQ(machine.getMemoryValue(0), 0u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, SnapshotTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded,
+                                           ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 case ExecutionEngine::Jit: return "Jit";
+                                 default: return "Switch";
+                             }
+                         });
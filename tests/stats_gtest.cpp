@@ -0,0 +1,97 @@
+/**
+ * @file stats_gtest.cpp
+ * @brief Unit tests for the opt-in guest profiling statistics.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+
+class StatsTest : public ::testing::TestWithParam<ExecutionEngine> {};
+
+TEST_P(StatsTest, ProfilesFactorial) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram(createFactorialProgram(100, 101));
+    machine.setMemoryValue(100, 5);
+    machine.setStatsEnabled(true);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 120u);
+
+    const ExecutionStats& stats = machine.getStats();
+    EXPECT_EQ(stats.instructions_retired, 30u);
+    EXPECT_EQ(stats.opcode_counts[static_cast<size_t>(Opcode::MUL)], 4u);
+    EXPECT_EQ(stats.opcode_counts[static_cast<size_t>(Opcode::CMP)], 6u);
+    EXPECT_EQ(stats.opcode_counts[static_cast<size_t>(Opcode::HALT)], 1u);
+    EXPECT_EQ(stats.pc_counts[6], 5u);  // loop head
+    EXPECT_EQ(stats.pc_counts[8], 4u);  // MUL
+
+    ASSERT_EQ(stats.jump_sites.size(), 3u);
+    EXPECT_EQ(stats.jump_sites.at(5).taken, 0u);   // n == 0 check
+    EXPECT_EQ(stats.jump_sites.at(5).not_taken, 1u);
+    EXPECT_EQ(stats.jump_sites.at(7).taken, 1u);   // loop exit
+    EXPECT_EQ(stats.jump_sites.at(7).not_taken, 4u);
+    EXPECT_EQ(stats.jump_sites.at(10).taken, 4u);  // back edge
+
+    EXPECT_EQ(stats.flags[0].written, 6u);  // ZF
+    EXPECT_EQ(stats.flags[0].set, 1u);
+    EXPECT_EQ(stats.flags[2].written, 8u);  // NF: 4 MUL + 4 SUB
+    EXPECT_EQ(stats.flags[3].written, 4u);  // OF
+
+    auto hot = stats.hottest(1);
+    ASSERT_EQ(hot.size(), 1u);
+    EXPECT_EQ(hot[0].first, 6u);
+
+    // Counters accumulate over runs until reset
+    machine.reset();
+    machine.run();
+    EXPECT_EQ(machine.getStats().instructions_retired, 60u);
+    machine.resetStats();
+    EXPECT_EQ(machine.getStats().instructions_retired, 0u);
+}
+
+TEST_P(StatsTest, DisabledStatsStayEmpty) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram(createFibonacciProgram(100, 101));
+    machine.setMemoryValue(100, 10);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 55u);
+    EXPECT_FALSE(machine.isStatsEnabled());
+    EXPECT_EQ(machine.getStats().instructions_retired, 0u);
+    EXPECT_TRUE(machine.getStats().pc_counts.empty());
+}
+
+TEST(StatsTest, Dumps) {
+    RiscMachine machine;
+    machine.setStatsEnabled(true);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 7, 2},
+        {Opcode::LOAD, 1, 0, 2},
+        {Opcode::DIV, 2, 0, 1},  // divide by zero: DF set, NF untouched
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    const ExecutionStats& stats = machine.getStats();
+    EXPECT_EQ(stats.flags[4].written, 1u);
+    EXPECT_EQ(stats.flags[4].set, 1u);
+    EXPECT_EQ(stats.flags[2].written, 0u);
+
+    const std::string text = stats.toString();
+    EXPECT_NE(text.find("instructions retired: 4"), std::string::npos) << text;
+    EXPECT_NE(text.find("DIV"), std::string::npos) << text;
+
+    const std::string json = stats.toJson();
+    EXPECT_EQ(json.rfind("{\"instructions_retired\":4,", 0), 0u) << json;
+    EXPECT_NE(json.find("\"pc_counts\":[1,1,1,1]"), std::string::npos) << json;
+    EXPECT_NE(json.find("\"DF\":{\"written\":1,\"set\":1}"), std::string::npos) << json;
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, StatsTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded,
+                                           ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 case ExecutionEngine::Jit: return "Jit";
+                                 default: return "Switch";
+                             }
+                         });
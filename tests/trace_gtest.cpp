@@ -0,0 +1,126 @@
+/**
+ * @file trace_gtest.cpp
+ * @brief Unit tests for the binary instruction trace.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/trace.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <fstream>
+
+class TraceTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+        path = ::testing::TempDir() + "risc_" + info->name() + ".trace";
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(TraceTest, RecordsEveryInstruction) {
+    RiscMachine machine(256, 1024, ExecutionEngine::Jit);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    machine.setMemoryValue(100, 5);
+    ASSERT_TRUE(machine.startTrace(path));
+    EXPECT_TRUE(machine.isTracing());
+    machine.run();
+    ASSERT_TRUE(machine.stopTrace());
+    EXPECT_FALSE(machine.isTracing());
+    EXPECT_EQ(machine.getMemoryValue(101), 120u);
+
+    std::vector<TraceRecord> records;
+    std::string error;
+    ASSERT_TRUE(readTraceFile(path, records, &error)) << error;
+    ASSERT_EQ(records.size(), 30u);
+    EXPECT_EQ(records.front().pc, 0u);
+    EXPECT_EQ(records.front().opcode, static_cast<uint8_t>(Opcode::LOAD));
+    EXPECT_EQ(records.back().opcode, static_cast<uint8_t>(Opcode::HALT));
+
+    uint32_t last_product = 0;
+    for (const TraceRecord& record : records) {
+        if (record.opcode == static_cast<uint8_t>(Opcode::MUL)) last_product = record.result;
+        if (record.opcode == static_cast<uint8_t>(Opcode::STORE)) {
+            EXPECT_EQ(record.result, 120u);
+        }
+    }
+    EXPECT_EQ(last_product, 120u);
+
+    // The loop exit compare (n == 1) is the only one that leaves ZF set
+    int zero_compares = 0;
+    for (const TraceRecord& record : records) {
+        if (record.opcode == static_cast<uint8_t>(Opcode::CMP) && (record.flags & 1)) ++zero_compares;
+    }
+    EXPECT_EQ(zero_compares, 1);
+}
+
+TEST_F(TraceTest, SmallRingLosesNothing) {
+    RiscMachine machine(256, 4096);
+    const uint32_t length = 2000;
+    for (uint32_t i = 0; i < length; ++i) machine.setMemoryValue(200 + i, i);
+    machine.setMemoryValue(100, 200);
+    machine.setMemoryValue(101, length);
+    machine.loadProgram(createSumListProgram(100, 101, 102));
+    ASSERT_TRUE(machine.startTrace(path, 16));
+    machine.run();
+    ASSERT_TRUE(machine.stopTrace());
+    EXPECT_EQ(machine.getMemoryValue(102), length * (length - 1) / 2);
+
+    std::vector<TraceRecord> records;
+    ASSERT_TRUE(readTraceFile(path, records));
+    EXPECT_EQ(records.size(), 10u * length + 4);
+}
+
+TEST_F(TraceTest, CopiesDoNotTrace) {
+    RiscMachine machine;
+    machine.loadProgram({{Opcode::LOAD, 0, 1, 2}, {Opcode::HALT, 0, 0, 0}});
+    MachineSnapshot start = machine.snapshot();
+    ASSERT_TRUE(machine.startTrace(path));
+
+    RiscMachine child = machine.fork();
+    EXPECT_FALSE(child.isTracing());
+    child.run();
+
+    machine.run();
+    machine.restore(start);  // keeps tracing
+    EXPECT_TRUE(machine.isTracing());
+    machine.run();
+    ASSERT_TRUE(machine.stopTrace());
+
+    std::vector<TraceRecord> records;
+    ASSERT_TRUE(readTraceFile(path, records));
+    EXPECT_EQ(records.size(), 4u);
+}
+
+TEST_F(TraceTest, RejectsNonTraceFiles) {
+    std::vector<TraceRecord> records;
+    std::string error;
+    EXPECT_FALSE(readTraceFile(path + ".missing", records, &error));
+    EXPECT_NE(error.find("cannot open"), std::string::npos);
+
+    std::ofstream(path, std::ios::binary) << "definitely not a trace file";
+    EXPECT_FALSE(readTraceFile(path, records, &error));
+    EXPECT_NE(error.find("bad magic"), std::string::npos);
+
+    RiscMachine machine;
+    EXPECT_FALSE(machine.startTrace(::testing::TempDir() + "missing/dir/trace", kDefaultTraceCapacity, &error));
+    EXPECT_FALSE(machine.isTracing());
+}
+
+TEST(TraceFormatTest, FormatsRecord) {
+    TraceRecord record;
+    record.pc = 7;
+    record.opcode = static_cast<uint8_t>(Opcode::ADD);
+    record.flags = 0b00110;
+    record.dst = 2;
+    record.src1 = 0;
+    record.src2 = 1;
+    record.result = 42;
+    EXPECT_EQ(formatTraceRecord(record), "     7  ADD         dst=2 src1=0 src2=1  result=42  flags=-CN--");
+}
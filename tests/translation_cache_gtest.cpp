@@ -0,0 +1,228 @@
+/**
+ * @file translation_cache_gtest.cpp
+ * @brief Unit tests for the persistent translation cache.
+ */
+
+#include "../src/algorithms.hpp"
+#include "../src/machine.hpp"
+#include "../src/translation_cache.hpp"
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Gives every test its own cache directory
+class TranslationCacheBase : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+        std::replace(name.begin(), name.end(), '/', '_');
+        directory = ::testing::TempDir() + "risc_translation_cache_" + name;
+        makeCache().clear();
+    }
+
+    void TearDown() override {
+        makeCache().clear();
+        ::rmdir(directory.c_str());
+    }
+
+    // A new object over the same directory, as a new process would create
+    TranslationCache makeCache(size_t max_entries = 4096, uint64_t max_bytes = uint64_t{1} << 30) const {
+        TranslationCacheOptions options;
+        options.directory = directory;
+        options.max_entries = max_entries;
+        options.max_bytes = max_bytes;
+        options.min_instructions = 0;
+        return TranslationCache(options);
+    }
+
+    std::shared_ptr<TranslationCache> sharedCache(size_t max_entries = 4096) const {
+        TranslationCacheOptions options;
+        options.directory = directory;
+        options.max_entries = max_entries;
+        options.min_instructions = 0;
+        return std::make_shared<TranslationCache>(options);
+    }
+
+    // Sums 100 words; the loop is a reduction loop
+    uint32_t runSumList(RiscMachine& machine) const {
+        machine.loadProgram(createSumListProgram(0, 1, 2));
+        machine.setMemoryValue(0, 16);
+        machine.setMemoryValue(1, 100);
+        for (uint32_t i = 0; i < 100; ++i) machine.setMemoryValue(16 + i, i);
+        machine.run();
+        return machine.getMemoryValue(2);
+    }
+
+    std::string directory;
+};
+
+class TranslationCacheTest : public TranslationCacheBase, public ::testing::WithParamInterface<ExecutionEngine> {};
+
+TEST_P(TranslationCacheTest, LaterLoadsReuseTheTranslation) {
+    auto first = sharedCache();
+    ASSERT_TRUE(first->isOpen());
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setTranslationCache(first);
+    EXPECT_EQ(runSumList(machine), 4950u);
+    EXPECT_EQ(first->stats().misses, 1u);
+    EXPECT_EQ(first->stats().stores, 1u);
+
+    // A new cache object, as in a new process
+    auto second = sharedCache();
+    RiscMachine reloaded(256, 1024, GetParam());
+    reloaded.setTranslationCache(second);
+    EXPECT_EQ(runSumList(reloaded), 4950u);
+    EXPECT_EQ(second->stats().hits, 1u);
+    EXPECT_EQ(second->stats().stores, 0u);
+    EXPECT_EQ(reloaded.isJitCompiled(), machine.isJitCompiled());
+    EXPECT_EQ(reloaded.getReducedIterations(), machine.getReducedIterations());
+    EXPECT_GT(reloaded.getReducedIterations(), 0u);
+}
+
+TEST_P(TranslationCacheTest, CachedTranslationsBehaveLikeFreshOnes) {
+    const std::vector<std::vector<Instruction>> programs = {
+        createFactorialProgram(100, 101),
+        createFibonacciProgram(100, 101),
+        {
+            {Opcode::LOAD, 0, 7, 2},
+            {Opcode::ADD, 20, 0, 0},   // register out of range: a verification issue
+            {Opcode::STORE, 101, 0, 0},
+            {Opcode::HALT, 0, 0, 0}
+        },
+    };
+    for (int round = 0; round < 2; ++round) {  // the second round runs from the cache
+        auto cache = sharedCache();
+        for (const auto& program : programs) {
+            RiscMachine cached(16, 1024, GetParam());
+            cached.setTranslationCache(cache);
+            cached.loadProgram(program);
+            cached.setMemoryValue(100, 10);
+            cached.run();
+            RiscMachine fresh(16, 1024, GetParam());
+            fresh.loadProgram(program);
+            fresh.setMemoryValue(100, 10);
+            fresh.run();
+            EXPECT_EQ(cached.getMemoryValue(101), fresh.getMemoryValue(101));
+            EXPECT_EQ(cached.getVerificationReport().toString(), fresh.getVerificationReport().toString());
+            EXPECT_EQ(cached.getVerificationReport().runtime_checks, fresh.getVerificationReport().runtime_checks);
+        }
+        EXPECT_EQ(cache->stats().hits, round == 0 ? 0u : programs.size());
+    }
+}
+
+TEST_P(TranslationCacheTest, ConfigurationIsPartOfTheKey) {
+    auto cache = sharedCache();
+    RiscMachine small(256, 1024, GetParam());
+    small.setTranslationCache(cache);
+    runSumList(small);
+    RiscMachine large(256, 2048, GetParam());
+    large.setTranslationCache(cache);
+    runSumList(large);
+    RiscMachine unfused(256, 1024, GetParam());
+    unfused.setFusionEnabled(false);
+    unfused.setTranslationCache(cache);
+    runSumList(unfused);
+    EXPECT_EQ(cache->stats().hits, 0u);
+    EXPECT_EQ(cache->stats().stores, 3u);
+}
+
+TEST_P(TranslationCacheTest, CorruptEntriesAreRetranslated) {
+    auto cache = sharedCache();
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setTranslationCache(cache);
+    runSumList(machine);
+
+    const std::vector<Instruction> program = createSumListProgram(0, 1, 2);
+    const TranslationKey key{static_cast<uint32_t>(GetParam()), 16, 1024, true, true};
+    const std::string path = cache->entryPath(program.data(), program.size(), key);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        ASSERT_TRUE(file.good());
+        file.seekp(-1, std::ios::end);
+        file.put('\x5A');
+    }
+    RiscMachine reloaded(256, 1024, GetParam());
+    reloaded.setTranslationCache(cache);
+    EXPECT_EQ(runSumList(reloaded), 4950u);
+    EXPECT_EQ(cache->stats().rejected, 1u);
+    EXPECT_EQ(cache->stats().stores, 2u);  // rewritten
+
+    ProgramTranslation translation;
+    EXPECT_TRUE(cache->lookup(program.data(), program.size(), key, translation));
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, TranslationCacheTest,
+                         ::testing::Values(ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             return info.param == ExecutionEngine::Threaded ? "Threaded" : "Jit";
+                         });
+
+class TranslationCacheLimitTest : public TranslationCacheBase {};
+
+TEST_F(TranslationCacheLimitTest, LeastRecentlyUsedEntriesAreEvicted) {
+    auto cache = sharedCache(2);
+    auto load = [&](uint32_t n) {
+        RiscMachine machine(256, 1024, ExecutionEngine::Threaded);
+        machine.setTranslationCache(cache);
+        machine.loadProgram(createFactorialProgram(100 + n, 200));
+        // Modification times may be as coarse as a scheduler tick
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    };
+    load(0);
+    load(1);
+    load(0);  // hit: 0 becomes the most recently used
+    load(2);  // evicts 1
+    EXPECT_EQ(cache->stats().evictions, 1u);
+    load(0);
+    load(1);
+    EXPECT_EQ(cache->stats().hits, 2u);
+    EXPECT_EQ(cache->stats().misses, 4u);
+}
+
+TEST_F(TranslationCacheLimitTest, OversizedEntriesAreNotStored) {
+    TranslationCache cache = makeCache(4096, 100);
+    const std::vector<Instruction> program = createFactorialProgram(100, 101);
+    const TranslationKey key{static_cast<uint32_t>(ExecutionEngine::Threaded), 16, 1024, true, true};
+    ProgramTranslation translation;
+    translation.packed.resize(program.size() + 1);
+    EXPECT_FALSE(cache.store(program.data(), program.size(), key, translation));
+    EXPECT_FALSE(cache.lookup(program.data(), program.size(), key, translation));
+}
+
+TEST_F(TranslationCacheLimitTest, SwitchEngineDoesNotUseTheCache) {
+    auto cache = sharedCache();
+    RiscMachine machine(256, 1024, ExecutionEngine::Switch);
+    machine.setTranslationCache(cache);
+    EXPECT_EQ(runSumList(machine), 4950u);
+    EXPECT_EQ(cache->stats().misses, 0u);
+    EXPECT_EQ(cache->stats().stores, 0u);
+}
+
+TEST_F(TranslationCacheLimitTest, ShortProgramsBypassTheCache) {
+    TranslationCacheOptions options;
+    options.directory = directory;
+    options.min_instructions = 100;
+    auto cache = std::make_shared<TranslationCache>(options);
+    RiscMachine machine(256, 1024, ExecutionEngine::Threaded);
+    machine.setTranslationCache(cache);
+    EXPECT_EQ(runSumList(machine), 4950u);
+    machine.loadProgram(std::vector<Instruction>(100, Instruction{Opcode::HALT, 0, 0, 0}));
+    EXPECT_EQ(cache->stats().misses, 1u);
+    EXPECT_EQ(cache->stats().stores, 1u);
+}
+
+TEST_F(TranslationCacheLimitTest, MissingDirectoryParentDisablesTheCache) {
+    TranslationCacheOptions options;
+    options.directory = directory + "/missing/cache";
+    auto cache = std::make_shared<TranslationCache>(options);
+    EXPECT_FALSE(cache->isOpen());
+    RiscMachine machine(256, 1024, ExecutionEngine::Threaded);
+    machine.setTranslationCache(cache);
+    EXPECT_EQ(runSumList(machine), 4950u);
+    EXPECT_EQ(cache->stats().stores, 0u);
+}
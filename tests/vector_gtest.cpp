@@ -0,0 +1,223 @@
+/**
+ * @file vector_gtest.cpp
+ * @brief Unit tests for the vector instructions and the vectorised programs.
+ */
+
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include "../src/optimizer.hpp"
+#include "../src/wide_machine.hpp"
+#include <gtest/gtest.h>
+#include <vector>
+
+class VectorTest : public ::testing::TestWithParam<ExecutionEngine> {
+protected:
+    static constexpr uint32_t kBase = 1000;
+
+    // Fills RAM[kBase + i] with i * 7 + 1 and returns the wrapping sum of the first `length` words
+    static uint32_t fillArray(RiscMachine& machine, uint32_t length) {
+        uint32_t sum = 0;
+        for (uint32_t i = 0; i < length; ++i) {
+            machine.setMemoryValue(kBase + i, i * 7 + 1);
+            sum += i * 7 + 1;
+        }
+        return sum;
+    }
+};
+
+TEST_P(VectorTest, SumListMatchesScalarSum) {
+    for (uint32_t length : {0u, 1u, 7u, 8u, 9u, 100u, 3000u}) {
+        RiscMachine machine(256, 8192, GetParam());
+        const uint32_t expected = fillArray(machine, length);
+        machine.setMemoryValue(100, kBase);
+        machine.setMemoryValue(101, length);
+        machine.loadProgram(createVectorSumListProgram(100, 101, 102));
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(102), expected) << "length " << length;
+    }
+}
+
+TEST_P(VectorTest, SumListIsIndependentOfVectorLength) {
+    for (uint32_t vlmax : {1u, 3u, 4u, 8u, 16u}) {
+        RiscMachine machine(256, 8192, GetParam());
+        machine.setVectorLength(vlmax);
+        EXPECT_EQ(machine.getVectorLength(), vlmax);
+        const uint32_t expected = fillArray(machine, 1237);
+        machine.setMemoryValue(100, kBase);
+        machine.setMemoryValue(101, 1237);
+        machine.loadProgram(createVectorSumListProgram(100, 101, 102));
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(102), expected) << "VLMAX " << vlmax;
+    }
+}
+
+TEST_P(VectorTest, DotProduct) {
+    RiscMachine machine(256, 8192, GetParam());
+    uint32_t expected = 0;
+    for (uint32_t i = 0; i < 1001; ++i) {
+        machine.setMemoryValue(2000 + i, i + 3);
+        machine.setMemoryValue(5000 + i, 0x10001u * i);
+        expected += (i + 3) * (0x10001u * i);
+    }
+    machine.setMemoryValue(100, 2000);
+    machine.setMemoryValue(101, 5000);
+    machine.setMemoryValue(102, 1001);
+    machine.loadProgram(createDotProductProgram(100, 101, 102, 103));
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(103), expected);
+}
+
+TEST_P(VectorTest, StridedLoadAndStore) {
+    // Transposes column 1 of a 4-column matrix into a row, and scatters it back doubled
+    RiscMachine machine(256, 1024, GetParam());
+    machine.setVectorLength(4);
+    for (uint32_t i = 0; i < 16; ++i) machine.setMemoryValue(200 + i, i);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 201, 2},      // R0 = &M[0][1]
+        {Opcode::LOAD, 1, 4, 2},        // R1 = row stride
+        {Opcode::LOAD, 2, 1, 2},        // R2 = 1
+        {Opcode::LOAD, 3, 300, 2},      // R3 = destination row
+        {Opcode::VLOAD, 0, 0, 1},       // V0 = column 1
+        {Opcode::VSTORE, 3, 0, 2},      // RAM[300..304) = V0
+        {Opcode::VADD, 1, 0, 0},
+        {Opcode::VSTORE, 0, 1, 1},      // column 1 = 2 * column 1
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    for (uint32_t row = 0; row < 4; ++row) {
+        EXPECT_EQ(machine.getMemoryValue(300 + row), row * 4 + 1);
+        EXPECT_EQ(machine.getMemoryValue(200 + row * 4 + 1), 2 * (row * 4 + 1));
+        EXPECT_EQ(machine.getMemoryValue(200 + row * 4), row * 4);
+    }
+    EXPECT_EQ(machine.getMemoryValue(304), 0u);
+}
+
+TEST_P(VectorTest, ShortVectorLengthLeavesTailElements) {
+    RiscMachine machine(256, 1024, GetParam());
+    for (uint32_t i = 0; i < 8; ++i) machine.setMemoryValue(100 + i, 10 + i);
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 2},
+        {Opcode::LOAD, 1, 1, 2},
+        {Opcode::VLOAD, 0, 0, 1},       // V0 = 10..17
+        {Opcode::LOAD, 2, 3, 2},
+        {Opcode::VSETVL, 3, 2, 0},      // vl = 3
+        {Opcode::VMUL, 0, 0, 0},        // V0[0..3) squared
+        {Opcode::VREDUCE, 4, 0, 0},     // sum of V0[0..3)
+        {Opcode::STORE, 200, 3, 0},
+        {Opcode::STORE, 201, 4, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(200), 3u);
+    EXPECT_EQ(machine.getMemoryValue(201), 100u + 121u + 144u);
+    VectorUnit::Register v0 = machine.getVectorRegister(0);
+    EXPECT_EQ(v0[2], 144u);
+    EXPECT_EQ(v0[3], 13u);
+    EXPECT_EQ(v0[7], 17u);
+    EXPECT_EQ(v0[8], 0u);
+}
+
+TEST_P(VectorTest, OutOfBoundsAccessFaultsBeforeTouchingMemory) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 1020, 2},     // elements 1020..1027: the last four are outside
+        {Opcode::LOAD, 1, 1, 2},
+        {Opcode::LOAD, 2, 7, 2},
+        {Opcode::VSETVL, 3, 2, 0},
+        {Opcode::VSTORE, 0, 0, 1},
+        {Opcode::STORE, 100, 2, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    machine.setMemoryValue(1023, 99);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(1023), 99u);
+    EXPECT_EQ(machine.getMemoryValue(100), 0u);
+}
+
+TEST_P(VectorTest, InvalidVectorRegistersAreIgnored) {
+    RiscMachine machine(256, 1024, GetParam());
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 100, 2},
+        {Opcode::LOAD, 1, 1, 2},
+        {Opcode::VLOAD, 8, 0, 1},       // no V8: no-op
+        {Opcode::VADD, 0, 9, 0},        // no-op
+        {Opcode::VREDUCE, 2, 12, 0},    // no-op
+        {Opcode::LOAD, 3, 5, 2},
+        {Opcode::STORE, 101, 3, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    EXPECT_FALSE(machine.getVerificationReport().verified());
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 5u);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, VectorTest,
+                         ::testing::Values(ExecutionEngine::Switch, ExecutionEngine::Threaded, ExecutionEngine::Jit),
+                         [](const ::testing::TestParamInfo<ExecutionEngine>& info) {
+                             switch (info.param) {
+                                 case ExecutionEngine::Switch: return "Switch";
+                                 case ExecutionEngine::Threaded: return "Threaded";
+                                 default: return "Jit";
+                             }
+                         });
+
+TEST(VectorProgramTest, DispatchesFewerInstructionsThanScalarSum) {
+    constexpr uint32_t kLength = 4096;
+    auto retired = [](const std::vector<Instruction>& program) {
+        RiscMachine machine(256, 8192);
+        for (uint32_t i = 0; i < kLength; ++i) machine.setMemoryValue(1000 + i, 1);
+        machine.setMemoryValue(100, 1000);
+        machine.setMemoryValue(101, kLength);
+        machine.setReductionEnabled(false);
+        machine.loadProgram(program);
+        machine.setStatsEnabled(true);
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(102), 4096u);
+        return machine.getStats().instructions_retired;
+    };
+    const uint64_t scalar = retired(createSumListProgram(100, 101, 102));
+    const uint64_t vector = retired(createVectorSumListProgram(100, 101, 102));
+    // 10 instructions per element against 8 per VLMAX (8) elements
+    EXPECT_LT(vector * 8, scalar);
+}
+
+TEST(VectorProgramTest, OptimizerKeepsVectorPrograms) {
+    const std::vector<Instruction> program = createDotProductProgram(100, 101, 102, 103);
+    const OptimizedProgram optimized = optimizeProgram(program, 16, 8192);
+    for (const std::vector<Instruction>* candidate : {&program, &optimized.program}) {
+        RiscMachine machine(256, 8192);
+        for (uint32_t i = 0; i < 50; ++i) {
+            machine.setMemoryValue(1000 + i, i);
+            machine.setMemoryValue(2000 + i, 2);
+        }
+        machine.setMemoryValue(100, 1000);
+        machine.setMemoryValue(101, 2000);
+        machine.setMemoryValue(102, 50);
+        machine.loadProgram(*candidate);
+        machine.run();
+        EXPECT_EQ(machine.getMemoryValue(103), 50u * 49u);
+    }
+}
+
+TEST(VectorProgramTest, WideMachineLanesMatchRiscMachine) {
+    WideMachine<8> wide(4096);
+    std::vector<uint32_t> expected(8);
+    for (size_t lane = 0; lane < 8; ++lane) {
+        const uint32_t length = static_cast<uint32_t>(lane * 37);  // diverging trip counts
+        for (uint32_t i = 0; i < length; ++i) {
+            wide.setMemoryValue(lane, 1000 + i, i + static_cast<uint32_t>(lane));
+            wide.setMemoryValue(lane, 2000 + i, 3);
+            expected[lane] += (i + static_cast<uint32_t>(lane)) * 3;
+        }
+        wide.setMemoryValue(lane, 100, 1000);
+        wide.setMemoryValue(lane, 101, 2000);
+        wide.setMemoryValue(lane, 102, length);
+    }
+    wide.setMemoryValue(7, 101, 4090);  // lane 7 faults on its second array
+    wide.loadProgram(createDotProductProgram(100, 101, 102, 103));
+    wide.run();
+    for (size_t lane = 0; lane < 7; ++lane) {
+        EXPECT_EQ(wide.getMemoryValue(lane, 103), expected[lane]) << "lane " << lane;
+    }
+    EXPECT_EQ(wide.getMemoryValue(7, 103), 0u);
+}
@@ -0,0 +1,72 @@
+/**
+ * @file verifier_gtest.cpp
+ * @brief Unit tests for the load-time program verifier.
+ */
+
+#include "../src/verifier.hpp"
+#include "../src/machine.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+
+TEST(VerifierTest, BundledProgramsVerify) {
+    for (const auto& program : {createFactorialProgram(100, 101), createFibonacciProgram(100, 101),
+                                createSumListProgram(300, 301, 302)}) {
+        VerificationReport report = verifyProgram(program, 16, 1024);
+        EXPECT_TRUE(report.verified()) << report.toString();
+    }
+}
+
+TEST(VerifierTest, IndirectLoadsNeedRuntimeChecks) {
+    VerificationReport report = verifyProgram(createSumListProgram(300, 301, 302), 16, 1024);
+    ASSERT_FALSE(report.runtime_checks.empty());
+    for (size_t index : report.runtime_checks) {
+        EXPECT_EQ(createSumListProgram(300, 301, 302)[index].opcode, Opcode::LOAD);
+    }
+}
+
+TEST(VerifierTest, ReportsEveryUnprovableOperand) {
+    std::vector<Instruction> program = {
+        {Opcode::LOAD, 20, 100, 0},     // 0: destination register
+        {Opcode::LOAD, 1, 9999, 0},     // 1: direct address
+        {Opcode::LOAD, 1, 100, 3},      // 2: addressing mode
+        {Opcode::STORE, 9999, 0, 0},    // 3: store address
+        {Opcode::ADD, 2, 0, 16},        // 4: source register
+        {Opcode::CMP, 0, 0, 99},        // 5: source register
+        {Opcode::JMP, 500, 0, 0},       // 6: jump target
+        {Opcode::JMP, 0, 7, 0},         // 7: jump condition
+        {Opcode::CHECK_FLAG, 3, 9, 0},  // 8: flag index
+        {static_cast<Opcode>(42), 0, 0, 0},  // 9: opcode
+        {Opcode::HALT, 0, 0, 0}
+    };
+    VerificationReport report = verifyProgram(program, 16, 1024);
+    ASSERT_EQ(report.issues.size(), 10u) << report.toString();
+    for (size_t i = 0; i < report.issues.size(); ++i) {
+        EXPECT_EQ(report.issues[i].index, i);
+    }
+    EXPECT_EQ(report.issues[0].message, "destination register R20 out of range (16 registers)");
+    EXPECT_EQ(report.issues[1].message, "address 9999 outside data memory (1024 words)");
+    EXPECT_EQ(report.issues[6].message, "jump target 500 outside program (11 instructions)");
+    EXPECT_NE(report.toString().find("4: ADD: source register R16"), std::string::npos);
+    EXPECT_NE(report.toString().find("9: UNKNOWN: unknown opcode 42"), std::string::npos);
+}
+
+TEST(VerifierTest, MachineReportsAndStillRunsUnverifiedPrograms) {
+    RiscMachine machine(256, 128);
+    machine.setMemoryValue(100, 5);
+    machine.loadProgram(createFactorialProgram(100, 101));
+    EXPECT_TRUE(machine.getVerificationReport().verified());
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 120u);
+
+    // Valid on a 1024-word machine, but address 200 is outside this one
+    machine.loadProgram({
+        {Opcode::LOAD, 0, 7, 2},
+        {Opcode::STORE, 200, 0, 0},
+        {Opcode::STORE, 101, 0, 0},
+        {Opcode::HALT, 0, 0, 0}
+    });
+    ASSERT_FALSE(machine.getVerificationReport().verified());
+    EXPECT_EQ(machine.getVerificationReport().issues[0].index, 1u);
+    machine.run();
+    EXPECT_EQ(machine.getMemoryValue(101), 7u);
+}
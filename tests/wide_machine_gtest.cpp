@@ -0,0 +1,134 @@
+/**
+ * @file wide_machine_gtest.cpp
+ * @brief Unit tests comparing WideMachine lanes against independent RiscMachine runs.
+ */
+
+#include "../src/wide_machine.hpp"
+#include "../src/algorithms.hpp"
+#include <gtest/gtest.h>
+#include <random>
+
+template <typename Wide>
+class WideMachineTest : public ::testing::Test {
+    protected:
+        static constexpr size_t kDataSize = 512;
+        Wide wide{kDataSize};
+
+        // Per-lane memory initialisation: (address, value) pairs
+        using LaneMemory = std::vector<std::pair<uint32_t, uint32_t>>;
+
+        // Runs the program on every lane and on one RiscMachine per lane and
+        // compares memory and flags lane by lane.
+        void expectMatchesScalar(const std::vector<Instruction>& program,
+                                 const std::vector<LaneMemory>& lane_memory) {
+            wide.loadProgram(program);
+            for (size_t lane = 0; lane < Wide::lanes; ++lane) {
+                for (const auto& [address, value] : lane_memory[lane]) {
+                    wide.setMemoryValue(lane, address, value);
+                }
+            }
+            wide.run();
+
+            for (size_t lane = 0; lane < Wide::lanes; ++lane) {
+                RiscMachine reference(512, kDataSize);
+                for (const auto& [address, value] : lane_memory[lane]) {
+                    reference.setMemoryValue(address, value);
+                }
+                reference.loadProgram(program);
+                reference.run();
+
+                for (uint32_t address = 0; address < kDataSize; ++address) {
+                    ASSERT_EQ(wide.getMemoryValue(lane, address), reference.getMemoryValue(address))
+                        << "lane " << lane << " address " << address;
+                }
+                StatusRegister expected = reference.getStatusRegister();
+                StatusRegister actual = wide.getStatusRegister(lane);
+                EXPECT_EQ(actual.ZF, expected.ZF) << "lane " << lane;
+                EXPECT_EQ(actual.CF, expected.CF) << "lane " << lane;
+                EXPECT_EQ(actual.NF, expected.NF) << "lane " << lane;
+                EXPECT_EQ(actual.OF, expected.OF) << "lane " << lane;
+                EXPECT_EQ(actual.DF, expected.DF) << "lane " << lane;
+            }
+        }
+    };
+
+using WideTypes = ::testing::Types<WideMachine<8>, WideMachine<16>>;
+TYPED_TEST_SUITE(WideMachineTest, WideTypes);
+
+TYPED_TEST(WideMachineTest, FactorialSameInput) {
+    std::vector<typename TestFixture::LaneMemory> memory(TypeParam::lanes, {{100, 10}});
+    this->expectMatchesScalar(createFactorialProgram(100, 101), memory);
+    EXPECT_FALSE(this->wide.getStats().scalar_fallback);
+    EXPECT_EQ(this->wide.getStats().lane_instructions, this->wide.getStats().vector_steps * TypeParam::lanes);
+}
+
+TYPED_TEST(WideMachineTest, FactorialDivergentInputs) {
+    std::vector<typename TestFixture::LaneMemory> memory;
+    for (uint32_t lane = 0; lane < TypeParam::lanes; ++lane) memory.push_back({{100, lane}});
+    this->expectMatchesScalar(createFactorialProgram(100, 101), memory);
+}
+
+TYPED_TEST(WideMachineTest, FibonacciWithOverflowLanes) {
+    std::vector<typename TestFixture::LaneMemory> memory;
+    for (uint32_t lane = 0; lane < TypeParam::lanes; ++lane) memory.push_back({{100, 40 + lane}});
+    this->expectMatchesScalar(createFibonacciProgram(100, 101), memory);
+}
+
+TYPED_TEST(WideMachineTest, SumListIncludingFaultingLane) {
+    std::vector<typename TestFixture::LaneMemory> memory;
+    for (uint32_t lane = 0; lane < TypeParam::lanes; ++lane) {
+        // Lane 0 has a zero-length list, which walks off the end of memory and faults
+        typename TestFixture::LaneMemory lane_memory = {{300, 400}, {301, lane}};
+        for (uint32_t i = 0; i < lane; ++i) lane_memory.emplace_back(400 + i, lane * 1000 + i);
+        if (lane == 3) lane_memory.emplace_back(401, UINT32_MAX);
+        memory.push_back(lane_memory);
+    }
+    this->expectMatchesScalar(createSumListProgram(300, 301, 302), memory);
+}
+
+TYPED_TEST(WideMachineTest, ScalarFallbackOnHeavyDivergence) {
+    // One lane runs a long loop while the others finish immediately
+    std::vector<typename TestFixture::LaneMemory> memory(TypeParam::lanes, {{100, 1}});
+    memory[0] = {{100, 5000}};
+    this->wide.setScalarFallback(2, 16);
+    this->expectMatchesScalar(createFactorialProgram(100, 101), memory);
+    EXPECT_TRUE(this->wide.getStats().scalar_fallback);
+    EXPECT_GT(this->wide.getStats().scalar_steps, 0u);
+}
+
+TYPED_TEST(WideMachineTest, RandomForwardPrograms) {
+    std::mt19937 rng(99);
+    auto next = [&rng](uint32_t bound) { return static_cast<uint32_t>(rng() % bound); };
+    for (int iteration = 0; iteration < 30; ++iteration) {
+        std::vector<Instruction> program;
+        const uint32_t length = 30;
+        for (uint32_t i = 0; i < length; ++i) {
+            switch (next(7)) {
+                case 0: program.push_back({Opcode::LOAD, next(8), 100 + next(8), 0}); break;
+                case 1: program.push_back({Opcode::LOAD, next(8), next(8), 1}); break;
+                case 2: program.push_back({Opcode::STORE, 100 + next(16), next(8), 0}); break;
+                case 3: program.push_back({Opcode::CMP, 0, next(8), next(8)}); break;
+                case 4: program.push_back({Opcode::JMP, i + 1 + next(length - i), next(2), 0}); break;
+                case 5: program.push_back({Opcode::CHECK_FLAG, next(8), next(5), 0}); break;
+                default: {
+                    const Opcode ops[] = {Opcode::ADD, Opcode::SUB, Opcode::MUL, Opcode::DIV, Opcode::MOV};
+                    program.push_back({ops[next(5)], next(8), next(8), next(8)});
+                    break;
+                }
+            }
+        }
+        program.push_back({Opcode::HALT, 0, 0, 0});
+
+        std::vector<typename TestFixture::LaneMemory> memory(TypeParam::lanes);
+        for (auto& lane_memory : memory) {
+            for (uint32_t address = 100; address < 108; ++address) {
+                lane_memory.emplace_back(address, next(3) == 0 ? UINT32_MAX - next(3) : next(110));
+            }
+        }
+        this->wide.reset();
+        for (size_t lane = 0; lane < TypeParam::lanes; ++lane) {
+            for (uint32_t address = 100; address < 116; ++address) this->wide.setMemoryValue(lane, address, 0);
+        }
+        this->expectMatchesScalar(program, memory);
+    }
+}